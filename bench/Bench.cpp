@@ -0,0 +1,46 @@
+#include "Bench.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    // Relaxed atomics: background threads (log writer) allocate too.
+    std::atomic<uint64_t> allocationCount{0};
+    std::atomic<uint64_t> allocatedByteCount{0};
+    volatile uint64_t sink = 0;
+}
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedByteCount.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace Bench {
+    uint64_t allocations() { return allocationCount.load(std::memory_order_relaxed); }
+    uint64_t allocatedBytes() { return allocatedByteCount.load(std::memory_order_relaxed); }
+
+    void consume(uint64_t value) { sink = sink + value; }
+
+    void printHeader() {
+        std::printf("%-44s %10s %10s %12s %10s\n", "benchmark", "ns/op", "allocs/op", "Mops/s", "MB/s");
+    }
+
+    void print(const std::string& name, const Result& result) {
+        double opsPerSecond = result.nanosPerOp > 0 ? 1e9 / result.nanosPerOp : 0;
+        std::printf("%-44s %10.1f %10.3f %12.2f", name.c_str(), result.nanosPerOp, result.allocationsPerOp,
+                    opsPerSecond / 1e6);
+        if (result.bytesPerOp > 0) {
+            std::printf(" %10.1f\n", opsPerSecond * result.bytesPerOp / (1024.0 * 1024.0));
+        } else {
+            std::printf(" %10s\n", "-");
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Small harness shared by the benchmark executables. Bench.cpp replaces the
+// global operator new so every heap allocation made by the code under test
+// is counted.
+namespace Bench {
+    uint64_t allocations();
+    uint64_t allocatedBytes();
+
+    // Keeps a result alive so the optimizer cannot drop the work.
+    void consume(uint64_t value);
+
+    struct Result {
+        std::size_t ops = 0;
+        double nanosPerOp = 0;
+        double allocationsPerOp = 0;
+        double bytesPerOp = 0;  // Payload processed, for throughput in MB/s; 0 if not meaningful
+    };
+
+    void printHeader();
+    void print(const std::string& name, const Result& result);
+
+    // Times fn(i) for i in [0, ops) after running the first few ops once to
+    // warm caches and let containers reach their steady-state size.
+    template <typename Fn>
+    Result run(std::size_t ops, Fn fn, double bytesPerOp = 0) {
+        for (std::size_t i = 0; i < ops && i < 1024; ++i) fn(i);
+
+        uint64_t allocationsBefore = allocations();
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < ops; ++i) fn(i);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        Result result;
+        result.ops = ops;
+        result.nanosPerOp = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) /
+                            static_cast<double>(ops);
+        result.allocationsPerOp = static_cast<double>(allocations() - allocationsBefore) / static_cast<double>(ops);
+        result.bytesPerOp = bytesPerOp;
+        return result;
+    }
+}
+
+#endif
@@ -0,0 +1,151 @@
+#include "FastFormat.h"
+#include "Utils.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Compares the cost of producing one CSV log line with the previous
+// stringstream/localtime formatting against the FastFormat path.
+
+namespace {
+    struct Sample {
+        std::chrono::system_clock::time_point timestamp;
+        uint32_t sourceAddr;
+        uint32_t destAddr;
+        std::string sourceIP;
+        std::string destIP;
+        uint16_t sourcePort;
+        uint16_t destPort;
+        std::string protocol;
+        uint32_t packetSize;
+    };
+
+    std::string addressString(uint32_t address) {
+        return std::to_string(address >> 24) + "." + std::to_string((address >> 16) & 0xFF) + "." +
+               std::to_string((address >> 8) & 0xFF) + "." + std::to_string(address & 0xFF);
+    }
+
+    std::vector<Sample> makeSamples(std::size_t count) {
+        std::vector<Sample> samples;
+        samples.reserve(count);
+        auto now = std::chrono::system_clock::now();
+        uint32_t seed = 12345;
+        for (std::size_t i = 0; i < count; ++i) {
+            seed = seed * 1103515245 + 12345;
+            Sample s;
+            s.timestamp = now + std::chrono::microseconds(i * 50);
+            s.sourceAddr = 0xC0A80000 | (seed & 0xFFFF);
+            s.destAddr = 0x0A000000 | (seed >> 8);
+            s.sourceIP = addressString(s.sourceAddr);
+            s.destIP = addressString(s.destAddr);
+            s.sourcePort = static_cast<uint16_t>(1024 + seed % 60000);
+            s.destPort = (i & 1) ? 443 : 53;
+            s.protocol = (i & 1) ? "TCP" : "UDP";
+            s.packetSize = 60 + seed % 1400;
+            samples.push_back(s);
+        }
+        return samples;
+    }
+
+    std::string legacyTimestamp(const std::chrono::system_clock::time_point& tp) {
+        auto time_t = std::chrono::system_clock::to_time_t(tp);
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(tp.time_since_epoch()) % 1000;
+        std::stringstream ss;
+        ss << std::put_time(std::localtime(&time_t), "%H:%M:%S");
+        ss << '.' << std::setfill('0') << std::setw(3) << ms.count();
+        return ss.str();
+    }
+
+    std::string legacyBytes(uint64_t bytes) {
+        const char* units[] = {"B", "KB", "MB", "GB", "TB"};
+        int unit = 0;
+        double size = static_cast<double>(bytes);
+        while (size >= 1024 && unit < 4) {
+            size /= 1024;
+            unit++;
+        }
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(unit == 0 ? 0 : 2) << size << " " << units[unit];
+        return ss.str();
+    }
+
+    std::size_t legacyLine(const Sample& s, std::string& out) {
+        std::stringstream line;
+        line << legacyTimestamp(s.timestamp) << "," << s.sourceIP << "," << s.sourcePort << ","
+             << s.destIP << "," << s.destPort << "," << s.protocol << "," << s.packetSize
+             << ",false,\"\"\n";
+        out = line.str();
+        return out.size() + legacyBytes(s.packetSize).size();
+    }
+
+    char* fastFormatLine(const Sample& s, char* buffer) {
+        char* out = FastFormat::timestamp(buffer, s.timestamp);
+        *out++ = ',';
+        out = FastFormat::ipv4(out, s.sourceAddr);
+        *out++ = ',';
+        out = FastFormat::uint(out, s.sourcePort);
+        *out++ = ',';
+        out = FastFormat::ipv4(out, s.destAddr);
+        *out++ = ',';
+        out = FastFormat::uint(out, s.destPort);
+        *out++ = ',';
+        out = FastFormat::text(out, s.protocol);
+        *out++ = ',';
+        out = FastFormat::uint(out, s.packetSize);
+        return FastFormat::text(out, ",false,\"\"\n", 10);
+    }
+
+    std::size_t fastLine(const Sample& s, char* buffer) {
+        char* out = fastFormatLine(s, buffer);
+        char bytes[FastFormat::BYTES_MAX_WIDTH];
+        return static_cast<std::size_t>(out - buffer) +
+               static_cast<std::size_t>(FastFormat::bytes(bytes, s.packetSize) - bytes);
+    }
+
+    template <typename Fn>
+    double nanosPerLine(const std::vector<Sample>& samples, int rounds, Fn fn) {
+        std::size_t sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r) {
+            for (const auto& s : samples) sink += fn(s);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        if (sink == 0) std::cerr << "empty output\n";
+        double nanos = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        return nanos / (static_cast<double>(samples.size()) * rounds);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t count = argc > 1 ? static_cast<std::size_t>(std::stoul(argv[1])) : 200000;
+    const int rounds = 5;
+    std::vector<Sample> samples = makeSamples(count);
+
+    // Both paths must agree before their timings mean anything.
+    std::string legacy;
+    char buffer[256];
+    for (std::size_t i = 0; i < samples.size() && i < 1000; ++i) {
+        legacyLine(samples[i], legacy);
+        char* end = fastFormatLine(samples[i], buffer);
+        if (legacy != std::string(buffer, end) || legacyBytes(samples[i].packetSize) != Utils::formatBytes(samples[i].packetSize)) {
+            std::cerr << "Output mismatch at sample " << i << ":\n  " << legacy << "  " << std::string(buffer, end);
+            return 1;
+        }
+    }
+
+    std::string scratch;
+    double legacyNanos = nanosPerLine(samples, rounds, [&](const Sample& s) { return legacyLine(s, scratch); });
+    double fastNanos = nanosPerLine(samples, rounds, [&](const Sample& s) { return fastLine(s, buffer); });
+
+    std::printf("%-28s %10s\n", "formatter", "ns/line");
+    std::printf("%-28s %10.1f\n", "stringstream + localtime", legacyNanos);
+    std::printf("%-28s %10.1f\n", "FastFormat", fastNanos);
+    std::printf("%-28s %9.1fx\n", "speedup", legacyNanos / fastNanos);
+    return 0;
+}
@@ -0,0 +1,188 @@
+#include "PacketParser.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Measures PacketParser on synthetic frames for each supported link layer,
+// and checks that every truncation of a valid frame is rejected cleanly.
+
+namespace {
+    typedef std::vector<uint8_t> Frame;
+
+    void put16(Frame& f, uint16_t v) {
+        f.push_back(static_cast<uint8_t>(v >> 8));
+        f.push_back(static_cast<uint8_t>(v));
+    }
+
+    void put32(Frame& f, uint32_t v) {
+        put16(f, static_cast<uint16_t>(v >> 16));
+        put16(f, static_cast<uint16_t>(v));
+    }
+
+    void appendTransport(Frame& f, uint32_t seed, bool tcp, uint16_t payload) {
+        put16(f, static_cast<uint16_t>(1024 + seed % 60000));
+        put16(f, tcp ? 443 : 53);
+        if (tcp) {
+            put32(f, seed);
+            put32(f, 0);
+            f.push_back(0x50);
+            f.push_back(0x18);
+            put16(f, 65535);
+            put32(f, 0);
+        } else {
+            put16(f, static_cast<uint16_t>(8 + payload));
+            put16(f, 0);
+        }
+        f.insert(f.end(), payload, 0xAB);
+    }
+
+    // IPv4 + TCP or UDP header and a small payload.
+    void appendIpv4(Frame& f, uint32_t seed, bool tcp) {
+        const uint16_t transport = tcp ? 20 : 8;
+        const uint16_t payload = 32;
+        f.push_back(0x45);
+        f.push_back(0);
+        put16(f, static_cast<uint16_t>(20 + transport + payload));
+        put16(f, static_cast<uint16_t>(seed));
+        put16(f, 0x4000);
+        f.push_back(64);
+        f.push_back(tcp ? 6 : 17);
+        put16(f, 0);
+        put32(f, 0xC0A80000 | (seed & 0xFFFF));
+        put32(f, 0x0A000000 | (seed >> 8 & 0xFFFFFF));
+        appendTransport(f, seed, tcp, payload);
+    }
+
+    // IPv6 with `extensions` headers (hop-by-hop options, then a first
+    // fragment header) ahead of TCP or UDP.
+    void appendIpv6(Frame& f, uint32_t seed, bool tcp, int extensions) {
+        const uint16_t transport = tcp ? 20 : 8;
+        const uint16_t payload = 32;
+        const uint8_t upper = tcp ? 6 : 17;
+        put32(f, 0x60000000);
+        put16(f, static_cast<uint16_t>(8 * extensions + transport + payload));
+        f.push_back(extensions > 0 ? 0 : upper);
+        f.push_back(64);
+        put32(f, 0x20010DB8);
+        put32(f, 0);
+        put32(f, seed >> 16);
+        put32(f, seed);
+        put32(f, 0x20010DB8);
+        put32(f, 1);
+        put32(f, 0);
+        put32(f, seed & 0xFF);
+        for (int i = 0; i < extensions; ++i) {
+            bool last = i + 1 == extensions;
+            f.push_back(last ? upper : 44);
+            f.insert(f.end(), 1, 0x00);
+            put16(f, last && i > 0 ? 0x0001 : 0x0000);  // Fragment header: offset 0, more fragments
+            put32(f, seed);
+        }
+        appendTransport(f, seed, tcp, payload);
+    }
+
+    Frame makeFrame(int linkType, int vlanTags, int ipv6Extensions, uint32_t seed) {
+        Frame f;
+        switch (linkType) {
+            case PacketParser::LINK_ETHERNET:
+                f.insert(f.end(), 12, 0x02);
+                for (int i = 0; i < vlanTags; ++i) {
+                    put16(f, i == 0 && vlanTags > 1 ? 0x88A8 : 0x8100);
+                    put16(f, static_cast<uint16_t>(100 + i));
+                }
+                put16(f, ipv6Extensions >= 0 ? 0x86DD : 0x0800);
+                break;
+            case PacketParser::LINK_LINUX_SLL:
+                f.insert(f.end(), 14, 0x00);
+                put16(f, 0x0800);
+                break;
+            case PacketParser::LINK_LINUX_SLL2:
+                put16(f, 0x0800);
+                f.insert(f.end(), 18, 0x00);
+                break;
+            case PacketParser::LINK_NULL:
+                f.push_back(2);
+                f.insert(f.end(), 3, 0x00);
+                break;
+            default:
+                break;
+        }
+        if (ipv6Extensions >= 0) {
+            appendIpv6(f, seed, (seed & 1) != 0, ipv6Extensions);
+        } else {
+            appendIpv4(f, seed, (seed & 1) != 0);
+        }
+        return f;
+    }
+
+    struct Case {
+        const char* name;
+        int linkType;
+        int vlanTags;
+        int ipv6Extensions;  // -1 for IPv4
+    };
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t count = argc > 1 ? static_cast<std::size_t>(std::stoul(argv[1])) : 4096;
+    const int rounds = 2000;
+    const Case cases[] = {
+        {"ethernet", PacketParser::LINK_ETHERNET, 0, -1},
+        {"ethernet + 802.1Q", PacketParser::LINK_ETHERNET, 1, -1},
+        {"ethernet + QinQ", PacketParser::LINK_ETHERNET, 2, -1},
+        {"ethernet IPv6", PacketParser::LINK_ETHERNET, 0, 0},
+        {"ethernet IPv6 + 2 ext hdrs", PacketParser::LINK_ETHERNET, 0, 2},
+        {"linux cooked (SLL)", PacketParser::LINK_LINUX_SLL, 0, -1},
+        {"linux cooked v2 (SLL2)", PacketParser::LINK_LINUX_SLL2, 0, -1},
+        {"BSD loopback (NULL)", PacketParser::LINK_NULL, 0, -1},
+        {"raw IP", PacketParser::LINK_RAW, 0, -1},
+    };
+
+    std::printf("%-28s %10s\n", "link type", "ns/packet");
+    for (const Case& c : cases) {
+        PacketParser parser(c.linkType);
+        std::vector<Frame> frames;
+        frames.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            frames.push_back(makeFrame(c.linkType, c.vlanTags, c.ipv6Extensions, static_cast<uint32_t>(i * 2654435761u)));
+        }
+
+        // Every frame must decode fully, and every strict prefix of it must
+        // fail or decode without ports rather than read past the end.
+        ParsedPacket parsed;
+        for (std::size_t i = 0; i < frames.size() && i < 64; ++i) {
+            const Frame& f = frames[i];
+            if (parser.parse(f.data(), static_cast<uint32_t>(f.size()), parsed) != ParsedPacket::OK || !parsed.hasPorts ||
+                parsed.vlanCount != c.vlanTags) {
+                std::cerr << c.name << ": frame " << i << " did not parse\n";
+                return 1;
+            }
+            for (std::size_t len = 0; len < f.size(); ++len) {
+                Frame prefix(f.begin(), f.begin() + static_cast<std::ptrdiff_t>(len));
+                parser.parse(prefix.data(), static_cast<uint32_t>(len), parsed);
+                if (parsed.payload != nullptr && parsed.payload + parsed.payloadLength > prefix.data() + len) {
+                    std::cerr << c.name << ": payload overruns a " << len << "-byte prefix\n";
+                    return 1;
+                }
+            }
+        }
+
+        uint64_t sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r) {
+            for (const Frame& f : frames) {
+                parser.parse(f.data(), static_cast<uint32_t>(f.size()), parsed);
+                sink += parsed.sourcePort + parsed.destAddr.hash();
+            }
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        if (sink == 0) std::cerr << "empty output\n";
+        double nanos = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        std::printf("%-28s %10.1f\n", c.name, nanos / (static_cast<double>(frames.size()) * rounds));
+    }
+    return 0;
+}
@@ -0,0 +1,398 @@
+#include "Bench.h"
+#include "PacketCapture.h"
+#include "AnomalyDetector.h"
+#include "MemoryBudget.h"
+#include "WatchRules.h"
+#include "NetworkStats.h"
+#include "Logger.h"
+#include "Pipeline.h"
+#include "Dissector.h"
+#include "FastFormat.h"
+#include "Utils.h"
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// One benchmark per hot-path component, each reporting ns/op, heap
+// allocations/op and throughput: ./network2.0_bench [scale], where the
+// default scale of 1 runs for a few seconds.
+
+namespace {
+    // Console chatter from setup and teardown (rule additions, log file and
+    // capture messages) would break up the results table.
+    class QuietOutput {
+    private:
+        std::ostringstream discard;
+        std::streambuf* saved;
+
+    public:
+        QuietOutput() : saved(std::cout.rdbuf(discard.rdbuf())) {}
+        ~QuietOutput() { std::cout.rdbuf(saved); }
+    };
+
+    uint32_t nextRandom(uint64_t& state) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<uint32_t>(state >> 16);
+    }
+
+    // Ethernet + IPv4 + TCP with 32 bytes of payload.
+    std::vector<uint8_t> makeFrame(uint32_t source, uint32_t dest, uint16_t destPort) {
+        std::vector<uint8_t> f(14 + 20 + 20 + 32, 0);
+        f[12] = 0x08;
+        uint8_t* ip = &f[14];
+        ip[0] = 0x45;
+        ip[3] = 72;
+        ip[8] = 64;
+        ip[9] = 6;
+        for (int i = 0; i < 4; ++i) {
+            ip[12 + i] = static_cast<uint8_t>(source >> (24 - 8 * i));
+            ip[16 + i] = static_cast<uint8_t>(dest >> (24 - 8 * i));
+        }
+        uint8_t* tcp = &f[34];
+        tcp[0] = 0xC3;
+        tcp[1] = 0x50;
+        tcp[2] = static_cast<uint8_t>(destPort >> 8);
+        tcp[3] = static_cast<uint8_t>(destPort);
+        tcp[12] = 0x50;
+        tcp[13] = 0x18;
+        return f;
+    }
+
+    // Packets from `sources` distinct addresses in 10.0.0.0/8 to a few
+    // servers in 192.168.0.0/24.
+    std::vector<PacketInfo> makePackets(std::size_t count, std::size_t sources) {
+        std::vector<PacketInfo> packets(count);
+        uint64_t state = 0x9E3779B97F4A7C15ULL;
+        for (PacketInfo& packet : packets) {
+            uint32_t r = nextRandom(state);
+            packet.sourceAddr = IpAddress::fromV4(0x0A000000u + static_cast<uint32_t>(r % sources));
+            packet.destAddr = IpAddress::fromV4(0xC0A80001u + (r >> 28));
+            packet.ipProtocol = 6;
+            packet.sourcePort = 50000;
+            packet.destPort = static_cast<uint16_t>(r % 1024);
+            packet.packetSize = 60 + r % 1400;
+        }
+        return packets;
+    }
+
+    Bench::Result benchParse(std::size_t ops) {
+        const std::size_t frameCount = 4096;
+        std::vector<std::vector<uint8_t>> frames;
+        uint64_t state = 1;
+        for (std::size_t i = 0; i < frameCount; ++i) {
+            uint32_t r = nextRandom(state);
+            frames.push_back(makeFrame(0x0A000000u | (r & 0xFFFFFF), 0xC0A80001u, static_cast<uint16_t>(r % 1024)));
+        }
+        struct pcap_pkthdr header = {};
+        header.caplen = header.len = static_cast<uint32_t>(frames[0].size());
+
+        QuietOutput quiet;
+        PacketCapture capture;
+        capture.setLinkType(DLT_EN10MB);
+        return Bench::run(ops, [&](std::size_t i) {
+            PacketInfo info;
+            Bench::consume(capture.parsePacket(&header, frames[i % frameCount].data(), info));
+        }, static_cast<double>(header.caplen));
+    }
+
+    Bench::Result benchAnomaly(std::size_t ops, std::size_t sources) {
+        std::vector<PacketInfo> packets = makePackets(65536, sources);
+        MemoryBudget budget;
+        budget.setLimit(std::size_t(1024) << 20);
+        AnomalyDetector detector(budget);
+        return Bench::run(ops, [&](std::size_t i) {
+            PacketInfo packet = packets[i % packets.size()];
+            Bench::consume(detector.analyzePacket(packet));
+        });
+    }
+
+    // Rules are spread over three prefix lengths in 172.16.0.0/12, which the
+    // traffic never hits: the common case is a miss.
+    Bench::Result benchWatchRules(std::size_t ops, std::size_t rules) {
+        std::vector<PacketInfo> packets = makePackets(65536, 100000);
+        QuietOutput quiet;
+        WatchRules watchRules;
+        for (std::size_t i = 0; i < rules; ++i) {
+            std::string network = "172." + std::to_string(16 + i % 16) + "." + std::to_string(i / 16 % 256) + ".";
+            switch (i % 3) {
+                case 0: watchRules.addWatchIP(network + std::to_string(i % 251)); break;
+                case 1: watchRules.addWatchIP(network + "0/24"); break;
+                default: watchRules.addWatchIP(network + "128/25"); break;
+            }
+        }
+        return Bench::run(ops, [&](std::size_t i) {
+            Bench::consume(watchRules.checkPacket(packets[i % packets.size()]));
+        });
+    }
+
+    void put16(std::vector<uint8_t>& out, std::size_t v) {
+        out.push_back(static_cast<uint8_t>(v >> 8));
+        out.push_back(static_cast<uint8_t>(v));
+    }
+
+    std::vector<uint8_t> dnsQuery(const std::string& name) {
+        std::vector<uint8_t> out = {0x12, 0x34, 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, 0};
+        std::size_t label = 0;
+        while (label < name.size()) {
+            std::size_t dot = std::min(name.find('.', label), name.size());
+            out.push_back(static_cast<uint8_t>(dot - label));
+            out.insert(out.end(), name.begin() + label, name.begin() + dot);
+            label = dot + 1;
+        }
+        out.insert(out.end(), {0, 0, 1, 0, 1});
+        return out;
+    }
+
+    // Host is the fourth header line, as browsers tend to send it.
+    std::vector<uint8_t> httpRequest(const std::string& host) {
+        std::string text = "GET /assets/app.js?v=3 HTTP/1.1\r\nUser-Agent: Mozilla/5.0 (X11; Linux x86_64)\r\n"
+                           "Accept: */*\r\nAccept-Language: en-US,en;q=0.5\r\nHost: " + host +
+                           "\r\nConnection: keep-alive\r\n\r\n";
+        return std::vector<uint8_t>(text.begin(), text.end());
+    }
+
+    // A ClientHello with a 32-byte session ID, 16 cipher suites and six
+    // extensions ahead of server_name, as TLS 1.3 clients send them.
+    std::vector<uint8_t> clientHello(const std::string& serverName) {
+        std::vector<uint8_t> extensions;
+        for (uint16_t type : {0x000A, 0x000B, 0x000D, 0x0010, 0x002B, 0x0033}) {
+            put16(extensions, type);
+            put16(extensions, 24);
+            extensions.insert(extensions.end(), 24, 0x11);
+        }
+        put16(extensions, 0);
+        put16(extensions, 5 + serverName.size());
+        put16(extensions, 3 + serverName.size());
+        extensions.push_back(0);
+        put16(extensions, serverName.size());
+        extensions.insert(extensions.end(), serverName.begin(), serverName.end());
+
+        std::vector<uint8_t> body = {3, 3};
+        body.insert(body.end(), 32, 0x5A);
+        body.push_back(32);
+        body.insert(body.end(), 32, 0x33);
+        put16(body, 32);
+        body.insert(body.end(), 32, 0x13);
+        body.insert(body.end(), {1, 0});
+        put16(body, extensions.size());
+        body.insert(body.end(), extensions.begin(), extensions.end());
+
+        std::vector<uint8_t> out = {22, 3, 1};
+        put16(out, 4 + body.size());
+        out.insert(out.end(), {1, 0});
+        put16(out, body.size());
+        out.insert(out.end(), body.begin(), body.end());
+        return out;
+    }
+
+    // 1024 packets with distinct names, already parsed down to the payload.
+    struct AppTraffic {
+        std::vector<std::vector<uint8_t>> payloads;
+        std::vector<ParsedPacket> packets;
+    };
+
+    AppTraffic makeAppTraffic(AppLayer::Protocol protocol, uint16_t destPort) {
+        AppTraffic traffic;
+        for (uint32_t i = 0; i < 1024; ++i) {
+            std::string name = "edge" + std::to_string(i) + ".cdn" + std::to_string(i % 7) + ".example.com";
+            switch (protocol) {
+                case AppLayer::DNS: traffic.payloads.push_back(dnsQuery(name)); break;
+                case AppLayer::HTTP: traffic.payloads.push_back(httpRequest(name)); break;
+                default: traffic.payloads.push_back(clientHello(name)); break;
+            }
+        }
+        for (const auto& payload : traffic.payloads) {
+            ParsedPacket packet = ParsedPacket();
+            packet.ipProtocol = protocol == AppLayer::DNS ? 17 : 6;
+            packet.hasPorts = true;
+            packet.sourcePort = 50000;
+            packet.destPort = destPort;
+            packet.payload = payload.data();
+            packet.payloadLength = static_cast<uint32_t>(payload.size());
+            traffic.packets.push_back(packet);
+        }
+        return traffic;
+    }
+
+    Bench::Result benchDissect(std::size_t ops, AppLayer::Protocol protocol, uint16_t destPort) {
+        AppTraffic traffic = makeAppTraffic(protocol, destPort);
+        Dissector dissector;
+        return Bench::run(ops, [&](std::size_t i) {
+            AppLayer app;
+            Bench::consume(dissector.dissect(traffic.packets[i % traffic.packets.size()], app) + app.name.size());
+        });
+    }
+
+    // Names from benchDissect against `rules` watched domains they never fall
+    // under: the common case is a miss.
+    Bench::Result benchDomainRules(std::size_t ops, std::size_t rules) {
+        AppTraffic traffic = makeAppTraffic(AppLayer::TLS, 443);
+        Dissector dissector;
+        std::vector<PacketInfo> packets = makePackets(traffic.packets.size(), 1000);
+        for (std::size_t i = 0; i < packets.size(); ++i) {
+            dissector.dissect(traffic.packets[i], packets[i].app);
+        }
+        QuietOutput quiet;
+        WatchRules watchRules;
+        for (std::size_t i = 0; i < rules; ++i) {
+            watchRules.addWatchDomain("tracker" + std::to_string(i) + (i % 2 ? ".example.net" : ".cdn3.example.com"));
+        }
+        return Bench::run(ops, [&](std::size_t i) {
+            Bench::consume(watchRules.checkPacket(packets[i % packets.size()]));
+        });
+    }
+
+    // All packets fall in one second, so past the first TOP_EXACT_PACKETS
+    // the top summaries see 1 in `topInterval`; 0 leaves just the counters.
+    Bench::Result benchStats(std::size_t ops, std::size_t sources, uint32_t topInterval) {
+        std::vector<PacketInfo> packets = makePackets(1024, sources);
+        NetworkStats stats;
+        stats.setTopSampleInterval(topInterval);
+        Bench::Result result = Bench::run(ops, [&](std::size_t i) {
+            stats.recordPacket(packets[i % packets.size()]);
+        });
+        stats.flush();
+        Bench::consume(stats.getTotalPackets());
+        return result;
+    }
+
+    Bench::Result benchLogger(std::size_t ops, Logger::Format format) {
+        std::vector<PacketInfo> packets = makePackets(65536, 100000);
+        QuietOutput quiet;
+        Logger logger;
+        logger.setFormat(format);
+        if (!logger.enableLogging("/dev/null")) return Bench::Result();
+        Bench::Result result = Bench::run(ops, [&](std::size_t i) {
+            logger.logPacket(packets[i % packets.size()]);
+            if ((i & 1023) == 0) logger.poll();
+        });
+        logger.disableLogging();
+        return result;
+    }
+
+    // The whole per-packet pipeline as NetworkMonitor configures it.
+    enum PipelineConfig { DETECT_ONLY, DETECT_LOG, INTERACTIVE };
+
+    Bench::Result benchPipeline(std::size_t ops, PipelineConfig config) {
+        std::vector<PacketInfo> packets = makePackets(65536, 100000);
+        QuietOutput quiet;
+        PerfMonitor perf;
+        MemoryBudget budget;
+        AnomalyDetector detector(budget);
+        NetworkStats stats;
+        WatchRules watchRules;
+        PacketStore store;
+        Logger logger;
+        EventWriter events;
+        std::function<void(const PacketInfo&)> onAlert;
+        PacketInfo recent[20];
+        std::size_t recentIndex = 0;
+
+        Pipeline::Context context;
+        context.perf = &perf;
+        context.detector = &detector;
+        context.stats = &stats;
+        context.watchRules = &watchRules;
+        context.store = &store;
+        context.logger = &logger;
+        context.events = &events;
+        context.onAlert = &onAlert;
+        if (config == DETECT_LOG) {
+            logger.setFormat(Logger::Format::BINARY);
+            if (!logger.enableLogging("/dev/null")) return Bench::Result();
+        }
+        if (config == INTERACTIVE) {
+            store.setCapacity(1000000);
+            context.recent = recent;
+            context.recentSize = 20;
+            context.recentIndex = &recentIndex;
+        }
+
+        Pipeline::configure(context);
+        Bench::Result result = Bench::run(ops, [&](std::size_t i) {
+            PacketInfo packet = packets[i % packets.size()];
+            Pipeline::process(context, packet);
+            if ((i & 1023) == 0) {
+                stats.flush();
+                logger.poll();
+            }
+        });
+        logger.disableLogging();
+        return result;
+    }
+
+    template <typename Fn>
+    Bench::Result benchFormatter(std::size_t ops, Fn fn) {
+        std::vector<PacketInfo> packets = makePackets(4096, 100000);
+        return Bench::run(ops, [&](std::size_t i) { Bench::consume(fn(packets[i % packets.size()])); });
+    }
+}
+
+int main(int argc, char* argv[]) {
+    double scale = argc > 1 ? std::stod(argv[1]) : 1.0;
+    auto ops = [scale](std::size_t base) { return static_cast<std::size_t>(static_cast<double>(base) * scale) + 1; };
+
+    Bench::printHeader();
+    Bench::print("PacketCapture::parsePacket eth/IPv4/TCP", benchParse(ops(2000000)));
+
+    for (std::size_t sources : {std::size_t(1), std::size_t(1000), std::size_t(100000), std::size_t(1000000)}) {
+        Bench::print("AnomalyDetector::analyzePacket " + std::to_string(sources) + " src",
+                     benchAnomaly(ops(2000000), sources));
+    }
+
+    for (std::size_t rules : {std::size_t(0), std::size_t(10), std::size_t(100), std::size_t(1000)}) {
+        Bench::print("WatchRules::checkPacket " + std::to_string(rules) + " rules", benchWatchRules(ops(5000000), rules));
+    }
+
+    Bench::print("Dissector::dissect DNS query", benchDissect(ops(5000000), AppLayer::DNS, 53));
+    Bench::print("Dissector::dissect HTTP request", benchDissect(ops(5000000), AppLayer::HTTP, 80));
+    Bench::print("Dissector::dissect TLS ClientHello", benchDissect(ops(5000000), AppLayer::TLS, 443));
+    Bench::print("Dissector::dissect unmapped port", benchDissect(ops(5000000), AppLayer::TLS, 7000));
+    for (std::size_t rules : {std::size_t(1), std::size_t(100)}) {
+        Bench::print("WatchRules::checkPacket " + std::to_string(rules) + " domain rules",
+                     benchDomainRules(ops(2000000), rules));
+    }
+
+    Bench::print("NetworkStats::recordPacket counters only",
+                 benchStats(ops(5000000), 100000, 0));
+    for (std::size_t sources : {std::size_t(1), std::size_t(1000000)}) {
+        Bench::print("NetworkStats::recordPacket " + std::to_string(sources) + " src",
+                     benchStats(ops(5000000), sources, NetworkStats::DEFAULT_TOP_SAMPLE_INTERVAL));
+        Bench::print("NetworkStats::recordPacket " + std::to_string(sources) + " src exact",
+                     benchStats(ops(2000000), sources, 1));
+    }
+    Bench::print("Logger::logPacket csv -> /dev/null", benchLogger(ops(2000000), Logger::Format::CSV));
+    Bench::print("Logger::logPacket binary -> /dev/null", benchLogger(ops(2000000), Logger::Format::BINARY));
+
+    const struct {
+        const char* name;
+        PipelineConfig config;
+    } pipelines[] = {
+        {"detect-only", DETECT_ONLY},
+        {"detect+log", DETECT_LOG},
+        {"detect+store+display", INTERACTIVE},
+    };
+    for (const auto& pipeline : pipelines) {
+        Bench::print(std::string("Pipeline ") + pipeline.name, benchPipeline(ops(1000000), pipeline.config));
+    }
+
+    Bench::print("Utils::formatTimestamp", benchFormatter(ops(1000000), [](const PacketInfo& p) {
+        return Utils::formatTimestamp(p.timestamp).size();
+    }));
+    Bench::print("Utils::formatBytes", benchFormatter(ops(2000000), [](const PacketInfo& p) {
+        return Utils::formatBytes(p.packetSize).size();
+    }));
+    Bench::print("Utils::protocolToString", benchFormatter(ops(5000000), [](const PacketInfo& p) {
+        return Utils::protocolToString(p.ipProtocol).size();
+    }));
+    Bench::print("FastFormat::timestamp + address", benchFormatter(ops(5000000), [](const PacketInfo& p) {
+        char buffer[64];
+        char* out = FastFormat::timestamp(buffer, p.timestamp);
+        return static_cast<std::size_t>(FastFormat::address(out, p.sourceAddr) - buffer);
+    }));
+    return 0;
+}
@@ -0,0 +1,241 @@
+#include "AnomalyDetector.h"
+#include "MemoryBudget.h"
+#include "Bench.h"
+#include "FastFormat.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Feeds a high-cardinality workload (a few hot sources mixed with a large
+// spread of one-off sources, as in a spoofed flood) through the previous
+// node-based trackers and through AnomalyDetector's slab tables, counting
+// heap allocations and, where the kernel allows it, hardware cache misses.
+
+namespace {
+    // The trackers as they were: string keys, a timestamp queue per burst
+    // tracker and a port set per scan tracker, every node heap-allocated.
+    // The per-packet full cleanup scan is left out, which only flatters this
+    // side at high cardinality.
+    class LegacyTrackers {
+    private:
+        struct BurstTracker {
+            std::queue<std::chrono::system_clock::time_point> recentPackets;
+        };
+        struct ScanTracker {
+            std::unordered_set<uint16_t> scannedPorts;
+            std::chrono::system_clock::time_point firstScanTime;
+        };
+        struct ConnectionTracker {
+            int failedAttempts = 0;
+            std::chrono::system_clock::time_point firstFailTime;
+        };
+
+        std::unordered_map<std::string, BurstTracker> burstTrackers;
+        std::unordered_map<std::string, ScanTracker> scanTrackers;
+        std::unordered_map<std::string, ConnectionTracker> connectionTrackers;
+        std::string source;
+
+    public:
+        bool analyzePacket(PacketInfo& packet) {
+            auto now = std::chrono::system_clock::now();
+            bool isAnomalous = false;
+
+            // Capture used to format this string for every packet.
+            char text[FastFormat::IP_MAX_WIDTH];
+            source.assign(text, FastFormat::address(text, packet.sourceAddr));  // Reuses capacity; no allocation
+
+            auto& burst = burstTrackers[source];
+            burst.recentPackets.push(now);
+            while (!burst.recentPackets.empty() &&
+                   std::chrono::duration_cast<std::chrono::seconds>(now - burst.recentPackets.front()).count() > 5) {
+                burst.recentPackets.pop();
+            }
+            if (burst.recentPackets.size() > 100) {
+                isAnomalous = true;
+                packet.anomalyReason = "Packet burst detected; ";
+            }
+
+            auto& scan = scanTrackers[source];
+            if (scan.scannedPorts.empty()) scan.firstScanTime = now;
+            scan.scannedPorts.insert(packet.destPort);
+            if (scan.scannedPorts.size() > 10) {
+                isAnomalous = true;
+                packet.anomalyReason = "Port scan detected; ";
+            }
+
+            auto& connection = connectionTrackers[source];
+            if (connection.failedAttempts == 0) connection.firstFailTime = now;
+            if (++connection.failedAttempts > 20) {
+                isAnomalous = true;
+                packet.anomalyReason = "Multiple failed connections; ";
+            }
+
+            packet.isAnomaly = isAnomalous;
+            return isAnomalous;
+        }
+
+        std::size_t size() const { return burstTrackers.size(); }
+    };
+
+    // Hardware cache-miss counter for this thread; reads zero when perf
+    // events are unavailable (non-Linux, containers, perf_event_paranoid).
+    class CacheMissCounter {
+    private:
+        int fd = -1;
+
+    public:
+        CacheMissCounter() {
+#ifdef __linux__
+            perf_event_attr attr{};
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+        }
+        ~CacheMissCounter() {
+#ifdef __linux__
+            if (fd >= 0) close(fd);
+#endif
+        }
+
+        bool available() const { return fd >= 0; }
+
+        void start() {
+#ifdef __linux__
+            if (fd < 0) return;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+        }
+
+        uint64_t stop() {
+            uint64_t value = 0;
+#ifdef __linux__
+            if (fd < 0) return 0;
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) value = 0;
+#endif
+            return value;
+        }
+    };
+
+    struct Workload {
+        std::vector<IpAddress> addresses;
+        std::vector<uint32_t> sources;  // Index into addresses per packet
+        std::vector<uint16_t> ports;
+    };
+
+    Workload makeWorkload(std::size_t distinct, std::size_t packets) {
+        Workload w;
+        w.addresses.reserve(distinct);
+        for (std::size_t i = 0; i < distinct; ++i) {
+            w.addresses.push_back(IpAddress::fromV4(0x0A000000u + static_cast<uint32_t>(i * 2654435761u % 0xFFFFFF)));
+        }
+        uint64_t seed = 88172645463325252ULL;
+        w.sources.reserve(packets);
+        w.ports.reserve(packets);
+        for (std::size_t i = 0; i < packets; ++i) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            // Half the packets come from 256 hot sources, half from anywhere.
+            std::size_t source = (seed & 1) ? (seed >> 8) % 256 : (seed >> 8) % distinct;
+            w.sources.push_back(static_cast<uint32_t>(source));
+            w.ports.push_back(static_cast<uint16_t>(1 + (seed >> 40) % 1024));
+        }
+        return w;
+    }
+
+    struct Result {
+        double nanos;
+        uint64_t allocations;
+        uint64_t bytes;
+        uint64_t cacheMisses;
+    };
+
+    template <typename Detector>
+    Result run(const Workload& w, Detector& detector, CacheMissCounter& misses) {
+        PacketInfo packet;
+        packet.ipProtocol = 6;
+        packet.packetSize = 60;
+        std::size_t flagged = 0;
+
+        uint64_t allocationsBefore = Bench::allocations();
+        uint64_t bytesBefore = Bench::allocatedBytes();
+        misses.start();
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < w.sources.size(); ++i) {
+            packet.sourceAddr = w.addresses[w.sources[i]];
+            packet.destPort = w.ports[i];
+            flagged += detector.analyzePacket(packet);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        Result result;
+        result.cacheMisses = misses.stop();
+        result.allocations = Bench::allocations() - allocationsBefore;
+        result.bytes = Bench::allocatedBytes() - bytesBefore;
+        result.nanos = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) /
+                       static_cast<double>(w.sources.size());
+        if (flagged == 0) std::cerr << "no anomalies flagged\n";
+        return result;
+    }
+
+    void print(const char* name, const Result& r, std::size_t packets, bool haveMisses) {
+        std::printf("%-30s %10.1f %12.3f %12.1f", name, r.nanos,
+                    static_cast<double>(r.allocations) / static_cast<double>(packets),
+                    static_cast<double>(r.bytes) / static_cast<double>(packets));
+        if (haveMisses) {
+            std::printf(" %12.2f\n", static_cast<double>(r.cacheMisses) / static_cast<double>(packets));
+        } else {
+            std::printf(" %12s\n", "n/a");
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t distinct = argc > 1 ? static_cast<std::size_t>(std::stoul(argv[1])) : 1000000;
+    std::size_t packets = argc > 2 ? static_cast<std::size_t>(std::stoul(argv[2])) : 4000000;
+    if (distinct < 256) distinct = 256;
+
+    Workload w = makeWorkload(distinct, packets);
+    CacheMissCounter misses;
+
+    std::printf("%zu packets from %zu distinct sources\n", packets, distinct);
+    std::printf("%-30s %10s %12s %12s %12s\n", "trackers", "ns/packet", "allocs/pkt", "bytes/pkt", "misses/pkt");
+
+    {
+        LegacyTrackers legacy;
+        print("node-based, string keys", run(w, legacy, misses), packets, misses.available());
+    }
+    {
+        MemoryBudget budget;
+        budget.setLimit(std::size_t(4096) << 20);
+        AnomalyDetector detector(budget);
+        print("slab + open addressing", run(w, detector, misses), packets, misses.available());
+    }
+    {
+        MemoryBudget budget;
+        budget.setLimit(std::size_t(16) << 20);
+        AnomalyDetector detector(budget);
+        print("slab + open addressing, 16 MB", run(w, detector, misses), packets, misses.available());
+        budget.printStats();
+    }
+    return 0;
+}
@@ -0,0 +1,27 @@
+#include "PacketParser.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+// libFuzzer entry point. The first input byte picks the link type so one
+// corpus covers every decoder; the rest is the captured frame.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static const int linkTypes[] = {
+        PacketParser::LINK_ETHERNET, PacketParser::LINK_LINUX_SLL, PacketParser::LINK_LINUX_SLL2,
+        PacketParser::LINK_NULL, PacketParser::LINK_LOOP, PacketParser::LINK_RAW, PacketParser::LINK_IPV4,
+        PacketParser::LINK_IPV6,
+    };
+    if (size < 1) return 0;
+
+    PacketParser parser(linkTypes[data[0] % (sizeof(linkTypes) / sizeof(linkTypes[0]))]);
+    const uint8_t* frame = data + 1;
+    uint32_t length = static_cast<uint32_t>(size - 1);
+
+    ParsedPacket parsed;
+    parser.parse(frame, length, parsed);
+    if (parsed.payload != nullptr &&
+        (parsed.payload < frame || parsed.payload + parsed.payloadLength > frame + length)) {
+        std::abort();
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+#ifndef ADDRESS_INDEX_H
+#define ADDRESS_INDEX_H
+
+#include "IpAddress.h"
+#include <memory>
+#include <cstddef>
+
+// Open-addressing map from IP address to T*, with the 16-byte key stored
+// inline in one bucket array: no allocation per entry, and a lookup touches
+// one or two adjacent cache lines. Linear probing; erase shifts the rest of
+// the cluster back so no tombstones build up. The caller decides when to
+// grow (see needsGrowth) so it can charge the new array to a budget first.
+// Other keys work if, like IpAddress, they provide hash(), == and isV4().
+template <typename T, typename Key = IpAddress>
+class AddressIndex {
+private:
+    struct Bucket {
+        Key key;
+        T* value = nullptr;  // nullptr marks an empty bucket
+    };
+
+    std::unique_ptr<Bucket[]> buckets;
+    std::size_t bucketCount = 0;  // Zero or a power of two
+    std::size_t count = 0;
+    std::size_t v6Count = 0;
+
+    std::size_t home(const Key& key) const { return static_cast<std::size_t>(key.hash()) & (bucketCount - 1); }
+
+    void place(const Key& key, T* value) {
+        std::size_t i = home(key);
+        while (buckets[i].value != nullptr) i = (i + 1) & (bucketCount - 1);
+        buckets[i].key = key;
+        buckets[i].value = value;
+    }
+
+public:
+    static const std::size_t MIN_BUCKETS = 16;
+
+    static std::size_t bytesFor(std::size_t buckets) { return buckets * sizeof(Bucket); }
+
+    T* find(const Key& key) const {
+        if (count == 0) return nullptr;
+        for (std::size_t i = home(key);; i = (i + 1) & (bucketCount - 1)) {
+            const Bucket& bucket = buckets[i];
+            if (bucket.value == nullptr) return nullptr;
+            if (bucket.key == key) return bucket.value;
+        }
+    }
+
+    // Kept at most 3/4 full so probe sequences stay short.
+    bool needsGrowth() const { return (count + 1) * 4 > bucketCount * 3; }
+    std::size_t grownCapacity() const { return bucketCount == 0 ? MIN_BUCKETS : bucketCount * 2; }
+
+    void rehash(std::size_t newBuckets) {
+        std::unique_ptr<Bucket[]> old(new Bucket[newBuckets]);
+        old.swap(buckets);
+        std::size_t oldCount = bucketCount;
+        bucketCount = newBuckets;
+        for (std::size_t i = 0; i < oldCount; ++i) {
+            if (old[i].value != nullptr) place(old[i].key, old[i].value);
+        }
+    }
+
+    // `key` must not be present, and needsGrowth() must be false.
+    void insert(const Key& key, T* value) {
+        place(key, value);
+        ++count;
+        if (!key.isV4()) ++v6Count;
+    }
+
+    void erase(const Key& key) {
+        if (count == 0) return;
+        const std::size_t mask = bucketCount - 1;
+        std::size_t hole = home(key);
+        for (;; hole = (hole + 1) & mask) {
+            if (buckets[hole].value == nullptr) return;
+            if (buckets[hole].key == key) break;
+        }
+        --count;
+        if (!key.isV4()) --v6Count;
+
+        // Backward shift: move each later entry of the cluster into the hole
+        // unless its home lies cyclically within (hole, current].
+        for (std::size_t i = (hole + 1) & mask; buckets[i].value != nullptr; i = (i + 1) & mask) {
+            std::size_t want = home(buckets[i].key);
+            if (((i - want) & mask) >= ((i - hole) & mask)) {
+                buckets[hole] = buckets[i];
+                hole = i;
+            }
+        }
+        buckets[hole] = Bucket();
+    }
+
+    // Drops the bucket array as well as the entries.
+    void clear() {
+        buckets.reset();
+        bucketCount = 0;
+        count = 0;
+        v6Count = 0;
+    }
+
+    std::size_t size() const { return count; }
+    std::size_t v6Size() const { return v6Count; }
+    std::size_t capacity() const { return bucketCount; }
+};
+
+#endif
@@ -5,140 +5,181 @@
 #include <chrono>
 #include <string>
 
+const char* const AnomalyDetector::BURST_REASON = "Packet burst detected; ";
+const char* const AnomalyDetector::SCAN_REASON = "Port scan detected; ";
+const char* const AnomalyDetector::FAILED_REASON = "Multiple failed connections; ";
+
+namespace {
+    const uint8_t PROTO_TCP = 6;
+}
+
+AnomalyDetector::AnomalyDetector(MemoryBudget& budget)
+    : burstTrackers(budget, "burst_trackers"),
+      scanTrackers(budget, "scan_trackers"),
+      connectionTrackers(budget, "connection_trackers") {}
+
+// Windows run on capture time rather than the wall clock, so a saved trace
+// replayed at full speed raises the same alerts as it did live. Counts are
+// weighted by the packet's sample weight, so the thresholds still mean the
+// same traffic when the sampler keeps only one packet or flow in N.
 bool AnomalyDetector::analyzePacket(PacketInfo& packet) {
-    cleanupOldEntries();
+    auto now = packet.timestamp;
+    cleanupOldEntries(now);
 
     bool isAnomalous = false;
-    std::string reason;
+    const char* reason = "";
 
-    if (isPacketBurst(packet.sourceIP)) {
+    if (isPacketBurst(packet, now)) {
+        burstDetections.increment();
         isAnomalous = true;
-        reason =+ "Packet burst detected; ";
+        reason = BURST_REASON;
     }
 
-    if (isPortScan(packet)) {
+    if (isPortScan(packet, now)) {
+        scanDetections.increment();
         isAnomalous = true;
-        reason =+ "Port scan detected; ";
+        reason = SCAN_REASON;
     }
 
-    if (packet.protocol == "TCP" && packet.packetSize < 100) {
-        if (isFailedConnection(packet)) {
+    if (packet.ipProtocol == PROTO_TCP && packet.packetSize < SMALL_TCP_BYTES) {
+        if (isFailedConnection(packet, now)) {
+            failedConnectionDetections.increment();
             isAnomalous = true;
-            reason =+ "Multiple failed connections; ";
+            reason = FAILED_REASON;
         }
     }
 
     if (isAnomalous) {
         packet.isAnomaly = true;
-        packet.anomalyReason = reason; 
+        packet.anomalyReason = reason;
     }
 
+    publishCounts();
     return isAnomalous;
 }
 
-bool AnomalyDetector::isPacketBurst(const std::string& sourceIP) {
-    auto& tracker = burstTrackers[sourceIP];
-    auto now = std::chrono::system_clock::now();
-
-    tracker.recentPackets.push(now);
+void AnomalyDetector::publishCounts() {
+    burstTrackerCount.set(burstTrackers.size());
+    scanTrackerCount.set(scanTrackers.size());
+    connectionTrackerCount.set(connectionTrackers.size());
+    ipv6TrackerCount.set(burstTrackers.v6Size());
+}
 
-    while (!tracker.recentPackets.empty()) {
-        auto packetTime = tracker.recentPackets.front();
-        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - packetTime).count();
+bool AnomalyDetector::isPacketBurst(const PacketInfo& packet, std::chrono::system_clock::time_point now) {
+    BurstTracker* tracker = burstTrackers.acquire(packet.sourceAddr);
+    if (tracker == nullptr) return false;
 
-        if (elapsed > BurstTracker::BURST_WINDOW_SECONDS) {
-            tracker.recentPackets.pop();
-        } else {
-            break;
+    int64_t second = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
+    int64_t stale = second - tracker->lastSecond;
+    if (stale >= BurstTracker::WINDOW_SLOTS || stale < 0) {
+        std::fill(tracker->counts, tracker->counts + BurstTracker::WINDOW_SLOTS, 0u);
+    } else {
+        for (int64_t s = tracker->lastSecond + 1; s <= second; ++s) {
+            tracker->counts[s % BurstTracker::WINDOW_SLOTS] = 0;
         }
     }
+    tracker->lastSecond = second;
+    tracker->counts[second % BurstTracker::WINDOW_SLOTS] += packet.sampleWeight;
 
-    return tracker.recentPackets.size() > BurstTracker::BURST_THRESHOLD;
+    std::size_t total = 0;
+    for (uint32_t count : tracker->counts) total += count;
+    return total > BURST_THRESHOLD;
 }
 
-bool AnomalyDetector::isPortScan(const PacketInfo& packet) {
-    if (packet.protocol != "TCP") return false;
+bool AnomalyDetector::isPortScan(const PacketInfo& packet, std::chrono::system_clock::time_point now) {
+    if (packet.ipProtocol != PROTO_TCP) return false;
 
-    auto& tracker = scanTrackers[packet.sourceIP];
-    auto now = std::chrono::system_clock::now();
+    ScanTracker* tracker = scanTrackers.acquire(packet.sourceAddr);
+    if (tracker == nullptr) return false;
 
-    if (tracker.scannedPorts.empty()) {
-        tracker.firstScanTime = now;
+    if (tracker->portCount == 0) {
+        tracker->firstScanTime = now;
     } else {
-        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - tracker.firstScanTime).count();
+        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - tracker->firstScanTime).count();
 
-        if (elapsed > ScanTracker::SCAN_WINDOW_SECONDS) {
-            tracker.scannedPorts.clear();
-            tracker.firstScanTime = now;
+        if (elapsed > SCAN_WINDOW_SECONDS) {
+            tracker->portCount = 0;
+            tracker->portEstimate = 0;
+            tracker->firstScanTime = now;
         }
     }
 
-    tracker.scannedPorts.insert(packet.destPort);
+    // portCount <= portEstimate, so the array never overflows.
+    uint16_t* end = tracker->scannedPorts + tracker->portCount;
+    if (tracker->portEstimate <= SCAN_THRESHOLD && std::find(tracker->scannedPorts, end, packet.destPort) == end) {
+        tracker->scannedPorts[tracker->portCount++] = packet.destPort;
+        tracker->portEstimate += packet.sampleWeight;
+    }
 
-    return tracker.scannedPorts.size() > ScanTracker::SCAN_THRESHOLD;
+    return tracker->portEstimate > SCAN_THRESHOLD;
 }
 
-bool AnomalyDetector::isFailedConnection(const PacketInfo& packet) {
-    auto& tracker = connectionTrackers[packet.sourceIP];
-    auto now = std::chrono::system_clock::now();
+bool AnomalyDetector::isFailedConnection(const PacketInfo& packet, std::chrono::system_clock::time_point now) {
+    ConnectionTracker* tracker = connectionTrackers.acquire(packet.sourceAddr);
+    if (tracker == nullptr) return false;
 
-    if (tracker.failedAttempts == 0) {
-        tracker.firstFailTime = now;
+    if (tracker->failedAttempts == 0) {
+        tracker->firstFailTime = now;
     } else {
-        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - tracker.firstFailTime).count();
+        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - tracker->firstFailTime).count();
 
-        if (elapsed > ConnectionTracker::FAILED_WINDOW_SECONDS) {
-            tracker.failedAttempts = 0;
-            tracker.firstFailTime = now;
+        if (elapsed > FAILED_WINDOW_SECONDS) {
+            tracker->failedAttempts = 0;
+            tracker->firstFailTime = now;
         }
     }
 
-    tracker.failedAttempts++;
+    tracker->failedAttempts += static_cast<int>(packet.sampleWeight);
 
-    return tracker.failedAttempts > ConnectionTracker::FAILED_THRESHOLD;
+    return tracker->failedAttempts > FAILED_THRESHOLD;
 }
 
-void AnomalyDetector::cleanupOldEntries() {
-    auto now = std::chrono::system_clock::now();
-
-    for (auto it = burstTrackers.begin(); it != burstTrackers.end();) {
-        if (it->second.recentPackets.empty()) {
-            it = burstTrackers.erase(it);
-        } else {
-            ++it;
-        }
-    }
-
-    for (auto it = scanTrackers.begin(); it != scanTrackers.end();) {
-        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - it->second.firstScanTime).count();
+// Trackers whose window has passed would be reset on their next packet
+// anyway, so they are freed. Runs at most once a second.
+void AnomalyDetector::cleanupOldEntries(std::chrono::system_clock::time_point now) {
+    if (now - lastCleanup < std::chrono::seconds(1)) return;
+    lastCleanup = now;
 
-        if (elapsed > ScanTracker::SCAN_WINDOW_SECONDS && it->second.scannedPorts.empty()) {
-            it = scanTrackers.erase(it);
-        } else {
-            ++it;
-        }
-    }
+    int64_t second = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
+    burstTrackers.expire([second](const BurstTracker& tracker) {
+        return second - tracker.lastSecond > BURST_WINDOW_SECONDS;
+    });
 
-    for (auto it = connectionTrackers.begin(); it != connectionTrackers.end();) {
-        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - it->second.firstFailTime).count();
+    scanTrackers.expire([&now](const ScanTracker& tracker) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - tracker.firstScanTime).count();
+        return elapsed > SCAN_WINDOW_SECONDS;
+    });
 
-        if (elapsed > ConnectionTracker::FAILED_WINDOW_SECONDS && it->second.failedAttempts == 0) {
-            it = connectionTrackers.erase(it);
-        } else {
-            ++it;
-        }
-    }
+    connectionTrackers.expire([&now](const ConnectionTracker& tracker) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - tracker.firstFailTime).count();
+        return elapsed > FAILED_WINDOW_SECONDS;
+    });
 }
 
 void AnomalyDetector::reset() {
     burstTrackers.clear();
     scanTrackers.clear();
     connectionTrackers.clear();
+    publishCounts();
 }
 
 void AnomalyDetector::printStats() const {
     std::cout << Utils::Colors::BOLD << "\n=== Anomaly Detection Stats ===" << Utils::Colors::RESET << std::endl;
-    std::cout << "Active burst trackers: " << burstTrackers.size() << std::endl;
-    std::cout << "Active scan trackers: " << scanTrackers.size() << std::endl;
-    std::cout << "Active connection trackers: " << connectionTrackers.size() << std::endl;
+    std::cout << "Active burst trackers: " << burstTrackerCount.get() << std::endl;
+    std::cout << "Active scan trackers: " << scanTrackerCount.get() << std::endl;
+    std::cout << "Active connection trackers: " << connectionTrackerCount.get() << std::endl;
+    std::cout << "IPv6 sources tracked: " << ipv6TrackerCount.get() << std::endl;
+}
+
+void AnomalyDetector::writeMetrics(std::ostream& out) const {
+    out << "# HELP network2_anomaly_trackers Active per-source anomaly trackers.\n"
+        << "# TYPE network2_anomaly_trackers gauge\n"
+        << "network2_anomaly_trackers{type=\"burst\"} " << burstTrackerCount.get() << "\n"
+        << "network2_anomaly_trackers{type=\"scan\"} " << scanTrackerCount.get() << "\n"
+        << "network2_anomaly_trackers{type=\"connection\"} " << connectionTrackerCount.get() << "\n"
+        << "# HELP network2_anomaly_detections_total Packets flagged by each anomaly heuristic.\n"
+        << "# TYPE network2_anomaly_detections_total counter\n"
+        << "network2_anomaly_detections_total{type=\"burst\"} " << burstDetections.get() << "\n"
+        << "network2_anomaly_detections_total{type=\"scan\"} " << scanDetections.get() << "\n"
+        << "network2_anomaly_detections_total{type=\"failed_connections\"} " << failedConnectionDetections.get() << "\n";
 }
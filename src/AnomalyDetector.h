@@ -2,49 +2,82 @@
 #define ANOMALY_DETECTOR_H
 
 #include "PacketTypes.h"
-#include <unordered_map>
-#include <unordered_set>
-#include <queue>
+#include "Counters.h"
+#include "TrackerTable.h"
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <ostream>
 
 class AnomalyDetector {
+public:
+    // Heuristic thresholds per source. A collector applies the same ones to
+    // the summaries it merges from several sensors.
+    static constexpr uint32_t BURST_THRESHOLD = 100;    // Packets
+    static constexpr int BURST_WINDOW_SECONDS = 5;
+    static constexpr uint32_t SCAN_THRESHOLD = 10;      // Distinct TCP destination ports
+    static constexpr int SCAN_WINDOW_SECONDS = 30;
+    static constexpr int FAILED_THRESHOLD = 20;         // TCP packets under SMALL_TCP_BYTES
+    static constexpr int FAILED_WINDOW_SECONDS = 60;
+    static constexpr uint32_t SMALL_TCP_BYTES = 100;
+
+    // Set as PacketInfo::anomalyReason; the last heuristic that fired wins.
+    static const char* const BURST_REASON;
+    static const char* const SCAN_REASON;
+    static const char* const FAILED_REASON;
+
 private:
+    // Trackers are fixed-size so they can live in slab-allocated tables
+    // under the shared state budget.
     struct BurstTracker {
-        std::queue<std::chrono::system_clock::time_point> recentPackets;
-        static const std::size_t BURST_THRESHOLD = 100;
-        static const int BURST_WINDOW_SECONDS = 5;
+        static const int WINDOW_SLOTS = BURST_WINDOW_SECONDS + 1;
+
+        int64_t lastSecond = 0;               // Second of the newest count
+        uint32_t counts[WINDOW_SLOTS] = {};   // Packets per second, indexed by second % WINDOW_SLOTS
     };
     
     struct ScanTracker {
-        std::unordered_set<uint16_t> scannedPorts;
+        // Only distinct ports up to one past the threshold matter.
+        uint16_t scannedPorts[SCAN_THRESHOLD + 1] = {};
+        uint8_t portCount = 0;
+        uint32_t portEstimate = 0;  // Distinct ports, each weighted by its packet's sample weight
         std::chrono::system_clock::time_point firstScanTime;
-        static const std::size_t SCAN_THRESHOLD = 10;
-        static const int SCAN_WINDOW_SECONDS = 30;
     };
     
     struct ConnectionTracker {
-        int failedAttempts;
+        int failedAttempts = 0;
         std::chrono::system_clock::time_point firstFailTime;
-        static const int FAILED_THRESHOLD = 20;
-        static const int FAILED_WINDOW_SECONDS = 60;
     };
     
-    std::unordered_map<std::string, BurstTracker> burstTrackers;
-    std::unordered_map<std::string, ScanTracker> scanTrackers;
-    std::unordered_map<std::string, ConnectionTracker> connectionTrackers;
+    TrackerTable<BurstTracker> burstTrackers;
+    TrackerTable<ScanTracker> scanTrackers;
+    TrackerTable<ConnectionTracker> connectionTrackers;
+    std::chrono::system_clock::time_point lastCleanup;
+    
+    // Published by the processing thread so other threads can report
+    // tracker sizes without touching the tables.
+    SingleWriterCounter burstTrackerCount;
+    SingleWriterCounter scanTrackerCount;
+    SingleWriterCounter connectionTrackerCount;
+    SingleWriterCounter ipv6TrackerCount;
+    SingleWriterCounter burstDetections;
+    SingleWriterCounter scanDetections;
+    SingleWriterCounter failedConnectionDetections;
     
-    void cleanupOldEntries();
-    bool isPacketBurst(const std::string& sourceIP);
-    bool isPortScan(const PacketInfo& packet);
-    bool isFailedConnection(const PacketInfo& packet);
+    void publishCounts();
+    void cleanupOldEntries(std::chrono::system_clock::time_point now);
+    bool isPacketBurst(const PacketInfo& packet, std::chrono::system_clock::time_point now);
+    bool isPortScan(const PacketInfo& packet, std::chrono::system_clock::time_point now);
+    bool isFailedConnection(const PacketInfo& packet, std::chrono::system_clock::time_point now);
     
 public:
-    AnomalyDetector() = default;
+    // Tracker memory is charged to `budget`, which must outlive the detector.
+    explicit AnomalyDetector(MemoryBudget& budget);
     
     bool analyzePacket(PacketInfo& packet);
     void reset();
     void printStats() const;
+    void writeMetrics(std::ostream& out) const;
 };
 
 #endif 
@@ -0,0 +1,221 @@
+#include "AsyncWriter.h"
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+AsyncWriter::AsyncWriter()
+    : opened(false), file(nullptr), fileBytes(0), current(nullptr), freeCount(0), stopping(false), flushRequested(false) {}
+
+AsyncWriter::~AsyncWriter() {
+    close();
+}
+
+bool AsyncWriter::open(const std::string& path, bool append, const Options& opts) {
+    close();
+    
+    file = path == "-" ? stdout : std::fopen(path.c_str(), append ? "ab" : "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    // Buffers are already large; stdio buffering would only add a copy.
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    
+    filename = path;
+    filePath = path;
+    fileBytes = 0;
+    opened = true;
+    options = opts;
+    options.bufferCount = (std::max)(options.bufferCount, static_cast<std::size_t>(2));
+    options.bufferSize = (std::max)(options.bufferSize, static_cast<std::size_t>(4096));
+    options.flushIntervalMs = (std::max)(options.flushIntervalMs, 1);
+    
+    buffers.assign(options.bufferCount, Buffer());
+    for (auto& buffer : buffers) {
+        buffer.data.resize(options.bufferSize);
+        buffer.used = 0;
+    }
+    current = &buffers[0];
+    freeBuffers.clear();
+    fullBuffers.clear();
+    for (std::size_t i = 1; i < buffers.size(); ++i) {
+        freeBuffers.push_back(&buffers[i]);
+    }
+    freeCount.store(freeBuffers.size(), std::memory_order_release);
+    
+    stopping = false;
+    flushRequested = false;
+    writerThread = std::thread([this]() { writerLoop(); });
+    return true;
+}
+
+void AsyncWriter::close() {
+    if (!opened) return;
+    
+    if (current != nullptr && current->used > 0) {
+        handOff(false);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_one();
+    if (writerThread.joinable()) {
+        writerThread.join();
+    }
+    
+    if (file == stdout) {
+        std::fflush(file);
+    } else if (file != nullptr) {
+        std::fclose(file);
+    }
+    file = nullptr;
+    opened = false;
+    current = nullptr;
+    freeBuffers.clear();
+    fullBuffers.clear();
+    buffers.clear();
+    freeCount.store(0);
+}
+
+bool AsyncWriter::handOff(bool allowDrop) {
+    if (allowDrop && options.overflow == OverflowPolicy::DROP &&
+        freeCount.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+    
+    std::unique_lock<std::mutex> lock(mutex);
+    fullBuffers.push_back(current);
+    current = nullptr;
+    workAvailable.notify_one();
+    
+    if (freeBuffers.empty()) {
+        producerStalls.increment();
+        bufferReturned.wait(lock, [this]() { return !freeBuffers.empty(); });
+    }
+    current = freeBuffers.front();
+    freeBuffers.pop_front();
+    freeCount.store(freeBuffers.size(), std::memory_order_release);
+    current->used = 0;
+    return true;
+}
+
+char* AsyncWriter::reserve(std::size_t size) {
+    if (current == nullptr || size > options.bufferSize) {
+        recordsDropped.increment();
+        return nullptr;
+    }
+    if (current->used + size > current->data.size() && !handOff(true)) {
+        recordsDropped.increment();
+        return nullptr;
+    }
+    return current->data.data() + current->used;
+}
+
+bool AsyncWriter::write(const char* data, std::size_t size) {
+    char* out = reserve(size);
+    if (out == nullptr) return false;
+    std::memcpy(out, data, size);
+    commit(size);
+    return true;
+}
+
+void AsyncWriter::rotate(const std::string& nextPath, SegmentClosed onClosed) {
+    if (current == nullptr) return;
+    current->rotateTo = nextPath;
+    current->onClosed = std::move(onClosed);
+    filename = nextPath;
+    handOff(false);
+}
+
+void AsyncWriter::switchFile(Buffer* buffer) {
+    if (file != nullptr) {
+        std::fclose(file);
+    }
+    std::string closedPath = filePath;
+    uint64_t closedBytes = fileBytes;
+    
+    file = std::fopen(buffer->rotateTo.c_str(), "wb");
+    if (file != nullptr) {
+        std::setvbuf(file, nullptr, _IONBF, 0);
+    } else {
+        writeErrors.increment();
+    }
+    filePath = buffer->rotateTo;
+    fileBytes = 0;
+    
+    if (buffer->onClosed) {
+        buffer->onClosed(closedPath, closedBytes);
+    }
+    buffer->rotateTo.clear();
+    buffer->onClosed = nullptr;
+}
+
+void AsyncWriter::poll() {
+    if (current != nullptr && current->used > 0 && flushRequested.load(std::memory_order_relaxed)) {
+        flushRequested.store(false, std::memory_order_relaxed);
+        handOff(true);
+    }
+}
+
+void AsyncWriter::flush() {
+    if (current == nullptr) return;
+    if (current->used > 0) {
+        handOff(false);
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    bufferReturned.wait(lock, [this]() { return freeBuffers.size() + 1 == buffers.size(); });
+}
+
+void AsyncWriter::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    
+    while (true) {
+        bool ready = workAvailable.wait_for(lock, std::chrono::milliseconds(options.flushIntervalMs),
+                                            [this]() { return stopping || !fullBuffers.empty(); });
+        if (fullBuffers.empty()) {
+            if (stopping) break;
+            if (!ready) {
+                flushRequested.store(true, std::memory_order_relaxed);
+            }
+            continue;
+        }
+        
+        Buffer* buffer = fullBuffers.front();
+        fullBuffers.pop_front();
+        lock.unlock();
+        
+        std::size_t written = 0;
+        if (buffer->used > 0) {
+            written = file != nullptr ? std::fwrite(buffer->data.data(), 1, buffer->used, file) : 0;
+            if (written != buffer->used) {
+                writeErrors.increment();
+            }
+            bytesWritten.add(written);
+            fileBytes += written;
+            writes.increment();
+        }
+        buffer->used = 0;
+        if (!buffer->rotateTo.empty()) {
+            switchFile(buffer);
+        }
+        
+        lock.lock();
+        freeBuffers.push_back(buffer);
+        freeCount.store(freeBuffers.size(), std::memory_order_release);
+        bufferReturned.notify_all();
+    }
+    
+    if (file != nullptr) {
+        std::fflush(file);
+    }
+}
+
+AsyncWriter::Stats AsyncWriter::getStats() const {
+    Stats stats;
+    stats.bytesWritten = bytesWritten.get();
+    stats.writes = writes.get();
+    stats.recordsDropped = recordsDropped.get();
+    stats.producerStalls = producerStalls.get();
+    stats.writeErrors = writeErrors.get();
+    return stats;
+}
@@ -0,0 +1,121 @@
+#ifndef ASYNC_WRITER_H
+#define ASYNC_WRITER_H
+
+#include "Counters.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+
+// Buffered file writer with a background I/O thread. One producer thread
+// formats directly into the current buffer; full buffers are handed to the
+// writer thread, which issues one large sequential write per buffer. When the
+// disk falls behind and every buffer is in flight, the producer either
+// blocks until one is returned or drops the incoming records, per policy.
+//
+// Output can be split into segments: rotate() marks the end of the current
+// buffer, and the writer thread switches files once everything before the
+// mark is on disk, so the producer never waits for the close/open.
+class AsyncWriter {
+public:
+    // Runs on the writer thread once a segment is complete, with its path and size.
+    typedef std::function<void(const std::string& path, uint64_t bytes)> SegmentClosed;
+
+    enum class OverflowPolicy { BLOCK, DROP };
+
+    struct Options {
+        std::size_t bufferSize;
+        std::size_t bufferCount;
+        int flushIntervalMs;
+        OverflowPolicy overflow;
+
+        Options() : bufferSize(1 << 20), bufferCount(4), flushIntervalMs(1000), overflow(OverflowPolicy::BLOCK) {}
+    };
+
+    struct Stats {
+        uint64_t bytesWritten;
+        uint64_t writes;
+        uint64_t recordsDropped;
+        uint64_t producerStalls;
+        uint64_t writeErrors;
+    };
+
+private:
+    struct Buffer {
+        std::vector<char> data;
+        std::size_t used;
+        std::string rotateTo;
+        SegmentClosed onClosed;
+    };
+
+    Options options;
+    bool opened;
+    std::string filename;
+
+    // Writer-thread state for the file currently being written.
+    std::FILE* file;
+    std::string filePath;
+    uint64_t fileBytes;
+
+    std::vector<Buffer> buffers;
+    Buffer* current;
+    std::deque<Buffer*> freeBuffers;
+    std::deque<Buffer*> fullBuffers;
+    std::atomic<std::size_t> freeCount;
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable bufferReturned;
+    std::thread writerThread;
+    bool stopping;
+    std::atomic<bool> flushRequested;
+
+    SingleWriterCounter bytesWritten;
+    SingleWriterCounter writes;
+    SingleWriterCounter recordsDropped;
+    SingleWriterCounter producerStalls;
+    SingleWriterCounter writeErrors;
+
+    void writerLoop();
+    bool handOff(bool allowDrop);
+    void switchFile(Buffer* buffer);
+
+public:
+    AsyncWriter();
+    ~AsyncWriter();
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+    // A path of "-" writes to stdout, which is left open on close().
+    bool open(const std::string& path, bool append, const Options& opts = Options());
+    void close();
+    bool isOpen() const { return opened; }
+    const std::string& getFilename() const { return filename; }
+
+    // Returns space for at least `size` bytes in the current buffer, or
+    // nullptr if the record must be dropped. Follow with commit().
+    char* reserve(std::size_t size);
+    void commit(std::size_t size) { current->used += size; }
+    bool write(const char* data, std::size_t size);
+
+    // Ends the current segment after the data written so far and continues
+    // in `nextPath`; `onClosed` is called for the finished segment.
+    void rotate(const std::string& nextPath, SegmentClosed onClosed);
+
+    // Called periodically by the producer: hands off a partially filled
+    // buffer once the writer thread has asked for a flush.
+    void poll();
+    void flush();
+
+    Stats getStats() const;
+    const Options& getOptions() const { return options; }
+};
+
+#endif
@@ -0,0 +1,268 @@
+#include "BinaryLog.h"
+#include <cstring>
+#include <algorithm>
+#include <limits>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    std::size_t align8(std::size_t value) {
+        return (value + 7) & ~static_cast<std::size_t>(7);
+    }
+
+    struct ColumnOffsets {
+        std::size_t timestamps, sourceAddrs, destAddrs, sizes, reasonEnds;
+        std::size_t sourcePorts, destPorts, protocols, flags, heap;
+    };
+
+    ColumnOffsets columnOffsets(uint32_t n) {
+        ColumnOffsets o;
+        std::size_t at = sizeof(BinaryLog::BlockHeader);
+        o.timestamps = at;   at = align8(at + n * sizeof(int64_t));
+        o.sourceAddrs = at;  at = align8(at + n * sizeof(uint32_t));
+        o.destAddrs = at;    at = align8(at + n * sizeof(uint32_t));
+        o.sizes = at;        at = align8(at + n * sizeof(uint32_t));
+        o.reasonEnds = at;   at = align8(at + n * sizeof(uint32_t));
+        o.sourcePorts = at;  at = align8(at + n * sizeof(uint16_t));
+        o.destPorts = at;    at = align8(at + n * sizeof(uint16_t));
+        o.protocols = at;    at = align8(at + n);
+        o.flags = at;        at = align8(at + n);
+        o.heap = at;
+        return o;
+    }
+
+    template <typename T>
+    void putColumn(char* out, std::size_t offset, const std::vector<T>& column) {
+        if (!column.empty()) {
+            std::memcpy(out + offset, column.data(), column.size() * sizeof(T));
+        }
+    }
+}
+
+BinaryLog::BlockBuilder::BlockBuilder() {
+    timestamps.reserve(BLOCK_RECORDS);
+    sourceAddrs.reserve(BLOCK_RECORDS);
+    destAddrs.reserve(BLOCK_RECORDS);
+    sizes.reserve(BLOCK_RECORDS);
+    reasonEnds.reserve(BLOCK_RECORDS);
+    sourcePorts.reserve(BLOCK_RECORDS);
+    destPorts.reserve(BLOCK_RECORDS);
+    protocols.reserve(BLOCK_RECORDS);
+    flags.reserve(BLOCK_RECORDS);
+    clear();
+}
+
+void BinaryLog::BlockBuilder::add(const PacketInfo& packet, int64_t timestampNanos, uint8_t recordFlags,
+                                  const char* reason, std::size_t reasonLength) {
+    timestamps.push_back(timestampNanos);
+    bool ipv6 = !packet.sourceAddr.isV4() || !packet.destAddr.isV4();
+    sourceAddrs.push_back(ipv6 ? 0 : packet.sourceAddr.v4());
+    destAddrs.push_back(ipv6 ? 0 : packet.destAddr.v4());
+    sizes.push_back(packet.packetSize);
+    sourcePorts.push_back(packet.sourcePort);
+    destPorts.push_back(packet.destPort);
+    protocols.push_back(packet.ipProtocol);
+    flags.push_back(ipv6 ? static_cast<uint8_t>(recordFlags | FLAG_IPV6) : recordFlags);
+    if (ipv6) {
+        char addresses[IPV6_HEAP_BYTES];
+        packet.sourceAddr.toBytes(reinterpret_cast<uint8_t*>(addresses));
+        packet.destAddr.toBytes(reinterpret_cast<uint8_t*>(addresses + 16));
+        heap.append(addresses, IPV6_HEAP_BYTES);
+    }
+    heap.append(reason, reasonLength);
+    reasonEnds.push_back(static_cast<uint32_t>(heap.size()));
+    minTimestamp = (std::min)(minTimestamp, timestampNanos);
+    maxTimestamp = (std::max)(maxTimestamp, timestampNanos);
+}
+
+void BinaryLog::BlockBuilder::clear() {
+    timestamps.clear();
+    sourceAddrs.clear();
+    destAddrs.clear();
+    sizes.clear();
+    reasonEnds.clear();
+    sourcePorts.clear();
+    destPorts.clear();
+    protocols.clear();
+    flags.clear();
+    heap.clear();
+    minTimestamp = std::numeric_limits<int64_t>::max();
+    maxTimestamp = std::numeric_limits<int64_t>::min();
+}
+
+std::size_t BinaryLog::BlockBuilder::encodedSize() const {
+    return align8(columnOffsets(size()).heap + heap.size());
+}
+
+void BinaryLog::BlockBuilder::encode(char* out) const {
+    uint32_t n = size();
+    ColumnOffsets o = columnOffsets(n);
+    std::size_t total = encodedSize();
+    std::memset(out, 0, total);
+
+    BlockHeader header;
+    header.magic = BLOCK_MAGIC;
+    header.recordCount = n;
+    header.minTimestamp = minTimestamp;
+    header.maxTimestamp = maxTimestamp;
+    header.heapBytes = static_cast<uint32_t>(heap.size());
+    header.blockBytes = static_cast<uint32_t>(total);
+    std::memcpy(out, &header, sizeof(header));
+
+    putColumn(out, o.timestamps, timestamps);
+    putColumn(out, o.sourceAddrs, sourceAddrs);
+    putColumn(out, o.destAddrs, destAddrs);
+    putColumn(out, o.sizes, sizes);
+    putColumn(out, o.reasonEnds, reasonEnds);
+    putColumn(out, o.sourcePorts, sourcePorts);
+    putColumn(out, o.destPorts, destPorts);
+    putColumn(out, o.protocols, protocols);
+    putColumn(out, o.flags, flags);
+    std::memcpy(out + o.heap, heap.data(), heap.size());
+}
+
+BinaryLog::Reader::Reader() : data(nullptr), length(0), offset(0) {
+#ifdef _WIN32
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+#endif
+}
+
+BinaryLog::Reader::~Reader() {
+    close();
+}
+
+bool BinaryLog::Reader::open(const std::string& path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error = "cannot open " + path;
+        return false;
+    }
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    length = static_cast<std::size_t>(size.QuadPart);
+    fileHandle = file;
+    if (length > 0) {
+        mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle != nullptr) {
+            data = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        }
+        if (data == nullptr) {
+            error = "cannot map " + path;
+            close();
+            return false;
+        }
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        error = "cannot stat " + path;
+        return false;
+    }
+    length = static_cast<std::size_t>(st.st_size);
+    if (length > 0) {
+        void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            length = 0;
+            error = "cannot map " + path;
+            return false;
+        }
+        madvise(mapped, length, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapped);
+    }
+    ::close(fd);
+#endif
+
+    FileHeader header;
+    if (length < sizeof(header)) {
+        error = path + " is not a Network 2.0 binary log";
+        close();
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.headerSize < sizeof(header)) {
+        error = path + " is not a Network 2.0 binary log";
+        close();
+        return false;
+    }
+    if (header.version < MIN_FORMAT_VERSION || header.version > FORMAT_VERSION) {
+        error = path + " has unsupported format version " + std::to_string(header.version);
+        close();
+        return false;
+    }
+    offset = header.headerSize;
+    error.clear();
+    return true;
+}
+
+void BinaryLog::Reader::close() {
+#ifdef _WIN32
+    if (data != nullptr) UnmapViewOfFile(data);
+    if (mappingHandle != nullptr) CloseHandle(mappingHandle);
+    if (fileHandle != nullptr) CloseHandle(fileHandle);
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    if (data != nullptr) munmap(const_cast<char*>(data), length);
+#endif
+    data = nullptr;
+    length = 0;
+    offset = 0;
+}
+
+void BinaryLog::Reader::rewind() {
+    if (data != nullptr) {
+        FileHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        offset = header.headerSize;
+    }
+}
+
+bool BinaryLog::Reader::next(BlockView& block) {
+    if (data == nullptr || offset + sizeof(BlockHeader) > length) return false;
+
+    const BlockHeader* header = reinterpret_cast<const BlockHeader*>(data + offset);
+    if (header->magic != BLOCK_MAGIC || header->blockBytes > length - offset ||
+        header->recordCount > BLOCK_RECORDS) {
+        return false;
+    }
+    ColumnOffsets o = columnOffsets(header->recordCount);
+    if (o.heap + header->heapBytes > header->blockBytes) return false;
+
+    const char* base = data + offset;
+    block.header = header;
+    block.timestamps = reinterpret_cast<const int64_t*>(base + o.timestamps);
+    block.sourceAddrs = reinterpret_cast<const uint32_t*>(base + o.sourceAddrs);
+    block.destAddrs = reinterpret_cast<const uint32_t*>(base + o.destAddrs);
+    block.sizes = reinterpret_cast<const uint32_t*>(base + o.sizes);
+    block.reasonEnds = reinterpret_cast<const uint32_t*>(base + o.reasonEnds);
+    block.sourcePorts = reinterpret_cast<const uint16_t*>(base + o.sourcePorts);
+    block.destPorts = reinterpret_cast<const uint16_t*>(base + o.destPorts);
+    block.protocols = reinterpret_cast<const uint8_t*>(base + o.protocols);
+    block.flags = reinterpret_cast<const uint8_t*>(base + o.flags);
+    block.heap = base + o.heap;
+
+    if (header->recordCount > 0 && block.reasonEnds[header->recordCount - 1] > header->heapBytes) {
+        return false;
+    }
+    offset += header->blockBytes;
+    return true;
+}
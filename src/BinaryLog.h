@@ -0,0 +1,156 @@
+#ifndef BINARY_LOG_H
+#define BINARY_LOG_H
+
+#include "PacketTypes.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Columnar binary packet log. A file is a FileHeader followed by blocks; each
+// block is a BlockHeader and up to BLOCK_RECORDS records stored column by
+// column, then a string heap holding the anomaly/alert reasons. Block headers
+// carry the time span of their records so readers can skip whole blocks.
+// Integers are little-endian and every column starts on an 8-byte boundary.
+//
+// Block layout after the header (n = recordCount):
+//   int64  timestampNanos[n]   (since the Unix epoch)
+//   uint32 sourceAddr[n], destAddr[n], packetSize[n]
+//   uint32 reasonEnd[n]        (end offset of each reason in the heap)
+//   uint16 sourcePort[n], destPort[n]
+//   uint8  ipProtocol[n], flags[n]
+//   char   heap[heapBytes]
+//
+// IPv4 addresses live in the uint32 columns. A record flagged FLAG_IPV6 has
+// zeros there instead; its source and destination addresses (16 bytes each,
+// network order) open its heap span, ahead of the reason. Version 1 files
+// predate IPv6 and are otherwise identical.
+namespace BinaryLog {
+    const char FILE_MAGIC[8] = {'N', '2', 'L', 'O', 'G', 0, 0, 0};
+    const uint32_t FORMAT_VERSION = 2;
+    const uint32_t MIN_FORMAT_VERSION = 1;
+    const uint32_t IPV6_HEAP_BYTES = 32;
+    const uint32_t BLOCK_MAGIC = 0x4B4C4232;  // "2BLK"
+    const uint32_t BLOCK_RECORDS = 4096;
+
+    enum RecordFlags : uint8_t {
+        FLAG_ANOMALY = 1,
+        FLAG_ALERT = 2,
+        FLAG_IPV6 = 4
+    };
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;
+    };
+
+    struct BlockHeader {
+        uint32_t magic;
+        uint32_t recordCount;
+        int64_t minTimestamp;
+        int64_t maxTimestamp;
+        uint32_t heapBytes;
+        uint32_t blockBytes;  // Header, columns and heap, padded to 8 bytes
+    };
+
+    // Accumulates records column-wise until sealed into a contiguous block.
+    class BlockBuilder {
+    private:
+        std::vector<int64_t> timestamps;
+        std::vector<uint32_t> sourceAddrs;
+        std::vector<uint32_t> destAddrs;
+        std::vector<uint32_t> sizes;
+        std::vector<uint32_t> reasonEnds;
+        std::vector<uint16_t> sourcePorts;
+        std::vector<uint16_t> destPorts;
+        std::vector<uint8_t> protocols;
+        std::vector<uint8_t> flags;
+        std::string heap;
+        int64_t minTimestamp;
+        int64_t maxTimestamp;
+
+    public:
+        BlockBuilder();
+
+        void add(const PacketInfo& packet, int64_t timestampNanos, uint8_t recordFlags, const char* reason,
+                 std::size_t reasonLength);
+        void clear();
+
+        uint32_t size() const { return static_cast<uint32_t>(timestamps.size()); }
+        bool empty() const { return timestamps.empty(); }
+        bool full() const { return timestamps.size() >= BLOCK_RECORDS; }
+        std::size_t encodedSize() const;
+
+        // Writes the block to `out`, which must hold encodedSize() bytes.
+        void encode(char* out) const;
+    };
+
+    // Read-only view of one block inside a mapped file.
+    struct BlockView {
+        const BlockHeader* header;
+        const int64_t* timestamps;
+        const uint32_t* sourceAddrs;
+        const uint32_t* destAddrs;
+        const uint32_t* sizes;
+        const uint32_t* reasonEnds;
+        const uint16_t* sourcePorts;
+        const uint16_t* destPorts;
+        const uint8_t* protocols;
+        const uint8_t* flags;
+        const char* heap;
+
+        std::string reason(uint32_t index) const {
+            uint32_t start = index == 0 ? 0 : reasonEnds[index - 1];
+            uint32_t end = reasonEnds[index];
+            if (flags[index] & FLAG_IPV6) start += IPV6_HEAP_BYTES;
+            if (start > end || end > header->heapBytes) return std::string();
+            return std::string(heap + start, end - start);
+        }
+
+        IpAddress sourceAddress(uint32_t index) const { return address(index, 0); }
+        IpAddress destAddress(uint32_t index) const { return address(index, 16); }
+
+    private:
+        IpAddress address(uint32_t index, uint32_t offset) const {
+            if (!(flags[index] & FLAG_IPV6)) {
+                return IpAddress::fromV4(offset == 0 ? sourceAddrs[index] : destAddrs[index]);
+            }
+            uint32_t start = index == 0 ? 0 : reasonEnds[index - 1];
+            if (start + IPV6_HEAP_BYTES > reasonEnds[index] || reasonEnds[index] > header->heapBytes) {
+                return IpAddress();
+            }
+            return IpAddress::fromBytes(reinterpret_cast<const uint8_t*>(heap + start + offset));
+        }
+    };
+
+    // Memory-maps a log file and walks its blocks. A trailing partial block
+    // (e.g. from a file still being written) ends iteration cleanly.
+    class Reader {
+    private:
+        const char* data;
+        std::size_t length;
+        std::size_t offset;
+        std::string error;
+#ifdef _WIN32
+        void* fileHandle;
+        void* mappingHandle;
+#endif
+
+    public:
+        Reader();
+        ~Reader();
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        bool open(const std::string& path);
+        void close();
+        bool next(BlockView& block);
+        void rewind();
+
+        const std::string& getError() const { return error; }
+        std::size_t fileSize() const { return length; }
+    };
+}
+
+#endif
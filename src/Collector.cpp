@@ -0,0 +1,396 @@
+#include "Collector.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+    const int64_t NANOS_PER_SECOND = 1000000000LL;
+    const std::size_t TALKER_COUNTERS = 1024;
+
+    int sensorCount(uint64_t bits) {
+        int count = 0;
+        for (; bits != 0; bits &= bits - 1) ++count;
+        return count;
+    }
+
+    // Sensor alerts carry the reason bits of the local detections; the
+    // first set bit in this order names the alert.
+    const char* localReason(uint8_t reasons) {
+        if (reasons & Summary::REASON_SCAN) return "Port scan detected";
+        if (reasons & Summary::REASON_FAILED) return "Multiple failed connections";
+        if (reasons & Summary::REASON_BURST) return "Packet burst detected";
+        return "Anomaly detected";
+    }
+}
+
+Collector::Collector(MemoryBudget& budget)
+    : listener(Socket::INVALID), sources(budget, "collector_sources"), talkers(TALKER_COUNTERS),
+      latestNanos(0), lastExpireSecond(0) {}
+
+Collector::~Collector() {
+    close();
+}
+
+bool Collector::listen(const std::string& listenEndpoint) {
+    close();
+    std::string error;
+    if (Socket::isUnixPath(listenEndpoint)) {
+        listener = Socket::listenUnix(listenEndpoint, error);
+        if (listener != Socket::INVALID) {
+            unixPath = listenEndpoint;
+        }
+    } else {
+        std::string host;
+        uint16_t port = 0;
+        if (Socket::parseHostPort(listenEndpoint, "127.0.0.1", host, port)) {
+            listener = Socket::listenTcp(host, port, error);
+        } else {
+            error = "expected [host:]port or a socket path: " + listenEndpoint;
+        }
+    }
+    if (listener == Socket::INVALID) {
+        std::cout << Utils::Colors::RED << "Collector cannot listen: " << error << Utils::Colors::RESET << std::endl;
+        return false;
+    }
+    endpoint = listenEndpoint;
+    std::cout << Utils::Colors::GREEN << "Collecting sensor summaries on " << endpoint << Utils::Colors::RESET << std::endl;
+    return true;
+}
+
+void Collector::close() {
+    while (!connections.empty()) {
+        disconnect(connections.size() - 1);
+    }
+    if (listener != Socket::INVALID) {
+        Socket::close(listener);
+        listener = Socket::INVALID;
+    }
+    if (!unixPath.empty()) {
+        std::remove(unixPath.c_str());
+        unixPath.clear();
+    }
+}
+
+void Collector::poll(int timeoutMs) {
+    if (listener == Socket::INVALID) return;
+
+    std::vector<Socket::Handle> handles;
+    handles.reserve(connections.size() + 1);
+    handles.push_back(listener);
+    for (const Connection& connection : connections) {
+        handles.push_back(connection.socket);
+    }
+    std::vector<uint8_t> ready;
+    if (Socket::waitReadable(handles, ready, timeoutMs)) {
+        // Backwards, so a disconnect only moves connections already visited.
+        for (std::size_t i = connections.size(); i-- > 0;) {
+            if (ready[i + 1] && !readConnection(connections[i])) {
+                disconnect(i);
+            }
+        }
+        if (ready[0]) {
+            acceptConnection();
+        }
+    }
+    expire();
+}
+
+void Collector::acceptConnection() {
+    Socket::Handle socket = Socket::accept(listener);
+    if (socket == Socket::INVALID) return;
+    if (connections.size() >= MAX_CONNECTIONS) {
+        Socket::close(socket);
+        return;
+    }
+    Connection connection;
+    connection.socket = socket;
+    connections.push_back(connection);
+}
+
+void Collector::disconnect(std::size_t index) {
+    Connection& connection = connections[index];
+    Socket::close(connection.socket);
+    if (connection.sensor >= 0) {
+        Sensor& sensor = sensors[static_cast<std::size_t>(connection.sensor)];
+        if (--sensor.connections == 0) {
+            connectedSensors.set(connectedSensors.get() - 1);
+            std::cout << Utils::Colors::YELLOW << "Sensor '" << sensor.name << "' disconnected"
+                      << Utils::Colors::RESET << std::endl;
+        }
+    }
+    connections.erase(connections.begin() + static_cast<std::ptrdiff_t>(index));
+}
+
+// Reads what is available and handles every complete frame. False closes
+// the connection: the sensor went away or sent something malformed.
+bool Collector::readConnection(Connection& connection) {
+    char chunk[READ_CHUNK];
+    long received = Socket::receive(connection.socket, chunk, sizeof(chunk));
+    if (received <= 0) return false;
+    bytesReceived.add(static_cast<uint64_t>(received));
+    connection.buffer.append(chunk, static_cast<std::size_t>(received));
+
+    std::size_t offset = 0;
+    while (true) {
+        const char* data = connection.buffer.data() + offset;
+        std::size_t available = connection.buffer.size() - offset;
+        std::size_t length = Summary::frameLength(data, available);
+        if (length == Summary::INVALID_FRAME) {
+            malformedFrames.increment();
+            return false;
+        }
+        if (length == 0 || available < length) break;
+        if (!handleFrame(connection, data, length)) return false;
+        offset += length;
+    }
+    connection.buffer.erase(0, offset);
+    return true;
+}
+
+bool Collector::handleFrame(Connection& connection, const char* data, std::size_t size) {
+    if (!summary.decode(data, size)) {
+        malformedFrames.increment();
+        return false;
+    }
+    if (connection.sensor < 0 || sensors[static_cast<std::size_t>(connection.sensor)].name != summary.sensor) {
+        int index = sensorIndex(summary.sensor);
+        if (index < 0) {
+            std::cout << Utils::Colors::RED << "Refusing sensor '" << summary.sensor << "': already "
+                      << MAX_SENSORS << " sensors" << Utils::Colors::RESET << std::endl;
+            return false;
+        }
+        if (connection.sensor >= 0 && --sensors[static_cast<std::size_t>(connection.sensor)].connections == 0) {
+            connectedSensors.set(connectedSensors.get() - 1);
+        }
+        connection.sensor = index;
+        Sensor& sensor = sensors[static_cast<std::size_t>(index)];
+        if (sensor.connections++ == 0) {
+            connectedSensors.increment();
+            std::cout << Utils::Colors::GREEN << "Sensor '" << sensor.name << "' connected"
+                      << Utils::Colors::RESET << std::endl;
+        }
+    }
+    merge(connection.sensor);
+    return true;
+}
+
+// Sensors are identified by name, so a sensor that reconnects keeps its
+// place in the source windows. -1 once MAX_SENSORS names are known.
+int Collector::sensorIndex(const std::string& name) {
+    for (std::size_t i = 0; i < sensors.size(); ++i) {
+        if (sensors[i].name == name) return static_cast<int>(i);
+    }
+    if (sensors.size() >= MAX_SENSORS) return -1;
+    Sensor sensor;
+    sensor.name = name;
+    sensors.push_back(sensor);
+    return static_cast<int>(sensors.size() - 1);
+}
+
+void Collector::merge(int index) {
+    Sensor& sensor = sensors[static_cast<std::size_t>(index)];
+    sensor.summaries++;
+    sensor.packets += summary.packets;
+    sensor.bytes += summary.bytes;
+    sensor.anomalies += summary.anomalies;
+    sensor.lastNanos = (std::max)(sensor.lastNanos, summary.endNanos);
+    summariesReceived.increment();
+    totalPackets.add(summary.packets);
+    totalBytes.add(summary.bytes);
+    totalAnomalies.add(summary.anomalies);
+    latestNanos = (std::max)(latestNanos, summary.endNanos);
+
+    for (const Summary::Talker& talker : summary.talkers) {
+        talkers.add(talker.address, talker.packets);
+    }
+
+    uint64_t bit = 1ULL << index;
+    for (const Summary::Source& source : summary.sources) {
+        SourceState* state = sources.acquire(source.address);
+        if (state != nullptr) {
+            mergeSource(source, *state, bit);
+        }
+
+        // Without a merged window (the table is full) detections are passed
+        // on every time, as are anomalies of no known reason.
+        uint8_t fresh = state != nullptr ? static_cast<uint8_t>(source.reasons & ~state->reported) : source.reasons;
+        if (source.anomalies > 0 && (fresh != 0 || source.reasons == 0)) {
+            Alert alert;
+            alert.nanos = summary.endNanos;
+            alert.kind = "sensor";
+            alert.reason = localReason(fresh);
+            alert.source = source.address;
+            alert.sensors.push_back(sensor.name);
+            alert.count = source.anomalies;
+            sensorAlerts.increment();
+            if (onAlert) onAlert(alert);
+        }
+        if (state != nullptr) {
+            state->reported |= source.reasons;
+            check(source.address, *state, summary.endNanos);
+        }
+    }
+}
+
+// Adds one sensor's view of a source to its merged windows. A window that
+// restarts also forgets which reasons were detected locally in it.
+void Collector::mergeSource(const Summary::Source& source, SourceState& state, uint64_t sensorBit) {
+    state.lastNanos = (std::max)(state.lastNanos, summary.endNanos);
+
+    // Packets land in the interval's last second, in the same ring of
+    // per-second counts the detector uses. Summaries may arrive out of
+    // order, so an older second still inside the window is added in place.
+    int64_t second = (summary.endNanos - 1) / NANOS_PER_SECOND;
+    if (second > state.lastSecond) {
+        if (second - state.lastSecond >= SourceState::BURST_SLOTS) {
+            std::fill(state.counts, state.counts + SourceState::BURST_SLOTS, 0u);
+            state.burstSensors = 0;
+            state.reported &= static_cast<uint8_t>(~Summary::REASON_BURST);
+        } else {
+            for (int64_t s = state.lastSecond + 1; s <= second; ++s) {
+                state.counts[s % SourceState::BURST_SLOTS] = 0;
+            }
+        }
+        state.lastSecond = second;
+    }
+    if (state.lastSecond - second < SourceState::BURST_SLOTS) {
+        state.counts[second % SourceState::BURST_SLOTS] += source.packets;
+        state.burstSensors |= sensorBit;
+    }
+
+    int64_t startSecond = summary.startNanos / NANOS_PER_SECOND;
+    if (!source.ports.isEmpty()) {
+        if (state.scanStart == 0 || startSecond - state.scanStart > AnomalyDetector::SCAN_WINDOW_SECONDS) {
+            state.scanStart = startSecond;
+            state.ports = DistinctSketch();
+            state.scanRate = 1;
+            state.scanSensors = 0;
+            state.scanAlerted = false;
+            state.reported &= static_cast<uint8_t>(~Summary::REASON_SCAN);
+        }
+        state.ports.merge(source.ports);
+        state.scanRate = (std::max)(state.scanRate, summary.sampleRate);
+        state.scanSensors |= sensorBit;
+    }
+
+    if (source.smallTcp > 0) {
+        if (state.failStart == 0 || startSecond - state.failStart > AnomalyDetector::FAILED_WINDOW_SECONDS) {
+            state.failStart = startSecond;
+            state.smallTcp = 0;
+            state.failSensors = 0;
+            state.failAlerted = false;
+            state.reported &= static_cast<uint8_t>(~Summary::REASON_FAILED);
+        }
+        state.smallTcp += source.smallTcp;
+        state.failSensors |= sensorBit;
+    }
+}
+
+void Collector::check(const IpAddress& address, SourceState& state, int64_t nanos) {
+    uint64_t packets = 0;
+    for (uint32_t count : state.counts) packets += count;
+    if (packets > AnomalyDetector::BURST_THRESHOLD && sensorCount(state.burstSensors) > 1 &&
+        !(state.reported & Summary::REASON_BURST) &&
+        state.lastSecond - state.burstAlertSecond > AnomalyDetector::BURST_WINDOW_SECONDS) {
+        raise("Distributed packet burst", address, state.burstSensors, packets, nanos);
+        state.burstAlertSecond = state.lastSecond;
+    }
+
+    double ports = state.ports.estimate() * state.scanRate;
+    if (!state.scanAlerted && !(state.reported & Summary::REASON_SCAN) && !state.ports.isEmpty() &&
+        ports > AnomalyDetector::SCAN_THRESHOLD && sensorCount(state.scanSensors) > 1) {
+        raise("Distributed port scan", address, state.scanSensors, static_cast<uint64_t>(std::lround(ports)), nanos);
+        state.scanAlerted = true;
+    }
+
+    if (!state.failAlerted && !(state.reported & Summary::REASON_FAILED) &&
+        state.smallTcp > static_cast<uint32_t>(AnomalyDetector::FAILED_THRESHOLD) && sensorCount(state.failSensors) > 1) {
+        raise("Distributed failed connections", address, state.failSensors, state.smallTcp, nanos);
+        state.failAlerted = true;
+    }
+}
+
+void Collector::raise(const char* reason, const IpAddress& address, uint64_t sensorBits, uint64_t count, int64_t nanos) {
+    Alert alert;
+    alert.nanos = nanos;
+    alert.kind = "global";
+    alert.reason = reason;
+    alert.source = address;
+    alert.count = count;
+    for (std::size_t i = 0; i < sensors.size(); ++i) {
+        if (sensorBits & (1ULL << i)) alert.sensors.push_back(sensors[i].name);
+    }
+    globalAlerts.increment();
+    if (onAlert) onAlert(alert);
+}
+
+// Sources whose newest summary is older than the longest window are freed,
+// at most once per second of capture time.
+void Collector::expire() {
+    int64_t second = latestNanos / NANOS_PER_SECOND;
+    if (second == lastExpireSecond) return;
+    lastExpireSecond = second;
+    int64_t horizon = latestNanos - static_cast<int64_t>(AnomalyDetector::FAILED_WINDOW_SECONDS) * NANOS_PER_SECOND;
+    sources.expire([horizon](const SourceState& state) { return state.lastNanos < horizon; });
+    trackedSources.set(sources.size());
+}
+
+void Collector::printStatus(std::size_t topTalkers) const {
+    std::cout << Utils::Colors::BOLD << "\n=== Collector (" << endpoint << ") ===" << Utils::Colors::RESET << std::endl;
+    std::cout << "Sensors: " << connectedSensors.get() << " connected, " << sensors.size() << " known; "
+              << summariesReceived.get() << " summaries (" << Utils::formatBytes(bytesReceived.get()) << "), "
+              << malformedFrames.get() << " malformed" << std::endl;
+    for (const Sensor& sensor : sensors) {
+        std::cout << "  " << std::left << std::setw(20) << sensor.name << std::right
+                  << (sensor.connections > 0 ? "connected    " : "disconnected ")
+                  << std::setw(8) << sensor.summaries << " summaries " << std::setw(12) << sensor.packets
+                  << " packets " << std::setw(10) << Utils::formatBytes(sensor.bytes) << std::endl;
+    }
+    std::cout << "Merged: " << totalPackets.get() << " packets, " << Utils::formatBytes(totalBytes.get()) << ", "
+              << totalAnomalies.get() << " flagged by sensors; " << sources.size() << " sources tracked" << std::endl;
+    std::cout << "Alerts: " << globalAlerts.get() << " global, " << sensorAlerts.get() << " from sensors" << std::endl;
+
+    std::vector<SpaceSaving<IpAddress, IpAddress::Hash>::Entry> top = talkers.top(topTalkers);
+    if (!top.empty()) {
+        std::cout << "Top talkers across sensors:" << std::endl;
+        for (std::size_t i = 0; i < top.size(); ++i) {
+            std::cout << std::setw(4) << i + 1 << ". " << std::left << std::setw(40) << top[i].key.toString()
+                      << std::right << std::setw(12) << top[i].count << " packets";
+            if (top[i].error > 0) {
+                std::cout << " (+/- " << top[i].error << ")";
+            }
+            std::cout << std::endl;
+        }
+    }
+}
+
+void Collector::writeMetrics(std::ostream& out) const {
+    out << "# HELP network2_collector_sensors_connected Sensors with an open connection to the collector.\n"
+        << "# TYPE network2_collector_sensors_connected gauge\n"
+        << "network2_collector_sensors_connected " << connectedSensors.get() << "\n"
+        << "# HELP network2_collector_summaries_total Sensor summaries merged.\n"
+        << "# TYPE network2_collector_summaries_total counter\n"
+        << "network2_collector_summaries_total " << summariesReceived.get() << "\n"
+        << "# HELP network2_collector_received_bytes_total Bytes received from sensors.\n"
+        << "# TYPE network2_collector_received_bytes_total counter\n"
+        << "network2_collector_received_bytes_total " << bytesReceived.get() << "\n"
+        << "# HELP network2_collector_malformed_frames_total Frames that failed to decode; the connection is closed.\n"
+        << "# TYPE network2_collector_malformed_frames_total counter\n"
+        << "network2_collector_malformed_frames_total " << malformedFrames.get() << "\n"
+        << "# HELP network2_collector_packets_total Packets seen by all sensors.\n"
+        << "# TYPE network2_collector_packets_total counter\n"
+        << "network2_collector_packets_total " << totalPackets.get() << "\n"
+        << "# HELP network2_collector_bytes_total Bytes seen by all sensors.\n"
+        << "# TYPE network2_collector_bytes_total counter\n"
+        << "network2_collector_bytes_total " << totalBytes.get() << "\n"
+        << "# HELP network2_collector_sources Sources with merged windows.\n"
+        << "# TYPE network2_collector_sources gauge\n"
+        << "network2_collector_sources " << trackedSources.get() << "\n"
+        << "# HELP network2_collector_alerts_total Alerts raised on merged windows (global) or passed on from sensors.\n"
+        << "# TYPE network2_collector_alerts_total counter\n"
+        << "network2_collector_alerts_total{kind=\"global\"} " << globalAlerts.get() << "\n"
+        << "network2_collector_alerts_total{kind=\"sensor\"} " << sensorAlerts.get() << "\n";
+}
@@ -0,0 +1,148 @@
+#ifndef COLLECTOR_H
+#define COLLECTOR_H
+
+#include "Summary.h"
+#include "Socket.h"
+#include "AnomalyDetector.h"
+#include "TrackerTable.h"
+#include "TopK.h"
+#include "Counters.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Collector side of multi-sensor aggregation. Accepts summaries from any
+// number of sensors over TCP or a Unix socket and merges them per source:
+// packet counts add up, distinct-port sketches are ORed and talkers feed a
+// Space-Saving summary. The detector's heuristics then run on the merged
+// state with the same thresholds and windows, keyed on the summaries'
+// capture time, so a scan or flood spread over several segments is caught
+// even when no single sensor sees enough of it.
+//
+// A merged window only raises a "global" alert when more than one sensor
+// contributed to it and none of them detected it alone; local detections are
+// passed on as "sensor" alerts, once per source, reason and window.
+//
+// Everything runs on the thread that calls poll(); the counters may be read
+// from others.
+class Collector {
+public:
+    struct Alert {
+        int64_t nanos = 0;
+        const char* kind = "global";      // "global" or "sensor"
+        const char* reason = "";
+        IpAddress source;
+        std::vector<std::string> sensors;  // Contributing sensors, or the reporting one
+        uint64_t count = 0;                // Packets, estimated ports or small TCP packets
+    };
+
+    static constexpr std::size_t MAX_SENSORS = 64;
+    static constexpr std::size_t MAX_CONNECTIONS = 256;
+    static constexpr std::size_t READ_CHUNK = 65536;
+
+private:
+    struct Connection {
+        Socket::Handle socket;
+        std::string buffer;
+        int sensor = -1;
+    };
+
+    struct Sensor {
+        std::string name;
+        int connections = 0;
+        uint64_t summaries = 0;
+        uint64_t packets = 0;
+        uint64_t bytes = 0;
+        uint64_t anomalies = 0;
+        int64_t lastNanos = 0;
+    };
+
+    // Merged windows for one source. Each window starts with the first
+    // summary that contributes to it and remembers which sensors did.
+    struct SourceState {
+        static const int BURST_SLOTS = AnomalyDetector::BURST_WINDOW_SECONDS + 1;
+
+        int64_t lastSecond = 0;
+        uint32_t counts[BURST_SLOTS] = {};
+        uint64_t burstSensors = 0;
+        int64_t burstAlertSecond = 0;
+
+        int64_t scanStart = 0;
+        DistinctSketch ports;
+        uint32_t scanRate = 1;     // Highest sampling rate among the merged sketches
+        uint64_t scanSensors = 0;
+        bool scanAlerted = false;
+
+        int64_t failStart = 0;
+        uint32_t smallTcp = 0;
+        uint64_t failSensors = 0;
+        bool failAlerted = false;
+
+        uint8_t reported = 0;      // Summary::Reason bits a sensor already detected in the open windows
+        int64_t lastNanos = 0;
+    };
+
+    Socket::Handle listener;
+    std::string endpoint;
+    std::string unixPath;
+    std::vector<Connection> connections;
+    std::vector<Sensor> sensors;
+    TrackerTable<SourceState> sources;
+    SpaceSaving<IpAddress, IpAddress::Hash> talkers;
+    Summary summary;          // Reused for decoding
+    int64_t latestNanos;
+    int64_t lastExpireSecond;
+
+    SingleWriterCounter summariesReceived;
+    SingleWriterCounter bytesReceived;
+    SingleWriterCounter malformedFrames;
+    SingleWriterCounter connectedSensors;
+    SingleWriterCounter totalPackets;
+    SingleWriterCounter totalBytes;
+    SingleWriterCounter totalAnomalies;
+    SingleWriterCounter globalAlerts;
+    SingleWriterCounter sensorAlerts;
+    SingleWriterCounter trackedSources;
+
+    void acceptConnection();
+    bool readConnection(Connection& connection);
+    bool handleFrame(Connection& connection, const char* data, std::size_t size);
+    void disconnect(std::size_t index);
+    int sensorIndex(const std::string& name);
+    void merge(int sensor);
+    void mergeSource(const Summary::Source& source, SourceState& state, uint64_t sensorBit);
+    void check(const IpAddress& address, SourceState& state, int64_t nanos);
+    void raise(const char* reason, const IpAddress& address, uint64_t sensorBits, uint64_t count, int64_t nanos);
+    void expire();
+
+public:
+    // Source state is charged to `budget`, which must outlive the collector.
+    explicit Collector(MemoryBudget& budget);
+    ~Collector();
+
+    // "[host:]port" (host defaults to 127.0.0.1) or a Unix socket path.
+    bool listen(const std::string& listenEndpoint);
+    void close();
+
+    // Accepts sensors and merges whatever has arrived, waiting up to
+    // `timeoutMs` for something to do.
+    void poll(int timeoutMs);
+
+    std::function<void(const Alert&)> onAlert;
+
+    uint64_t getPackets() const { return totalPackets.get(); }
+    uint64_t getBytes() const { return totalBytes.get(); }
+    uint64_t getAnomalies() const { return totalAnomalies.get(); }
+    uint64_t getConnectedSensors() const { return connectedSensors.get(); }
+
+    // Poll thread only.
+    void printStatus(std::size_t topTalkers) const;
+
+    // Reads only counters, so it is safe from the metrics thread.
+    void writeMetrics(std::ostream& out) const;
+};
+
+#endif
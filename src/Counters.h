@@ -0,0 +1,55 @@
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+static const std::size_t CACHE_LINE_SIZE = 64;
+
+// Counter owned by exactly one writing thread. The update is a relaxed
+// load/add/store (a plain add on x86, no locked instruction), while any other
+// thread may read the current value at any time without tearing.
+class SingleWriterCounter {
+private:
+    std::atomic<uint64_t> value{0};
+
+public:
+    void add(uint64_t amount) {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+    void increment() { add(1); }
+    void set(uint64_t newValue) { value.store(newValue, std::memory_order_relaxed); }
+    uint64_t get() const { return value.load(std::memory_order_relaxed); }
+};
+
+// Sequence lock for a single writer. Readers retry while a write is in
+// progress or if one completed during their read, which gives them a
+// consistent view of a group of SingleWriterCounters without ever blocking
+// the writer.
+class SeqLock {
+private:
+    std::atomic<uint32_t> sequence{0};
+
+public:
+    void beginWrite() {
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+    void endWrite() {
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    uint32_t beginRead() const {
+        uint32_t seq;
+        while ((seq = sequence.load(std::memory_order_acquire)) & 1u) {
+        }
+        return seq;
+    }
+    bool retryRead(uint32_t seq) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return sequence.load(std::memory_order_relaxed) != seq;
+    }
+};
+
+#endif
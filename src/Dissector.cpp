@@ -0,0 +1,209 @@
+#include "Dissector.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    const uint8_t PROTO_TCP = 6;
+    const uint8_t PROTO_UDP = 17;
+
+    inline uint16_t load16(const uint8_t* p) {
+        return static_cast<uint16_t>(p[0] << 8 | p[1]);
+    }
+
+    const char* const HTTP_METHODS[] = {"GET ", "POST ", "HEAD ", "PUT ", "DELETE ", "OPTIONS ", "PATCH ", "CONNECT "};
+
+    bool isHttpRequest(const uint8_t* data, uint32_t length) {
+        for (const char* method : HTTP_METHODS) {
+            std::size_t size = std::strlen(method);
+            if (length >= size && std::memcmp(data, method, size) == 0) return true;
+        }
+        return false;
+    }
+
+    inline bool isHostHeader(const uint8_t* line) {
+        return (line[0] | 0x20) == 'h' && (line[1] | 0x20) == 'o' && (line[2] | 0x20) == 's' &&
+               (line[3] | 0x20) == 't' && line[4] == ':';
+    }
+}
+
+Dissector::Dissector() {
+    ports.fill(0);
+    for (uint16_t port : {53, 5353, 5355}) setPort(AppLayer::DNS, port);
+    for (uint16_t port : {80, 8000, 8080}) setPort(AppLayer::HTTP, port);
+    for (uint16_t port : {443, 465, 853, 993, 995, 8443}) setPort(AppLayer::TLS, port);
+    setPort(AppLayer::QUIC, 443);
+}
+
+void Dissector::setPort(AppLayer::Protocol protocol, uint16_t port) {
+    uint8_t& entry = ports[port];
+    switch (protocol) {
+        case AppLayer::DNS:
+            entry = static_cast<uint8_t>(AppLayer::DNS << 4 | AppLayer::DNS);
+            break;
+        case AppLayer::HTTP:
+        case AppLayer::TLS:
+            entry = static_cast<uint8_t>((entry & 0xF0) | protocol);
+            break;
+        case AppLayer::QUIC:
+            entry = static_cast<uint8_t>((entry & 0x0F) | protocol << 4);
+            break;
+        default:
+            entry = 0;
+            break;
+    }
+}
+
+AppLayer::Protocol Dissector::lookup(uint8_t ipProtocol, uint16_t port) const {
+    int shift = ipProtocol == PROTO_UDP ? 4 : 0;
+    return static_cast<AppLayer::Protocol>(ports[port] >> shift & 0x0F);
+}
+
+bool Dissector::dissect(const ParsedPacket& packet, AppLayer& out) const {
+    if (!packet.hasPorts || packet.payloadLength == 0) return false;
+    if (packet.ipProtocol != PROTO_TCP && packet.ipProtocol != PROTO_UDP) return false;
+
+    AppLayer::Protocol protocol = lookup(packet.ipProtocol, packet.destPort);
+    if (protocol == AppLayer::NONE) {
+        protocol = lookup(packet.ipProtocol, packet.sourcePort);
+        if (protocol == AppLayer::NONE) return false;
+    }
+
+    out.protocol = protocol;
+    const uint8_t* data = packet.payload;
+    uint32_t length = packet.payloadLength;
+    switch (protocol) {
+        case AppLayer::DNS:
+            // DNS over TCP prefixes each message with its length.
+            if (packet.ipProtocol == PROTO_TCP) {
+                if (length <= 2) break;
+                data += 2;
+                length -= 2;
+            }
+            dissectDns(data, length, out);
+            break;
+        case AppLayer::HTTP:
+            dissectHttp(data, length, out);
+            break;
+        case AppLayer::TLS:
+            dissectTls(data, length, out);
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+
+// Only the first question is read. Compression pointers cannot appear in
+// it, so one is treated as malformed rather than followed. The labels are
+// joined in a stack buffer before DomainName keeps what fits.
+void Dissector::dissectDns(const uint8_t* data, uint32_t length, AppLayer& out) {
+    if (length < 12) return;
+    out.dnsResponse = (data[2] & 0x80) != 0;
+    if (out.dnsResponse) {
+        out.dnsRcode = data[3] & 0x0F;
+    }
+    if (load16(data + 4) == 0) return;
+
+    uint8_t name[DomainName::MAX_WIRE_LENGTH + 1];
+    std::size_t size = 0;
+    uint32_t pos = 12;
+    while (pos < length) {
+        uint8_t label = data[pos];
+        if (label == 0) {
+            if (size > 0) out.name.assign(name, size - 1);
+            return;
+        }
+        if ((label & 0xC0) != 0 || label > length - pos - 1 || size + label + 1 > sizeof(name)) return;
+        std::memcpy(name + size, data + pos + 1, label);
+        size += label;
+        name[size++] = '.';
+        pos += 1 + label;
+    }
+}
+
+// Requests only. The header block is scanned a line at a time with memchr
+// up to MAX_HTTP_HEADER_BYTES; a Host value cut off by the capture is
+// dropped rather than reported in part.
+void Dissector::dissectHttp(const uint8_t* data, uint32_t length, AppLayer& out) {
+    if (!isHttpRequest(data, length)) return;
+
+    const uint8_t* limit = data + (std::min)(length, MAX_HTTP_HEADER_BYTES);
+    const uint8_t* line = static_cast<const uint8_t*>(std::memchr(data, '\n', limit - data));
+    while (line != nullptr && ++line < limit) {
+        if (*line == '\r' || *line == '\n') return;
+        if (limit - line > 5 && isHostHeader(line)) {
+            const uint8_t* value = line + 5;
+            while (value < limit && (*value == ' ' || *value == '\t')) ++value;
+            const uint8_t* end = value;
+            if (end < limit && *end == '[') {
+                while (end < limit && *end != ']' && *end != '\r' && *end != '\n') ++end;
+                if (end < limit && *end == ']') ++end;
+            } else {
+                while (end < limit && *end != ':' && *end != '\r' && *end != '\n' && *end != ' ' && *end != '\t') ++end;
+            }
+            if (end == limit || end == value) return;
+            if (end[-1] == '.') --end;
+            out.name.assign(value, end - value);
+            return;
+        }
+        line = static_cast<const uint8_t*>(std::memchr(line, '\n', limit - line));
+    }
+}
+
+// Walks a ClientHello in the first record of the segment to the
+// server_name extension. Anything that does not fit the layout, or runs
+// past the captured bytes, leaves the name empty.
+void Dissector::dissectTls(const uint8_t* data, uint32_t length, AppLayer& out) {
+    // Record type handshake, version 3.x, handshake type client_hello.
+    if (length < 9 || data[0] != 22 || data[1] != 3 || data[5] != 1) return;
+
+    uint32_t pos = 9 + 2 + 32;  // Record and handshake headers, client version, random
+    if (pos >= length) return;
+    pos += 1 + data[pos];              // Session ID
+    if (pos + 2 > length) return;
+    pos += 2 + load16(data + pos);     // Cipher suites
+    if (pos >= length) return;
+    pos += 1 + data[pos];              // Compression methods
+    if (pos + 2 > length) return;
+    uint32_t end = (std::min)(length, pos + 2 + load16(data + pos));
+    pos += 2;
+
+    while (pos + 4 <= end) {
+        uint16_t type = load16(data + pos);
+        uint16_t size = load16(data + pos + 2);
+        pos += 4;
+        if (type == 0) {
+            // server_name_list length, then the first entry: type host_name and a length.
+            if (pos + 5 > end || data[pos + 2] != 0) return;
+            uint16_t nameLength = load16(data + pos + 3);
+            if (nameLength == 0 || nameLength > end - pos - 5) return;
+            out.name.assign(data + pos + 5, nameLength);
+            return;
+        }
+        pos += size;
+    }
+}
+
+bool Dissector::parseProtocol(const std::string& name, AppLayer::Protocol& protocol) {
+    std::string upper = Utils::toUpperCase(name);
+    if (upper == "NONE") {
+        protocol = AppLayer::NONE;
+        return true;
+    }
+    for (int i = AppLayer::NONE + 1; i < AppLayer::PROTOCOL_COUNT; ++i) {
+        if (upper == AppLayer::protocolName(static_cast<AppLayer::Protocol>(i))) {
+            protocol = static_cast<AppLayer::Protocol>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* Dissector::rcodeName(uint8_t rcode) {
+    static const char* const NAMES[16] = {
+        "NOERROR", "FORMERR", "SERVFAIL", "NXDOMAIN", "NOTIMP", "REFUSED", "YXDOMAIN", "YXRRSET",
+        "NXRRSET", "NOTAUTH", "NOTZONE", "DSOTYPENI", "RCODE12", "RCODE13", "RCODE14", "RCODE15"
+    };
+    return NAMES[rcode & 0x0F];
+}
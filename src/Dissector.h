@@ -0,0 +1,55 @@
+#ifndef DISSECTOR_H
+#define DISSECTOR_H
+
+#include "PacketParser.h"
+#include "PacketTypes.h"
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Application-layer classification of parsed packets. A port-indexed table
+// picks the protocol (destination port first, then source port), and a
+// bounded dissector reads the payload in place:
+//   DNS   query name, and the response code of responses (TCP or UDP)
+//   HTTP  Host header of requests
+//   TLS   server name (SNI) of a ClientHello
+//   QUIC  classified only: the Initial packet that carries the SNI is
+//         encrypted
+// Every read is checked against the captured payload, truncated packets
+// yield what was captured, and nothing allocates. Packets without payload
+// (handshakes, pure ACKs) are not classified.
+class Dissector {
+public:
+    // How far into a request the HTTP dissector looks for the Host header.
+    static constexpr uint32_t MAX_HTTP_HEADER_BYTES = 2048;
+
+private:
+    // Per port: the protocol on TCP in the low nibble and on UDP in the high
+    // nibble, so a lookup touches one byte.
+    std::array<uint8_t, 65536> ports;
+
+    static void dissectDns(const uint8_t* data, uint32_t length, AppLayer& out);
+    static void dissectHttp(const uint8_t* data, uint32_t length, AppLayer& out);
+    static void dissectTls(const uint8_t* data, uint32_t length, AppLayer& out);
+
+public:
+    // Starts with the well-known ports: DNS on 53, 5353 and 5355; HTTP on
+    // 80, 8000 and 8080; TLS on 443, 465, 853, 993, 995 and 8443; QUIC on
+    // UDP 443.
+    Dissector();
+
+    // Maps a port to a protocol on the transport it runs over: DNS on TCP
+    // and UDP, HTTP and TLS on TCP, QUIC on UDP. NONE clears the port.
+    void setPort(AppLayer::Protocol protocol, uint16_t port);
+    AppLayer::Protocol lookup(uint8_t ipProtocol, uint16_t port) const;
+
+    // Fills `out` and returns true when the packet is on a mapped port and
+    // has payload. `out` must be freshly constructed.
+    bool dissect(const ParsedPacket& packet, AppLayer& out) const;
+
+    // "dns", "http", "tls", "quic" or "none" (case-insensitive).
+    static bool parseProtocol(const std::string& name, AppLayer::Protocol& protocol);
+    static const char* rcodeName(uint8_t rcode);
+};
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef DOMAIN_NAME_H
+#define DOMAIN_NAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// A host name taken from a DNS question, an HTTP Host header or a TLS SNI
+// extension: lowercase and without a trailing dot. Fixed-size so that
+// PacketInfo can carry one and the statistics can key a summary on it
+// without allocating.
+//
+// The buffer is short, because PacketInfo is copied through the queue once
+// per packet. A longer name keeps only the parent domain that fits and is
+// marked truncated ("*.tunnel.example.com"), which still matches watch
+// rules for that domain and its parents and groups long generated labels
+// under their zone.
+//
+// Names are hashed from the last character backwards, so the hash of every
+// parent domain ("b.c" and "c" for "a.b.c") falls out of one pass over the
+// name; see forEachSuffix().
+class DomainName {
+public:
+    static const std::size_t MAX_LENGTH = 44;
+    static const std::size_t MAX_WIRE_LENGTH = 253;  // Longest name DNS allows
+
+    struct Hash {
+        std::size_t operator()(const DomainName& name) const { return static_cast<std::size_t>(name.hash()); }
+    };
+
+private:
+    static const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+    static const uint64_t FNV_PRIME = 1099511628211ULL;
+
+    uint8_t length;
+    bool truncated;
+    char text[MAX_LENGTH];
+
+public:
+    DomainName() : length(0), truncated(false) {}
+    // Copies only the bytes in use; most packets carry no name.
+    DomainName(const DomainName& other) : length(other.length), truncated(other.truncated) {
+        std::memcpy(text, other.text, length);
+    }
+    DomainName& operator=(const DomainName& other) {
+        length = other.length;
+        truncated = other.truncated;
+        std::memmove(text, other.text, length);
+        return *this;
+    }
+
+    // Normalises a name given by the user ("Example.COM.", "*.example.com");
+    // false if it is empty, longer than MAX_LENGTH or contains anything but
+    // letters, digits, '-', '_' and dots between labels.
+    static bool parse(const std::string& input, DomainName& out) {
+        std::string name = input;
+        if (name.size() > 2 && name.compare(0, 2, "*.") == 0) name.erase(0, 2);
+        if (!name.empty() && name.back() == '.') name.pop_back();
+        if (name.empty() || name.size() > MAX_LENGTH) return false;
+        char previous = '.';
+        for (char c : name) {
+            bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                         c == '-' || c == '_' || (c == '.' && previous != '.');
+            if (!valid) return false;
+            previous = c;
+        }
+        if (previous == '.') return false;
+        return out.assign(reinterpret_cast<const uint8_t*>(name.data()), name.size());
+    }
+
+    // Sets the name from dotted bytes in a packet, lowercasing them. A name
+    // longer than MAX_LENGTH keeps the labels that fit from the right. Fails,
+    // leaving the name empty, if a byte is not printable ASCII or not even
+    // the last label fits.
+    bool assign(const uint8_t* data, std::size_t count) {
+        length = 0;
+        truncated = false;
+        if (count > MAX_WIRE_LENGTH) return false;
+        std::size_t start = 0;
+        if (count > MAX_LENGTH) {
+            start = count - MAX_LENGTH;
+            while (start < count && data[start - 1] != '.') ++start;
+            if (start == count) return false;
+            truncated = true;
+        }
+        for (std::size_t i = start; i < count; ++i) {
+            uint8_t c = data[i];
+            if (c <= 0x20 || c >= 0x7F) {
+                truncated = false;
+                return false;
+            }
+            text[i - start] = static_cast<char>(c >= 'A' && c <= 'Z' ? c | 0x20 : c);
+        }
+        length = static_cast<uint8_t>(count - start);
+        return true;
+    }
+
+    void clear() {
+        length = 0;
+        truncated = false;
+    }
+
+    bool empty() const { return length == 0; }
+    bool isTruncated() const { return truncated; }
+    // The stored name, without the "*." of a truncated one.
+    std::size_t size() const { return length; }
+    const char* data() const { return text; }
+    std::string toString() const { return (truncated ? "*." : "") + std::string(text, length); }
+
+    uint64_t hash() const {
+        uint64_t h = FNV_OFFSET;
+        for (std::size_t i = length; i-- > 0;) {
+            h = (h ^ static_cast<uint8_t>(text[i])) * FNV_PRIME;
+        }
+        return h;
+    }
+
+    // Calls fn(hash, offset) for the stored name and each parent domain,
+    // longest last, where `hash` equals hash() of that suffix on its own and
+    // `offset` is where it starts. Stops early when fn returns true.
+    template <typename Fn>
+    bool forEachSuffix(Fn fn) const {
+        uint64_t h = FNV_OFFSET;
+        for (std::size_t i = length; i-- > 0;) {
+            h = (h ^ static_cast<uint8_t>(text[i])) * FNV_PRIME;
+            if ((i == 0 || text[i - 1] == '.') && fn(h, i)) return true;
+        }
+        return false;
+    }
+
+    bool operator==(const DomainName& other) const {
+        return length == other.length && truncated == other.truncated && std::memcmp(text, other.text, length) == 0;
+    }
+    bool operator!=(const DomainName& other) const { return !(*this == other); }
+};
+
+#endif
@@ -0,0 +1,204 @@
+#include "EventLoop.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+EventLoop::EventLoop() : epollFd(-1), stopped(false) {}
+
+EventLoop::~EventLoop() {
+#ifdef __linux__
+    for (const Source& source : sources) {
+        if (source.kind != Kind::DESCRIPTOR) {
+            ::close(source.fd);
+        }
+    }
+    if (epollFd >= 0) {
+        ::close(epollFd);
+    }
+#endif
+}
+
+bool EventLoop::isSupported() {
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+void EventLoop::blockSignals(const std::vector<int>& signals) {
+#ifdef __linux__
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (int signum : signals) {
+        sigaddset(&mask, signum);
+    }
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+#else
+    (void)signals;
+#endif
+}
+
+bool EventLoop::open(std::string& error) {
+#ifdef __linux__
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        error = std::string("epoll_create1: ") + std::strerror(errno);
+        return false;
+    }
+    return true;
+#else
+    error = "the event loop needs Linux (epoll)";
+    return false;
+#endif
+}
+
+// Sources are identified by their index, which stays valid because sources
+// are only ever appended.
+bool EventLoop::add(int fd, Kind kind, std::string& error) {
+#ifdef __linux__
+    struct epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u32 = static_cast<uint32_t>(sources.size());
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        error = std::string("epoll_ctl: ") + std::strerror(errno);
+        if (kind != Kind::DESCRIPTOR) {
+            ::close(fd);
+        }
+        return false;
+    }
+    Source source;
+    source.fd = fd;
+    source.kind = kind;
+    sources.push_back(std::move(source));
+    return true;
+#else
+    (void)fd;
+    (void)kind;
+    error = "the event loop needs Linux (epoll)";
+    return false;
+#endif
+}
+
+bool EventLoop::watch(int fd, Handler onReadable, std::string& error) {
+    if (!add(fd, Kind::DESCRIPTOR, error)) {
+        return false;
+    }
+    sources.back().onReady = std::move(onReadable);
+    return true;
+}
+
+bool EventLoop::addTimer(int intervalMs, Handler onExpiry, std::string& error) {
+#ifdef __linux__
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) {
+        error = std::string("timerfd_create: ") + std::strerror(errno);
+        return false;
+    }
+    struct itimerspec spec;
+    spec.it_interval.tv_sec = intervalMs / 1000;
+    spec.it_interval.tv_nsec = static_cast<long>(intervalMs % 1000) * 1000000L;
+    spec.it_value = spec.it_interval;
+    if (timerfd_settime(fd, 0, &spec, nullptr) != 0) {
+        error = std::string("timerfd_settime: ") + std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    if (!add(fd, Kind::TIMER, error)) {
+        return false;
+    }
+    sources.back().onReady = std::move(onExpiry);
+    return true;
+#else
+    (void)intervalMs;
+    (void)onExpiry;
+    error = "the event loop needs Linux (epoll)";
+    return false;
+#endif
+}
+
+bool EventLoop::addSignals(const std::vector<int>& signals, SignalHandler onSignal, std::string& error) {
+#ifdef __linux__
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (int signum : signals) {
+        sigaddset(&mask, signum);
+    }
+    int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd < 0) {
+        error = std::string("signalfd: ") + std::strerror(errno);
+        return false;
+    }
+    if (!add(fd, Kind::SIGNALS, error)) {
+        return false;
+    }
+    sources.back().onSignal = std::move(onSignal);
+    return true;
+#else
+    (void)signals;
+    (void)onSignal;
+    error = "the event loop needs Linux (epoll)";
+    return false;
+#endif
+}
+
+// Timer and signal descriptors are read here, so one wakeup covers every
+// expiry or signal that has piled up since the last one.
+void EventLoop::dispatch(Source& source) {
+#ifdef __linux__
+    switch (source.kind) {
+        case Kind::DESCRIPTOR:
+            source.onReady();
+            break;
+        case Kind::TIMER: {
+            uint64_t expirations = 0;
+            if (::read(source.fd, &expirations, sizeof(expirations)) == static_cast<ssize_t>(sizeof(expirations))) {
+                source.onReady();
+            }
+            break;
+        }
+        case Kind::SIGNALS: {
+            struct signalfd_siginfo info;
+            while (::read(source.fd, &info, sizeof(info)) == static_cast<ssize_t>(sizeof(info))) {
+                source.onSignal(static_cast<int>(info.ssi_signo));
+            }
+            break;
+        }
+    }
+#else
+    (void)source;
+#endif
+}
+
+void EventLoop::run() {
+#ifdef __linux__
+    struct epoll_event events[MAX_EVENTS];
+    stopped = false;
+    while (!stopped) {
+        int ready = epoll_wait(epollFd, events, MAX_EVENTS, idle ? 0 : -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        for (int i = 0; i < ready && !stopped; ++i) {
+            dispatch(sources[events[i].data.u32]);
+        }
+        if (ready == 0 && idle && !stopped && !idle()) {
+            idle = nullptr;
+        }
+    }
+#endif
+}
@@ -0,0 +1,66 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Single-threaded readiness loop over epoll (Linux only). Descriptors,
+// periodic timers (timerfd) and signals (signalfd) are all delivered as
+// callbacks on the thread that calls run(), so the state they touch needs
+// no locks. Handlers should do a bounded amount of work per call; the loop
+// is level-triggered and calls them again while their descriptor stays
+// readable.
+class EventLoop {
+public:
+    typedef std::function<void()> Handler;
+    typedef std::function<void(int)> SignalHandler;
+
+    static constexpr int MAX_EVENTS = 16;
+
+private:
+    enum class Kind { DESCRIPTOR, TIMER, SIGNALS };
+
+    struct Source {
+        int fd;
+        Kind kind;
+        Handler onReady;
+        SignalHandler onSignal;
+    };
+
+    int epollFd;
+    std::vector<Source> sources;
+    std::function<bool()> idle;
+    bool stopped;
+
+    bool add(int fd, Kind kind, std::string& error);
+    void dispatch(Source& source);
+
+public:
+    EventLoop();
+    ~EventLoop();
+
+    static bool isSupported();
+    // Blocks the signals in the calling thread and every thread it starts
+    // afterwards, so that only a signalfd sees them. Call before any thread
+    // is created.
+    static void blockSignals(const std::vector<int>& signals);
+
+    bool open(std::string& error);
+    // Calls `onReadable` whenever `fd` is readable, hung up or in error.
+    // The loop does not own `fd`.
+    bool watch(int fd, Handler onReadable, std::string& error);
+    bool addTimer(int intervalMs, Handler onExpiry, std::string& error);
+    // The signals must already be blocked (see blockSignals()).
+    bool addSignals(const std::vector<int>& signals, SignalHandler onSignal, std::string& error);
+    // Work for when nothing is ready, such as reading a trace file, which
+    // epoll cannot wait on. While it is set the loop polls instead of
+    // blocking; it is dropped once it returns false.
+    void setIdle(std::function<bool()> work) { idle = std::move(work); }
+
+    // Runs until stop() is called from a handler.
+    void run();
+    void stop() { stopped = true; }
+};
+
+#endif
@@ -0,0 +1,276 @@
+#include "EventWriter.h"
+#include "FastFormat.h"
+#include "Utils.h"
+#include <iostream>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    // Covers the fixed keys, punctuation and numbers of the largest event.
+    const std::size_t FIXED_EVENT_BYTES = 384;
+
+    template <std::size_t N>
+    char* literal(char* out, const char (&text)[N]) {
+        return FastFormat::text(out, text, N - 1);
+    }
+
+    char* timestamp(char* out, int64_t nanos) {
+        if (nanos < 0) nanos = 0;
+        out = FastFormat::uint(out, static_cast<uint64_t>(nanos / 1000000000LL));
+        *out++ = '.';
+        uint64_t micros = static_cast<uint64_t>(nanos % 1000000000LL) / 1000;
+        for (uint64_t scale = 100000; scale > 0; scale /= 10) {
+            *out++ = static_cast<char>('0' + micros / scale % 10);
+        }
+        return out;
+    }
+
+    // Non-negative, three decimals.
+    char* decimal(char* out, double value) {
+        uint64_t thousandths = value > 0 && std::isfinite(value) ? static_cast<uint64_t>(value * 1000.0 + 0.5) : 0;
+        out = FastFormat::uint(out, thousandths / 1000);
+        *out++ = '.';
+        *out++ = static_cast<char>('0' + thousandths / 100 % 10);
+        *out++ = static_cast<char>('0' + thousandths / 10 % 10);
+        *out++ = static_cast<char>('0' + thousandths % 10);
+        return out;
+    }
+
+    // A JSON string body; at most 6 output bytes per input byte.
+    char* escaped(char* out, const char* text, std::size_t length) {
+        static const char HEX[] = "0123456789abcdef";
+        for (std::size_t i = 0; i < length; ++i) {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            if (c == '"' || c == '\\') {
+                *out++ = '\\';
+                *out++ = static_cast<char>(c);
+            } else if (c < 0x20) {
+                out = literal(out, "\\u00");
+                *out++ = HEX[c >> 4];
+                *out++ = HEX[c & 15];
+            } else {
+                *out++ = static_cast<char>(c);
+            }
+        }
+        return out;
+    }
+
+    char* escaped(char* out, const std::string& text) {
+        return escaped(out, text.data(), text.size());
+    }
+
+    char* endpoints(char* out, const IpAddress& source, uint16_t sourcePort, const IpAddress& dest, uint16_t destPort) {
+        out = literal(out, ",\"src\":\"");
+        out = FastFormat::address(out, source);
+        out = literal(out, "\",\"sport\":");
+        out = FastFormat::uint(out, sourcePort);
+        out = literal(out, ",\"dst\":\"");
+        out = FastFormat::address(out, dest);
+        out = literal(out, "\",\"dport\":");
+        return FastFormat::uint(out, destPort);
+    }
+
+    int64_t epochNanos(const std::chrono::system_clock::time_point& tp) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count();
+    }
+}
+
+EventWriter::EventWriter() : enabled(false) {}
+
+const char* EventWriter::typeName(Type type) {
+    switch (type) {
+        case TYPE_ALERT: return "alert";
+        case TYPE_FLOW: return "flow";
+        case TYPE_STATS: return "stats";
+        default: return "unknown";
+    }
+}
+
+bool EventWriter::open(const std::string& path, const AsyncWriter::Options& options) {
+    close();
+    if (!writer.open(path, true, options)) {
+        std::cout << Utils::Colors::RED << "Error: Cannot open event output " << path
+                  << Utils::Colors::RESET << std::endl;
+        return false;
+    }
+    enabled = true;
+    std::cout << Utils::Colors::GREEN << "Writing JSON events to " << (path == "-" ? "stdout" : path)
+              << Utils::Colors::RESET << std::endl;
+    return true;
+}
+
+void EventWriter::close() {
+    if (!enabled) return;
+    writer.close();
+    enabled = false;
+}
+
+char* EventWriter::header(char* out, Type type, int64_t nanos) {
+    const char* name = typeName(type);
+    out = literal(out, "{\"type\":\"");
+    out = FastFormat::text(out, name, std::strlen(name));
+    out = literal(out, "\",\"ts\":");
+    return timestamp(out, nanos);
+}
+
+void EventWriter::finish(char* start, char* out, Type type) {
+    out = literal(out, "}\n");
+    writer.commit(static_cast<std::size_t>(out - start));
+    events[type].increment();
+}
+
+void EventWriter::writeAlert(const PacketInfo& packet, const char* kind) {
+    if (!enabled) return;
+
+    // The detector's reasons end in "; " so they can be concatenated.
+    const char* reason = packet.anomalyReason;
+    std::size_t reasonLength = std::strlen(reason);
+    while (reasonLength > 0 && (reason[reasonLength - 1] == ' ' || reason[reasonLength - 1] == ';')) {
+        --reasonLength;
+    }
+    std::size_t kindLength = std::strlen(kind);
+    const AppLayer& app = packet.app;
+
+    char* start = writer.reserve(FIXED_EVENT_BYTES + 2 * FastFormat::IP_MAX_WIDTH + FastFormat::PROTOCOL_MAX_WIDTH +
+                                 kindLength + 6 * (reasonLength + app.name.size()) + 32);
+    if (start == nullptr) return;
+    char* out = header(start, TYPE_ALERT, epochNanos(packet.timestamp));
+    out = literal(out, ",\"kind\":\"");
+    out = FastFormat::text(out, kind, kindLength);
+    if (reasonLength > 0 && std::strcmp(kind, "anomaly") == 0) {
+        out = literal(out, "\",\"reason\":\"");
+        out = escaped(out, reason, reasonLength);
+    }
+    out = literal(out, "\",\"proto\":\"");
+    out = FastFormat::protocol(out, packet.ipProtocol);
+    *out++ = '"';
+    if (app.protocol != AppLayer::NONE) {
+        out = literal(out, ",\"app\":\"");
+        const char* appName = AppLayer::protocolName(app.protocol);
+        out = FastFormat::text(out, appName, std::strlen(appName));
+        *out++ = '"';
+        if (!app.name.empty()) {
+            out = literal(out, ",\"name\":\"");
+            if (app.name.isTruncated()) out = literal(out, "*.");
+            out = escaped(out, app.name.data(), app.name.size());
+            *out++ = '"';
+        }
+    }
+    out = endpoints(out, packet.sourceAddr, packet.sourcePort, packet.destAddr, packet.destPort);
+    out = literal(out, ",\"size\":");
+    out = FastFormat::uint(out, packet.packetSize);
+    finish(start, out, TYPE_ALERT);
+}
+
+void EventWriter::writeCollectorAlert(const Collector::Alert& alert) {
+    if (!enabled) return;
+
+    std::size_t names = 0;
+    for (const std::string& sensor : alert.sensors) {
+        names += 3 + 6 * sensor.size();
+    }
+    std::size_t kindLength = std::strlen(alert.kind);
+    std::size_t reasonLength = std::strlen(alert.reason);
+    char* start = writer.reserve(FIXED_EVENT_BYTES + FastFormat::IP_MAX_WIDTH + kindLength + 6 * reasonLength + names);
+    if (start == nullptr) return;
+    char* out = header(start, TYPE_ALERT, alert.nanos);
+    out = literal(out, ",\"kind\":\"");
+    out = FastFormat::text(out, alert.kind, kindLength);
+    out = literal(out, "\",\"reason\":\"");
+    out = escaped(out, alert.reason, reasonLength);
+    out = literal(out, "\",\"src\":\"");
+    out = FastFormat::address(out, alert.source);
+    out = literal(out, "\",\"count\":");
+    out = FastFormat::uint(out, alert.count);
+    out = literal(out, ",\"sensors\":[");
+    for (std::size_t i = 0; i < alert.sensors.size(); ++i) {
+        if (i > 0) *out++ = ',';
+        *out++ = '"';
+        out = escaped(out, alert.sensors[i]);
+        *out++ = '"';
+    }
+    *out++ = ']';
+    finish(start, out, TYPE_ALERT);
+}
+
+void EventWriter::writeFlow(const FlowTable::Flow& flow, FlowTable::EndReason reason) {
+    if (!enabled) return;
+
+    char* start = writer.reserve(FIXED_EVENT_BYTES + 2 * FastFormat::IP_MAX_WIDTH);
+    if (start == nullptr) return;
+    char* out = header(start, TYPE_FLOW, flow.lastNanos);
+    out = literal(out, ",\"start\":");
+    out = timestamp(out, flow.firstNanos);
+    out = literal(out, ",\"end\":");
+    out = timestamp(out, flow.lastNanos);
+    out = literal(out, ",\"proto\":");
+    out = FastFormat::uint(out, flow.key.protocol);
+    out = endpoints(out, flow.key.source, flow.key.sourcePort, flow.key.dest, flow.key.destPort);
+    out = literal(out, ",\"packets\":");
+    out = FastFormat::uint(out, flow.packets);
+    out = literal(out, ",\"bytes\":");
+    out = FastFormat::uint(out, flow.bytes);
+    out = flow.anomalous ? literal(out, ",\"anomalous\":true") : literal(out, ",\"anomalous\":false");
+    out = literal(out, ",\"sample_rate\":");
+    out = FastFormat::uint(out, flow.sampleRate);
+    out = literal(out, ",\"end_reason\":\"");
+    const char* name = FlowTable::reasonName(reason);
+    out = FastFormat::text(out, name, std::strlen(name));
+    *out++ = '"';
+    finish(start, out, TYPE_FLOW);
+}
+
+void EventWriter::writeStats(const Stats& stats) {
+    if (!enabled) return;
+
+    char* start = writer.reserve(FIXED_EVENT_BYTES);
+    if (start == nullptr) return;
+    char* out = header(start, TYPE_STATS, stats.nanos);
+    out = literal(out, ",\"packets\":");
+    out = FastFormat::uint(out, stats.packets);
+    out = literal(out, ",\"bytes\":");
+    out = FastFormat::uint(out, stats.bytes);
+    out = literal(out, ",\"anomalies\":");
+    out = FastFormat::uint(out, stats.anomalies);
+    out = literal(out, ",\"pps\":");
+    out = decimal(out, stats.packetRate);
+    out = literal(out, ",\"bytes_per_sec\":");
+    out = decimal(out, stats.byteRate);
+    out = literal(out, ",\"queue_depth\":");
+    out = FastFormat::uint(out, stats.queueDepth);
+    out = literal(out, ",\"capture_drops\":");
+    out = FastFormat::uint(out, stats.captureDrops);
+    out = literal(out, ",\"state_bytes\":");
+    out = FastFormat::uint(out, stats.stateBytes);
+    out = literal(out, ",\"active_flows\":");
+    out = FastFormat::uint(out, stats.activeFlows);
+    out = literal(out, ",\"sample_rate\":");
+    out = FastFormat::uint(out, stats.sampleRate);
+    out = literal(out, ",\"sampled_out\":");
+    out = FastFormat::uint(out, stats.sampledOut);
+    out = literal(out, ",\"events_dropped\":");
+    out = FastFormat::uint(out, writer.getStats().recordsDropped);
+    finish(start, out, TYPE_STATS);
+}
+
+void EventWriter::printStats() const {
+    AsyncWriter::Stats stats = writer.getStats();
+    std::cout << "Event writer: " << (enabled ? (writer.getFilename() == "-" ? std::string("stdout") : writer.getFilename())
+                                              : std::string("disabled"));
+    for (int type = 0; type < TYPE_COUNT; ++type) {
+        std::cout << ", " << events[type].get() << " " << typeName(static_cast<Type>(type));
+    }
+    std::cout << ", " << Utils::formatBytes(stats.bytesWritten) << " in " << stats.writes << " writes"
+              << ", dropped " << stats.recordsDropped << std::endl;
+}
+
+void EventWriter::writeMetrics(std::ostream& out) const {
+    out << "# HELP network2_events_total JSON events written, by type\n"
+        << "# TYPE network2_events_total counter\n";
+    for (int type = 0; type < TYPE_COUNT; ++type) {
+        out << "network2_events_total{type=\"" << typeName(static_cast<Type>(type)) << "\"} " << events[type].get() << "\n";
+    }
+    out << "# HELP network2_events_dropped_total JSON events dropped because the output fell behind\n"
+        << "# TYPE network2_events_dropped_total counter\n"
+        << "network2_events_dropped_total " << writer.getStats().recordsDropped << "\n";
+}
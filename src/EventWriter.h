@@ -0,0 +1,71 @@
+#ifndef EVENT_WRITER_H
+#define EVENT_WRITER_H
+
+#include "PacketTypes.h"
+#include "FlowTable.h"
+#include "Collector.h"
+#include "AsyncWriter.h"
+#include "Counters.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Machine-readable event stream, one JSON object per line, for log shippers.
+// Events are formatted straight into AsyncWriter's buffers with the
+// FastFormat routines, so writing one costs no heap allocation and the
+// output reaches the file or stdout in large batched writes. Every event has
+// "type" and "ts" (Unix seconds with microseconds). All calls come from the
+// processing thread.
+class EventWriter {
+public:
+    enum Type { TYPE_ALERT = 0, TYPE_FLOW, TYPE_STATS, TYPE_COUNT };
+
+    // Pipeline totals for a "stats" event, gathered by the caller.
+    struct Stats {
+        int64_t nanos = 0;
+        uint64_t packets = 0;
+        uint64_t bytes = 0;
+        uint64_t anomalies = 0;
+        double packetRate = 0;  // Per second, 5-second moving average
+        double byteRate = 0;
+        uint64_t queueDepth = 0;
+        uint64_t captureDrops = 0;
+        uint64_t stateBytes = 0;
+        uint64_t activeFlows = 0;
+        uint32_t sampleRate = 1;
+        uint64_t sampledOut = 0;
+    };
+
+private:
+    AsyncWriter writer;
+    bool enabled;
+    SingleWriterCounter events[TYPE_COUNT];
+
+    static const char* typeName(Type type);
+    char* header(char* out, Type type, int64_t nanos);
+    void finish(char* start, char* out, Type type);
+
+public:
+    EventWriter();
+
+    // "-" writes to stdout.
+    bool open(const std::string& path, const AsyncWriter::Options& options = AsyncWriter::Options());
+    void close();
+    bool isEnabled() const { return enabled; }
+
+    // `kind` is "anomaly" or "watch"; anomalies carry the detector's reason.
+    void writeAlert(const PacketInfo& packet, const char* kind);
+    void writeFlow(const FlowTable::Flow& flow, FlowTable::EndReason reason);
+    void writeStats(const Stats& stats);
+    // A collector's alert: "global" on merged summaries or "sensor" when a
+    // sensor flagged the source itself.
+    void writeCollectorAlert(const Collector::Alert& alert);
+
+    void poll() { if (enabled) writer.poll(); }
+
+    void printStats() const;
+    void writeMetrics(std::ostream& out) const;
+};
+
+#endif
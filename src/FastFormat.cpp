@@ -0,0 +1,131 @@
+#include "FastFormat.h"
+#include "Utils.h"
+#include <charconv>
+#include <ctime>
+
+namespace {
+    struct OctetTable {
+        char text[256][4];
+        uint8_t length[256];
+        
+        constexpr OctetTable() : text(), length() {
+            for (int i = 0; i < 256; ++i) {
+                if (i >= 100) {
+                    text[i][0] = static_cast<char>('0' + i / 100);
+                    text[i][1] = static_cast<char>('0' + (i / 10) % 10);
+                    text[i][2] = static_cast<char>('0' + i % 10);
+                    length[i] = 3;
+                } else if (i >= 10) {
+                    text[i][0] = static_cast<char>('0' + i / 10);
+                    text[i][1] = static_cast<char>('0' + i % 10);
+                    length[i] = 2;
+                } else {
+                    text[i][0] = static_cast<char>('0' + i);
+                    length[i] = 1;
+                }
+            }
+        }
+    };
+    
+    constexpr OctetTable OCTETS;
+    
+    inline char* twoDigits(char* out, int value) {
+        out[0] = static_cast<char>('0' + value / 10);
+        out[1] = static_cast<char>('0' + value % 10);
+        return out + 2;
+    }
+    
+    struct TimestampCache {
+        int64_t second = INT64_MIN;
+        char prefix[8];
+    };
+}
+
+char* FastFormat::timestamp(char* out, const std::chrono::system_clock::time_point& tp) {
+    static thread_local TimestampCache cache;
+    
+    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(tp.time_since_epoch()).count();
+    int64_t second = millis / 1000;
+    int ms = static_cast<int>(millis % 1000);
+    if (ms < 0) {
+        ms += 1000;
+        second -= 1;
+    }
+    
+    if (second != cache.second) {
+        std::tm local;
+        Utils::localTime(static_cast<std::time_t>(second), local);
+        char* p = cache.prefix;
+        p = twoDigits(p, local.tm_hour);
+        *p++ = ':';
+        p = twoDigits(p, local.tm_min);
+        *p++ = ':';
+        twoDigits(p, local.tm_sec);
+        cache.second = second;
+    }
+    
+    std::memcpy(out, cache.prefix, 8);
+    out[8] = '.';
+    out[9] = static_cast<char>('0' + ms / 100);
+    out[10] = static_cast<char>('0' + (ms / 10) % 10);
+    out[11] = static_cast<char>('0' + ms % 10);
+    return out + TIMESTAMP_WIDTH;
+}
+
+char* FastFormat::ipv4(char* out, uint32_t address) {
+    // Octets are copied as fixed 4-byte blocks and the separator written
+    // after the digits, so the last octet may touch one byte of slack.
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        unsigned octet = (address >> shift) & 0xFF;
+        std::memcpy(out, OCTETS.text[octet], 4);
+        out[OCTETS.length[octet]] = '.';
+        out += OCTETS.length[octet] + (shift > 0 ? 1 : 0);
+    }
+    return out;
+}
+
+char* FastFormat::uint(char* out, uint64_t value) {
+    return std::to_chars(out, out + UINT_MAX_WIDTH, value).ptr;
+}
+
+char* FastFormat::protocol(char* out, uint8_t number) {
+    switch (number) {
+        case 1: return text(out, "ICMP", 4);
+        case 6: return text(out, "TCP", 3);
+        case 17: return text(out, "UDP", 3);
+        case 58: return text(out, "ICMPv6", 6);
+        default:
+            out = text(out, "OTHER(", 6);
+            out = uint(out, number);
+            *out++ = ')';
+            return out;
+    }
+}
+
+char* FastFormat::bytes(char* out, uint64_t value) {
+    static const char* const UNITS[] = {" B", " KB", " MB", " GB"};
+    
+    if (value < 1024) {
+        out = uint(out, value);
+        return text(out, UNITS[0], 2);
+    }
+    
+    int unit = 0;
+    uint64_t scale = 1;
+    while (unit < 3 && value >= scale * 1024) {
+        scale *= 1024;
+        unit++;
+    }
+    
+    // Two decimals, rounded half-up.
+    uint64_t whole = value / scale;
+    uint64_t hundredths = ((value % scale) * 100 + scale / 2) / scale;
+    if (hundredths == 100) {
+        whole++;
+        hundredths = 0;
+    }
+    out = uint(out, whole);
+    *out++ = '.';
+    out = twoDigits(out, static_cast<int>(hundredths));
+    return text(out, UNITS[unit], unit == 0 ? 2 : 3);
+}
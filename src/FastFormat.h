@@ -0,0 +1,68 @@
+#ifndef FAST_FORMAT_H
+#define FAST_FORMAT_H
+
+#include "IpAddress.h"
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+// Allocation-free formatters for the per-packet output paths (CSV logging and
+// the live table). Each writes into a caller-provided buffer and returns the
+// new end pointer; callers must reserve the documented maximum width.
+namespace FastFormat {
+    const std::size_t TIMESTAMP_WIDTH = 12;  // HH:MM:SS.mmm
+    const std::size_t IPV4_MAX_WIDTH = 16;   // 15 characters plus one byte of slack
+    const std::size_t IP_MAX_WIDTH = IpAddress::MAX_TEXT_WIDTH;
+    const std::size_t UINT_MAX_WIDTH = 20;
+    const std::size_t BYTES_MAX_WIDTH = 24;
+    const std::size_t PROTOCOL_MAX_WIDTH = 10;  // OTHER(255)
+    const std::size_t ROUTE_MAX_WIDTH = 2 * IP_MAX_WIDTH + 4;
+
+    // Local time of day with milliseconds. The H:M:S prefix is cached per
+    // thread and only recomputed when the second changes.
+    char* timestamp(char* out, const std::chrono::system_clock::time_point& tp);
+
+    // Dotted quad from a host-order address, using a precomputed octet table.
+    char* ipv4(char* out, uint32_t address);
+
+    // Either family: IPv4 through ipv4(), IPv6 in RFC 5952 form.
+    inline char* address(char* out, const IpAddress& address) {
+        return address.isV4() ? ipv4(out, address.v4()) : address.format(out);
+    }
+
+    // "source -> dest", for alert messages.
+    inline char* route(char* out, const IpAddress& source, const IpAddress& dest) {
+        out = address(out, source);
+        std::memcpy(out, " -> ", 4);
+        return address(out + 4, dest);
+    }
+
+    char* uint(char* out, uint64_t value);
+
+    // Same output as Utils::protocolToString ("TCP", "ICMPv6", "OTHER(47)", ...).
+    char* protocol(char* out, uint8_t number);
+
+    // Same output as Utils::formatBytes ("512 B", "1.50 KB", ...).
+    char* bytes(char* out, uint64_t value);
+
+    inline char* text(char* out, const char* str, std::size_t length) {
+        std::memcpy(out, str, length);
+        return out + length;
+    }
+
+    inline char* text(char* out, const std::string& str) {
+        return text(out, str.data(), str.size());
+    }
+
+    // Pads [start, end) with spaces up to `width` columns, like std::setw with std::left.
+    inline char* padTo(char* start, char* end, std::size_t width) {
+        while (static_cast<std::size_t>(end - start) < width) {
+            *end++ = ' ';
+        }
+        return end;
+    }
+}
+
+#endif
@@ -0,0 +1,356 @@
+#include "FlightRecorder.h"
+#include "Utils.h"
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+    const uint32_t PCAPNG_SECTION_HEADER = 0x0A0D0D0A;
+    const uint32_t PCAPNG_INTERFACE_DESCRIPTION = 0x00000001;
+    const uint32_t PCAPNG_ENHANCED_PACKET = 0x00000006;
+    const uint32_t PCAPNG_BYTE_ORDER_MAGIC = 0x1A2B3C4D;
+    const uint16_t OPT_END = 0;
+    const uint16_t OPT_COMMENT = 1;
+    const uint16_t IF_TSRESOL = 9;
+    const uint32_t SNAPLEN = 262144;
+
+    std::size_t pad4(std::size_t value) {
+        return (value + 3) & ~static_cast<std::size_t>(3);
+    }
+
+    // Builds pcapng blocks in memory; the caller writes the buffer out.
+    class PcapngBuffer {
+    private:
+        std::vector<uint8_t> data;
+
+        void put32(uint32_t value) { append(&value, sizeof(value)); }
+        void put16(uint16_t value) { append(&value, sizeof(value)); }
+        void append(const void* bytes, std::size_t size) {
+            const uint8_t* p = static_cast<const uint8_t*>(bytes);
+            data.insert(data.end(), p, p + size);
+        }
+        void padTo4() { data.resize(pad4(data.size()), 0); }
+
+        void option(uint16_t code, const void* value, std::size_t length) {
+            put16(code);
+            put16(static_cast<uint16_t>(length));
+            append(value, length);
+            padTo4();
+        }
+
+        std::size_t beginBlock(uint32_t type) {
+            std::size_t start = data.size();
+            put32(type);
+            put32(0);
+            return start;
+        }
+
+        void endBlock(std::size_t start) {
+            uint32_t length = static_cast<uint32_t>(data.size() - start + 4);
+            std::memcpy(&data[start + 4], &length, sizeof(length));
+            put32(length);
+        }
+
+    public:
+        void sectionHeader(const std::string& comment) {
+            std::size_t start = beginBlock(PCAPNG_SECTION_HEADER);
+            put32(PCAPNG_BYTE_ORDER_MAGIC);
+            put16(1);
+            put16(0);
+            int64_t sectionLength = -1;
+            append(&sectionLength, sizeof(sectionLength));
+            std::size_t commentLength = (std::min)(comment.size(), static_cast<std::size_t>(0xFFFF));
+            if (commentLength > 0) option(OPT_COMMENT, comment.data(), commentLength);
+            put32(OPT_END);
+            endBlock(start);
+        }
+
+        void interfaceDescription(int linkType) {
+            std::size_t start = beginBlock(PCAPNG_INTERFACE_DESCRIPTION);
+            put16(static_cast<uint16_t>(linkType));
+            put16(0);
+            put32(SNAPLEN);
+            uint8_t nanosecondResolution = 9;
+            option(IF_TSRESOL, &nanosecondResolution, 1);
+            put32(OPT_END);
+            endBlock(start);
+        }
+
+        void enhancedPacket(int64_t timestampNanos, uint32_t wireLength, const uint8_t* frame, uint32_t capturedLength) {
+            std::size_t start = beginBlock(PCAPNG_ENHANCED_PACKET);
+            uint64_t ts = static_cast<uint64_t>(timestampNanos);
+            put32(0);
+            put32(static_cast<uint32_t>(ts >> 32));
+            put32(static_cast<uint32_t>(ts));
+            put32(capturedLength);
+            put32(wireLength);
+            append(frame, capturedLength);
+            padTo4();
+            endBlock(start);
+        }
+
+        const std::vector<uint8_t>& bytes() const { return data; }
+    };
+
+    std::string dumpFilename(const std::string& directory, const std::chrono::system_clock::time_point& when) {
+        std::tm local;
+        Utils::localTime(std::chrono::system_clock::to_time_t(when), local);
+        char stamp[32];
+        std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &local);
+
+        std::string base = directory + "/flight-" + stamp;
+        std::string path = base + ".pcapng";
+        for (int n = 2; std::FILE* existing = std::fopen(path.c_str(), "rb"); ++n) {
+            std::fclose(existing);
+            path = base + "-" + std::to_string(n) + ".pcapng";
+        }
+        return path;
+    }
+}
+
+FlightRecorder::FlightRecorder()
+    : linkType(1), head(0), tail(0), stopping(false), nextTriggerNanos(0), suppressedCount(0) {}
+
+FlightRecorder::~FlightRecorder() {
+    stop();
+}
+
+std::size_t FlightRecorder::recordSize(uint32_t capturedLength) {
+    return (sizeof(RecordHeader) + capturedLength + 7) & ~static_cast<std::size_t>(7);
+}
+
+bool FlightRecorder::start(const Options& opts, int dataLinkType) {
+    stop();
+
+    options = opts;
+    options.arenaBytes = (std::max)(options.arenaBytes & ~static_cast<std::size_t>(7), static_cast<std::size_t>(1 << 20));
+    options.windowSeconds = (std::max)(options.windowSeconds, 1);
+    linkType = dataLinkType;
+
+    try {
+        arena.assign(options.arenaBytes, 0);
+    } catch (const std::bad_alloc&) {
+        std::cout << Utils::Colors::RED << "Flight recorder: cannot allocate " << Utils::formatBytes(options.arenaBytes)
+                  << Utils::Colors::RESET << std::endl;
+        return false;
+    }
+    head.store(0);
+    tail.store(0);
+    stopping = false;
+    nextTriggerNanos.store(0, std::memory_order_relaxed);
+    requests.clear();
+    dumpThread = std::thread([this]() { dumpLoop(); });
+    return true;
+}
+
+void FlightRecorder::stop() {
+    if (arena.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    requestAvailable.notify_one();
+    if (dumpThread.joinable()) {
+        dumpThread.join();
+    }
+    arena.clear();
+    arena.shrink_to_fit();
+}
+
+void FlightRecorder::record(int64_t timestampNanos, uint32_t wireLength, const uint8_t* data, uint32_t capturedLength) {
+    if (arena.empty()) return;
+
+    const std::size_t capacity = arena.size();
+    const std::size_t size = recordSize(capturedLength);
+    if (size > capacity / 4) {
+        rejectedCount.increment();
+        return;
+    }
+
+    // A record never straddles the end of the arena: the remainder is skipped,
+    // marked explicitly when there is room for a header.
+    uint64_t pos = head.load(std::memory_order_relaxed);
+    std::size_t remaining = capacity - pos % capacity;
+    uint64_t skip = remaining < size ? remaining : 0;
+    uint64_t end = pos + skip + size;
+
+    uint64_t oldest = tail.load(std::memory_order_relaxed);
+    if (end - oldest > capacity) {
+        while (end - oldest > capacity) {
+            std::size_t offset = oldest % capacity;
+            const RecordHeader* header = reinterpret_cast<const RecordHeader*>(&arena[offset]);
+            if (capacity - offset < sizeof(RecordHeader) || header->capturedLength == WRAP_MARKER) {
+                oldest += capacity - offset;
+            } else {
+                oldest += recordSize(header->capturedLength);
+                overwrittenCount.increment();
+            }
+        }
+        // Publish the new tail before touching the reclaimed bytes, so a
+        // dump copying concurrently can tell which of its bytes are stale.
+        tail.store(oldest, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    if (skip >= sizeof(RecordHeader)) {
+        RecordHeader marker = {0, WRAP_MARKER, 0};
+        std::memcpy(&arena[pos % capacity], &marker, sizeof(marker));
+    }
+
+    RecordHeader header = {timestampNanos, capturedLength, wireLength};
+    uint8_t* out = &arena[(pos + skip) % capacity];
+    std::memcpy(out, &header, sizeof(header));
+    std::memcpy(out + sizeof(header), data, capturedLength);
+    head.store(end, std::memory_order_release);
+
+    packetCount.increment();
+    byteCount.add(capturedLength);
+}
+
+bool FlightRecorder::claimTrigger() {
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t next = nextTriggerNanos.load(std::memory_order_relaxed);
+    int64_t cooldown = static_cast<int64_t>(options.cooldownSeconds) * 1000000000;
+    if (now < next || !nextTriggerNanos.compare_exchange_strong(next, now + cooldown, std::memory_order_relaxed)) {
+        suppressedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void FlightRecorder::trigger(const std::string& reason) {
+    std::lock_guard<std::mutex> lock(mutex);
+    requests.push_back(DumpRequest{reason, options.windowSeconds, std::chrono::system_clock::now()});
+    requestAvailable.notify_one();
+}
+
+void FlightRecorder::requestDump(int windowSeconds, const std::string& reason) {
+    std::lock_guard<std::mutex> lock(mutex);
+    requests.push_back(DumpRequest{reason, windowSeconds > 0 ? windowSeconds : options.windowSeconds,
+                                   std::chrono::system_clock::now()});
+    requestAvailable.notify_one();
+}
+
+void FlightRecorder::dumpLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        requestAvailable.wait(lock, [this]() { return stopping || !requests.empty(); });
+        if (stopping) break;
+
+        DumpRequest request = requests.front();
+        requests.pop_front();
+        lock.unlock();
+        writeDump(request);
+        lock.lock();
+    }
+}
+
+// Copies [tail, head) out of the arena. Bytes the writer reclaimed during the
+// copy are exactly those before the tail re-read afterwards; `start` is the
+// first position still valid.
+std::size_t FlightRecorder::snapshot(std::vector<uint8_t>& copy, uint64_t& start) {
+    const std::size_t capacity = arena.size();
+    uint64_t last = head.load(std::memory_order_acquire);
+    uint64_t first = tail.load(std::memory_order_acquire);
+
+    copy.resize(static_cast<std::size_t>(last - first));
+    std::size_t offset = first % capacity;
+    std::size_t firstPart = (std::min)(copy.size(), capacity - offset);
+    std::memcpy(copy.data(), &arena[offset], firstPart);
+    std::memcpy(copy.data() + firstPart, &arena[0], copy.size() - firstPart);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t reclaimed = tail.load(std::memory_order_relaxed);
+    start = (std::max)(first, reclaimed);
+    if (start > last) start = last;
+    return static_cast<std::size_t>(start - first);
+}
+
+bool FlightRecorder::writeDump(const DumpRequest& request) {
+    const std::size_t capacity = arena.size();
+    std::vector<uint8_t> copy;
+    uint64_t position;
+    std::size_t index = snapshot(copy, position);
+
+    int64_t cutoff = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        (request.requested - std::chrono::seconds(request.windowSeconds)).time_since_epoch()).count();
+
+    PcapngBuffer out;
+    out.sectionHeader("Network 2.0 flight recorder: " + request.reason);
+    out.interfaceDescription(linkType);
+
+    uint64_t written = 0;
+    while (index + sizeof(RecordHeader) <= copy.size()) {
+        std::size_t remaining = capacity - position % capacity;
+        RecordHeader header;
+        std::memcpy(&header, &copy[index], sizeof(header));
+        if (remaining < sizeof(RecordHeader) || header.capturedLength == WRAP_MARKER) {
+            index += remaining;
+            position += remaining;
+            continue;
+        }
+        std::size_t size = recordSize(header.capturedLength);
+        if (index + size > copy.size()) break;
+        if (header.timestampNanos >= cutoff) {
+            out.enhancedPacket(header.timestampNanos, header.wireLength, &copy[index + sizeof(header)], header.capturedLength);
+            written++;
+        }
+        index += size;
+        position += size;
+    }
+
+    std::string path = dumpFilename(options.directory, request.requested);
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        std::cout << Utils::Colors::RED << "Flight recorder: cannot create " << path << Utils::Colors::RESET << std::endl;
+        return false;
+    }
+    const auto& bytes = out.bytes();
+    bool ok = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    ok = std::fclose(file) == 0 && ok;
+
+    dumpCount.increment();
+    dumpedPacketCount.add(written);
+    std::cout << (ok ? Utils::Colors::GREEN : Utils::Colors::RED) << "Flight recorder: wrote " << written
+              << " packets (" << request.reason << ") to " << path << Utils::Colors::RESET << std::endl;
+    return ok;
+}
+
+FlightRecorder::Stats FlightRecorder::getStats() const {
+    Stats stats;
+    stats.packets = packetCount.get();
+    stats.bytes = byteCount.get();
+    stats.overwritten = overwrittenCount.get();
+    stats.rejected = rejectedCount.get();
+    stats.dumps = dumpCount.get();
+    stats.dumpedPackets = dumpedPacketCount.get();
+    stats.triggersSuppressed = suppressedCount.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void FlightRecorder::printStats() const {
+    if (!isRunning()) {
+        std::cout << "Flight recorder: disabled" << std::endl;
+        return;
+    }
+    Stats stats = getStats();
+    std::cout << "Flight recorder: " << stats.packets - stats.overwritten << " packets held in "
+              << Utils::formatBytes(options.arenaBytes) << ", " << stats.overwritten << " overwritten, "
+              << stats.dumps << " dumps (" << stats.triggersSuppressed << " triggers suppressed)" << std::endl;
+}
+
+void FlightRecorder::writeMetrics(std::ostream& out) const {
+    if (!isRunning()) return;
+    Stats stats = getStats();
+    out << "# HELP network2_flight_recorder_packets_total Frames copied into the flight recorder.\n"
+        << "# TYPE network2_flight_recorder_packets_total counter\n"
+        << "network2_flight_recorder_packets_total " << stats.packets << "\n"
+        << "# HELP network2_flight_recorder_overwritten_total Frames overwritten before being dumped.\n"
+        << "# TYPE network2_flight_recorder_overwritten_total counter\n"
+        << "network2_flight_recorder_overwritten_total " << stats.overwritten << "\n"
+        << "# HELP network2_flight_recorder_dumps_total pcapng dumps written.\n"
+        << "# TYPE network2_flight_recorder_dumps_total counter\n"
+        << "network2_flight_recorder_dumps_total " << stats.dumps << "\n";
+}
@@ -0,0 +1,115 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include "Counters.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <cstdint>
+#include <cstddef>
+
+// Keeps the most recent raw frames in a preallocated byte ring so that an
+// alert can be backed by the packets around it. The capture thread is the
+// only writer and pays one memcpy per frame; the oldest frames are simply
+// overwritten. Dumps run on a background thread, which copies the live part
+// of the ring and then discards anything the writer overwrote during the
+// copy, so recording never waits for a dump. Dumps are written as pcapng.
+class FlightRecorder {
+public:
+    struct Options {
+        std::size_t arenaBytes;
+        int windowSeconds;    // How far back a dump reaches
+        int cooldownSeconds;  // Minimum spacing between alert-triggered dumps
+        std::string directory;
+
+        Options() : arenaBytes(64 << 20), windowSeconds(30), cooldownSeconds(60), directory(".") {}
+    };
+
+    struct Stats {
+        uint64_t packets;
+        uint64_t bytes;
+        uint64_t overwritten;
+        uint64_t rejected;
+        uint64_t dumps;
+        uint64_t dumpedPackets;
+        uint64_t triggersSuppressed;
+    };
+
+private:
+    struct RecordHeader {
+        int64_t timestampNanos;
+        uint32_t capturedLength;  // WRAP_MARKER pads the end of the arena
+        uint32_t wireLength;
+    };
+
+    struct DumpRequest {
+        std::string reason;
+        int windowSeconds;
+        std::chrono::system_clock::time_point requested;
+    };
+
+    static const uint32_t WRAP_MARKER = 0xFFFFFFFF;
+
+    Options options;
+    std::vector<uint8_t> arena;
+    int linkType;
+
+    // Positions are monotonic byte offsets; the arena index is pos % size.
+    // Writer-owned, readable by the dump thread.
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head;
+    std::atomic<uint64_t> tail;
+    SingleWriterCounter packetCount;
+    SingleWriterCounter byteCount;
+    SingleWriterCounter overwrittenCount;
+    SingleWriterCounter rejectedCount;
+
+    std::mutex mutex;
+    std::condition_variable requestAvailable;
+    std::deque<DumpRequest> requests;
+    bool stopping;
+    std::atomic<int64_t> nextTriggerNanos;  // Steady clock; triggers before it are suppressed
+    std::thread dumpThread;
+
+    alignas(CACHE_LINE_SIZE) SingleWriterCounter dumpCount;
+    SingleWriterCounter dumpedPacketCount;
+    std::atomic<uint64_t> suppressedCount;
+
+    static std::size_t recordSize(uint32_t capturedLength);
+    void dumpLoop();
+    bool writeDump(const DumpRequest& request);
+    std::size_t snapshot(std::vector<uint8_t>& copy, uint64_t& start);
+
+public:
+    FlightRecorder();
+    ~FlightRecorder();
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    bool start(const Options& opts, int dataLinkType);
+    void stop();
+    bool isRunning() const { return !arena.empty(); }
+
+    // Capture thread only.
+    void record(int64_t timestampNanos, uint32_t wireLength, const uint8_t* data, uint32_t capturedLength);
+
+    // Alert triggers are rate limited by cooldownSeconds. claimTrigger()
+    // checks the cooldown without locking and, if it has passed, starts the
+    // next one; only then build the reason and call trigger(), which queues
+    // the dump. requestDump always queues.
+    bool claimTrigger();
+    void trigger(const std::string& reason);
+    void requestDump(int windowSeconds, const std::string& reason);
+
+    Stats getStats() const;
+    const Options& getOptions() const { return options; }
+    void printStats() const;
+    void writeMetrics(std::ostream& out) const;
+};
+
+#endif
@@ -0,0 +1,96 @@
+#include "FlowTable.h"
+#include <algorithm>
+
+namespace {
+    const int64_t NANOS_PER_SECOND = 1000000000LL;
+}
+
+FlowTable::FlowTable(MemoryBudget& budget)
+    : flows(budget, "flows"),
+      idleNanos(DEFAULT_IDLE_SECONDS * NANOS_PER_SECOND),
+      activeNanos(DEFAULT_ACTIVE_SECONDS * NANOS_PER_SECOND) {}
+
+const char* FlowTable::reasonName(EndReason reason) {
+    switch (reason) {
+        case END_IDLE: return "idle";
+        case END_ACTIVE: return "active";
+        case END_EVICTED: return "evicted";
+        case END_FLUSH: return "flush";
+        default: return "unknown";
+    }
+}
+
+void FlowTable::setTimeouts(int idleSeconds, int activeSeconds) {
+    idleNanos = idleSeconds * NANOS_PER_SECOND;
+    activeNanos = activeSeconds * NANOS_PER_SECOND;
+}
+
+void FlowTable::add(const PacketInfo& packet) {
+    int64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(packet.timestamp.time_since_epoch()).count();
+    if (nanos > lastPacketNanos) {
+        lastPacketNanos = nanos;
+        lastPacketSeen = std::chrono::steady_clock::now();
+    }
+    if (nanos - lastSweepNanos >= NANOS_PER_SECOND) {
+        sweep(nanos);
+    }
+
+    Key key;
+    key.source = packet.sourceAddr;
+    key.dest = packet.destAddr;
+    key.sourcePort = packet.sourcePort;
+    key.destPort = packet.destPort;
+    key.protocol = packet.ipProtocol;
+
+    Flow* flow = flows.acquire(key, [this](const Flow& evicted) {
+        exported[END_EVICTED].increment();
+        if (exporter) exporter(evicted, END_EVICTED);
+    });
+    if (flow == nullptr) return;
+    if (flow->packets == 0) {
+        flow->key = key;
+        flow->firstNanos = nanos;
+    }
+    flow->lastNanos = (std::max)(flow->lastNanos, nanos);
+    flow->packets++;
+    flow->bytes += packet.packetSize;
+    flow->anomalous = flow->anomalous || packet.isAnomaly;
+    flow->sampleRate = (std::max)(flow->sampleRate, packet.sampleWeight);
+    activeFlows.set(flows.size());
+}
+
+void FlowTable::expire() {
+    if (lastPacketNanos == 0) return;
+    auto quiet = std::chrono::steady_clock::now() - lastPacketSeen;
+    int64_t now = lastPacketNanos + std::chrono::duration_cast<std::chrono::nanoseconds>(quiet).count();
+    if (now - lastSweepNanos >= NANOS_PER_SECOND) {
+        sweep(now);
+    }
+}
+
+void FlowTable::sweep(int64_t now) {
+    lastSweepNanos = now;
+    flows.expire([this, now](const Flow& flow) {
+        EndReason reason;
+        if (now - flow.lastNanos > idleNanos) {
+            reason = END_IDLE;
+        } else if (now - flow.firstNanos > activeNanos) {
+            reason = END_ACTIVE;
+        } else {
+            return false;
+        }
+        exported[reason].increment();
+        if (exporter) exporter(flow, reason);
+        return true;
+    });
+    activeFlows.set(flows.size());
+}
+
+void FlowTable::flush() {
+    flows.expire([this](const Flow& flow) {
+        exported[END_FLUSH].increment();
+        if (exporter) exporter(flow, END_FLUSH);
+        return true;
+    });
+    activeFlows.set(flows.size());
+}
@@ -0,0 +1,84 @@
+#ifndef FLOW_TABLE_H
+#define FLOW_TABLE_H
+
+#include "PacketTypes.h"
+#include "MemoryBudget.h"
+#include "TrackerTable.h"
+#include "Counters.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+// Unidirectional 5-tuple flows, NetFlow style. A flow is exported when it
+// has been idle or active for longer than the timeouts, when the budget
+// forces its entry to be recycled, or on flush(). Timeouts run on packet
+// time, advanced by the wall clock while no packets arrive.
+class FlowTable {
+public:
+    struct Key {
+        IpAddress source;
+        IpAddress dest;
+        uint16_t sourcePort = 0;
+        uint16_t destPort = 0;
+        uint8_t protocol = 0;
+
+        uint64_t hash() const {
+            uint64_t ports = (static_cast<uint64_t>(sourcePort) << 24) | (static_cast<uint64_t>(destPort) << 8) | protocol;
+            return IpAddress::mix(source.hash() ^ (dest.hash() * 0x9E3779B97F4A7C15ULL) ^ ports);
+        }
+        bool isV4() const { return source.isV4(); }
+        bool operator==(const Key& other) const {
+            return source == other.source && dest == other.dest && sourcePort == other.sourcePort &&
+                   destPort == other.destPort && protocol == other.protocol;
+        }
+    };
+
+    struct Flow {
+        Key key;
+        int64_t firstNanos = 0;
+        int64_t lastNanos = 0;
+        uint64_t packets = 0;
+        uint64_t bytes = 0;
+        bool anomalous = false;  // At least one packet was flagged
+        uint32_t sampleRate = 1;  // Highest sampling rate N while the flow was seen
+    };
+
+    enum EndReason { END_IDLE = 0, END_ACTIVE, END_EVICTED, END_FLUSH, END_REASON_COUNT };
+
+    typedef std::function<void(const Flow& flow, EndReason reason)> Exporter;
+
+    static const int DEFAULT_IDLE_SECONDS = 30;
+    static const int DEFAULT_ACTIVE_SECONDS = 300;
+
+    static const char* reasonName(EndReason reason);
+
+private:
+    TrackerTable<Flow, Key> flows;
+    Exporter exporter;
+    int64_t idleNanos;
+    int64_t activeNanos;
+    int64_t lastPacketNanos = 0;
+    std::chrono::steady_clock::time_point lastPacketSeen;
+    int64_t lastSweepNanos = 0;
+
+    SingleWriterCounter activeFlows;
+    SingleWriterCounter exported[END_REASON_COUNT];
+
+    void sweep(int64_t now);
+
+public:
+    // Flow memory is charged to `budget`, which must outlive the table.
+    explicit FlowTable(MemoryBudget& budget);
+
+    void setTimeouts(int idleSeconds, int activeSeconds);
+    void setExporter(Exporter exporterFn) { exporter = exporterFn; }
+
+    void add(const PacketInfo& packet);
+    void expire();  // Call periodically so quiet flows still time out
+    void flush();   // Exports every flow, e.g. at shutdown
+
+    uint64_t getActiveFlows() const { return activeFlows.get(); }
+    uint64_t getExported(EndReason reason) const { return exported[reason].get(); }
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+// Log-linear (HDR-style) histogram: values below 2^(SubBucketBits + 1) get
+// exact buckets, larger values share each power-of-two range between
+// 2^SubBucketBits linear sub-buckets, bounding the relative error of any
+// reported percentile to 2^-SubBucketBits. Values at or above 2^MaxBits land
+// in the last bucket. Recording is a bit scan and an increment.
+template <unsigned SubBucketBits, unsigned MaxBits>
+class LogLinearHistogram {
+public:
+    static constexpr std::size_t SUB_BUCKETS = std::size_t(1) << SubBucketBits;
+    static constexpr std::size_t BUCKET_COUNT = (MaxBits - SubBucketBits + 1) * SUB_BUCKETS;
+
+    static std::size_t bucketIndex(uint64_t value) {
+        if (value < 2 * SUB_BUCKETS) return static_cast<std::size_t>(value);
+        unsigned msb = 63 - countLeadingZeros(value);
+        if (msb >= MaxBits) return BUCKET_COUNT - 1;
+        unsigned shift = msb - SubBucketBits;
+        return (shift + 1) * SUB_BUCKETS + static_cast<std::size_t>((value >> shift) - SUB_BUCKETS);
+    }
+
+    // Highest value that maps to the bucket, so percentiles never under-report.
+    static uint64_t bucketUpperBound(std::size_t index) {
+        if (index < 2 * SUB_BUCKETS) return index;
+        unsigned shift = static_cast<unsigned>(index / SUB_BUCKETS) - 1;
+        uint64_t mantissa = SUB_BUCKETS + (index % SUB_BUCKETS);
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    // Shared by any bucket array (plain or atomic) that follows this layout.
+    template <typename Buckets>
+    static uint64_t percentileOf(const Buckets& buckets, uint64_t total, double fraction) {
+        if (total == 0) return 0;
+        uint64_t target = static_cast<uint64_t>(fraction * static_cast<double>(total));
+        if (target < 1) target = 1;
+        if (target > total) target = total;
+        uint64_t seen = 0;
+        for (std::size_t i = 0; i < BUCKET_COUNT; ++i) {
+            seen += buckets[i];
+            if (seen >= target) return bucketUpperBound(i);
+        }
+        return bucketUpperBound(BUCKET_COUNT - 1);
+    }
+
+    LogLinearHistogram() { reset(); }
+
+    void record(uint64_t value) {
+        counts[bucketIndex(value)]++;
+        total++;
+    }
+
+    void reset() {
+        counts.fill(0);
+        total = 0;
+    }
+
+    uint64_t percentile(double fraction) const { return percentileOf(counts, total, fraction); }
+    uint64_t count() const { return total; }
+    const std::array<uint64_t, BUCKET_COUNT>& buckets() const { return counts; }
+
+private:
+    std::array<uint64_t, BUCKET_COUNT> counts;
+    uint64_t total;
+
+    static unsigned countLeadingZeros(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned>(__builtin_clzll(value));
+#else
+        unsigned n = 0;
+        for (uint64_t bit = uint64_t(1) << 63; bit != 0 && !(value & bit); bit >>= 1) n++;
+        return n;
+#endif
+    }
+};
+
+#endif
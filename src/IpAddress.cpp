@@ -0,0 +1,199 @@
+#include "IpAddress.h"
+#include <cctype>
+
+namespace {
+    bool parseV4(const std::string& text, std::size_t pos, std::size_t end, uint32_t& address) {
+        address = 0;
+        for (int octet = 0; octet < 4; ++octet) {
+            if (octet > 0) {
+                if (pos >= end || text[pos] != '.') return false;
+                ++pos;
+            }
+            std::size_t digits = 0;
+            unsigned value = 0;
+            while (pos < end && std::isdigit(static_cast<unsigned char>(text[pos])) && digits < 3) {
+                value = value * 10 + static_cast<unsigned>(text[pos] - '0');
+                ++pos;
+                ++digits;
+            }
+            if (digits == 0 || value > 255) return false;
+            address = (address << 8) | value;
+        }
+        return pos == end;
+    }
+
+    int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    bool parseV6(const std::string& text, uint8_t* bytes) {
+        uint16_t groups[8] = {0};
+        int count = 0;
+        int gap = -1;  // Group index where "::" expands
+        std::size_t pos = 0;
+        const std::size_t end = text.size();
+
+        if (text.compare(0, 2, "::") == 0) {
+            gap = 0;
+            pos = 2;
+        } else if (end > 0 && text[0] == ':') {
+            return false;
+        }
+
+        while (pos < end) {
+            if (count == 8) return false;
+
+            // A dotted quad may stand in for the last two groups.
+            std::size_t next = text.find(':', pos);
+            std::size_t fieldEnd = next == std::string::npos ? end : next;
+            if (text.find('.', pos) < fieldEnd) {
+                uint32_t v4;
+                if (next != std::string::npos || count > 6 || !parseV4(text, pos, end, v4)) return false;
+                groups[count++] = static_cast<uint16_t>(v4 >> 16);
+                groups[count++] = static_cast<uint16_t>(v4);
+                pos = end;
+                break;
+            }
+
+            int digits = 0;
+            unsigned value = 0;
+            while (pos < fieldEnd) {
+                int h = hexValue(text[pos]);
+                if (h < 0 || ++digits > 4) return false;
+                value = (value << 4) | static_cast<unsigned>(h);
+                ++pos;
+            }
+            if (digits == 0) return false;
+            groups[count++] = static_cast<uint16_t>(value);
+
+            if (pos == end) break;
+            ++pos;  // ':'
+            if (pos < end && text[pos] == ':') {
+                if (gap >= 0) return false;
+                gap = count;
+                ++pos;
+            } else if (pos == end) {
+                return false;  // Trailing single ':'
+            }
+        }
+
+        if (gap < 0 && count != 8) return false;
+        if (gap >= 0 && count > 7) return false;
+
+        uint16_t expanded[8] = {0};
+        if (gap < 0) {
+            for (int i = 0; i < 8; ++i) expanded[i] = groups[i];
+        } else {
+            for (int i = 0; i < gap; ++i) expanded[i] = groups[i];
+            int tail = count - gap;
+            for (int i = 0; i < tail; ++i) expanded[8 - tail + i] = groups[gap + i];
+        }
+        for (int i = 0; i < 8; ++i) {
+            bytes[2 * i] = static_cast<uint8_t>(expanded[i] >> 8);
+            bytes[2 * i + 1] = static_cast<uint8_t>(expanded[i]);
+        }
+        return true;
+    }
+}
+
+bool IpAddress::parse(const std::string& text, IpAddress& out) {
+    if (text.find(':') == std::string::npos) {
+        uint32_t v4;
+        if (!parseV4(text, 0, text.size(), v4)) return false;
+        out = fromV4(v4);
+        return true;
+    }
+
+    uint8_t bytes[16];
+    if (!parseV6(text, bytes)) return false;
+    out = fromBytes(bytes);
+    return true;
+}
+
+std::string IpAddress::toString() const {
+    char buffer[MAX_TEXT_WIDTH];
+    return std::string(buffer, format(buffer));
+}
+
+char* IpAddress::format(char* out) const {
+    if (isV4()) {
+        uint32_t v = v4();
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            unsigned octet = (v >> shift) & 0xFF;
+            if (octet >= 100) *out++ = static_cast<char>('0' + octet / 100);
+            if (octet >= 10) *out++ = static_cast<char>('0' + octet / 10 % 10);
+            *out++ = static_cast<char>('0' + octet % 10);
+            if (shift > 0) *out++ = '.';
+        }
+        return out;
+    }
+
+    // RFC 5952: lower-case hex, no leading zeros, the longest run of two or
+    // more zero groups (the first on a tie) becomes "::".
+    int bestStart = -1, bestLength = 1;
+    for (int i = 0; i < 8;) {
+        if (group(i) != 0) {
+            ++i;
+            continue;
+        }
+        int start = i;
+        while (i < 8 && group(i) == 0) ++i;
+        if (i - start > bestLength) {
+            bestStart = start;
+            bestLength = i - start;
+        }
+    }
+
+    static const char digits[] = "0123456789abcdef";
+    for (int i = 0; i < 8; ++i) {
+        if (i == bestStart) {
+            *out++ = ':';
+            *out++ = ':';
+            i += bestLength - 1;
+            continue;
+        }
+        if (i > 0 && i != bestStart + bestLength) *out++ = ':';
+        uint16_t value = group(i);
+        bool started = false;
+        for (int shift = 12; shift >= 0; shift -= 4) {
+            unsigned nibble = (value >> shift) & 0xF;
+            if (nibble != 0 || started || shift == 0) {
+                *out++ = digits[nibble];
+                started = true;
+            }
+        }
+    }
+    return out;
+}
+
+bool IpPrefix::parse(const std::string& text, IpPrefix& out) {
+    std::size_t slash = text.find('/');
+    IpAddress address;
+    if (!IpAddress::parse(text.substr(0, slash), address)) return false;
+
+    int limit = address.isV4() ? 32 : 128;
+    int bits = limit;
+    if (slash != std::string::npos) {
+        std::string length = text.substr(slash + 1);
+        if (length.empty() || length.size() > 3) return false;
+        bits = 0;
+        for (char c : length) {
+            if (!std::isdigit(static_cast<unsigned char>(c))) return false;
+            bits = bits * 10 + (c - '0');
+        }
+        if (bits > limit) return false;
+    }
+
+    out.bits = address.isV4() ? bits + 96 : bits;
+    out.network = address.masked(out.bits);
+    return true;
+}
+
+std::string IpPrefix::toString() const {
+    int limit = isV4() ? 32 : 128;
+    int length = isV4() ? bits - 96 : bits;
+    return length == limit ? network.toString() : network.toString() + "/" + std::to_string(length);
+}
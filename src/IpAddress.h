@@ -0,0 +1,121 @@
+#ifndef IP_ADDRESS_H
+#define IP_ADDRESS_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// IPv4 or IPv6 address as a 128-bit value in two words. IPv4 is held in its
+// IPv4-mapped form (::ffff:a.b.c.d) so both families compare, hash and mask
+// the same way; containers that want to keep IPv4 entries at four bytes can
+// test isV4() and key on v4() instead.
+class IpAddress {
+private:
+    uint64_t high;  // Bytes 0-7 of the address, big-endian
+    uint64_t low;   // Bytes 8-15
+
+    static const uint64_t V4_MAPPED = 0x0000FFFF00000000ULL;
+
+public:
+    struct Hash {
+        std::size_t operator()(const IpAddress& address) const { return static_cast<std::size_t>(address.hash()); }
+    };
+
+    // For maps keyed directly by a host-order IPv4 address; std::hash is the
+    // identity for integers on common standard libraries.
+    struct V4Hash {
+        std::size_t operator()(uint32_t address) const { return static_cast<std::size_t>(mix(address)); }
+    };
+
+    IpAddress() : high(0), low(0) {}
+
+    static IpAddress fromV4(uint32_t hostOrder) {
+        IpAddress address;
+        address.low = V4_MAPPED | hostOrder;
+        return address;
+    }
+
+    // From 16 bytes in network order, e.g. straight out of an IPv6 header.
+    static IpAddress fromBytes(const uint8_t* bytes) {
+        IpAddress address;
+        for (int i = 0; i < 8; ++i) {
+            address.high = (address.high << 8) | bytes[i];
+            address.low = (address.low << 8) | bytes[i + 8];
+        }
+        return address;
+    }
+
+    // Accepts dotted-quad IPv4 and RFC 4291 IPv6 text, including "::"
+    // compression and a trailing dotted quad.
+    static bool parse(const std::string& text, IpAddress& out);
+
+    bool isV4() const { return high == 0 && (low & 0xFFFFFFFF00000000ULL) == V4_MAPPED; }
+    uint32_t v4() const { return static_cast<uint32_t>(low); }
+    bool isUnspecified() const { return high == 0 && low == 0; }
+
+    void toBytes(uint8_t* out) const {
+        for (int i = 0; i < 8; ++i) {
+            out[i] = static_cast<uint8_t>(high >> (56 - 8 * i));
+            out[i + 8] = static_cast<uint8_t>(low >> (56 - 8 * i));
+        }
+    }
+
+    uint16_t group(int index) const {
+        uint64_t word = index < 4 ? high : low;
+        return static_cast<uint16_t>(word >> (48 - 16 * (index & 3)));
+    }
+
+    // Keeps the first `bits` of the 128-bit form (an IPv4 /24 is bits = 120).
+    IpAddress masked(int bits) const {
+        IpAddress address;
+        if (bits <= 0) return address;
+        if (bits >= 128) return *this;
+        if (bits >= 64) {
+            address.high = high;
+            address.low = bits == 64 ? 0 : low & (~0ULL << (128 - bits));
+        } else {
+            address.high = high & (~0ULL << (64 - bits));
+        }
+        return address;
+    }
+
+    static const std::size_t MAX_TEXT_WIDTH = 40;  // 39 characters for a full IPv6 address
+
+    // Dotted quad for IPv4, RFC 5952 compressed form for IPv6. format()
+    // writes into a buffer of at least MAX_TEXT_WIDTH and returns the end.
+    std::string toString() const;
+    char* format(char* out) const;
+
+    // Multiply-xorshift over both words; cheap and well spread even for
+    // addresses that differ only in the last few bits.
+    uint64_t hash() const { return mix(high * 0x9E3779B97F4A7C15ULL ^ low); }
+
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xFF51AFD7ED558CCDULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    bool operator==(const IpAddress& other) const { return high == other.high && low == other.low; }
+    bool operator!=(const IpAddress& other) const { return !(*this == other); }
+    bool operator<(const IpAddress& other) const {
+        return high != other.high ? high < other.high : low < other.low;
+    }
+};
+
+// An address with a prefix length, written "2001:db8::/64" or "10.0.0.0/8".
+// The length is stored over the 128-bit form, so IPv4 prefixes are offset by 96.
+struct IpPrefix {
+    IpAddress network;
+    int bits = 128;
+
+    // A bare address is a single-host prefix.
+    static bool parse(const std::string& text, IpPrefix& out);
+
+    bool contains(const IpAddress& address) const { return address.masked(bits) == network; }
+    bool isV4() const { return network.isV4() && bits >= 96; }
+    std::string toString() const;
+};
+
+#endif
@@ -1,105 +1,270 @@
 #include "Logger.h"
 #include "Utils.h"
+#include "FastFormat.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <ctime>
 #include <chrono>
+#include <cstring>
+#include <filesystem>
 
-Logger::Logger() : isLoggingEnabled(false) {}
+namespace {
+    const char CSV_HEADER[] = "Timestamp,Source_IP,Source_Port,Dest_IP,Dest_Port,Protocol,Size_Bytes,Is_Anomaly,Anomaly_Reason\n";
+    const std::size_t FIXED_RECORD_BYTES = FastFormat::TIMESTAMP_WIDTH + 2 * FastFormat::IP_MAX_WIDTH +
+                                           3 * FastFormat::UINT_MAX_WIDTH + 24;
+    
+    std::size_t recordCapacity(std::size_t prefixLength, std::size_t reasonLength) {
+        return FIXED_RECORD_BYTES + FastFormat::PROTOCOL_MAX_WIDTH + prefixLength + reasonLength;
+    }
+    
+    char* formatRecord(char* out, const PacketInfo& packet, const std::chrono::system_clock::time_point& timestamp,
+                       bool isAnomaly, const char* reasonPrefix, std::size_t prefixLength,
+                       const char* reason, std::size_t reasonLength) {
+        out = FastFormat::timestamp(out, timestamp);
+        *out++ = ',';
+        out = FastFormat::address(out, packet.sourceAddr);
+        *out++ = ',';
+        out = FastFormat::uint(out, packet.sourcePort);
+        *out++ = ',';
+        out = FastFormat::address(out, packet.destAddr);
+        *out++ = ',';
+        out = FastFormat::uint(out, packet.destPort);
+        *out++ = ',';
+        out = FastFormat::protocol(out, packet.ipProtocol);
+        *out++ = ',';
+        out = FastFormat::uint(out, packet.packetSize);
+        out = isAnomaly ? FastFormat::text(out, ",true,\"", 7) : FastFormat::text(out, ",false,\"", 8);
+        out = FastFormat::text(out, reasonPrefix, prefixLength);
+        out = FastFormat::text(out, reason, reasonLength);
+        return FastFormat::text(out, "\"\n", 2);
+    }
+}
+
+Logger::Logger()
+    : isLoggingEnabled(false), format(Format::CSV), rotateBytes(0), rotateMinutes(0), retainBytes(0),
+      segmentSequence(0) {
+    resetSegment();
+}
 
 Logger::~Logger() {
     disableLogging();
 }
 
+void Logger::setRotation(uint64_t maxSegmentBytes, int maxSegmentMinutes, uint64_t maxTotalBytes) {
+    rotateBytes = maxSegmentBytes;
+    rotateMinutes = maxSegmentMinutes;
+    retainBytes = maxTotalBytes;
+}
+
+void Logger::resetSegment() {
+    segment.firstNanos = 0;
+    segment.lastNanos = 0;
+    segment.records = 0;
+    segment.bytes = 0;
+    segmentStarted = std::chrono::steady_clock::now();
+}
+
+void Logger::writeHeader() {
+    if (format == Format::BINARY) {
+        writeBinaryHeader();
+    } else {
+        writeCSVHeader();
+    }
+}
+
 void Logger::writeCSVHeader() {
-    if (csvFile.is_open()) {
-        csvFile << "Timestamp,Source_IP,Source_Port,Dest_IP,Dest_Port,Protocol,Size_Bytes,Is_Anomaly,Anomaly_Reason" << std::endl;
+    writer.write(CSV_HEADER, sizeof(CSV_HEADER) - 1);
+    segment.bytes += sizeof(CSV_HEADER) - 1;
+}
+
+void Logger::writeBinaryHeader() {
+    BinaryLog::FileHeader header;
+    std::memcpy(header.magic, BinaryLog::FILE_MAGIC, sizeof(header.magic));
+    header.version = BinaryLog::FORMAT_VERSION;
+    header.headerSize = sizeof(header);
+    writer.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    segment.bytes += sizeof(header);
+}
+
+void Logger::sealBlock() {
+    if (block.empty()) return;
+    std::size_t size = block.encodedSize();
+    char* out = writer.reserve(size);
+    if (out != nullptr) {
+        block.encode(out);
+        commitRecord(size);
     }
+    block.clear();
+}
+
+void Logger::commitRecord(std::size_t size) {
+    writer.commit(size);
+    segment.bytes += size;
+}
+
+void Logger::rotateSegment() {
+    sealBlock();
+    
+    // Runs on the writer thread after the segment is on disk, so neither the
+    // sidecar write nor the retention sweep delays packet processing.
+    SegmentIndex::Entry closed = segment;
+    std::string nextPath = SegmentIndex::segmentPath(csvFilename, ++segmentSequence);
+    std::string basePath = csvFilename;
+    uint64_t retain = retainBytes;
+    writer.rotate(nextPath, [closed, basePath, nextPath, retain](const std::string& path, uint64_t bytes) {
+        SegmentIndex::Entry entry = closed;
+        entry.bytes = bytes;
+        SegmentIndex::writeEntry(path, entry);
+        if (retain > 0) {
+            SegmentIndex::enforceRetention(basePath, retain, nextPath);
+        }
+    });
+    
+    resetSegment();
+    writeHeader();
 }
 
 bool Logger::enableLogging(const std::string& filename) {
-    if (csvFile.is_open()) {
-        csvFile.close();
+    if (writer.isOpen()) {
+        writer.close();
     }
     
     csvFilename = filename;
-    csvFile.open(filename, std::ios::out | std::ios::trunc);
     
-    if (csvFile.is_open()) {
+    // Segments continue numbering after any left by an earlier run.
+    std::string path = filename;
+    if (isSegmented()) {
+        segmentSequence = SegmentIndex::lastSequence(filename) + 1;
+        path = SegmentIndex::segmentPath(filename, segmentSequence);
+    }
+    
+    if (writer.open(path, false, writerOptions)) {
         isLoggingEnabled = true;
-        writeCSVHeader();
-        std::cout << Utils::Colors::GREEN << "Logging enabled: " << filename << Utils::Colors::RESET << std::endl;
+        block.clear();
+        resetSegment();
+        writeHeader();
+        std::cout << Utils::Colors::GREEN << "Logging enabled: " << path << Utils::Colors::RESET << std::endl;
         return true;
     }
     
-    std::cout << Utils::Colors::RED << "Failed to open log file: " << filename << Utils::Colors::RESET << std::endl;
+    isLoggingEnabled = false;
+    std::cout << Utils::Colors::RED << "Failed to open log file: " << path << Utils::Colors::RESET << std::endl;
     return false;
 }
 
 void Logger::disableLogging() {
-    if (csvFile.is_open()) {
-        csvFile.close();
+    if (writer.isOpen()) {
+        sealBlock();
+        std::string lastSegment = writer.getFilename();
+        writer.close();
+        if (isSegmented()) {
+            std::error_code ec;
+            SegmentIndex::Entry entry = segment;
+            entry.bytes = std::filesystem::file_size(lastSegment, ec);
+            SegmentIndex::writeEntry(lastSegment, entry);
+            if (retainBytes > 0) {
+                SegmentIndex::enforceRetention(csvFilename, retainBytes, lastSegment);
+            }
+        }
     }
     isLoggingEnabled = false;
     std::cout << Utils::Colors::YELLOW << "Logging disabled" << Utils::Colors::RESET << std::endl;
 }
 
-void Logger::logPacket(const PacketInfo& packet) {
-    if (!isLoggingEnabled || !csvFile.is_open()) return;
+void Logger::writeRecord(const PacketInfo& packet, const std::chrono::system_clock::time_point& timestamp,
+                         bool isAnomaly, const char* reasonPrefix, const char* reason, std::size_t reasonLength) {
+    int64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+    if (segment.records == 0 || nanos < segment.firstNanos) segment.firstNanos = nanos;
+    if (segment.records == 0 || nanos > segment.lastNanos) segment.lastNanos = nanos;
+    segment.records++;
+    
+    if (format == Format::BINARY) {
+        if (block.empty()) {
+            blockStarted = std::chrono::steady_clock::now();
+        }
+        uint8_t flags = (isAnomaly ? BinaryLog::FLAG_ANOMALY : 0) | (*reasonPrefix != '\0' ? BinaryLog::FLAG_ALERT : 0);
+        block.add(packet, nanos, flags, reason, reasonLength);
+        // Keep each block well inside one writer buffer so it is never split or dropped for size.
+        if (block.full() || block.encodedSize() * 2 >= writer.getOptions().bufferSize) {
+            sealBlock();
+        }
+    } else {
+        std::size_t prefixLength = std::strlen(reasonPrefix);
+        char* out = writer.reserve(recordCapacity(prefixLength, reasonLength));
+        if (out == nullptr) return;
+        
+        char* end = formatRecord(out, packet, timestamp, isAnomaly, reasonPrefix, prefixLength, reason, reasonLength);
+        commitRecord(static_cast<std::size_t>(end - out));
+    }
     
-    csvFile << Utils::formatTimestamp(packet.timestamp) << ","
-            << packet.sourceIP << ","
-            << packet.sourcePort << ","
-            << packet.destIP << ","
-            << packet.destPort << ","
-            << packet.protocol << ","
-            << packet.packetSize << ","
-            << (packet.isAnomaly ? "true" : "false") << ","
-            << "\"" << packet.anomalyReason << "\""
-            << std::endl;
+    if (rotateBytes > 0 && segment.bytes >= rotateBytes) {
+        rotateSegment();
+    }
+}
+
+void Logger::logPacket(const PacketInfo& packet) {
+    if (!isLoggingEnabled) return;
+    writeRecord(packet, packet.timestamp, packet.isAnomaly, "", packet.anomalyReason, std::strlen(packet.anomalyReason));
 }
 
 void Logger::logAlert(const Alert& alert) {
-    if (!isLoggingEnabled || !csvFile.is_open()) return;
-    
-    const auto& packet = alert.packet;
-    csvFile << Utils::formatTimestamp(alert.timestamp) << ","
-            << packet.sourceIP << ","
-            << packet.sourcePort << ","
-            << packet.destIP << ","
-            << packet.destPort << ","
-            << packet.protocol << ","
-            << packet.packetSize << ","
-            << "true,"
-            << "\"ALERT: " << alert.message << "\""
-            << std::endl;
+    if (!isLoggingEnabled) return;
+    writeRecord(alert.packet, alert.timestamp, true, "ALERT: ", alert.message.data(), alert.message.size());
+}
+
+void Logger::poll() {
+    if (isLoggingEnabled) {
+        if (rotateMinutes > 0 && segment.records > 0 &&
+            std::chrono::steady_clock::now() - segmentStarted >= std::chrono::minutes(rotateMinutes)) {
+            rotateSegment();
+        }
+        if (!block.empty() && std::chrono::steady_clock::now() - blockStarted >=
+                                  std::chrono::milliseconds(writer.getOptions().flushIntervalMs)) {
+            sealBlock();
+        }
+        writer.poll();
+    }
+}
+
+void Logger::printStats() const {
+    AsyncWriter::Stats stats = writer.getStats();
+    std::cout << "Log writer: " << (isLoggingEnabled ? writer.getFilename() : std::string("disabled"))
+              << ", " << Utils::formatBytes(stats.bytesWritten) << " in " << stats.writes << " writes"
+              << ", dropped " << stats.recordsDropped << " records, " << stats.producerStalls << " stalls";
+    if (stats.writeErrors > 0) {
+        std::cout << Utils::Colors::RED << ", " << stats.writeErrors << " write errors" << Utils::Colors::RESET;
+    }
+    std::cout << std::endl;
 }
 
 void Logger::exportToCSV(const std::vector<PacketInfo>& packets, const std::string& filename) {
-    std::ofstream exportFile(filename);
+    exportToCSV(packets.size(), [&packets](std::size_t i, PacketInfo& packet) { packet = packets[i]; }, filename);
+}
+
+void Logger::exportToCSV(std::size_t count, const std::function<void(std::size_t, PacketInfo&)>& fill,
+                         const std::string& filename) {
+    std::ofstream exportFile(filename, std::ios::out | std::ios::binary);
     
     if (!exportFile.is_open()) {
         std::cout << Utils::Colors::RED << "Failed to create export file: " << filename << Utils::Colors::RESET << std::endl;
         return;
     }
     
-    exportFile << "Timestamp,Source_IP,Source_Port,Dest_IP,Dest_Port,Protocol,Size_Bytes,Is_Anomaly,Anomaly_Reason" << std::endl;
+    exportFile.write(CSV_HEADER, sizeof(CSV_HEADER) - 1);
     
-    for (const auto& packet : packets) {
-        exportFile << Utils::formatTimestamp(packet.timestamp) << ","
-                   << packet.sourceIP << ","
-                   << packet.sourcePort << ","
-                   << packet.destIP << ","
-                   << packet.destPort << ","
-                   << packet.protocol << ","
-                   << packet.packetSize << ","
-                   << (packet.isAnomaly ? "true" : "false") << ","
-                   << "\"" << packet.anomalyReason << "\""
-                   << std::endl;
+    PacketInfo packet;
+    std::vector<char> line;
+    for (std::size_t i = 0; i < count; ++i) {
+        fill(i, packet);
+        std::size_t reasonLength = std::strlen(packet.anomalyReason);
+        line.resize(recordCapacity(0, reasonLength));
+        char* end = formatRecord(line.data(), packet, packet.timestamp, packet.isAnomaly, "", 0,
+                                 packet.anomalyReason, reasonLength);
+        exportFile.write(line.data(), end - line.data());
     }
     
     exportFile.close();
-    std::cout << Utils::Colors::GREEN << "Exported " << packets.size() << " packets to " << filename << Utils::Colors::RESET << std::endl;
+    std::cout << Utils::Colors::GREEN << "Exported " << count << " packets to " << filename << Utils::Colors::RESET << std::endl;
 }
@@ -3,17 +3,48 @@
 
 #include "PacketTypes.h"
 #include "Alert.h"
+#include "AsyncWriter.h"
+#include "BinaryLog.h"
+#include "SegmentIndex.h"
 #include <string>
-#include <fstream>
 #include <vector>
+#include <chrono>
+#include <functional>
 
 class Logger {
+public:
+    enum class Format { CSV, BINARY };
+    
 private:
     std::string csvFilename;
-    std::ofstream csvFile;
+    AsyncWriter writer;
+    AsyncWriter::Options writerOptions;
     bool isLoggingEnabled;
+    Format format;
+    
+    // Binary records are collected column-wise and written one block at a time.
+    BinaryLog::BlockBuilder block;
+    std::chrono::steady_clock::time_point blockStarted;
     
+    // Segmented logging; a zero limit disables that rotation trigger or the
+    // retention cap. The span of the open segment is tracked here and handed
+    // to the writer thread, which writes the sidecar once the segment is closed.
+    uint64_t rotateBytes;
+    int rotateMinutes;
+    uint64_t retainBytes;
+    unsigned segmentSequence;
+    SegmentIndex::Entry segment;
+    std::chrono::steady_clock::time_point segmentStarted;
+    
+    void writeHeader();
     void writeCSVHeader();
+    void writeBinaryHeader();
+    void sealBlock();
+    void commitRecord(std::size_t size);
+    void rotateSegment();
+    void resetSegment();
+    void writeRecord(const PacketInfo& packet, const std::chrono::system_clock::time_point& timestamp,
+                     bool isAnomaly, const char* reasonPrefix, const char* reason, std::size_t reasonLength);
     
 public:
     Logger();
@@ -24,6 +55,20 @@ public:
     void logPacket(const PacketInfo& packet);
     void logAlert(const Alert& alert);
     void exportToCSV(const std::vector<PacketInfo>& packets, const std::string& filename);
+    // Writes `count` records, each produced into a reused PacketInfo by `fill`.
+    void exportToCSV(std::size_t count, const std::function<void(std::size_t, PacketInfo&)>& fill,
+                     const std::string& filename);
+    
+    // Hands a partly filled buffer to the writer thread once the flush
+    // interval has passed; call regularly from the logging thread.
+    void poll();
+    void setWriterOptions(const AsyncWriter::Options& options) { writerOptions = options; }
+    void setFormat(Format logFormat) { format = logFormat; }
+    Format getFormat() const { return format; }
+    void setRotation(uint64_t maxSegmentBytes, int maxSegmentMinutes, uint64_t maxTotalBytes);
+    bool isSegmented() const { return rotateBytes > 0 || rotateMinutes > 0; }
+    AsyncWriter::Stats getWriterStats() const { return writer.getStats(); }
+    void printStats() const;
     
     bool isEnabled() const { return isLoggingEnabled; }
     const std::string& getFilename() const { return csvFilename; }
@@ -0,0 +1,73 @@
+#include "MemoryBudget.h"
+#include "Utils.h"
+#include <iostream>
+#include <iomanip>
+
+MemoryBudget::MemoryBudget() : limit(DEFAULT_LIMIT) {}
+
+MemoryBudget::Account& MemoryBudget::addAccount(const std::string& name) {
+    accounts.emplace_back(new Account);
+    accounts.back()->name = name;
+    return *accounts.back();
+}
+
+bool MemoryBudget::reserve(Account& account, std::size_t bytes) {
+    uint64_t total = used.get() + bytes;
+    if (total > limit) return false;
+    used.set(total);
+    if (total > peak.get()) peak.set(total);
+    account.bytes.add(bytes);
+    return true;
+}
+
+void MemoryBudget::release(Account& account, std::size_t bytes) {
+    used.set(used.get() - bytes);
+    account.bytes.set(account.bytes.get() - bytes);
+}
+
+void MemoryBudget::printStats() const {
+    std::cout << Utils::Colors::BOLD << "\n=== State Memory ===" << Utils::Colors::RESET << std::endl;
+    std::cout << "Budget: " << Utils::formatBytes(used.get()) << " of " << Utils::formatBytes(limit)
+              << " used (peak " << Utils::formatBytes(peak.get()) << ")" << std::endl;
+
+    std::cout << std::left << std::setw(22) << "  Structure" << std::setw(10) << "Entries" << std::setw(10) << "Capacity"
+              << std::setw(8) << "Slabs" << std::setw(12) << "Memory" << std::setw(12) << "Allocated" << std::setw(12)
+              << "Evicted" << "Expired" << std::endl;
+    for (const auto& account : accounts) {
+        std::cout << "  " << std::left << std::setw(20) << account->name << std::setw(10) << account->entries.get()
+                  << std::setw(10) << account->capacity.get() << std::setw(8) << account->slabs.get() << std::setw(12)
+                  << Utils::formatBytes(account->bytes.get()) << std::setw(12) << account->allocations.get()
+                  << std::setw(12) << account->evictions.get() << account->expirations.get() << std::endl;
+    }
+}
+
+void MemoryBudget::writeMetrics(std::ostream& out) const {
+    out << "# HELP network2_state_budget_bytes Memory limit for per-key state (--max-state-mb).\n"
+        << "# TYPE network2_state_budget_bytes gauge\n"
+        << "network2_state_budget_bytes " << limit << "\n"
+        << "# HELP network2_state_bytes Memory reserved by each per-key structure.\n"
+        << "# TYPE network2_state_bytes gauge\n";
+    for (const auto& account : accounts) {
+        out << "network2_state_bytes{structure=\"" << account->name << "\"} " << account->bytes.get() << "\n";
+    }
+    out << "# HELP network2_state_entries Live entries in each per-key structure.\n"
+        << "# TYPE network2_state_entries gauge\n";
+    for (const auto& account : accounts) {
+        out << "network2_state_entries{structure=\"" << account->name << "\"} " << account->entries.get() << "\n";
+    }
+    out << "# HELP network2_state_slabs Slabs allocated by each per-key structure.\n"
+        << "# TYPE network2_state_slabs gauge\n";
+    for (const auto& account : accounts) {
+        out << "network2_state_slabs{structure=\"" << account->name << "\"} " << account->slabs.get() << "\n";
+    }
+    out << "# HELP network2_state_allocations_total Entries handed out by each structure's slab pool.\n"
+        << "# TYPE network2_state_allocations_total counter\n";
+    for (const auto& account : accounts) {
+        out << "network2_state_allocations_total{structure=\"" << account->name << "\"} " << account->allocations.get() << "\n";
+    }
+    out << "# HELP network2_state_evictions_total Entries recycled because the memory budget was full.\n"
+        << "# TYPE network2_state_evictions_total counter\n";
+    for (const auto& account : accounts) {
+        out << "network2_state_evictions_total{structure=\"" << account->name << "\"} " << account->evictions.get() << "\n";
+    }
+}
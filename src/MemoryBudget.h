@@ -0,0 +1,59 @@
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include "Counters.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Shared cap on the memory held by per-key state (everything that grows with
+// the number of distinct addresses seen). Structures register an Account and
+// reserve memory a slab at a time; once a reservation is refused they recycle
+// their own entries instead of growing, so the total stays under the limit
+// however many sources appear. Reservations come from the processing thread
+// only; the counters may be read from any thread.
+class MemoryBudget {
+public:
+    struct Account {
+        std::string name;
+        SingleWriterCounter bytes;     // Reserved, including index overhead
+        SingleWriterCounter entries;   // Live entries
+        SingleWriterCounter capacity;  // Entries the reserved slabs can hold
+        SingleWriterCounter slabs;
+        SingleWriterCounter allocations;  // Entries handed out, new or reused
+        SingleWriterCounter evictions;
+        SingleWriterCounter expirations;
+    };
+
+    static const std::size_t DEFAULT_LIMIT = 64 * 1024 * 1024;
+
+private:
+    std::size_t limit;
+    SingleWriterCounter used;
+    SingleWriterCounter peak;
+    std::vector<std::unique_ptr<Account>> accounts;
+
+public:
+    MemoryBudget();
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    void setLimit(std::size_t bytes) { limit = bytes; }
+    std::size_t getLimit() const { return limit; }
+    std::size_t getUsed() const { return static_cast<std::size_t>(used.get()); }
+
+    // Accounts are registered while the owning structures are constructed,
+    // before any packet is processed.
+    Account& addAccount(const std::string& name);
+
+    bool reserve(Account& account, std::size_t bytes);
+    void release(Account& account, std::size_t bytes);
+
+    void printStats() const;
+    void writeMetrics(std::ostream& out) const;
+};
+
+#endif
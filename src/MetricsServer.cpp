@@ -0,0 +1,121 @@
+#include "MetricsServer.h"
+#include "Utils.h"
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+
+namespace {
+    const int ACCEPT_POLL_MS = 500;
+    const int CLIENT_TIMEOUT_MS = 2000;
+    const std::size_t MAX_REQUEST_BYTES = 8192;
+}
+
+MetricsServer::MetricsServer() : listenSocket(Socket::INVALID), running(false) {}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::startTcp(uint16_t port) {
+    if (running) {
+        std::cout << Utils::Colors::YELLOW << "Metrics server already running" << Utils::Colors::RESET << std::endl;
+        return false;
+    }
+    
+    std::string error;
+    Socket::Handle sock = Socket::listenTcp("127.0.0.1", port, error);
+    if (sock == Socket::INVALID) {
+        std::cout << Utils::Colors::RED << "Failed to listen for metrics on 127.0.0.1:" << port << ": " << error
+                  << Utils::Colors::RESET << std::endl;
+        return false;
+    }
+
+    listenSocket = sock;
+    running = true;
+    serverThread = std::thread([this]() { serveLoop(); });
+    std::cout << Utils::Colors::GREEN << "Serving metrics on http://127.0.0.1:" << port << "/metrics"
+              << Utils::Colors::RESET << std::endl;
+    return true;
+}
+
+bool MetricsServer::startUnix(const std::string& path) {
+    if (running) {
+        std::cout << Utils::Colors::YELLOW << "Metrics server already running" << Utils::Colors::RESET << std::endl;
+        return false;
+    }
+    
+    std::string error;
+    Socket::Handle sock = Socket::listenUnix(path, error);
+    if (sock == Socket::INVALID) {
+        std::cout << Utils::Colors::RED << "Failed to listen for metrics: " << error << Utils::Colors::RESET << std::endl;
+        return false;
+    }
+
+    unixPath = path;
+    listenSocket = sock;
+    running = true;
+    serverThread = std::thread([this]() { serveLoop(); });
+    std::cout << Utils::Colors::GREEN << "Serving metrics on unix:" << path << Utils::Colors::RESET << std::endl;
+    return true;
+}
+
+void MetricsServer::stop() {
+    running = false;
+    if (serverThread.joinable()) {
+        serverThread.join();
+    }
+    if (listenSocket != Socket::INVALID) {
+        Socket::close(listenSocket);
+        listenSocket = Socket::INVALID;
+    }
+    if (!unixPath.empty()) {
+        std::remove(unixPath.c_str());
+        unixPath.clear();
+    }
+}
+
+void MetricsServer::serveLoop() {
+    while (running) {
+        if (!Socket::waitReadable(listenSocket, ACCEPT_POLL_MS)) continue;
+
+        Socket::Handle client = Socket::accept(listenSocket);
+        if (client == Socket::INVALID) continue;
+
+        handleClient(client);
+        Socket::close(client);
+    }
+}
+
+void MetricsServer::handleClient(Socket::Handle client) {
+    std::string request;
+    char buffer[1024];
+
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST_BYTES) {
+        if (!Socket::waitReadable(client, CLIENT_TIMEOUT_MS)) return;
+        long n = Socket::receive(client, buffer, sizeof(buffer));
+        if (n <= 0) return;
+        request.append(buffer, static_cast<std::size_t>(n));
+    }
+
+    bool isMetrics = request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 13, "GET /metrics?") == 0;
+    if (!isMetrics) {
+        static const char NOT_FOUND[] = "HTTP/1.0 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: 10\r\n\r\nNot Found\n";
+        Socket::sendAll(client, NOT_FOUND, sizeof(NOT_FOUND) - 1);
+        return;
+    }
+
+    std::ostringstream body;
+    if (render) {
+        render(body);
+    }
+    std::string payload = body.str();
+
+    std::ostringstream response;
+    response << "HTTP/1.0 200 OK\r\n"
+             << "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+             << "Content-Length: " << payload.size() << "\r\n"
+             << "Connection: close\r\n\r\n"
+             << payload;
+    std::string data = response.str();
+    Socket::sendAll(client, data.data(), data.size());
+}
@@ -0,0 +1,39 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include "Socket.h"
+#include <string>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <ostream>
+#include <cstdint>
+
+// Minimal HTTP listener serving Prometheus text exposition on GET /metrics.
+// It binds to 127.0.0.1 or, on POSIX systems, a Unix domain socket, and
+// handles one scrape at a time on its own thread. The render callback must
+// only read lock-free snapshots so that scrapes never stall the packet path.
+class MetricsServer {
+private:
+    Socket::Handle listenSocket;
+    std::string unixPath;
+    std::atomic<bool> running;
+    std::thread serverThread;
+
+    void serveLoop();
+    void handleClient(Socket::Handle client);
+
+public:
+    MetricsServer();
+    ~MetricsServer();
+
+    bool startTcp(uint16_t port);
+    bool startUnix(const std::string& path);
+    void stop();
+
+    bool isRunning() const { return running; }
+
+    std::function<void(std::ostream&)> render;
+};
+
+#endif
@@ -0,0 +1,1125 @@
+#include "NetworkMonitor.h"
+#include "Utils.h"
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <csignal>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+bool NetworkMonitor::parseArguments(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        uint64_t number = 0;
+        
+        if (arg == "--help" || arg == "-h") {
+            printHelp();
+            return false;
+        } else if (arg == "--watch-ip" && i + 1 < argc) {
+            std::string ip = argv[++i];
+            IpPrefix prefix;
+            if (!IpPrefix::parse(ip, prefix)) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid IP address '" << ip << "'" 
+                          << Utils::Colors::RESET << std::endl;
+                std::cerr << "Expected an IPv4 or IPv6 address, optionally with a prefix length "
+                          << "(e.g., 192.168.1.10, 10.0.0.0/8, 2001:db8:1:2::/64)" << std::endl;
+                return false;
+            }
+            watchRules.addWatchIP(ip);
+        } else if (arg == "--alert-port" && i + 1 < argc) {
+            std::string portStr = argv[++i];
+            if (!Utils::parseCount(portStr, 65535, number)) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid port number '" << portStr << "'"
+                          << Utils::Colors::RESET << std::endl;
+                std::cerr << "Port must be a number between 0 and 65535" << std::endl;
+                return false;
+            }
+            uint16_t port = static_cast<uint16_t>(number);
+            watchRules.addWatchPort(port);
+        } else if (arg == "--watch-domain" && i + 1 < argc) {
+            std::string domain = argv[++i];
+            DomainName name;
+            if (!DomainName::parse(domain, name)) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid domain name '" << domain << "'"
+                          << Utils::Colors::RESET << std::endl;
+                std::cerr << "Expected a host name of up to " << DomainName::MAX_LENGTH
+                          << " characters such as example.com or *.example.com" << std::endl;
+                return false;
+            }
+            watchRules.addWatchDomain(domain);
+        } else if (arg == "--app-port" && i + 1 < argc) {
+            std::string value = argv[++i];
+            std::size_t colon = value.find(':');
+            AppLayer::Protocol protocol = AppLayer::NONE;
+            if (colon == std::string::npos || !Dissector::parseProtocol(value.substr(0, colon), protocol) ||
+                !Utils::parseCount(value.substr(colon + 1), 65535, number)) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid application port '" << value << "'"
+                          << Utils::Colors::RESET << std::endl;
+                std::cerr << "Expected <app>:<port> with app dns, http, tls, quic or none (e.g., http:8081)" << std::endl;
+                return false;
+            }
+            capture.getDissector().setPort(protocol, static_cast<uint16_t>(number));
+        } else if (arg == "--log" && i + 1 < argc) {
+            logFilename = argv[++i];
+        } else if (arg == "--log-format" && i + 1 < argc) {
+            std::string format = argv[++i];
+            if (format == "csv") {
+                logger.setFormat(Logger::Format::CSV);
+            } else if (format == "binary") {
+                logger.setFormat(Logger::Format::BINARY);
+            } else {
+                std::cerr << Utils::Colors::RED << "Error: Invalid log format '" << format << "'"
+                          << Utils::Colors::RESET << std::endl;
+                std::cerr << "Valid formats: csv, binary" << std::endl;
+                return false;
+            }
+        } else if ((arg == "--log-rotate-mb" || arg == "--log-retain-mb") && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (!Utils::parseCount(value, 65535, number) || number == 0) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid size '" << value << "' for " << arg
+                          << Utils::Colors::RESET << std::endl;
+                std::cerr << "Size must be between 1 and 65535 MB" << std::endl;
+                return false;
+            }
+            (arg == "--log-rotate-mb" ? logRotateMB : logRetainMB) = number;
+        } else if (arg == "--log-rotate-min" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (!Utils::parseCount(value, 65535, number) || number == 0) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid rotation interval '" << value << "'"
+                          << Utils::Colors::RESET << std::endl;
+                return false;
+            }
+            logRotateMinutes = static_cast<int>(number);
+        } else if (arg == "--log-buffer-kb" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (!Utils::parseCount(value, 65535, number) || number < 4) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid log buffer size '" << value << "'"
+                          << Utils::Colors::RESET << std::endl;
+                std::cerr << "Buffer size must be between 4 and 65535 KB" << std::endl;
+                return false;
+            }
+            logOptions.bufferSize = static_cast<size_t>(number) * 1024;
+        } else if (arg == "--log-flush-ms" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (!Utils::parseCount(value, 65535, number) || number == 0) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid log flush interval '" << value << "'"
+                          << Utils::Colors::RESET << std::endl;
+                return false;
+            }
+            logOptions.flushIntervalMs = static_cast<int>(number);
+        } else if (arg == "--log-overflow" && i + 1 < argc) {
+            std::string policy = argv[++i];
+            if (policy == "block") {
+                logOptions.overflow = AsyncWriter::OverflowPolicy::BLOCK;
+            } else if (policy == "drop") {
+                logOptions.overflow = AsyncWriter::OverflowPolicy::DROP;
+            } else {
+                std::cerr << Utils::Colors::RED << "Error: Invalid log overflow policy '" << policy << "'"
+                          << Utils::Colors::RESET << std::endl;
+                std::cerr << "Valid policies: block, drop" << std::endl;
+                return false;
+            }
+        } else if (arg == "--interface" && i + 1 < argc) {
+            i++;
+        } else if (arg == "--read" && i + 1 < argc) {
+            traceFile = argv[++i];
+        } else if (arg == "--collect" && i + 1 < argc) {
+            collectEndpoint = argv[++i];
+        } else if (arg == "--export-to" && i + 1 < argc) {
+            exportOptions.endpoint = argv[++i];
+        } else if (arg == "--export-interval" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (!Utils::parseCount(value, 3600, number) || number == 0) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid export interval '" << value << "'"
+                          << Utils::Colors::RESET << std::endl;
+                std::cerr << "Interval must be between 1 and 3600 seconds" << std::endl;
+                return false;
+            }
+            exportOptions.intervalSeconds = static_cast<int>(number);
+        } else if (arg == "--sensor-name" && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name.empty() || name.size() > Summary::MAX_SENSOR_NAME) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid sensor name '" << name << "'"
+                          << Utils::Colors::RESET << std::endl;
+                std::cerr << "Name must be 1 to " << Summary::MAX_SENSOR_NAME << " characters" << std::endl;
+                return false;
+            }
+            exportOptions.sensor = name;
+        } else if (arg == "--perf-sample" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (!Utils::parseCount(value, 65535, number)) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid sample interval '" << value << "'"
+                          << Utils::Colors::RESET << std::endl;
+                std::cerr << "Sample interval must be a number between 0 (off) and 65535" << std::endl;
+                return false;
+            }
+            perf.setSampleInterval(static_cast<uint32_t>(number));
+        } else if (arg == "--perf-dump" && i + 1 < argc) {
+            perfDumpFile = argv[++i];
+        } else if (arg == "--perf-interval" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (!Utils::parseCount(value, 65535, number) || number == 0) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid dump interval '" << value << "'"
+                          << Utils::Colors::RESET << std::endl;
+                return false;
+            }
+            perfDumpIntervalSeconds = static_cast<int>(number);
+        } else if (arg == "--metrics-port" && i + 1 < argc) {
+            std::string portStr = argv[++i];
+            if (!Utils::parseCount(portStr, 65535, number) || number == 0) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid metrics port '" << portStr << "'"
+                          << Utils::Colors::RESET << std::endl;
+                return false;
+            }
+            metricsPort = static_cast<uint16_t>(number);
+        } else if (arg == "--metrics-socket" && i + 1 < argc) {
+            metricsSocket = argv[++i];
+        } else if (arg == "--daemon" || arg == "--headless") {
+            headless = true;
+        } else if (arg == "--events" && i + 1 < argc) {
+            eventsPath = argv[++i];
+        } else if (arg == "--events-stats" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (!Utils::parseCount(value, 65535, number)) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid stats event interval '" << value << "'"
+                          << Utils::Colors::RESET << std::endl;
+                std::cerr << "Interval must be a number of seconds between 0 (off) and 65535" << std::endl;
+                return false;
+            }
+            statsEventSeconds = static_cast<int>(number);
+        } else if (arg == "--events-flows") {
+            flowsEnabled = true;
+        } else if ((arg == "--flow-idle" || arg == "--flow-active") && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (!Utils::parseCount(value, 65535, number) || number == 0) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid timeout '" << value << "' for " << arg
+                          << Utils::Colors::RESET << std::endl;
+                std::cerr << "Timeout must be between 1 and 65535 seconds" << std::endl;
+                return false;
+            }
+            (arg == "--flow-idle" ? flowIdleSeconds : flowActiveSeconds) = static_cast<int>(number);
+        } else if ((arg == "--cpu-capture" || arg == "--cpu-worker") && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (!Utils::parseCount(value, 65535, number)) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid CPU number '" << value << "' for " << arg
+                          << Utils::Colors::RESET << std::endl;
+                return false;
+            }
+            (arg == "--cpu-capture" ? cpuCapture : cpuWorker) = static_cast<int>(number);
+        } else if (arg == "--busy-poll") {
+            busyPoll = true;
+        } else if (arg == "--event-loop") {
+            eventLoop = true;
+        } else if ((arg == "--sample" || arg == "--overload-max-rate") && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (!Utils::parseCount(value, 65535, number) || number == 0) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid sampling rate '" << value << "' for " << arg
+                          << Utils::Colors::RESET << std::endl;
+                std::cerr << "Rate N (keep 1 in N) must be between 1 and 65535" << std::endl;
+                return false;
+            }
+            (arg == "--sample" ? sampleOptions.baseRate : sampleOptions.maxRate) = static_cast<uint32_t>(number);
+        } else if (arg == "--sample-mode" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode == "flow") {
+                sampleOptions.mode = Sampler::MODE_FLOW;
+            } else if (mode == "packet") {
+                sampleOptions.mode = Sampler::MODE_PACKET;
+            } else {
+                std::cerr << Utils::Colors::RED << "Error: Invalid sampling mode '" << mode << "'"
+                          << Utils::Colors::RESET << std::endl;
+                std::cerr << "Valid modes: flow, packet" << std::endl;
+                return false;
+            }
+        } else if (arg == "--overload-queue" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (!Utils::parseCount(value, 999999999, number)) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid overload queue depth '" << value << "'"
+                          << Utils::Colors::RESET << std::endl;
+                std::cerr << "Depth must be a number of packets up to 999999999 (0 disables adaptive sampling)" << std::endl;
+                return false;
+            }
+            sampleOptions.queueLimit = static_cast<size_t>(number);
+        } else if (arg == "--store-packets" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (!Utils::parseCount(value, 999999999, number)) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid packet store size '" << value << "'"
+                          << Utils::Colors::RESET << std::endl;
+                std::cerr << "Size must be a number of packets up to 999999999 (0 disables the store)" << std::endl;
+                return false;
+            }
+            storePackets = static_cast<size_t>(number);
+        } else if (arg == "--max-state-mb" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (!Utils::parseCount(value, 65535, number) || number == 0) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid state memory budget '" << value << "'"
+                          << Utils::Colors::RESET << std::endl;
+                std::cerr << "Budget must be between 1 and 65535 MB" << std::endl;
+                return false;
+            }
+            stateBudget.setLimit(static_cast<size_t>(number) << 20);
+        } else if (arg == "--flight-mb" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (!Utils::parseCount(value, 65535, number) || number == 0) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid flight recorder size '" << value << "'"
+                          << Utils::Colors::RESET << std::endl;
+                std::cerr << "Size must be between 1 and 65535 MB" << std::endl;
+                return false;
+            }
+            flightOptions.arenaBytes = static_cast<size_t>(number) << 20;
+            flightEnabled = true;
+        } else if (arg == "--flight-seconds" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (!Utils::parseCount(value, 65535, number) || number == 0) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid flight recorder window '" << value << "'"
+                          << Utils::Colors::RESET << std::endl;
+                return false;
+            }
+            flightOptions.windowSeconds = static_cast<int>(number);
+        } else if (arg == "--flight-cooldown" && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (!Utils::parseCount(value, 65535, number)) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid flight recorder cooldown '" << value << "'"
+                          << Utils::Colors::RESET << std::endl;
+                return false;
+            }
+            flightOptions.cooldownSeconds = static_cast<int>(number);
+        } else if (arg == "--flight-dir" && i + 1 < argc) {
+            flightOptions.directory = argv[++i];
+        } else if (arg == "--protocol" && i + 1 < argc) {
+            std::string proto = argv[++i];
+            int number = Utils::protocolNumber(proto);
+            if (number < 0) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid protocol '" << proto << "'"
+                          << Utils::Colors::RESET << std::endl;
+                std::cerr << "Valid protocols: TCP, UDP, ICMP, ICMPv6" << std::endl;
+                return false;
+            }
+            protocolFilter = Utils::protocolToString(number);
+            std::cout << Utils::Colors::GREEN << "Filtering for protocol: " 
+                      << protocolFilter << Utils::Colors::RESET << std::endl;
+        } else {
+            std::cout << Utils::Colors::RED << "Unknown argument: " << arg 
+                      << Utils::Colors::RESET << std::endl;
+            return false;
+        }
+    }
+    
+    if (logRetainMB > 0 && logRotateMB == 0 && logRotateMinutes == 0) {
+        std::cerr << Utils::Colors::RED << "Error: --log-retain-mb requires --log-rotate-mb or --log-rotate-min"
+                  << Utils::Colors::RESET << std::endl;
+        return false;
+    }
+    if (headless && eventsPath.empty()) {
+        eventsPath = "-";
+    }
+    if (eventsPath == "-" && !headless) {
+        std::cerr << Utils::Colors::RED << "Error: --events - needs --daemon; stdout is used by the live display"
+                  << Utils::Colors::RESET << std::endl;
+        return false;
+    }
+    if (flowsEnabled && eventsPath.empty()) {
+        std::cerr << Utils::Colors::RED << "Error: --events-flows requires --events or --daemon"
+                  << Utils::Colors::RESET << std::endl;
+        return false;
+    }
+    if (!collectEndpoint.empty() && (!traceFile.empty() || !exportOptions.endpoint.empty())) {
+        std::cerr << Utils::Colors::RED << "Error: --collect does not capture; it cannot be combined with --read or --export-to"
+                  << Utils::Colors::RESET << std::endl;
+        return false;
+    }
+    if (eventLoop && !EventLoop::isSupported()) {
+        std::cerr << Utils::Colors::RED << "Error: --event-loop needs Linux (epoll)" << Utils::Colors::RESET << std::endl;
+        return false;
+    }
+    if (eventLoop && (busyPoll || cpuCapture >= 0 || !collectEndpoint.empty())) {
+        std::cerr << Utils::Colors::RED << "Error: --event-loop cannot be combined with --busy-poll, --cpu-capture or --collect"
+                  << Utils::Colors::RESET << std::endl;
+        std::cerr << "The loop runs on one thread; pin it with --cpu-worker" << std::endl;
+        return false;
+    }
+    if (!exportOptions.endpoint.empty() && exportOptions.sensor.empty()) {
+        exportOptions.sensor = Socket::hostName().substr(0, Summary::MAX_SENSOR_NAME);
+    }
+    
+    packetStore.setCapacity(storePackets);
+    flowTable.setTimeouts(flowIdleSeconds, flowActiveSeconds);
+    logger.setWriterOptions(logOptions);
+    logger.setRotation(logRotateMB * 1024 * 1024, logRotateMinutes, logRetainMB * 1024 * 1024);
+    if (!logFilename.empty()) {
+        logger.enableLogging(logFilename);
+    }
+    
+    return true;
+}
+
+void NetworkMonitor::printHelp() const {
+    std::cout << "Usage: network2.0 [OPTIONS]\n\n"
+              << "Options:\n"
+              << "  --help, -h              Show this help message\n"
+              << "  --watch-ip <IP[/len]>   Watch traffic for an IPv4/IPv6 address or network\n"
+              << "  --alert-port <PORT>     Alert on traffic to/from specific port\n"
+              << "  --watch-domain <name>   Alert on DNS queries, HTTP requests and TLS SNI for a domain or its subdomains\n"
+              << "  --app-port <app>:<port> Dissect a port as dns, http, tls or quic, or none to turn it off\n"
+              << "  --log <filename>        Enable logging to CSV file\n"
+              << "  --log-format <format>   Log file format: csv or binary (default csv)\n"
+              << "  --log-rotate-mb <MB>    Start a new log segment after this many MB\n"
+              << "  --log-rotate-min <min>  Start a new log segment after this many minutes\n"
+              << "  --log-retain-mb <MB>    Delete the oldest segments beyond this total size\n"
+              << "  --log-buffer-kb <KB>    Size of each log write buffer (default 1024)\n"
+              << "  --log-flush-ms <ms>     Maximum delay before buffered log lines are written (default 1000)\n"
+              << "  --log-overflow <mode>   When the disk falls behind: block or drop (default block)\n"
+              << "  --interface <name>      Specify network interface\n"
+              << "  --read <file.pcap>      Process a saved trace instead of capturing live\n"
+              << "  --protocol <TYPE>       Filter by protocol (TCP, UDP, ICMP, ICMPv6)\n"
+              << "  --perf-sample <N>       Time 1 in N packets per pipeline stage (default 64, 0 = off)\n"
+              << "  --perf-dump <filename>  Append pipeline performance reports to a file\n"
+              << "  --perf-interval <sec>   Seconds between performance reports (default 10)\n"
+              << "  --metrics-port <PORT>   Serve Prometheus metrics on 127.0.0.1:<PORT>/metrics\n"
+              << "  --metrics-socket <path> Serve Prometheus metrics on a Unix domain socket\n"
+              << "  --daemon, --headless    Run without the live display or keyboard input; stop with SIGINT/SIGTERM\n"
+              << "  --events <file|->       Write JSON-lines alert and stats events (default - in daemon mode)\n"
+              << "  --events-stats <sec>    Seconds between stats events (default 10, 0 = off)\n"
+              << "  --events-flows          Also write a flow record when each 5-tuple flow ends\n"
+              << "  --flow-idle <sec>       End a flow after this long without packets (default 30)\n"
+              << "  --flow-active <sec>     End long-lived flows after this long (default 300)\n"
+              << "  --cpu-capture <cpu>     Pin the capture thread to a CPU\n"
+              << "  --cpu-worker <cpu>      Pin the processing thread to a CPU\n"
+              << "  --busy-poll             Spin on the interface and queue instead of sleeping (lowest latency)\n"
+              << "  --event-loop            Capture, process, draw and read commands on one epoll thread (Linux)\n"
+              << "  --sample <N>            Process 1 in N packets or flows (default 1 = everything)\n"
+              << "  --sample-mode <mode>    flow (keep whole connections) or packet (default flow)\n"
+              << "  --overload-queue <N>    Queue depth that starts adaptive sampling (default 262144, 0 = off)\n"
+              << "  --overload-max-rate <N> Highest adaptive sampling rate N (default 1024)\n"
+              << "  --export-to <endpoint>  Send traffic summaries to a collector at host:port or a Unix socket path\n"
+              << "  --export-interval <sec> Seconds of traffic per summary (default 5)\n"
+              << "  --sensor-name <name>    Name of this sensor at the collector (default host name)\n"
+              << "  --collect <endpoint>    Run as a collector on [host:]port (default host 127.0.0.1) or a socket path\n"
+              << "  --store-packets <N>     Keep the last N packets for filtered export (default 1000000)\n"
+              << "  --max-state-mb <MB>     Cap memory used by per-source tracking state (default 64)\n"
+              << "  --flight-mb <MB>        Keep the last <MB> of raw frames for pcapng dumps on alert\n"
+              << "  --flight-seconds <sec>  How far back a flight recorder dump reaches (default 30)\n"
+              << "  --flight-cooldown <sec> Minimum time between alert-triggered dumps (default 60)\n"
+              << "  --flight-dir <dir>      Directory for flight recorder dumps (default .)\n\n"
+              << "Interactive Commands:\n"
+              << "  h, help                 Show help\n"
+              << "  s, stats                Show detailed statistics\n"
+              << "  w, watch                Show current watch rules\n"
+              << "  a, anomalies           Show anomaly detection status\n"
+              << "  t, top [n]             Show top talkers by packets and bytes\n"
+              << "  n, names [n]           Show top DNS, HTTP and TLS server names\n"
+              << "  p, perf                Show pipeline stage latencies and drops\n"
+              << "  d, dump [sec]          Write recent raw frames to a pcapng file\n"
+              << "  r, reset               Reset all statistics\n"
+              << "  l, log <filename>      Enable/disable logging\n"
+              << "  e, export <filename> [filters]\n"
+              << "                         Export stored packets to CSV, oldest first; filters are\n"
+              << "                         ip=ADDR[/len] port=N proto=TCP|UDP|ICMP|ICMPv6 last=<sec> anomalies\n"
+              << "  q, quit                Quit the program\n\n"
+              << "Examples:\n"
+              << "  network2.0 --watch-ip 192.168.1.10 --log traffic.csv\n"
+              << "  network2.0 --alert-port 8080 --interface eth0\n"
+              << "  network2.0 --watch-domain example.com --app-port http:8081 --interface eth0\n"
+              << "  network2.0 --daemon --events-flows --interface eth0 > events.jsonl\n"
+              << "  network2.0 --daemon --collect 0.0.0.0:9300 --events alerts.jsonl\n"
+              << "  network2.0 --daemon --interface eth0 --export-to collector.example:9300\n";
+}
+
+bool NetworkMonitor::initialize(const std::string& interface) {
+    if (collectEndpoint.empty()) {
+        if (!initializeCapture(interface)) {
+            return false;
+        }
+    } else {
+        collector.onAlert = [this](const Collector::Alert& alert) { reportCollectorAlert(alert); };
+        if (!collector.listen(collectEndpoint)) {
+            return false;
+        }
+    }
+    
+    metricsServer.render = [this](std::ostream& out) { writeMetrics(out); };
+    if (metricsPort != 0 && !metricsSocket.empty()) {
+        std::cout << Utils::Colors::RED << "Use either --metrics-port or --metrics-socket, not both"
+                  << Utils::Colors::RESET << std::endl;
+        return false;
+    }
+    if (metricsPort != 0 && !metricsServer.startTcp(metricsPort)) {
+        return false;
+    }
+    if (!metricsSocket.empty() && !metricsServer.startUnix(metricsSocket)) {
+        return false;
+    }
+    
+    if (!eventsPath.empty()) {
+        if (!events.open(eventsPath)) {
+            return false;
+        }
+        flowTable.setExporter([this](const FlowTable::Flow& flow, FlowTable::EndReason reason) {
+            events.writeFlow(flow, reason);
+        });
+    }
+    if (!exportOptions.endpoint.empty() && !exporter.start(exportOptions)) {
+        return false;
+    }
+    lastPerfDump = lastStatsEvent = std::chrono::steady_clock::now();
+    configurePipeline();
+    
+    watchRules.printWatchedItems();
+    return true;
+}
+
+bool NetworkMonitor::initializeCapture(const std::string& interface) {
+    capture.setBusyPoll(busyPoll);
+    capture.setEventDriven(eventLoop);
+    if (!(traceFile.empty() ? capture.initialize(interface) : capture.initializeOffline(traceFile))) {
+        return false;
+    }
+    capture.setPerfMonitor(&perf);
+    sampler.setOptions(sampleOptions);
+    capture.setSampler(&sampler);
+    
+    if (flightEnabled) {
+        if (!flightRecorder.start(flightOptions, capture.getLinkType())) {
+            return false;
+        }
+        capture.setFlightRecorder(&flightRecorder);
+        std::cout << Utils::Colors::GREEN << "Flight recorder: keeping the last "
+                  << Utils::formatBytes(flightRecorder.getOptions().arenaBytes) << " of frames, dumps to "
+                  << flightOptions.directory << Utils::Colors::RESET << std::endl;
+    }
+    
+    if (eventLoop) {
+        // Processed where it was parsed: no queue, no copy, no lock.
+        capture.onPacketReceived = [this](PacketInfo& packet) { Pipeline::process(pipelineContext, packet); };
+        return true;
+    }
+    capture.onPacketReceived = [this](PacketInfo& packet) {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        if (!traceFile.empty()) {
+            queueSpace.wait(lock, [this]() { return packetQueue.size() < MAX_TRACE_BACKLOG || !running; });
+        } else if (sampler.isAdaptive() && packetQueue.size() >= SHED_QUEUE_FACTOR * sampleOptions.queueLimit) {
+            sampler.shed();
+            return;
+        }
+        packetQueue.push_back(std::move(packet));
+        if (busyPoll) {
+            packetsPending.store(true, std::memory_order_release);
+            if (workerParked) {
+                queueReady.notify_one();
+            }
+        }
+    };
+    return true;
+}
+
+void NetworkMonitor::writeMetrics(std::ostream& out) const {
+    if (!collectEndpoint.empty()) {
+        collector.writeMetrics(out);
+        stateBudget.writeMetrics(out);
+        events.writeMetrics(out);
+        return;
+    }
+    stats.writeMetrics(out);
+    sampler.writeMetrics(out);
+    anomalyDetector.writeMetrics(out);
+    stateBudget.writeMetrics(out);
+    watchRules.writeMetrics(out);
+    perf.writeMetrics(out);
+    capture.writeMetrics(out);
+    flightRecorder.writeMetrics(out);
+    events.writeMetrics(out);
+    exporter.writeMetrics(out);
+}
+
+void NetworkMonitor::start() {
+    if (!collectEndpoint.empty()) {
+        running = true;
+        collectLoop();
+        metricsServer.stop();
+        collector.close();
+        finishEvents();
+        return;
+    }
+    if (eventLoop) {
+        runEventLoop();
+        metricsServer.stop();
+        capture.stopCapture();
+        exporter.stop();
+        finishEvents();
+        flightRecorder.stop();
+        return;
+    }
+    
+    configurePipeline();
+    running = true;
+    captureFinished = false;
+    
+    std::thread captureThread([this]() {
+        pinThread("capture", cpuCapture);
+        capture.startCapture();
+        captureFinished = true;
+    });
+    
+    std::thread displayThread;
+    if (headless) {
+        pinThread("processing", cpuWorker);
+        headlessLoop();
+    } else {
+        displayThread = std::thread([this]() {
+            pinThread("processing", cpuWorker);
+            displayLoop();
+        });
+        handleUserInput();
+    }
+    
+    running = false;
+    queueSpace.notify_all();
+    queueReady.notify_all();
+    capture.requestStop();
+    metricsServer.stop();
+    
+    if (captureThread.joinable()) {
+        captureThread.join();
+    }
+    if (displayThread.joinable()) {
+        displayThread.join();
+    }
+    capture.stopCapture();
+    drainQueue();
+    exporter.stop();
+    finishEvents();
+    flightRecorder.stop();
+}
+
+void NetworkMonitor::stop() {
+    running = false;
+    queueSpace.notify_all();
+    queueReady.notify_all();
+    capture.stopCapture();
+}
+
+// Reads the whole trace as fast as the pipeline allows, with no display and
+// no pause between batches, then shuts down. Needs --read.
+bool NetworkMonitor::replay(ReplaySummary& summary) {
+    if (traceFile.empty()) {
+        std::cout << Utils::Colors::RED << "Replay needs a trace file (--read)" << Utils::Colors::RESET << std::endl;
+        return false;
+    }
+    
+    // Nothing is displayed, so the pipeline can skip the live table.
+    headless = true;
+    configurePipeline();
+    auto startTime = std::chrono::steady_clock::now();
+    bool completed = false;
+    if (eventLoop) {
+        completed = runEventLoop();
+    } else {
+        running = true;
+        std::thread processingThread([this]() {
+            pinThread("processing", cpuWorker);
+            while (running) {
+                drainQueue();
+                periodicTasks();
+                waitForPackets(std::chrono::steady_clock::now() + std::chrono::milliseconds(1));
+            }
+        });
+        
+        pinThread("capture", cpuCapture);
+        completed = capture.startCapture();
+        running = false;
+        queueSpace.notify_all();
+        queueReady.notify_all();
+        processingThread.join();
+    }
+    drainQueue();
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    exporter.stop();
+    finishEvents();
+    
+    capture.stopCapture();
+    metricsServer.stop();
+    flightRecorder.stop();
+    if (logger.isEnabled()) {
+        logger.disableLogging();
+    }
+    
+    PerfMonitor::Snapshot snapshot = perf.snapshot();
+    summary.frames = snapshot.stages[PerfMonitor::STAGE_PARSE].packets;
+    summary.packets = snapshot.stages[PerfMonitor::STAGE_QUEUE].packets;
+    summary.maxQueueDepth = snapshot.maxQueueDepth;
+    summary.captureDrops = snapshot.pcapDropped + snapshot.pcapIfDropped;
+    summary.logDrops = logger.getWriterStats().recordsDropped;
+    return completed;
+}
+
+// Points the pipeline at the monitor's components and resolves the current
+// configuration. Call with the processing lock held once processing has started.
+void NetworkMonitor::configurePipeline() {
+    pipelineContext.perf = &perf;
+    pipelineContext.detector = &anomalyDetector;
+    pipelineContext.stats = &stats;
+    pipelineContext.watchRules = &watchRules;
+    pipelineContext.store = &packetStore;
+    pipelineContext.flows = flowsEnabled ? &flowTable : nullptr;
+    pipelineContext.logger = &logger;
+    pipelineContext.events = &events;
+    pipelineContext.flight = flightEnabled ? &flightRecorder : nullptr;
+    pipelineContext.exporter = &exporter;
+    pipelineContext.onAlert = &onAlert;
+    pipelineContext.protocolFilter = protocolFilter;
+    pipelineContext.recent = headless ? nullptr : recentPackets;
+    pipelineContext.recentSize = MAX_DISPLAY_PACKETS;
+    pipelineContext.recentIndex = &currentIndex;
+    Pipeline::configure(pipelineContext);
+}
+
+void NetworkMonitor::dumpPerf() {
+    std::ofstream out(perfDumpFile, std::ios::out | std::ios::app);
+    if (!out.is_open()) {
+        return;
+    }
+    out << "=== " << Utils::getCurrentDateTime() << " ===" << std::endl;
+    perf.dump(out);
+    out << std::endl;
+}
+
+void NetworkMonitor::exportPackets(const std::vector<std::string>& args) {
+    if (args.size() < 2 || args[1].empty()) {
+        std::cout << Utils::Colors::YELLOW << "Usage: export <filename> [ip=ADDR[/len]] [port=N] [proto=TCP|UDP|ICMP|ICMPv6] [last=sec] [anomalies]"
+                  << Utils::Colors::RESET << std::endl;
+        return;
+    }
+    const std::string& filename = args[1];
+    
+    if (!packetStore.isEnabled()) {
+        if (args.size() > 2) {
+            std::cout << Utils::Colors::YELLOW << "Filters need the packet store (--store-packets)"
+                      << Utils::Colors::RESET << std::endl;
+            return;
+        }
+        std::vector<PacketInfo> packets;
+        {
+            std::lock_guard<std::mutex> lock(processingMutex);
+            size_t count = (std::min)(stats.getTotalPackets(), static_cast<uint64_t>(MAX_DISPLAY_PACKETS));
+            size_t oldest = count < MAX_DISPLAY_PACKETS ? 0 : currentIndex;
+            for (size_t i = 0; i < count; ++i) {
+                packets.push_back(recentPackets[(oldest + i) % MAX_DISPLAY_PACKETS]);
+            }
+        }
+        logger.exportToCSV(packets, filename);
+        return;
+    }
+    
+    PacketStore::Filter filter;
+    std::string error;
+    if (!PacketStore::Filter::parse(std::vector<std::string>(args.begin() + 2, args.end()), filter, error)) {
+        std::cout << Utils::Colors::RED << error << Utils::Colors::RESET << std::endl;
+        return;
+    }
+    
+    // Only the scan runs under the store lock; formatting and file I/O happen after.
+    PacketStore::Result result;
+    {
+        std::lock_guard<std::mutex> lock(packetStoreMutex);
+        packetStore.query(filter, result);
+    }
+    logger.exportToCSV(result.size(), [&result](size_t i, PacketInfo& packet) { result.toPacketInfo(i, packet); }, filename);
+}
+
+// Takes the whole queue under the queue lock and runs it through the
+// pipeline after releasing it, so capture keeps queueing meanwhile.
+void NetworkMonitor::drainQueue() {
+    std::deque<PacketInfo> batch;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        packetsPending.store(false, std::memory_order_relaxed);
+        perf.updateQueueDepth(packetQueue.size());
+        batch.swap(packetQueue);
+    }
+    queueSpace.notify_all();
+    
+    std::lock_guard<std::mutex> processing(processingMutex);
+    {
+        std::lock_guard<std::mutex> store(packetStoreMutex);
+        for (PacketInfo& packet : batch) {
+            Pipeline::process(pipelineContext, packet);
+        }
+    }
+    stats.flush();
+    logger.poll();
+    events.poll();
+}
+
+// Returns at `deadline`, or with --busy-poll as soon as packets are queued:
+// spins on the pending flag for BUSY_POLL_SPINS checks, then parks until the
+// capture thread signals a push or the deadline passes.
+void NetworkMonitor::waitForPackets(std::chrono::steady_clock::time_point deadline) {
+    if (!busyPoll) {
+        std::this_thread::sleep_until(deadline);
+        return;
+    }
+    for (unsigned spin = 0; spin < BUSY_POLL_SPINS; ++spin) {
+        if (packetsPending.load(std::memory_order_acquire) || !running) {
+            return;
+        }
+        Utils::cpuRelax();
+    }
+    std::unique_lock<std::mutex> lock(queueMutex);
+    workerParked = true;
+    queueReady.wait_until(lock, deadline, [this]() { return !packetQueue.empty() || !running; });
+    workerParked = false;
+}
+
+// Threads are pinned as they start, before they allocate anything, so on a
+// NUMA machine first-touch places their tables and buffers on the node of
+// the chosen CPU.
+void NetworkMonitor::pinThread(const char* name, int cpu) {
+    if (cpu < 0) {
+        return;
+    }
+    // Built first and written once: the capture thread may be printing too.
+    bool pinned = Utils::pinCurrentThread(cpu);
+    std::string message = (pinned ? Utils::Colors::GREEN + "Pinned " : Utils::Colors::YELLOW + "Could not pin ") +
+                          name + " thread to CPU " + std::to_string(cpu) + Utils::Colors::RESET + "\n";
+    std::cout << message << std::flush;
+}
+
+// Timed work shared by the display, headless and replay loops. Runs on the
+// processing thread, which owns the flow table and the event writer.
+void NetworkMonitor::periodicTasks() {
+    auto now = std::chrono::steady_clock::now();
+    if (flowsEnabled) {
+        flowTable.expire();
+    }
+    // A trace's packets carry their own times, which close the intervals.
+    if (exporter.isEnabled() && traceFile.empty()) {
+        exporter.tick(std::chrono::system_clock::now());
+    }
+    if (!perfDumpFile.empty() && now - lastPerfDump >= std::chrono::seconds(perfDumpIntervalSeconds)) {
+        dumpPerf();
+        lastPerfDump = now;
+    }
+    if (events.isEnabled() && statsEventSeconds > 0 &&
+        now - lastStatsEvent >= std::chrono::seconds(statsEventSeconds)) {
+        writeStatsEvent();
+        lastStatsEvent = now;
+    }
+}
+
+void NetworkMonitor::writeStatsEvent() {
+    NetworkStats::Snapshot snapshot = stats.snapshot();
+    PerfMonitor::Snapshot perfSnapshot = perf.snapshot();
+    
+    EventWriter::Stats event;
+    event.nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    if (!collectEndpoint.empty()) {
+        event.packets = collector.getPackets();
+        event.bytes = collector.getBytes();
+        event.anomalies = collector.getAnomalies();
+        event.stateBytes = stateBudget.getUsed();
+        events.writeStats(event);
+        return;
+    }
+    event.packets = snapshot.totalPackets;
+    event.bytes = snapshot.totalBytes;
+    event.anomalies = snapshot.anomalousPackets;
+    event.packetRate = snapshot.rates.packets[1];
+    event.byteRate = snapshot.rates.bytes[1];
+    event.queueDepth = perfSnapshot.queueDepth;
+    event.captureDrops = perfSnapshot.pcapDropped + perfSnapshot.pcapIfDropped;
+    event.stateBytes = stateBudget.getUsed();
+    event.activeFlows = flowTable.getActiveFlows();
+    event.sampleRate = sampler.getRate();
+    event.sampledOut = sampler.getSkipped();
+    events.writeStats(event);
+}
+
+// Ends every open flow and writes a last stats event, so a clean shutdown
+// leaves a complete record. Call once the processing loop has stopped.
+void NetworkMonitor::finishEvents() {
+    if (!events.isEnabled()) {
+        return;
+    }
+    if (flowsEnabled) {
+        flowTable.flush();
+    }
+    if (statsEventSeconds > 0) {
+        writeStatsEvent();
+    }
+    events.close();
+}
+
+void NetworkMonitor::displayLoop() {
+    auto nextDisplay = std::chrono::steady_clock::now();
+    
+    while (running) {
+        drainQueue();
+        
+        if (std::chrono::steady_clock::now() >= nextDisplay) {
+            std::lock_guard<std::mutex> lock(processingMutex);
+            size_t displayCount = (std::min)(stats.getTotalPackets(), 
+                                         static_cast<uint64_t>(MAX_DISPLAY_PACKETS));
+            stats.printLiveTable(recentPackets, displayCount);
+            nextDisplay = std::chrono::steady_clock::now() + std::chrono::milliseconds(DISPLAY_INTERVAL_MS);
+        }
+        
+        periodicTasks();
+        waitForPackets(nextDisplay);
+    }
+}
+
+// Daemon mode: no display and no stdin. Runs until a signal clears `running`
+// or, when reading a trace, the capture ends and the queue has been drained.
+void NetworkMonitor::headlessLoop() {
+    while (running) {
+        bool finished = captureFinished;
+        drainQueue();
+        periodicTasks();
+        if (finished) {
+            break;
+        }
+        waitForPackets(std::chrono::steady_clock::now() + std::chrono::milliseconds(HEADLESS_TICK_MS));
+    }
+}
+
+// Collector mode: merges sensor summaries until a signal clears `running`.
+// Without --daemon a status report is printed every COLLECTOR_STATUS_SECONDS.
+void NetworkMonitor::collectLoop() {
+    auto lastStatus = std::chrono::steady_clock::now();
+    while (running) {
+        collector.poll(HEADLESS_TICK_MS);
+        auto now = std::chrono::steady_clock::now();
+        if (events.isEnabled() && statsEventSeconds > 0 &&
+            now - lastStatsEvent >= std::chrono::seconds(statsEventSeconds)) {
+            writeStatsEvent();
+            lastStatsEvent = now;
+        }
+        events.poll();
+        if (!headless && now - lastStatus >= std::chrono::seconds(COLLECTOR_STATUS_SECONDS)) {
+            collector.printStatus(COLLECTOR_TOP_TALKERS);
+            lastStatus = now;
+        }
+    }
+}
+
+// --event-loop: capture, processing, the live table, commands, timed work and
+// signals all run on the calling thread. Frames go through the pipeline
+// inside pcap_dispatch(), so the packet path has no queue, copy or lock.
+// Returns false if the loop could not be set up.
+bool NetworkMonitor::runEventLoop() {
+    EventLoop loop;
+    std::string error;
+    bool ready = loop.open(error) &&
+                 loop.addSignals({SIGINT, SIGTERM}, [&loop](int) { loop.stop(); }, error) &&
+                 loop.addTimer(headless ? HEADLESS_TICK_MS : DISPLAY_INTERVAL_MS, [this]() {
+                     if (!headless) {
+                         size_t displayCount = (std::min)(stats.getTotalPackets(),
+                                                          static_cast<uint64_t>(MAX_DISPLAY_PACKETS));
+                         stats.printLiveTable(recentPackets, displayCount);
+                     }
+                     periodicTasks();
+                     stats.flush();
+                     logger.poll();
+                     events.poll();
+                 }, error);
+    if (ready && traceFile.empty()) {
+        int fd = capture.getSelectableFd();
+        if (fd < 0) {
+            error = "the capture handle cannot be polled";
+            ready = false;
+        } else {
+            ready = loop.watch(fd, [this, &loop]() { readPackets(loop); }, error);
+        }
+    } else if (ready) {
+        // A trace file is always readable, so it is read between events.
+        loop.setIdle([this, &loop]() { return readPackets(loop); });
+    }
+#ifndef _WIN32
+    if (ready && !headless) {
+        ready = loop.watch(STDIN_FILENO, [this, &loop]() { readCommands(loop); }, error);
+    }
+#endif
+    if (!ready) {
+        std::cout << Utils::Colors::RED << "Cannot start the event loop: " << error << Utils::Colors::RESET << std::endl;
+        return false;
+    }
+    
+    running = true;
+    captureFinished = false;
+    pinThread("event loop", cpuWorker);
+    std::cout << Utils::Colors::GREEN << "Starting packet capture (event loop)..." << Utils::Colors::RESET << std::endl;
+    if (!headless) {
+        std::cout << "\nPress 'h' for help, 'q' to quit: " << std::flush;
+    }
+    loop.run();
+    running = false;
+    return true;
+}
+
+// Handles up to EVENT_LOOP_MAX_BATCHES batches, then returns so that timers
+// and input are not starved under load; epoll reports the descriptor again
+// if frames are left. False once the capture has ended.
+bool NetworkMonitor::readPackets(EventLoop& loop) {
+    bool more = true;
+    for (int batch = 0; batch < EVENT_LOOP_MAX_BATCHES; ++batch) {
+        int count = capture.dispatch(EVENT_LOOP_BATCH);
+        if (count < 0) {
+            more = false;
+            break;
+        }
+        if (count < EVENT_LOOP_BATCH) {
+            break;
+        }
+    }
+    stats.flush();
+    logger.poll();
+    events.poll();
+    if (!more) {
+        captureFinished = true;
+        // Like the threaded modes, the live table stays up after a trace ends.
+        if (headless || traceFile.empty()) {
+            loop.stop();
+        }
+    }
+    return more;
+}
+
+// Runs each complete line the terminal has sent as a command. End of input
+// or "q" stops the loop.
+void NetworkMonitor::readCommands(EventLoop& loop) {
+#ifndef _WIN32
+    char buffer[256];
+    ssize_t length = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+    if (length <= 0) {
+        loop.stop();
+        return;
+    }
+    commandBuffer.append(buffer, static_cast<size_t>(length));
+    size_t end;
+    while ((end = commandBuffer.find('\n')) != std::string::npos) {
+        std::string input = commandBuffer.substr(0, end);
+        commandBuffer.erase(0, end + 1);
+        if (!handleCommand(input)) {
+            loop.stop();
+            return;
+        }
+        std::cout << "\nCommand: " << std::flush;
+    }
+#else
+    loop.stop();
+#endif
+}
+
+void NetworkMonitor::reportCollectorAlert(const Collector::Alert& alert) {
+    bool global = std::string(alert.kind) == "global";
+    std::string sensors;
+    for (const std::string& sensor : alert.sensors) {
+        sensors += (sensors.empty() ? "" : ", ") + sensor;
+    }
+    auto timestamp = std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(alert.nanos)));
+    std::cout << (global ? Utils::Colors::RED : Utils::Colors::YELLOW) << "[" << Utils::formatTimestamp(timestamp) << "] "
+              << (global ? "GLOBAL: " : "SENSOR: ") << alert.reason << " from " << alert.source.toString()
+              << " (" << alert.count << ", seen by " << sensors << ")" << Utils::Colors::RESET << std::endl;
+    events.writeCollectorAlert(alert);
+}
+
+void NetworkMonitor::handleUserInput() {
+    std::string input;
+    std::cout << "\nPress 'h' for help, 'q' to quit: ";
+    
+    while (running && std::getline(std::cin, input) && handleCommand(input)) {
+        std::cout << "\nCommand: ";
+    }
+    
+    running = false;
+}
+
+bool NetworkMonitor::handleCommand(const std::string& input) {
+    if (input == "q" || input == "quit") {
+        return false;
+    } else if (input == "h" || input == "help") {
+        printHelp();
+    } else if (input == "s" || input == "stats") {
+        stats.printStats();
+        stateBudget.printStats();
+    } else if (input == "w" || input == "watch") {
+        watchRules.printWatchedItems();
+    } else if (input == "a" || input == "anomalies") {
+        anomalyDetector.printStats();
+        stateBudget.printStats();
+    } else if (input == "t" || input == "top" || input.substr(0, 2) == "t " || input.substr(0, 4) == "top ") {
+        uint64_t count = 10;
+        size_t space = input.find(' ');
+        if (space != std::string::npos && !Utils::parseCount(input.substr(space + 1), 65535, count)) {
+            std::cout << Utils::Colors::YELLOW << "Usage: top [n], with n up to 65535"
+                      << Utils::Colors::RESET << std::endl;
+        } else {
+            stats.printTopTalkers(static_cast<size_t>(count));
+        }
+    } else if (input == "n" || input == "names" || input.substr(0, 2) == "n " || input.substr(0, 6) == "names ") {
+        uint64_t count = 10;
+        size_t space = input.find(' ');
+        if (space != std::string::npos && !Utils::parseCount(input.substr(space + 1), 65535, count)) {
+            std::cout << Utils::Colors::YELLOW << "Usage: names [n], with n up to 65535"
+                      << Utils::Colors::RESET << std::endl;
+        } else {
+            stats.printTopDomains(static_cast<size_t>(count));
+        }
+    } else if (input == "p" || input == "perf") {
+        perf.printStats();
+        capture.printStats();
+        sampler.printStats();
+        exporter.printStats();
+        logger.printStats();
+        events.printStats();
+        flightRecorder.printStats();
+        {
+            std::lock_guard<std::mutex> lock(packetStoreMutex);
+            packetStore.printStats();
+        }
+    } else if (input == "d" || input == "dump" || input.substr(0, 2) == "d " || input.substr(0, 5) == "dump ") {
+        if (!flightRecorder.isRunning()) {
+            std::cout << Utils::Colors::YELLOW << "Flight recorder is off; start with --flight-mb <MB>"
+                      << Utils::Colors::RESET << std::endl;
+        } else {
+            uint64_t seconds = 0;
+            size_t space = input.find(' ');
+            if (space != std::string::npos && !Utils::parseCount(input.substr(space + 1), 65535, seconds)) {
+                std::cout << Utils::Colors::YELLOW << "Usage: dump [sec], with sec up to 65535"
+                          << Utils::Colors::RESET << std::endl;
+            } else {
+                flightRecorder.requestDump(static_cast<int>(seconds), "manual dump");
+                std::cout << "Writing flight recorder dump..." << std::endl;
+            }
+        }
+    } else if (input == "r" || input == "reset") {
+        stats.reset();
+        {
+            // Tracker tables belong to the processing thread, which holds the processing lock.
+            std::lock_guard<std::mutex> lock(processingMutex);
+            anomalyDetector.reset();
+        }
+        std::cout << Utils::Colors::GREEN << "Statistics reset" << Utils::Colors::RESET << std::endl;
+    } else if (input.substr(0, 2) == "l " || input.substr(0, 4) == "log ") {
+        std::string filename = input.substr(input.find(' ') + 1);
+        // The processing thread writes to the logger while holding the processing lock.
+        std::lock_guard<std::mutex> lock(processingMutex);
+        if (filename == "off") {
+            logger.disableLogging();
+        } else {
+            logger.enableLogging(filename);
+        }
+        configurePipeline();
+    } else if (input.substr(0, 2) == "e " || input.substr(0, 7) == "export ") {
+        exportPackets(Utils::splitString(input, ' '));
+    } else {
+        std::cout << Utils::Colors::YELLOW << "Unknown command. Type 'h' for help." 
+                  << Utils::Colors::RESET << std::endl;
+    }
+    return true;
+}
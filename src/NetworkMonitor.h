@@ -0,0 +1,175 @@
+#ifndef NETWORK_MONITOR_H
+#define NETWORK_MONITOR_H
+
+#include "PacketCapture.h"
+#include "AnomalyDetector.h"
+#include "MemoryBudget.h"
+#include "NetworkStats.h"
+#include "WatchRules.h"
+#include "Logger.h"
+#include "PerfMonitor.h"
+#include "MetricsServer.h"
+#include "FlightRecorder.h"
+#include "PacketStore.h"
+#include "FlowTable.h"
+#include "EventWriter.h"
+#include "Pipeline.h"
+#include "Sampler.h"
+#include "SummaryExporter.h"
+#include "Collector.h"
+#include "EventLoop.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <deque>
+#include <string>
+#include <vector>
+
+class NetworkMonitor {
+public:
+    // Totals from one headless pass over a trace file.
+    struct ReplaySummary {
+        uint64_t frames = 0;         // Frames read from the trace
+        uint64_t packets = 0;        // Frames that parsed and were processed
+        double seconds = 0;          // Wall time from the first read to the drained queue
+        uint64_t maxQueueDepth = 0;
+        uint64_t captureDrops = 0;   // Reported by libpcap (kernel and interface)
+        uint64_t logDrops = 0;       // Log records dropped under --log-overflow drop
+    };
+
+private:
+    PacketCapture capture;
+    Sampler sampler;
+    Sampler::Options sampleOptions;
+    MemoryBudget stateBudget;  // Declared before the structures that charge it
+    AnomalyDetector anomalyDetector;
+    FlowTable flowTable;
+    SummaryExporter exporter;
+    SummaryExporter::Options exportOptions;
+    Collector collector;
+    std::string collectEndpoint;  // Non-empty = collector mode, no capture
+    NetworkStats stats;
+    WatchRules watchRules;
+    Logger logger;
+    PerfMonitor perf;
+    MetricsServer metricsServer;
+    FlightRecorder flightRecorder;
+    FlightRecorder::Options flightOptions;
+    bool flightEnabled = false;
+    PacketStore packetStore;
+    size_t storePackets = 1000000;
+    std::string protocolFilter;  // Empty = no filter, "TCP", "UDP", "ICMP" or "ICMPv6"
+    std::string traceFile;       // Read packets from this pcap instead of an interface
+    std::string logFilename;
+    AsyncWriter::Options logOptions;
+    uint64_t logRotateMB = 0;
+    int logRotateMinutes = 0;
+    uint64_t logRetainMB = 0;
+    std::string perfDumpFile;
+    int perfDumpIntervalSeconds = 10;
+    uint16_t metricsPort = 0;
+    std::string metricsSocket;
+    bool headless = false;
+    EventWriter events;
+    std::string eventsPath;      // "-" for stdout
+    int statsEventSeconds = 10;  // 0 = no stats events
+    bool flowsEnabled = false;
+    int flowIdleSeconds = FlowTable::DEFAULT_IDLE_SECONDS;
+    int flowActiveSeconds = FlowTable::DEFAULT_ACTIVE_SECONDS;
+    std::chrono::steady_clock::time_point lastPerfDump;
+    std::chrono::steady_clock::time_point lastStatsEvent;
+    int cpuCapture = -1;  // -1 = not pinned
+    int cpuWorker = -1;
+    bool busyPoll = false;
+    bool eventLoop = false;  // One thread multiplexes capture, input, timers and signals
+    std::string commandBuffer;  // Event loop: input not yet ended by a newline
+
+    std::atomic<bool> running{false};
+    std::atomic<bool> captureFinished{false};
+    std::deque<PacketInfo> packetQueue;
+    std::mutex queueMutex;  // Guards only packetQueue and workerParked
+    // Held while the processing thread runs a batch through the pipeline:
+    // the detector, logger, pipeline context and live-table ring.
+    std::mutex processingMutex;
+    std::mutex packetStoreMutex;  // Held by the processing thread while it adds a batch
+    std::condition_variable queueSpace;  // Signalled when the queue has been drained
+    std::condition_variable queueReady;  // Busy-poll: signalled on push while the worker is parked
+    std::atomic<bool> packetsPending{false};  // Busy-poll: set on push, cleared by drainQueue()
+    bool workerParked = false;  // Guarded by queueMutex
+
+    // A trace can be read much faster than it is analysed, so the reader
+    // waits once this many packets are queued instead of queueing the file.
+    static constexpr size_t MAX_TRACE_BACKLOG = 8192;
+
+    // How often the headless loop drains the queue and writes events, and
+    // how often the live table is redrawn.
+    static constexpr int HEADLESS_TICK_MS = 100;
+    static constexpr int DISPLAY_INTERVAL_MS = 500;
+    static constexpr int COLLECTOR_STATUS_SECONDS = 10;
+    static constexpr size_t COLLECTOR_TOP_TALKERS = 10;
+
+    // With adaptive sampling, packets are shed outright once the queue is
+    // this many times the overload limit.
+    static constexpr size_t SHED_QUEUE_FACTOR = 4;
+
+    // Event loop: frames per pcap_dispatch() call, and calls per wakeup
+    // before timers and input get their turn.
+    static constexpr int EVENT_LOOP_BATCH = 256;
+    static constexpr int EVENT_LOOP_MAX_BATCHES = 16;
+
+    // Busy-poll: empty queue checks before the worker parks.
+    static constexpr unsigned BUSY_POLL_SPINS = 16384;
+
+    static constexpr size_t MAX_DISPLAY_PACKETS = 20;
+    PacketInfo recentPackets[MAX_DISPLAY_PACKETS];
+    size_t currentIndex = 0;
+
+    Pipeline::Context pipelineContext;
+
+    bool initializeCapture(const std::string& interface);
+    void configurePipeline();
+    void drainQueue();
+    void waitForPackets(std::chrono::steady_clock::time_point deadline);
+    void pinThread(const char* name, int cpu);
+    void periodicTasks();
+    void writeStatsEvent();
+    void finishEvents();
+    void dumpPerf();
+    void exportPackets(const std::vector<std::string>& args);
+    void writeMetrics(std::ostream& out) const;
+    void displayLoop();
+    void headlessLoop();
+    void collectLoop();
+    bool runEventLoop();
+    bool readPackets(EventLoop& loop);
+    void readCommands(EventLoop& loop);
+    void reportCollectorAlert(const Collector::Alert& alert);
+    void handleUserInput();
+    bool handleCommand(const std::string& input);  // False for quit
+
+public:
+    NetworkMonitor()
+        : anomalyDetector(stateBudget), flowTable(stateBudget), exporter(stateBudget), collector(stateBudget) {}
+
+    // Called on the processing thread for every packet that is flagged as an
+    // anomaly or matches a watch rule.
+    std::function<void(const PacketInfo&)> onAlert;
+
+    bool initialize(const std::string& interface);
+    void start();
+    void stop();
+    // Only clears the running flag, so it is safe in a signal handler; a
+    // headless start() then returns after writing its final events.
+    // (With --event-loop the signals arrive through a signalfd instead.)
+    void requestStop() { running = false; }
+    bool isHeadless() const { return headless || !collectEndpoint.empty(); }
+    bool replay(ReplaySummary& summary);
+    void printHelp() const;
+    bool parseArguments(int argc, char* argv[]);
+};
+
+#endif
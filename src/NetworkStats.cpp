@@ -1,112 +1,879 @@
 #include "NetworkStats.h"
 #include "Utils.h"
+#include "FastFormat.h"
+#include "Dissector.h"
 #include <iostream>
 #include <iomanip>
+#include <cmath>
+#include <algorithm>
 
-NetworkStats::NetworkStats() : totalPackets(0), totalBytes(0), anomalousPackets(0) {
-    startTime = std::chrono::system_clock::now();
-    lastPacketTime = startTime;
+constexpr int NetworkStats::EWMA_WINDOWS[3];
+
+namespace {
+    std::atomic<uint64_t> nextInstanceId{1};
+    
+    int64_t epochSecond(const std::chrono::system_clock::time_point& tp) {
+        return std::chrono::duration_cast<std::chrono::seconds>(tp.time_since_epoch()).count();
+    }
+    
+    int64_t epochNanos(const std::chrono::system_clock::time_point& tp) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count();
+    }
+    
+    int64_t steadyNanos() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    
+    std::chrono::system_clock::time_point fromNanos(int64_t nanos) {
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(nanos)));
+    }
+    
+    const double EWMA_ALPHA[3] = {
+        1.0 - std::exp(-1.0 / NetworkStats::EWMA_WINDOWS[0]),
+        1.0 - std::exp(-1.0 / NetworkStats::EWMA_WINDOWS[1]),
+        1.0 - std::exp(-1.0 / NetworkStats::EWMA_WINDOWS[2])
+    };
+    
+    const int64_t MAX_IDLE_SECONDS = 3600;
+    
+    void foldEwma(double* packetRates, double* byteRates, uint64_t packets, uint64_t bytes, int64_t idleSeconds) {
+        idleSeconds = (std::min)(idleSeconds, MAX_IDLE_SECONDS);
+        for (int i = 0; i < 3; ++i) {
+            packetRates[i] += EWMA_ALPHA[i] * (static_cast<double>(packets) - packetRates[i]);
+            byteRates[i] += EWMA_ALPHA[i] * (static_cast<double>(bytes) - byteRates[i]);
+            if (idleSeconds > 0) {
+                double decay = std::pow(1.0 - EWMA_ALPHA[i], static_cast<double>(idleSeconds));
+                packetRates[i] *= decay;
+                byteRates[i] *= decay;
+            }
+        }
+    }
+    
+    const std::memory_order relaxed = std::memory_order_relaxed;
+}
+
+NetworkStats::TopSummaries::TopSummaries()
+    : byPackets(TOP_TALKER_CAPACITY), byBytes(TOP_TALKER_CAPACITY), domains(TOP_DOMAIN_CAPACITY), sampled(false) {}
+
+NetworkStats::Shard::Shard(bool isShared)
+    : topRandom(0x9E3779B9u),
+      published(new TopSummaries()), spare(new TopSummaries()), shared(isShared) {
+    bucket = &history[0];
+    for (int i = 0; i < 3; ++i) {
+        ewmaPackets[i].store(0.0, relaxed);
+        ewmaBytes[i].store(0.0, relaxed);
+    }
+}
+
+NetworkStats::NetworkStats() : instanceId(nextInstanceId.fetch_add(1)) {}
+
+int NetworkStats::protocolSlot(uint8_t ipProtocol) {
+    switch (ipProtocol) {
+        case 6: return SLOT_TCP;
+        case 17: return SLOT_UDP;
+        case 1:
+        case 58: return SLOT_ICMP;
+        default: return SLOT_OTHER;
+    }
+}
+
+NetworkStats::Shard& NetworkStats::localShard() {
+    struct Cache {
+        uint64_t owner = 0;
+        Shard* shard = nullptr;
+    };
+    static thread_local Cache cache;
+    
+    if (cache.owner != instanceId) {
+        cache.shard = &registerShard();
+        cache.owner = instanceId;
+    }
+    return *cache.shard;
+}
+
+NetworkStats::Shard& NetworkStats::registerShard() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto self = std::this_thread::get_id();
+    std::size_t count = shardCount.load(relaxed);
+    
+    for (std::size_t i = 0; i < count; ++i) {
+        if (shardOwners[i] == self && !shards[i]->shared) {
+            return *shards[i];
+        }
+    }
+    
+    if (count == MAX_SHARDS) {
+        return *shards[MAX_SHARDS - 1];
+    }
+    
+    shards[count].reset(new Shard(count == MAX_SHARDS - 1));
+    shards[count]->generation.store(resetGeneration.load(), relaxed);
+    shardOwners[count] = self;
+    shardCount.store(count + 1, std::memory_order_release);
+    return *shards[count];
+}
+
+bool NetworkStats::isLive(const Shard& shard) const {
+    return shard.generation.load(std::memory_order_acquire) == resetGeneration.load(std::memory_order_acquire);
+}
+
+// The current second on the packet clock: the newest packet second of any
+// shard, plus the wall time since that shard reached it. Rates and history
+// therefore follow a replayed trace, and still decay once packets stop.
+// Before any packet it is the wall clock.
+int64_t NetworkStats::clockSecond() const {
+    int64_t now = steadyNanos();
+    int64_t newest = -1;
+    std::size_t count = shardCount.load(std::memory_order_acquire);
+    for (std::size_t s = 0; s < count; ++s) {
+        const Shard& shard = *shards[s];
+        if (!isLive(shard)) continue;
+        int64_t current = shard.currentSecond.load(relaxed);
+        if (current < 0) continue;
+        int64_t idle = (std::max)(static_cast<int64_t>(0), now - shard.advancedAtNanos.load(relaxed)) / 1000000000;
+        newest = (std::max)(newest, current + idle);
+    }
+    return newest >= 0 ? newest : epochSecond(std::chrono::system_clock::now());
 }
 
 void NetworkStats::recordPacket(const PacketInfo& packet) {
-    totalPackets++;
-    totalBytes += packet.packetSize;
-    lastPacketTime = packet.timestamp;
+    Shard& shard = localShard();
+    
+    if (shard.shared) {
+        std::lock_guard<std::mutex> lock(shard.writerMutex);
+        record(shard, packet);
+    } else {
+        record(shard, packet);
+    }
+}
+
+void NetworkStats::record(Shard& shard, const PacketInfo& packet) {
+    uint64_t generation = resetGeneration.load(relaxed);
+    if (shard.generation.load(relaxed) != generation) {
+        clearShard(shard, generation);
+    }
+    
+    int64_t nanos = epochNanos(packet.timestamp);
+    if (nanos >= shard.nextSecondNanos) {
+        advanceTo(shard, epochSecond(packet.timestamp), nanos);
+    }
+    
+    uint64_t weight = packet.sampleWeight;
+    uint64_t bytes = weight * packet.packetSize;
     
+    shard.lock.beginWrite();
+    shard.packets.add(weight);
+    shard.bytes.add(bytes);
     if (packet.isAnomaly) {
-        anomalousPackets++;
+        shard.anomalies.add(weight);
     }
+    shard.observed.increment();
+    shard.sampleRate.set(weight);
+    shard.lastPacketNanos.store(nanos, relaxed);
     
-    protocolCounts[packet.protocol]++;
+    Bucket& bucket = *shard.bucket;
+    bucket.packets.add(weight);
+    bucket.bytes.add(bytes);
+    if (packet.isAnomaly) {
+        bucket.anomalies.add(weight);
+    }
+    shard.lock.endWrite();
+    
+    bucket.protocolPackets[protocolSlot(packet.ipProtocol)].add(weight);
+    shard.protocolPackets[packet.ipProtocol].add(weight);
+    shard.sizeBuckets[SizeHistogram::bucketIndex(packet.packetSize)].add(weight);
+    
+    const AppLayer& app = packet.app;
+    if (app.protocol != AppLayer::NONE) {
+        shard.appPackets[app.protocol].add(weight);
+        if (app.dnsResponse) {
+            shard.dnsResponses[app.dnsRcode].add(weight);
+        } else if (!app.name.empty()) {
+            shard.topPendingNames += weight;
+        }
+    }
     
-    ipCounts[packet.sourceIP]++;
-    if (packet.sourceIP != packet.destIP) {
-        ipCounts[packet.destIP]++;
+    shard.topPendingPackets += weight;
+    shard.topPendingBytes += bytes;
+    if (shard.topExactLeft > 0) {
+        --shard.topExactLeft;
+        feedTop(shard, packet);
+    } else if (--shard.topCountdown == 0) {
+        shard.topCountdown = nextTopGap(shard);
+        shard.top.sampled = true;
+        feedTop(shard, packet);
+    }
+}
+
+// Credits the packet with the weight pending since the last one fed, so the
+// summaries' totals match the counters. The name weight waits for the next
+// fed packet that has a name.
+void NetworkStats::feedTop(Shard& shard, const PacketInfo& packet) {
+    if (topSampleInterval.load(relaxed) == 0) {
+        return;
+    }
+    TopSummaries& top = shard.top;
+    top.byPackets.add(packet.sourceAddr, shard.topPendingPackets);
+    top.byBytes.add(packet.sourceAddr, shard.topPendingBytes);
+    if (packet.sourceAddr != packet.destAddr) {
+        top.byPackets.add(packet.destAddr, shard.topPendingPackets);
+        top.byBytes.add(packet.destAddr, shard.topPendingBytes);
+    }
+    shard.topPendingPackets = 0;
+    shard.topPendingBytes = 0;
+    if (shard.topPendingNames > 0 && !packet.app.name.empty() && !packet.app.dnsResponse) {
+        top.domains.add(packet.app.name, shard.topPendingNames);
+        shard.topPendingNames = 0;
+    }
+    shard.topDirty = true;
+}
+
+// Uniform on [1, 2 * interval - 1], so the gaps average `interval` without
+// locking onto periodic traffic such as request/response pairs.
+uint32_t NetworkStats::nextTopGap(Shard& shard) const {
+    uint32_t interval = topSampleInterval.load(relaxed);
+    if (interval <= 1) {
+        return interval == 0 ? UINT32_MAX : 1;
+    }
+    uint32_t x = shard.topRandom;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    shard.topRandom = x;
+    return 1 + x % (2 * interval - 1);
+}
+
+void NetworkStats::advanceTo(Shard& shard, int64_t second, int64_t packetNanos) {
+    int64_t current = shard.currentSecond.load(relaxed);
+    if (current < 0) {
+        // The shard's first packet; the earliest one across shards starts the clock.
+        int64_t start = startNanos.load(relaxed);
+        while ((start == 0 || packetNanos < start) && !startNanos.compare_exchange_weak(start, packetNanos, relaxed)) {
+        }
+    }
+    
+    shard.lock.beginWrite();
+    if (current >= 0) {
+        const auto& done = shard.history[current % HISTORY_SECONDS];
+        double packetRates[3];
+        double byteRates[3];
+        for (int i = 0; i < 3; ++i) {
+            packetRates[i] = shard.ewmaPackets[i].load(relaxed);
+            byteRates[i] = shard.ewmaBytes[i].load(relaxed);
+        }
+        foldEwma(packetRates, byteRates, done.packets.get(), done.bytes.get(), second - current - 1);
+        for (int i = 0; i < 3; ++i) {
+            shard.ewmaPackets[i].store(packetRates[i], relaxed);
+            shard.ewmaBytes[i].store(byteRates[i], relaxed);
+        }
+    }
+    
+    // Invalidate the slot while it is zeroed so readers never pair the new
+    // second with the old counts.
+    auto& bucket = shard.history[second % HISTORY_SECONDS];
+    bucket.second.store(-1, relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bucket.packets.set(0);
+    bucket.bytes.set(0);
+    bucket.anomalies.set(0);
+    for (auto& counter : bucket.protocolPackets) {
+        counter.set(0);
+    }
+    bucket.second.store(second, std::memory_order_release);
+    shard.advancedAtNanos.store(steadyNanos(), relaxed);
+    shard.currentSecond.store(second, relaxed);
+    shard.lock.endWrite();
+    
+    shard.bucket = &bucket;
+    shard.nextSecondNanos = (second + 1) * 1000000000;
+    shard.topExactLeft = topSampleInterval.load(relaxed) == 0 ? 0 : TOP_EXACT_PACKETS;
+}
+
+// The copy into the spare buffer is made without the lock, which is only
+// held to swap the two. Unless `wait` is set, a reader holding the lock
+// just defers publication to the next flush.
+void NetworkStats::publish(Shard& shard, bool wait) {
+    TopSummaries& spare = *shard.spare;
+    spare.byPackets = shard.top.byPackets;
+    spare.byBytes = shard.top.byBytes;
+    spare.domains = shard.top.domains;
+    spare.sampled = shard.top.sampled;
+    
+    std::unique_lock<std::mutex> lock(shard.publishMutex, std::defer_lock);
+    if (wait) {
+        lock.lock();
+    } else if (!lock.try_lock()) {
+        return;
+    }
+    std::swap(shard.published, shard.spare);
+    shard.topDirty = false;
+}
+
+void NetworkStats::clearShard(Shard& shard, uint64_t generation) {
+    shard.lock.beginWrite();
+    shard.packets.set(0);
+    shard.bytes.set(0);
+    shard.anomalies.set(0);
+    shard.observed.set(0);
+    shard.sampleRate.set(0);
+    shard.lastPacketNanos.store(0, relaxed);
+    shard.currentSecond.store(-1, relaxed);
+    shard.nextSecondNanos = 0;
+    for (int i = 0; i < 3; ++i) {
+        shard.ewmaPackets[i].store(0.0, relaxed);
+        shard.ewmaBytes[i].store(0.0, relaxed);
+    }
+    for (auto& bucket : shard.history) {
+        bucket.second.store(-1, relaxed);
+    }
+    shard.lock.endWrite();
+    
+    for (auto& counter : shard.protocolPackets) {
+        counter.set(0);
+    }
+    for (auto& counter : shard.sizeBuckets) {
+        counter.set(0);
+    }
+    for (auto& counter : shard.appPackets) {
+        counter.set(0);
+    }
+    for (auto& counter : shard.dnsResponses) {
+        counter.set(0);
+    }
+    shard.top.byPackets.clear();
+    shard.top.byBytes.clear();
+    shard.top.domains.clear();
+    shard.top.sampled = false;
+    shard.topPendingPackets = 0;
+    shard.topPendingBytes = 0;
+    shard.topPendingNames = 0;
+    publish(shard, true);
+    shard.generation.store(generation, std::memory_order_release);
+}
+
+void NetworkStats::flush() {
+    Shard& shard = localShard();
+    std::unique_lock<std::mutex> lock(shard.writerMutex, std::defer_lock);
+    if (shard.shared) {
+        lock.lock();
+    }
+    
+    uint64_t generation = resetGeneration.load(relaxed);
+    if (shard.generation.load(relaxed) != generation) {
+        clearShard(shard, generation);
+    } else if (shard.topDirty) {
+        publish(shard, false);
     }
 }
 
 void NetworkStats::reset() {
-    totalPackets = 0;
-    totalBytes = 0;
-    anomalousPackets = 0;
-    protocolCounts.clear();
-    ipCounts.clear();
-    startTime = std::chrono::system_clock::now();
+    // Each writer clears its own shard when it next notices the new
+    // generation; until then readers treat stale shards as empty.
+    startNanos.store(0);
+    resetGeneration.fetch_add(1, std::memory_order_acq_rel);
+}
+
+NetworkStats::Snapshot NetworkStats::snapshot() const {
+    Snapshot snap;
+    snap.totalPackets = 0;
+    snap.totalBytes = 0;
+    snap.anomalousPackets = 0;
+    snap.observedPackets = 0;
+    snap.sampleRate = 1;
+    snap.protocolPackets.fill(0);
+    snap.sizeBuckets.fill(0);
+    snap.appPackets.fill(0);
+    snap.dnsResponses.fill(0);
+    for (int i = 0; i < 3; ++i) {
+        snap.rates.packets[i] = 0.0;
+        snap.rates.bytes[i] = 0.0;
+    }
+    int64_t lastNanos = 0;
+    int64_t now = clockSecond();
+    
+    std::size_t count = shardCount.load(std::memory_order_acquire);
+    for (std::size_t s = 0; s < count; ++s) {
+        const Shard& shard = *shards[s];
+        if (!isLive(shard)) continue;
+        
+        uint64_t packets, bytes, anomalies, lastBucketPackets, lastBucketBytes;
+        int64_t shardLastNanos, current;
+        double packetRates[3];
+        double byteRates[3];
+        uint32_t seq;
+        do {
+            seq = shard.lock.beginRead();
+            packets = shard.packets.get();
+            bytes = shard.bytes.get();
+            anomalies = shard.anomalies.get();
+            shardLastNanos = shard.lastPacketNanos.load(relaxed);
+            current = shard.currentSecond.load(relaxed);
+            for (int i = 0; i < 3; ++i) {
+                packetRates[i] = shard.ewmaPackets[i].load(relaxed);
+                byteRates[i] = shard.ewmaBytes[i].load(relaxed);
+            }
+            lastBucketPackets = 0;
+            lastBucketBytes = 0;
+            if (current >= 0) {
+                const auto& bucket = shard.history[current % HISTORY_SECONDS];
+                lastBucketPackets = bucket.packets.get();
+                lastBucketBytes = bucket.bytes.get();
+            }
+        } while (shard.lock.retryRead(seq));
+        
+        snap.totalPackets += packets;
+        snap.totalBytes += bytes;
+        snap.anomalousPackets += anomalies;
+        snap.observedPackets += shard.observed.get();
+        if (shardLastNanos > lastNanos && shard.sampleRate.get() > 0) {
+            snap.sampleRate = static_cast<uint32_t>(shard.sampleRate.get());
+        }
+        lastNanos = (std::max)(lastNanos, shardLastNanos);
+        
+        // Fold the shard's last bucket and idle time once its second has
+        // passed, so rates decay when traffic stops instead of freezing.
+        if (current >= 0 && now > current) {
+            foldEwma(packetRates, byteRates, lastBucketPackets, lastBucketBytes, now - current - 1);
+        }
+        for (int i = 0; i < 3; ++i) {
+            snap.rates.packets[i] += packetRates[i];
+            snap.rates.bytes[i] += byteRates[i];
+        }
+        
+        for (std::size_t i = 0; i < snap.protocolPackets.size(); ++i) {
+            snap.protocolPackets[i] += shard.protocolPackets[i].get();
+        }
+        for (std::size_t i = 0; i < snap.sizeBuckets.size(); ++i) {
+            snap.sizeBuckets[i] += shard.sizeBuckets[i].get();
+        }
+        for (std::size_t i = 0; i < snap.appPackets.size(); ++i) {
+            snap.appPackets[i] += shard.appPackets[i].get();
+        }
+        for (std::size_t i = 0; i < snap.dnsResponses.size(); ++i) {
+            snap.dnsResponses[i] += shard.dnsResponses[i].get();
+        }
+    }
+    
+    int64_t start = startNanos.load();
+    snap.startTime = start > 0 ? fromNanos(start) : std::chrono::system_clock::now();
+    snap.lastPacketTime = lastNanos > 0 ? fromNanos(lastNanos) : snap.startTime;
+    return snap;
+}
+
+double NetworkStats::Snapshot::packetsPerSecond() const {
+    std::chrono::duration<double> elapsed = lastPacketTime - startTime;
+    if (elapsed.count() <= 0.0) return 0.0;
+    return static_cast<double>(totalPackets) / elapsed.count();
+}
+
+uint64_t NetworkStats::Snapshot::sizePercentile(double fraction) const {
+    uint64_t total = 0;
+    for (uint64_t count : sizeBuckets) {
+        total += count;
+    }
+    return SizeHistogram::percentileOf(sizeBuckets, total, fraction);
+}
+
+std::vector<NetworkStats::SecondBucket> NetworkStats::getHistory(int seconds) const {
+    seconds = (std::max)(0, (std::min)(seconds, HISTORY_SECONDS));
+    int64_t last = clockSecond();
+    std::size_t count = shardCount.load(std::memory_order_acquire);
+    
+    std::vector<SecondBucket> result;
+    result.reserve(seconds);
+    for (int64_t second = last - seconds + 1; second <= last; ++second) {
+        SecondBucket merged = SecondBucket();
+        merged.second = second;
+        
+        for (std::size_t s = 0; s < count; ++s) {
+            const Shard& shard = *shards[s];
+            if (!isLive(shard)) continue;
+            
+            const auto& bucket = shard.history[((second % HISTORY_SECONDS) + HISTORY_SECONDS) % HISTORY_SECONDS];
+            if (bucket.second.load(std::memory_order_acquire) != second) continue;
+            
+            SecondBucket copy = SecondBucket();
+            copy.packets = bucket.packets.get();
+            copy.bytes = bucket.bytes.get();
+            copy.anomalies = bucket.anomalies.get();
+            for (int p = 0; p < PROTOCOL_SLOTS; ++p) {
+                copy.protocolPackets[p] = bucket.protocolPackets[p].get();
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (bucket.second.load(relaxed) != second) continue;
+            
+            merged.packets += copy.packets;
+            merged.bytes += copy.bytes;
+            merged.anomalies += copy.anomalies;
+            for (int p = 0; p < PROTOCOL_SLOTS; ++p) {
+                merged.protocolPackets[p] += copy.protocolPackets[p];
+            }
+        }
+        result.push_back(merged);
+    }
+    return result;
 }
 
-double NetworkStats::getPacketsPerSecond() const {
-    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-        lastPacketTime - startTime).count();
-    if (elapsed == 0) return 0.0;
-    return static_cast<double>(totalPackets) / elapsed;
+std::vector<NetworkStats::TopTalker> NetworkStats::getTopTalkers(bool byBytes, size_t count) const {
+    std::vector<TalkerSummary> copies;
+    std::size_t shardTotal = shardCount.load(std::memory_order_acquire);
+    copies.reserve(shardTotal);
+    
+    for (std::size_t s = 0; s < shardTotal; ++s) {
+        Shard& shard = *shards[s];
+        if (!isLive(shard)) continue;
+        std::lock_guard<std::mutex> lock(shard.publishMutex);
+        copies.push_back(byBytes ? shard.published->byBytes : shard.published->byPackets);
+    }
+    
+    std::vector<const TalkerSummary*> parts;
+    for (const auto& copy : copies) {
+        parts.push_back(&copy);
+    }
+    return TalkerSummary::merge(parts, count);
+}
+
+// Whether any live shard's summaries include sampled packets. Their counts
+// can then be too low as well as too high, by more than the +/- term.
+bool NetworkStats::topSampled() const {
+    std::size_t shardTotal = shardCount.load(std::memory_order_acquire);
+    for (std::size_t s = 0; s < shardTotal; ++s) {
+        Shard& shard = *shards[s];
+        if (!isLive(shard)) continue;
+        std::lock_guard<std::mutex> lock(shard.publishMutex);
+        if (shard.published->sampled) return true;
+    }
+    return false;
+}
+
+std::vector<NetworkStats::TopDomain> NetworkStats::getTopDomains(size_t count) const {
+    std::vector<DomainSummary> copies;
+    std::size_t shardTotal = shardCount.load(std::memory_order_acquire);
+    copies.reserve(shardTotal);
+    
+    for (std::size_t s = 0; s < shardTotal; ++s) {
+        Shard& shard = *shards[s];
+        if (!isLive(shard)) continue;
+        std::lock_guard<std::mutex> lock(shard.publishMutex);
+        copies.push_back(shard.published->domains);
+    }
+    
+    std::vector<const DomainSummary*> parts;
+    for (const auto& copy : copies) {
+        parts.push_back(&copy);
+    }
+    return DomainSummary::merge(parts, count);
 }
 
 void NetworkStats::printStats() const {
+    Snapshot snap = snapshot();
+    
     std::cout << Utils::Colors::BOLD << "\n=== Network Statistics ===" << Utils::Colors::RESET << std::endl;
-    std::cout << "Total packets: " << totalPackets << std::endl;
-    std::cout << "Total bytes: " << Utils::formatBytes(totalBytes) << std::endl;
-    std::cout << "Anomalous packets: " << Utils::Colors::RED << anomalousPackets 
+    std::cout << "Total packets: " << snap.totalPackets << std::endl;
+    std::cout << "Total bytes: " << Utils::formatBytes(snap.totalBytes) << std::endl;
+    std::cout << "Anomalous packets: " << Utils::Colors::RED << snap.anomalousPackets 
               << Utils::Colors::RESET << " (" << std::fixed << std::setprecision(2)
-              << (totalPackets > 0 ? (double)anomalousPackets / totalPackets * 100 : 0.0) 
+              << (snap.totalPackets > 0 ? (double)snap.anomalousPackets / snap.totalPackets * 100 : 0.0) 
               << "%)" << std::endl;
-    std::cout << "Packets/sec: " << std::fixed << std::setprecision(2) 
-              << getPacketsPerSecond() << std::endl;
+    std::cout << "Packets/sec (lifetime avg): " << std::fixed << std::setprecision(2) 
+              << snap.packetsPerSecond() << std::endl;
+    if (snap.observedPackets != snap.totalPackets) {
+        std::cout << Utils::Colors::YELLOW << "Sampling: currently 1 in " << snap.sampleRate
+                  << "; counts are estimates from " << snap.observedPackets << " observed packets"
+                  << Utils::Colors::RESET << std::endl;
+    }
+    
+    const Rates& rates = snap.rates;
+    std::cout << "Rate 1s/5s/15s: " << std::setprecision(1)
+              << rates.packets[0] << " / " << rates.packets[1] << " / " << rates.packets[2] << " pps, "
+              << Utils::formatBytes(static_cast<uint64_t>(rates.bytes[0])) << "/s / "
+              << Utils::formatBytes(static_cast<uint64_t>(rates.bytes[1])) << "/s / "
+              << Utils::formatBytes(static_cast<uint64_t>(rates.bytes[2])) << "/s" << std::endl;
+    
+    if (snap.totalPackets > 0) {
+        std::cout << "Packet size p50/p99/p999: " << snap.sizePercentile(0.50) << " / "
+                  << snap.sizePercentile(0.99) << " / " << snap.sizePercentile(0.999)
+                  << " bytes" << std::endl;
+    }
     
-    if (!protocolCounts.empty()) {
+    auto lastMinute = getHistory(60);
+    const SecondBucket* peak = nullptr;
+    uint64_t minutePackets = 0;
+    uint64_t minuteAnomalies = 0;
+    for (const auto& bucket : lastMinute) {
+        minutePackets += bucket.packets;
+        minuteAnomalies += bucket.anomalies;
+        if (peak == nullptr || bucket.packets > peak->packets) {
+            peak = &bucket;
+        }
+    }
+    if (peak != nullptr && peak->packets > 0) {
+        std::cout << "Last 60s: " << minutePackets << " packets, " << minuteAnomalies
+                  << " anomalies, peak " << peak->packets << " pps at "
+                  << Utils::formatTimestamp(std::chrono::system_clock::time_point(std::chrono::seconds(peak->second)))
+                  << " (TCP " << peak->protocolPackets[SLOT_TCP] << ", UDP " << peak->protocolPackets[SLOT_UDP]
+                  << ", ICMP " << peak->protocolPackets[SLOT_ICMP] << ", other " << peak->protocolPackets[SLOT_OTHER]
+                  << ")" << std::endl;
+    }
+    
+    if (snap.totalPackets > 0) {
         std::cout << "\nProtocol distribution:" << std::endl;
-        for (const auto& pair : protocolCounts) {
-            std::cout << "  " << pair.first << ": " << pair.second 
+        for (std::size_t proto = 0; proto < snap.protocolPackets.size(); ++proto) {
+            uint64_t packets = snap.protocolPackets[proto];
+            if (packets == 0) continue;
+            std::cout << "  " << Utils::protocolToString(static_cast<int>(proto)) << ": " << packets 
                      << " (" << std::fixed << std::setprecision(1)
-                     << (double)pair.second / totalPackets * 100 << "%)" << std::endl;
+                     << (double)packets / snap.totalPackets * 100 << "%)" << std::endl;
         }
     }
+    
+    uint64_t appTotal = 0;
+    for (int app = AppLayer::NONE + 1; app < AppLayer::PROTOCOL_COUNT; ++app) {
+        appTotal += snap.appPackets[app];
+    }
+    if (appTotal > 0) {
+        std::cout << "\nApplication protocols (packets with payload):" << std::endl;
+        for (int app = AppLayer::NONE + 1; app < AppLayer::PROTOCOL_COUNT; ++app) {
+            uint64_t packets = snap.appPackets[app];
+            if (packets == 0) continue;
+            std::cout << "  " << AppLayer::protocolName(static_cast<AppLayer::Protocol>(app)) << ": " << packets
+                      << " (" << std::fixed << std::setprecision(1)
+                      << (double)packets / snap.totalPackets * 100 << "%)" << std::endl;
+        }
+    }
+    
+    bool firstRcode = true;
+    for (int rcode = 0; rcode < DNS_RCODES; ++rcode) {
+        if (snap.dnsResponses[rcode] == 0) continue;
+        std::cout << (firstRcode ? "DNS responses: " : ", ") << Dissector::rcodeName(static_cast<uint8_t>(rcode))
+                  << " " << snap.dnsResponses[rcode];
+        firstRcode = false;
+    }
+    if (!firstRcode) {
+        std::cout << std::endl;
+    }
 }
 
 void NetworkStats::printLiveTable(const PacketInfo* recentPackets, size_t count) const {
+    Snapshot snap = snapshot();
     Utils::clearScreen();
     
     std::cout << Utils::Colors::BOLD << Utils::Colors::CYAN 
               << "=== Network 2.0 - Live Traffic ===" 
               << Utils::Colors::RESET << std::endl;
     
-    std::cout << "Packets: " << totalPackets << " | Bytes: " << Utils::formatBytes(totalBytes)
-              << " | Anomalies: " << Utils::Colors::RED << anomalousPackets << Utils::Colors::RESET
-              << " | Rate: " << std::fixed << std::setprecision(1) << getPacketsPerSecond() << " pps"
-              << std::endl << std::endl;
+    std::cout << "Packets: " << snap.totalPackets << " | Bytes: " << Utils::formatBytes(snap.totalBytes)
+              << " | Anomalies: " << Utils::Colors::RED << snap.anomalousPackets << Utils::Colors::RESET
+              << " | Rate: " << std::fixed << std::setprecision(1) << snap.rates.packets[0] << " pps";
+    if (snap.sampleRate > 1) {
+        std::cout << Utils::Colors::YELLOW << " | Sampling 1 in " << snap.sampleRate << Utils::Colors::RESET;
+    }
+    std::cout << std::endl << std::endl;
+    
+    // Address columns widen to fit IPv6 only while an IPv6 row is on screen.
+    std::size_t addressWidth = 16;
+    for (size_t i = 0; i < count; ++i) {
+        if (!recentPackets[i].sourceAddr.isV4() || !recentPackets[i].destAddr.isV4()) {
+            addressWidth = FastFormat::IP_MAX_WIDTH;
+        }
+    }
     
     std::cout << Utils::Colors::BOLD;
     std::cout << std::left << std::setw(12) << "Time"
-              << std::setw(16) << "Source IP"
-              << std::setw(16) << "Dest IP"
+              << std::setw(addressWidth) << "Source IP"
+              << std::setw(addressWidth) << "Dest IP"
               << std::setw(8) << "Protocol"
               << std::setw(10) << "Size"
               << std::setw(40) << "Notes"
               << Utils::Colors::RESET << std::endl;
     
-    std::cout << std::string(102, '-') << std::endl;
+    std::cout << std::string(70 + 2 * addressWidth, '-') << std::endl;
     
 
+    // Rows are formatted into one buffer and written with a single call;
+    // the widths match the header above.
+    std::string frame;
+    char row[256];
     for (size_t i = 0; i < count; ++i) {
         const auto& packet = recentPackets[i];
         
-        std::string color = Utils::Colors::WHITE;
-        if (packet.isAnomaly) {
-            color = Utils::Colors::RED;
-        }
+        frame += packet.isAnomaly ? Utils::Colors::RED : Utils::Colors::WHITE;
         
-        std::cout << color;
-        std::cout << std::left << std::setw(12) << Utils::formatTimestamp(packet.timestamp)
-                  << std::setw(16) << packet.sourceIP
-                  << std::setw(16) << packet.destIP
-                  << std::setw(8) << packet.protocol
-                  << std::setw(10) << Utils::formatBytes(packet.packetSize);
+        char* start = row;
+        char* out = FastFormat::timestamp(start, packet.timestamp);
+        start = out = FastFormat::padTo(start, out, 12);
+        out = FastFormat::address(out, packet.sourceAddr);
+        start = out = FastFormat::padTo(start, out, addressWidth);
+        out = FastFormat::address(out, packet.destAddr);
+        start = out = FastFormat::padTo(start, out, addressWidth);
+        out = FastFormat::protocol(out, packet.ipProtocol);
+        start = out = FastFormat::padTo(start, out, 8);
+        out = FastFormat::bytes(out, packet.packetSize);
+        out = FastFormat::padTo(start, out, 10);
+        frame.append(row, out - row);
         
+        std::size_t notesStart = frame.size();
         if (packet.isAnomaly) {
-            std::cout << std::setw(40) << ("ANOMALY: " + packet.anomalyReason);
-        } else {
-            std::cout << std::setw(40) << "";
+            frame += "ANOMALY: ";
+            frame += packet.anomalyReason;
+        } else if (packet.app.protocol != AppLayer::NONE) {
+            frame += AppLayer::protocolName(packet.app.protocol);
+            if (packet.app.dnsResponse) {
+                frame += ' ';
+                frame += Dissector::rcodeName(packet.app.dnsRcode);
+            }
+            if (!packet.app.name.empty()) {
+                frame += packet.app.name.isTruncated() ? " *." : " ";
+                frame.append(packet.app.name.data(), packet.app.name.size());
+            }
         }
+        if (frame.size() - notesStart < 40) frame.append(40 - (frame.size() - notesStart), ' ');
         
-        std::cout << Utils::Colors::RESET << std::endl;
+        frame += Utils::Colors::RESET;
+        frame += '\n';
+    }
+    std::cout << frame << std::flush;
+}
+
+void NetworkStats::printTopTalkers(size_t count) const {
+    auto byPackets = getTopTalkers(false, count);
+    auto byBytes = getTopTalkers(true, count);
+    
+    std::cout << Utils::Colors::BOLD << "\n=== Top Talkers ===" << Utils::Colors::RESET << std::endl;
+    
+    if (byPackets.empty()) {
+        std::cout << Utils::Colors::YELLOW << "No traffic recorded yet" << Utils::Colors::RESET << std::endl;
+        return;
+    }
+    
+    bool sampled = topSampled();
+    std::cout << "Up to " << TOP_TALKER_CAPACITY << " hosts tracked per processing thread;";
+    if (sampled) {
+        std::cout << " beyond " << TOP_EXACT_PACKETS << " packets a second, counts are sampled estimates from 1 in "
+                  << topSampleInterval.load(relaxed) << " packets and may be too high or too low" << std::endl;
+    } else {
+        std::cout << " counts may over-estimate by at most the +/- column" << std::endl;
+    }
+    
+    std::size_t hostWidth = 18;
+    for (const auto* list : {&byPackets, &byBytes}) {
+        for (const auto& entry : *list) {
+            if (!entry.key.isV4()) hostWidth = FastFormat::IP_MAX_WIDTH + 2;
+        }
+    }
+    
+    std::cout << Utils::Colors::CYAN << "\nBy packets:" << Utils::Colors::RESET << std::endl;
+    std::cout << std::left << std::setw(4) << "#" << std::setw(hostWidth) << "Host"
+              << std::setw(14) << "Packets" << (sampled ? "" : "+/-") << std::endl;
+    size_t rank = 1;
+    for (const auto& entry : byPackets) {
+        std::cout << std::left << std::setw(4) << rank++ << std::setw(hostWidth) << entry.key.toString()
+                  << std::setw(14) << entry.count;
+        if (!sampled) std::cout << entry.error;
+        std::cout << std::endl;
     }
+    
+    std::cout << Utils::Colors::CYAN << "\nBy bytes:" << Utils::Colors::RESET << std::endl;
+    std::cout << std::left << std::setw(4) << "#" << std::setw(hostWidth) << "Host"
+              << std::setw(14) << "Bytes" << (sampled ? "" : "+/-") << std::endl;
+    rank = 1;
+    for (const auto& entry : byBytes) {
+        std::cout << std::left << std::setw(4) << rank++ << std::setw(hostWidth) << entry.key.toString()
+                  << std::setw(14) << Utils::formatBytes(entry.count);
+        if (!sampled) std::cout << Utils::formatBytes(entry.error);
+        std::cout << std::endl;
+    }
+}
+
+void NetworkStats::printTopDomains(size_t count) const {
+    auto domains = getTopDomains(count);
+    
+    std::cout << Utils::Colors::BOLD << "\n=== Top Names ===" << Utils::Colors::RESET << std::endl;
+    if (domains.empty()) {
+        std::cout << Utils::Colors::YELLOW << "No DNS queries, HTTP requests or TLS ClientHellos seen yet"
+                  << Utils::Colors::RESET << std::endl;
+        return;
+    }
+    
+    bool sampled = topSampled();
+    std::cout << "DNS query names, HTTP Host headers and TLS SNI; up to " << TOP_DOMAIN_CAPACITY
+              << " names tracked per processing thread" << std::endl;
+    if (sampled) {
+        std::cout << "Beyond " << TOP_EXACT_PACKETS << " packets a second, counts are sampled estimates from 1 in "
+                  << topSampleInterval.load(relaxed) << " packets and may be too high or too low" << std::endl;
+    }
+    
+    std::size_t nameWidth = 24;
+    for (const auto& entry : domains) {
+        nameWidth = (std::max)(nameWidth, entry.key.size() + 4);
+    }
+    std::cout << std::left << std::setw(4) << "#" << std::setw(nameWidth) << "Name"
+              << std::setw(14) << "Packets" << (sampled ? "" : "+/-") << std::endl;
+    size_t rank = 1;
+    for (const auto& entry : domains) {
+        std::cout << std::left << std::setw(4) << rank++ << std::setw(nameWidth) << entry.key.toString()
+                  << std::setw(14) << entry.count;
+        if (!sampled) std::cout << entry.error;
+        std::cout << std::endl;
+    }
+}
+
+void NetworkStats::writeMetrics(std::ostream& out) const {
+    Snapshot snap = snapshot();
+    
+    out << "# HELP network2_packets_total Packets processed, scaled up by the sampling rate.\n"
+        << "# TYPE network2_packets_total counter\n"
+        << "network2_packets_total " << snap.totalPackets << "\n"
+        << "# HELP network2_bytes_total Bytes processed.\n"
+        << "# TYPE network2_bytes_total counter\n"
+        << "network2_bytes_total " << snap.totalBytes << "\n"
+        << "# HELP network2_anomalous_packets_total Packets flagged as anomalous.\n"
+        << "# TYPE network2_anomalous_packets_total counter\n"
+        << "network2_anomalous_packets_total " << snap.anomalousPackets << "\n"
+        << "# HELP network2_observed_packets_total Packets actually recorded; below network2_packets_total while sampling.\n"
+        << "# TYPE network2_observed_packets_total counter\n"
+        << "network2_observed_packets_total " << snap.observedPackets << "\n";
+    
+    out << "# HELP network2_protocol_packets_total Packets processed per IP protocol.\n"
+        << "# TYPE network2_protocol_packets_total counter\n";
+    for (std::size_t proto = 0; proto < snap.protocolPackets.size(); ++proto) {
+        if (snap.protocolPackets[proto] == 0) continue;
+        out << "network2_protocol_packets_total{protocol=\"" << Utils::protocolToString(static_cast<int>(proto))
+            << "\"} " << snap.protocolPackets[proto] << "\n";
+    }
+    
+    out << "# HELP network2_app_packets_total Packets with payload per application protocol, classified by port.\n"
+        << "# TYPE network2_app_packets_total counter\n";
+    for (int app = AppLayer::NONE + 1; app < AppLayer::PROTOCOL_COUNT; ++app) {
+        out << "network2_app_packets_total{app=\"" << AppLayer::protocolName(static_cast<AppLayer::Protocol>(app))
+            << "\"} " << snap.appPackets[app] << "\n";
+    }
+    out << "# HELP network2_dns_responses_total DNS responses by response code.\n"
+        << "# TYPE network2_dns_responses_total counter\n";
+    for (int rcode = 0; rcode < DNS_RCODES; ++rcode) {
+        if (snap.dnsResponses[rcode] == 0 && rcode != 0) continue;
+        out << "network2_dns_responses_total{rcode=\"" << Dissector::rcodeName(static_cast<uint8_t>(rcode))
+            << "\"} " << snap.dnsResponses[rcode] << "\n";
+    }
+    
+    out << "# HELP network2_packet_rate Packets per second, exponentially weighted.\n"
+        << "# TYPE network2_packet_rate gauge\n";
+    for (int i = 0; i < 3; ++i) {
+        out << "network2_packet_rate{window=\"" << EWMA_WINDOWS[i] << "s\"} " << snap.rates.packets[i] << "\n";
+    }
+    out << "# HELP network2_byte_rate Bytes per second, exponentially weighted.\n"
+        << "# TYPE network2_byte_rate gauge\n";
+    for (int i = 0; i < 3; ++i) {
+        out << "network2_byte_rate{window=\"" << EWMA_WINDOWS[i] << "s\"} " << snap.rates.bytes[i] << "\n";
+    }
+    
+    out << "# HELP network2_packet_size_bytes Packet size distribution.\n"
+        << "# TYPE network2_packet_size_bytes summary\n"
+        << "network2_packet_size_bytes{quantile=\"0.5\"} " << snap.sizePercentile(0.50) << "\n"
+        << "network2_packet_size_bytes{quantile=\"0.99\"} " << snap.sizePercentile(0.99) << "\n"
+        << "network2_packet_size_bytes{quantile=\"0.999\"} " << snap.sizePercentile(0.999) << "\n"
+        << "network2_packet_size_bytes_sum " << snap.totalBytes << "\n"
+        << "network2_packet_size_bytes_count " << snap.totalPackets << "\n";
 }
@@ -2,34 +2,200 @@
 #define NETWORK_STATS_H
 
 #include "PacketTypes.h"
-#include <unordered_map>
+#include "TopK.h"
+#include "Histogram.h"
+#include "Counters.h"
 #include <string>
 #include <chrono>
+#include <array>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <ostream>
 
+// Statistics are written through per-thread shards: each processing thread
+// owns a cache-line-aligned block that only it writes, so recordPacket never
+// contends with other writers or readers. Readers sum the shards on demand
+// into a Snapshot, using each shard's sequence lock for a consistent view of
+// its headline counters.
+//
+// Per packet, recordPacket only updates counters. The top-talker and
+// top-name summaries are fed every packet for the first TOP_EXACT_PACKETS of
+// each second, then from a random 1 in setTopSampleInterval() packets that
+// carries the weight of the packets skipped since the last one, so totals
+// stay exact and heavy hitters keep their share.
 class NetworkStats {
+public:
+    enum ProtocolSlot { SLOT_TCP = 0, SLOT_UDP, SLOT_ICMP, SLOT_OTHER, PROTOCOL_SLOTS };
+
+    struct SecondBucket {
+        int64_t second;
+        uint64_t packets;
+        uint64_t bytes;
+        uint64_t anomalies;
+        std::array<uint64_t, PROTOCOL_SLOTS> protocolPackets;
+    };
+
+    struct Rates {
+        double packets[3];
+        double bytes[3];
+    };
+
+    static constexpr int HISTORY_SECONDS = 600;
+    static constexpr int EWMA_WINDOWS[3] = {1, 5, 15};
+
+    typedef LogLinearHistogram<5, 17> SizeHistogram;
+    typedef SpaceSaving<IpAddress, IpAddress::Hash> TalkerSummary;
+    typedef TalkerSummary::Entry TopTalker;
+    typedef SpaceSaving<DomainName, DomainName::Hash> DomainSummary;
+    typedef DomainSummary::Entry TopDomain;
+
+    static const int DNS_RCODES = 16;
+    static const uint32_t TOP_EXACT_PACKETS = 1024;
+    static const uint32_t DEFAULT_TOP_SAMPLE_INTERVAL = 64;
+
+    // Under sampling, packet, byte and anomaly counts are estimates: each
+    // recorded packet counts sampleWeight times. observedPackets is what was
+    // actually recorded.
+    struct Snapshot {
+        uint64_t totalPackets;
+        uint64_t totalBytes;
+        uint64_t anomalousPackets;
+        uint64_t observedPackets;
+        uint32_t sampleRate;  // Weight of the most recent packet; 1 when not sampling
+        std::array<uint64_t, 256> protocolPackets;
+        std::array<uint64_t, SizeHistogram::BUCKET_COUNT> sizeBuckets;
+        std::array<uint64_t, AppLayer::PROTOCOL_COUNT> appPackets;
+        std::array<uint64_t, DNS_RCODES> dnsResponses;
+        Rates rates;
+        std::chrono::system_clock::time_point startTime;
+        std::chrono::system_clock::time_point lastPacketTime;
+
+        double packetsPerSecond() const;
+        uint64_t sizePercentile(double fraction) const;
+    };
+
 private:
-    uint64_t totalPackets;
-    uint64_t totalBytes;
-    uint64_t anomalousPackets;
-    
-    std::unordered_map<std::string, uint64_t> protocolCounts;
-    std::unordered_map<std::string, uint64_t> ipCounts;
-    
-    std::chrono::system_clock::time_point startTime;
-    std::chrono::system_clock::time_point lastPacketTime;
-    
+    static const std::size_t TOP_TALKER_CAPACITY = 64;
+    static const std::size_t TOP_DOMAIN_CAPACITY = 64;
+    static const std::size_t MAX_SHARDS = 64;
+
+    struct Bucket {
+        std::atomic<int64_t> second{-1};
+        SingleWriterCounter packets;
+        SingleWriterCounter bytes;
+        SingleWriterCounter anomalies;
+        SingleWriterCounter protocolPackets[PROTOCOL_SLOTS];
+    };
+
+    struct TopSummaries {
+        TalkerSummary byPackets;
+        TalkerSummary byBytes;
+        DomainSummary domains;  // DNS queries, HTTP requests and TLS ClientHellos by name
+        bool sampled;  // Fed from sampled packets since the last reset, so no error bound holds
+
+        TopSummaries();
+    };
+
+    struct alignas(CACHE_LINE_SIZE) Shard {
+        SeqLock lock;
+        std::atomic<uint64_t> generation{0};
+        SingleWriterCounter packets;
+        SingleWriterCounter bytes;
+        SingleWriterCounter anomalies;
+        SingleWriterCounter observed;
+        SingleWriterCounter sampleRate;
+        std::atomic<int64_t> lastPacketNanos{0};
+        std::atomic<int64_t> currentSecond{-1};
+        std::atomic<int64_t> advancedAtNanos{0};  // Steady clock when currentSecond began
+        std::atomic<double> ewmaPackets[3];
+        std::atomic<double> ewmaBytes[3];
+        SingleWriterCounter protocolPackets[256];
+        SingleWriterCounter sizeBuckets[SizeHistogram::BUCKET_COUNT];
+        SingleWriterCounter appPackets[AppLayer::PROTOCOL_COUNT];
+        SingleWriterCounter dnsResponses[DNS_RCODES];
+        std::array<Bucket, HISTORY_SECONDS> history;
+        // Writer-owned: the bucket for currentSecond, and when the next second starts.
+        Bucket* bucket;
+        int64_t nextSecondNanos = 0;
+
+        // Owned by the writer, with the weight not yet fed to them. flush()
+        // copies them into `spare` and swaps it with `published`, which
+        // readers copy under publishMutex.
+        TopSummaries top;
+        uint64_t topPendingPackets = 0;
+        uint64_t topPendingBytes = 0;
+        uint64_t topPendingNames = 0;
+        uint32_t topExactLeft = 0;
+        uint32_t topCountdown = 1;
+        uint32_t topRandom;
+        bool topDirty = false;
+        std::mutex publishMutex;
+        std::unique_ptr<TopSummaries> published;
+        std::unique_ptr<TopSummaries> spare;
+
+        // The last shard is shared by any threads beyond MAX_SHARDS - 1 and
+        // serialises them through writerMutex.
+        bool shared;
+        std::mutex writerMutex;
+
+        explicit Shard(bool isShared);
+    };
+
+    const uint64_t instanceId;
+    std::atomic<uint64_t> resetGeneration{0};
+    std::atomic<int64_t> startNanos{0};  // First packet since construction or reset; 0 before it
+    std::atomic<uint32_t> topSampleInterval{DEFAULT_TOP_SAMPLE_INTERVAL};
+
+    std::array<std::unique_ptr<Shard>, MAX_SHARDS> shards;
+    std::array<std::thread::id, MAX_SHARDS> shardOwners;
+    std::atomic<std::size_t> shardCount{0};
+    std::mutex registryMutex;
+
+    Shard& localShard();
+    Shard& registerShard();
+    void record(Shard& shard, const PacketInfo& packet);
+    void clearShard(Shard& shard, uint64_t generation);
+    void advanceTo(Shard& shard, int64_t second, int64_t packetNanos);
+    void feedTop(Shard& shard, const PacketInfo& packet);
+    uint32_t nextTopGap(Shard& shard) const;
+    void publish(Shard& shard, bool wait);
+    bool isLive(const Shard& shard) const;
+    bool topSampled() const;
+    int64_t clockSecond() const;
+
+    static int protocolSlot(uint8_t ipProtocol);
+
 public:
     NetworkStats();
-    
+    NetworkStats(const NetworkStats&) = delete;
+    NetworkStats& operator=(const NetworkStats&) = delete;
+
     void recordPacket(const PacketInfo& packet);
+    // Beyond the first TOP_EXACT_PACKETS of each second, feed the top
+    // summaries from 1 in `interval` packets on average; 1 feeds every
+    // packet and 0 stops feeding them.
+    void setTopSampleInterval(uint32_t interval) { topSampleInterval.store(interval, std::memory_order_relaxed); }
+    void flush();
     void reset();
     void printStats() const;
     void printLiveTable(const PacketInfo* recentPackets, size_t count) const;
-    
-    uint64_t getTotalPackets() const { return totalPackets; }
-    uint64_t getTotalBytes() const { return totalBytes; }
-    uint64_t getAnomalousPackets() const { return anomalousPackets; }
-    double getPacketsPerSecond() const;
+    void printTopTalkers(size_t count) const;
+    void printTopDomains(size_t count) const;
+    void writeMetrics(std::ostream& out) const;
+
+    Snapshot snapshot() const;
+    std::vector<SecondBucket> getHistory(int seconds) const;
+    std::vector<TopTalker> getTopTalkers(bool byBytes, size_t count) const;
+    std::vector<TopDomain> getTopDomains(size_t count) const;
+
+    uint64_t getTotalPackets() const { return snapshot().totalPackets; }
+    uint64_t getTotalBytes() const { return snapshot().totalBytes; }
+    uint64_t getAnomalousPackets() const { return snapshot().anomalousPackets; }
+    double getPacketsPerSecond() const { return snapshot().packetsPerSecond(); }
+    Rates getRates() const { return snapshot().rates; }
 };
 
 #endif
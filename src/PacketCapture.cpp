@@ -6,9 +6,14 @@
 #ifdef _WIN32
 #include <iphlpapi.h>
 #pragma comment(lib, "iphlpapi.lib")
+#else
+#include <poll.h>
+#include <sys/socket.h>
+#include <thread>
 #endif
 
-PacketCapture::PacketCapture() : handle(nullptr), isCapturing(false), onPacketReceived(nullptr) {
+PacketCapture::PacketCapture() 
+    : handle(nullptr), isCapturing(false), offline(false), busyPoll(false), eventDriven(false), stopRequested(false), perfMonitor(nullptr), flightRecorder(nullptr), sampler(nullptr), packetsSinceStats(0), onPacketReceived(nullptr) {
 #ifdef _WIN32
     WSADATA wsaData;
     WSAStartup(MAKEWORD(2, 2), &wsaData);
@@ -64,18 +69,94 @@ bool PacketCapture::initialize(const std::string& iface) {
         interface = iface;
     }
     
-    handle = pcap_open_live(interface.c_str(), BUFSIZ, 1, 1000, errbuf);
+    if (busyPoll || eventDriven) {
+        openImmediate(errbuf);
+    } else {
+        handle = pcap_open_live(interface.c_str(), BUFSIZ, 1, 1000, errbuf);
+    }
     if (handle == nullptr) {
         std::cout << Utils::Colors::RED << "Error opening interface " << interface 
                   << ": " << errbuf << Utils::Colors::RESET << std::endl;
         return false;
     }
     
+    if (!checkLinkType()) {
+        return false;
+    }
+    
     std::cout << Utils::Colors::GREEN << "Initialized capture on interface: " 
               << interface << Utils::Colors::RESET << std::endl;
     return true;
 }
 
+bool PacketCapture::initializeOffline(const std::string& traceFile) {
+    char errbuf[PCAP_ERRBUF_SIZE];
+    
+    interface = traceFile;
+    offline = true;
+    handle = pcap_open_offline(traceFile.c_str(), errbuf);
+    if (handle == nullptr) {
+        std::cout << Utils::Colors::RED << "Error opening trace " << traceFile 
+                  << ": " << errbuf << Utils::Colors::RESET << std::endl;
+        return false;
+    }
+    
+    if (!checkLinkType()) {
+        return false;
+    }
+    
+    std::cout << Utils::Colors::GREEN << "Reading packets from trace: " 
+              << traceFile << Utils::Colors::RESET << std::endl;
+    return true;
+}
+
+// Immediate mode hands each frame over as soon as it arrives instead of
+// waiting for the kernel buffer timeout; the socket is non-blocking so
+// pollLoop() can spin on it, or an event loop can drain it when it is readable.
+bool PacketCapture::openImmediate(char* errbuf) {
+    handle = pcap_create(interface.c_str(), errbuf);
+    if (handle == nullptr) {
+        return false;
+    }
+    pcap_set_snaplen(handle, BUFSIZ);
+    pcap_set_promisc(handle, 1);
+    pcap_set_immediate_mode(handle, 1);
+    if (pcap_activate(handle) < 0 || pcap_setnonblock(handle, 1, errbuf) == -1) {
+        std::strncpy(errbuf, pcap_geterr(handle), PCAP_ERRBUF_SIZE - 1);
+        errbuf[PCAP_ERRBUF_SIZE - 1] = '\0';
+        pcap_close(handle);
+        handle = nullptr;
+        return false;
+    }
+    
+#ifdef SO_BUSY_POLL
+    // Lets the kernel poll the NIC queue from the read instead of waiting for
+    // an interrupt; needs driver support and usually CAP_NET_ADMIN.
+    int fd = pcap_get_selectable_fd(handle);
+    int budget = SOCKET_BUSY_POLL_USEC;
+    if (busyPoll && (fd < 0 || setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &budget, sizeof(budget)) != 0)) {
+        std::cout << Utils::Colors::YELLOW << "SO_BUSY_POLL not available on " << interface
+                  << "; polling from user space only" << Utils::Colors::RESET << std::endl;
+    }
+#endif
+    return true;
+}
+
+bool PacketCapture::checkLinkType() {
+    int linkType = pcap_datalink(handle);
+    if (!PacketParser::isSupported(linkType)) {
+        const char* name = pcap_datalink_val_to_name(linkType);
+        std::cout << Utils::Colors::RED << "Unsupported link type on " << interface << ": "
+                  << (name != nullptr ? name : "unknown") << " (" << linkType << ")"
+                  << Utils::Colors::RESET << std::endl;
+        pcap_close(handle);
+        handle = nullptr;
+        return false;
+    }
+    parser.setLinkType(linkType);
+    return true;
+}
+
 bool PacketCapture::startCapture() {
     if (handle == nullptr) {
         std::cout << Utils::Colors::RED << "Capture not initialized" << Utils::Colors::RESET << std::endl;
@@ -83,8 +164,12 @@ bool PacketCapture::startCapture() {
     }
     
     isCapturing = true;
+    stopRequested = false;
     std::cout << Utils::Colors::GREEN << "Starting packet capture..." << Utils::Colors::RESET << std::endl;
     
+    if (busyPoll && !offline) {
+        return pollLoop();
+    }
     if (pcap_loop(handle, -1, packetHandler, reinterpret_cast<u_char*>(this)) == -1) {
         std::cout << Utils::Colors::RED << "Error in packet capture loop: " 
                   << pcap_geterr(handle) << Utils::Colors::RESET << std::endl;
@@ -94,6 +179,77 @@ bool PacketCapture::startCapture() {
     return true;
 }
 
+// Reads without blocking for as long as frames keep coming. After
+// BUSY_POLL_SPINS empty reads it waits up to PARK_MS for the descriptor, so
+// an idle link does not keep the core at 100%.
+bool PacketCapture::pollLoop() {
+#ifndef _WIN32
+    int fd = pcap_get_selectable_fd(handle);
+#endif
+    uint32_t idle = 0;
+    while (!stopRequested.load(std::memory_order_relaxed)) {
+        int count = pcap_dispatch(handle, -1, packetHandler, reinterpret_cast<u_char*>(this));
+        if (count == PCAP_ERROR_BREAK) {
+            break;
+        }
+        if (count < 0) {
+            std::cout << Utils::Colors::RED << "Error in packet capture loop: "
+                      << pcap_geterr(handle) << Utils::Colors::RESET << std::endl;
+            return false;
+        }
+        if (count > 0) {
+            idle = 0;
+        } else if (++idle < BUSY_POLL_SPINS) {
+            Utils::cpuRelax();
+        } else {
+            idle = 0;
+#ifdef _WIN32
+            WaitForSingleObject(pcap_getevent(handle), PARK_MS);
+#else
+            if (fd >= 0) {
+                struct pollfd pfd = {fd, POLLIN, 0};
+                poll(&pfd, 1, PARK_MS);
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(PARK_MS));
+            }
+#endif
+        }
+    }
+    return true;
+}
+
+int PacketCapture::getSelectableFd() const {
+#ifdef _WIN32
+    return -1;
+#else
+    return handle != nullptr && !offline ? pcap_get_selectable_fd(handle) : -1;
+#endif
+}
+
+int PacketCapture::dispatch(int maxPackets) {
+    if (handle == nullptr) {
+        return -1;
+    }
+    isCapturing = true;
+    int count = pcap_dispatch(handle, maxPackets, packetHandler, reinterpret_cast<u_char*>(this));
+    if (count == PCAP_ERROR_BREAK || (offline && count == 0)) {
+        return -1;
+    }
+    if (count < 0) {
+        std::cout << Utils::Colors::RED << "Error in packet capture: " << pcap_geterr(handle)
+                  << Utils::Colors::RESET << std::endl;
+        return -1;
+    }
+    return count;
+}
+
+void PacketCapture::requestStop() {
+    stopRequested = true;
+    if (handle != nullptr) {
+        pcap_breakloop(handle);
+    }
+}
+
 void PacketCapture::stopCapture() {
     if (handle != nullptr) {
         pcap_breakloop(handle);
@@ -107,66 +263,103 @@ void PacketCapture::stopCapture() {
 void PacketCapture::packetHandler(u_char* userData, const struct pcap_pkthdr* pkthdr, const u_char* packet) {
     PacketCapture* capture = reinterpret_cast<PacketCapture*>(userData);
     
+    if (capture->flightRecorder != nullptr) {
+        int64_t nanos = static_cast<int64_t>(pkthdr->ts.tv_sec) * 1000000000LL + static_cast<int64_t>(pkthdr->ts.tv_usec) * 1000LL;
+        capture->flightRecorder->record(nanos, pkthdr->len, packet, pkthdr->caplen);
+    }
+    
     if (capture->onPacketReceived) {
-        PacketInfo info = capture->parsePacket(pkthdr, packet);
-        capture->onPacketReceived(info);
+        PerfMonitor* perf = capture->perfMonitor;
+        bool sampled = perf != nullptr && perf->shouldSample();
+        uint64_t start = sampled ? PerfMonitor::cycles() : 0;
+        
+        PacketInfo info;
+        bool parsed = capture->parsePacket(pkthdr, packet, info);
+        
+        if (perf != nullptr) {
+            perf->countStage(PerfMonitor::STAGE_PARSE);
+            if (sampled) {
+                uint64_t end = PerfMonitor::cycles();
+                perf->recordStage(PerfMonitor::STAGE_PARSE, end - start);
+                info.captureCycles = end;
+            }
+            if (++capture->packetsSinceStats >= STATS_REFRESH_PACKETS) {
+                capture->refreshCaptureStats();
+            }
+        }
+        
+        if (parsed) {
+            capture->onPacketReceived(info);
+        }
     }
 }
 
-PacketInfo PacketCapture::parsePacket(const struct pcap_pkthdr* pkthdr, const u_char* packet) {
-    PacketInfo info;
-    info.packetSize = pkthdr->len;
-    info.timestamp = std::chrono::system_clock::now();
-    
-    const u_char* ip_packet = packet + 14;
+// pcap_stats is not safe to call concurrently with the capture loop, so it is
+// polled from the capture thread itself every few thousand packets.
+void PacketCapture::refreshCaptureStats() {
+    packetsSinceStats = 0;
+    uint64_t received = 0;
+    uint64_t dropped = 0;
+    struct pcap_stat ps;
+    if (handle != nullptr && pcap_stats(handle, &ps) == 0) {
+        perfMonitor->updateCaptureStats(ps.ps_recv, ps.ps_drop, ps.ps_ifdrop);
+        received = ps.ps_recv;
+        dropped = static_cast<uint64_t>(ps.ps_drop) + ps.ps_ifdrop;
+    }
+    if (sampler != nullptr) {
+        sampler->adjust(perfMonitor->getQueueDepth(), received, dropped);
+    }
+}
+
+// Frames the parser rejects (non-IP, truncated, malformed) are counted by
+// status and dropped instead of being passed on with garbage fields.
+bool PacketCapture::parsePacket(const struct pcap_pkthdr* pkthdr, const u_char* packet, PacketInfo& info) {
+    ParsedPacket parsed;
+    ParsedPacket::Status status = parser.parse(packet, pkthdr->caplen, parsed);
+    parseResults[status].increment();
+    if (status != ParsedPacket::OK) {
+        return false;
+    }
     
-#ifdef _WIN32
-    struct ip {
-        unsigned char ip_hl:4;
-        unsigned char ip_v:4;
-        unsigned char ip_tos;
-        unsigned short ip_len;
-        unsigned short ip_id;
-        unsigned short ip_off;
-        unsigned char ip_ttl;
-        unsigned char ip_p;
-        unsigned short ip_sum;
-        struct in_addr ip_src;
-        struct in_addr ip_dst;
-    };
-#endif
+    // Sampled out before any formatting, so skipped packets cost only the parse.
+    if (sampler != nullptr) {
+        info.sampleWeight = sampler->sample(parsed);
+        if (info.sampleWeight == 0) {
+            return false;
+        }
+    }
     
-    const struct ip* ip_header = reinterpret_cast<const struct ip*>(ip_packet);
-  
-    info.sourceIP = ipToString(ntohl(ip_header->ip_src.s_addr));
-    info.destIP = ipToString(ntohl(ip_header->ip_dst.s_addr));
-    info.protocol = Utils::protocolToString(ip_header->ip_p);
+    info.packetSize = pkthdr->len;
+    info.timestamp = std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+        std::chrono::seconds(pkthdr->ts.tv_sec) + std::chrono::microseconds(pkthdr->ts.tv_usec)));
+    info.sourceAddr = parsed.sourceAddr;
+    info.destAddr = parsed.destAddr;
+    info.ipProtocol = parsed.ipProtocol;
     
-    if (ip_header->ip_p == IPPROTO_TCP || ip_header->ip_p == IPPROTO_UDP) {
-        const u_char* transport_header = ip_packet + (ip_header->ip_hl * 4);
-        
-        struct transport_ports {
-            uint16_t source;
-            uint16_t dest;
-        };
-        
-        const struct transport_ports* ports = 
-            reinterpret_cast<const struct transport_ports*>(transport_header);
-        
-        info.sourcePort = ntohs(ports->source);
-        info.destPort = ntohs(ports->dest);
+    if (parsed.hasPorts) {
+        info.sourcePort = parsed.sourcePort;
+        info.destPort = parsed.destPort;
     }
     
-    return info;
+    // The payload is only valid here, while the frame buffer is.
+    dissector.dissect(parsed, info.app);
+    
+    return true;
 }
 
-std::string PacketCapture::ipToString(uint32_t ip) {
-    char buffer[INET_ADDRSTRLEN];
-    struct in_addr addr;
-    addr.s_addr = htonl(ip);
-    
-    if (inet_ntop(AF_INET, &addr, buffer, INET_ADDRSTRLEN) != nullptr) {
-        return std::string(buffer);
+void PacketCapture::printStats() const {
+    std::cout << "Parser: link type " << parser.getLinkType();
+    for (int i = 0; i < ParsedPacket::STATUS_COUNT; ++i) {
+        std::cout << ", " << PacketParser::statusName(static_cast<ParsedPacket::Status>(i)) << " " << parseResults[i].get();
+    }
+    std::cout << std::endl;
+}
+
+void PacketCapture::writeMetrics(std::ostream& out) const {
+    out << "# HELP network2_parse_frames_total Captured frames by parse result; only ok frames are processed.\n"
+        << "# TYPE network2_parse_frames_total counter\n";
+    for (int i = 0; i < ParsedPacket::STATUS_COUNT; ++i) {
+        out << "network2_parse_frames_total{result=\"" << PacketParser::statusName(static_cast<ParsedPacket::Status>(i))
+            << "\"} " << parseResults[i].get() << "\n";
     }
-    return "0.0.0.0";
 }
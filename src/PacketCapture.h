@@ -2,7 +2,15 @@
 #define PACKET_CAPTURE_H
 
 #include "PacketTypes.h"
+#include "PerfMonitor.h"
+#include "FlightRecorder.h"
+#include "PacketParser.h"
+#include "Dissector.h"
+#include "Sampler.h"
+#include "Counters.h"
+#include <atomic>
 #include <string>
+#include <ostream>
 #include <vector>
 #include <functional>
 
@@ -23,21 +31,76 @@ private:
     pcap_t* handle;
     std::string interface;
     bool isCapturing;
+    bool offline;
+    bool busyPoll;
+    bool eventDriven;
+    std::atomic<bool> stopRequested;
+    PerfMonitor* perfMonitor;
+    FlightRecorder* flightRecorder;
+    Sampler* sampler;
+    PacketParser parser;
+    Dissector dissector;
+    SingleWriterCounter parseResults[ParsedPacket::STATUS_COUNT];
+    uint32_t packetsSinceStats;
+    
+    static const uint32_t STATS_REFRESH_PACKETS = 4096;
+    
+    // Busy-poll mode: empty non-blocking reads before the capture thread
+    // parks, how long it parks, and the SO_BUSY_POLL budget (Linux).
+    static constexpr uint32_t BUSY_POLL_SPINS = 16384;
+    static constexpr int PARK_MS = 1;
+    static constexpr int SOCKET_BUSY_POLL_USEC = 50;
     
     static void packetHandler(u_char* userData, const struct pcap_pkthdr* pkthdr, const u_char* packet);
-    PacketInfo parsePacket(const struct pcap_pkthdr* pkthdr, const u_char* packet);
-    std::string ipToString(uint32_t ip);
+    void refreshCaptureStats();
+    bool checkLinkType();
+    bool openImmediate(char* errbuf);
+    bool pollLoop();
     
 public:
     PacketCapture();
     ~PacketCapture();
     
     bool initialize(const std::string& interface = "");
+    bool initializeOffline(const std::string& traceFile);  // Capture ends at the end of the file
     bool startCapture();
+    void requestStop();  // Makes startCapture() return; safe from another thread
     void stopCapture();
+    // Before initialize(): open live interfaces in immediate, non-blocking
+    // mode and spin on them instead of blocking in pcap_loop.
+    void setBusyPoll(bool enabled) { busyPoll = enabled; }
+    // Before initialize(): open live interfaces in immediate, non-blocking
+    // mode for a caller that waits on getSelectableFd() and calls dispatch().
+    void setEventDriven(bool enabled) { eventDriven = enabled; }
+    // Descriptor that becomes readable when frames arrive, or -1 if there is
+    // none (trace files, some platforms).
+    int getSelectableFd() const;
+    // Handles up to `maxPackets` frames without blocking and returns how
+    // many; -1 at the end of a trace or on error.
+    int dispatch(int maxPackets);
     std::vector<std::string> getAvailableInterfaces();
+    void setPerfMonitor(PerfMonitor* monitor) { perfMonitor = monitor; }
+    void setFlightRecorder(FlightRecorder* recorder) { flightRecorder = recorder; }
+    void setSampler(Sampler* packetSampler) { sampler = packetSampler; }
+    int getLinkType() const { return handle != nullptr ? pcap_datalink(handle) : parser.getLinkType(); }
+    
+    // Decodes one frame into `info`; false (and counted) if it is not a
+    // well-formed IP packet, or if the sampler skips it. Can be driven
+    // without a live handle, e.g. from saved frames, after setting the link
+    // type.
+    bool parsePacket(const struct pcap_pkthdr* pkthdr, const u_char* packet, PacketInfo& info);
+    void setLinkType(int linkType) { parser.setLinkType(linkType); }
+    // Port table for the application-layer dissectors; configure before capturing.
+    Dissector& getDissector() { return dissector; }
+    
+    void printStats() const;
+    void writeMetrics(std::ostream& out) const;
     
-    std::function<void(const PacketInfo&)> onPacketReceived;
+    // The packet may be modified; it is not used again after the call. The
+    // std::function costs about what a direct call does per packet (one
+    // indirect call on a warm cache), and keeps capture free of the pipeline
+    // and queue, which the bench and replay tools drive it without.
+    std::function<void(PacketInfo&)> onPacketReceived;
     
     bool isActive() const { return isCapturing; }
     const std::string& getInterface() const { return interface; }
@@ -0,0 +1,275 @@
+#include "PacketParser.h"
+
+namespace {
+    const uint16_t ETHERTYPE_IPV4 = 0x0800;
+    const uint16_t ETHERTYPE_IPV6 = 0x86DD;
+    const uint16_t ETHERTYPE_VLAN = 0x8100;
+    const uint16_t ETHERTYPE_QINQ = 0x88A8;
+    const uint16_t ETHERTYPE_QINQ_OLD = 0x9100;
+    const int MAX_STACKED_TAGS = 4;
+
+    const uint32_t ETHERNET_HEADER = 14;
+    const uint32_t VLAN_TAG = 4;
+    const uint32_t SLL_HEADER = 16;
+    const uint32_t SLL2_HEADER = 20;
+    const uint32_t NULL_HEADER = 4;
+    const uint32_t IPV4_MIN_HEADER = 20;
+    const uint32_t IPV6_HEADER = 40;
+    const int MAX_EXTENSION_HEADERS = 8;
+
+    const uint8_t PROTO_TCP = 6;
+    const uint8_t PROTO_UDP = 17;
+
+    // IPv6 extension headers that can precede the upper-layer header.
+    const uint8_t EXT_HOP_BY_HOP = 0;
+    const uint8_t EXT_ROUTING = 43;
+    const uint8_t EXT_FRAGMENT = 44;
+    const uint8_t EXT_AUTH = 51;
+    const uint8_t EXT_DEST_OPTIONS = 60;
+    const uint8_t EXT_MOBILITY = 135;
+    const uint8_t EXT_HIP = 139;
+    const uint8_t EXT_SHIM6 = 140;
+
+    // Address family values seen in DLT_NULL/DLT_LOOP headers across platforms.
+    const uint32_t BSD_AF_INET = 2;
+    const uint32_t BSD_AF_INET6_VALUES[] = {10, 24, 28, 30};
+
+    inline uint16_t load16(const uint8_t* p) {
+        return static_cast<uint16_t>((p[0] << 8) | p[1]);
+    }
+
+    inline uint32_t load32(const uint8_t* p) {
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+               (static_cast<uint32_t>(p[2]) << 8) | p[3];
+    }
+
+    bool isVlanTag(uint16_t etherType) {
+        return etherType == ETHERTYPE_VLAN || etherType == ETHERTYPE_QINQ || etherType == ETHERTYPE_QINQ_OLD;
+    }
+}
+
+bool PacketParser::isSupported(int linkType) {
+    switch (linkType) {
+        case LINK_NULL:
+        case LINK_ETHERNET:
+        case LINK_RAW:
+        case LINK_RAW_OPENBSD:
+        case LINK_RAW_LINKTYPE:
+        case LINK_LOOP:
+        case LINK_LINUX_SLL:
+        case LINK_IPV4:
+        case LINK_IPV6:
+        case LINK_LINUX_SLL2:
+            return true;
+        default:
+            return false;
+    }
+}
+
+const char* PacketParser::statusName(ParsedPacket::Status status) {
+    switch (status) {
+        case ParsedPacket::OK: return "ok";
+        case ParsedPacket::TRUNCATED: return "truncated";
+        case ParsedPacket::NOT_IP: return "not_ip";
+        case ParsedPacket::MALFORMED: return "malformed";
+        case ParsedPacket::UNSUPPORTED: return "unsupported";
+        default: return "unknown";
+    }
+}
+
+ParsedPacket::Status PacketParser::parse(const uint8_t* frame, uint32_t capturedLength, ParsedPacket& out) const {
+    out = ParsedPacket();
+
+    switch (linkType) {
+        case LINK_ETHERNET:
+            out.status = parseEthernet(frame, capturedLength, out);
+            break;
+        case LINK_LINUX_SLL:
+            out.status = capturedLength < SLL_HEADER
+                ? ParsedPacket::TRUNCATED
+                : parseEtherType(load16(frame + 14), frame + SLL_HEADER, capturedLength - SLL_HEADER, out);
+            break;
+        case LINK_LINUX_SLL2:
+            out.status = capturedLength < SLL2_HEADER
+                ? ParsedPacket::TRUNCATED
+                : parseEtherType(load16(frame), frame + SLL2_HEADER, capturedLength - SLL2_HEADER, out);
+            break;
+        case LINK_NULL:
+        case LINK_LOOP: {
+            if (capturedLength < NULL_HEADER) {
+                out.status = ParsedPacket::TRUNCATED;
+                break;
+            }
+            // DLT_LOOP is big-endian; DLT_NULL is in the capturing host's byte
+            // order, so accept whichever reading gives a small value.
+            uint32_t family = load32(frame);
+            if (linkType == LINK_NULL && family > 0xFFFF) {
+                family = (family >> 24) | ((family >> 8) & 0xFF00) | ((family << 8) & 0xFF0000) | (family << 24);
+            }
+            bool known = family == BSD_AF_INET;
+            for (uint32_t value : BSD_AF_INET6_VALUES) {
+                known = known || family == value;
+            }
+            out.status = known ? parseIp(frame + NULL_HEADER, capturedLength - NULL_HEADER, out) : ParsedPacket::NOT_IP;
+            break;
+        }
+        case LINK_RAW:
+        case LINK_RAW_OPENBSD:
+        case LINK_RAW_LINKTYPE:
+        case LINK_IPV4:
+        case LINK_IPV6:
+            out.status = parseIp(frame, capturedLength, out);
+            break;
+        default:
+            out.status = ParsedPacket::UNSUPPORTED;
+            break;
+    }
+    return out.status;
+}
+
+ParsedPacket::Status PacketParser::parseEthernet(const uint8_t* data, uint32_t length, ParsedPacket& out) const {
+    if (length < ETHERNET_HEADER) return ParsedPacket::TRUNCATED;
+    return parseEtherType(load16(data + 12), data + ETHERNET_HEADER, length - ETHERNET_HEADER, out);
+}
+
+ParsedPacket::Status PacketParser::parseEtherType(uint16_t etherType, const uint8_t* data, uint32_t length,
+                                                  ParsedPacket& out) const {
+    // 802.1Q and QinQ tags: TCI then the inner EtherType.
+    for (int tags = 0; isVlanTag(etherType); ++tags) {
+        if (tags == MAX_STACKED_TAGS) return ParsedPacket::UNSUPPORTED;
+        if (length < VLAN_TAG) return ParsedPacket::TRUNCATED;
+        if (out.vlanCount < ParsedPacket::MAX_VLAN_TAGS) {
+            out.vlanIds[out.vlanCount++] = load16(data) & 0x0FFF;
+        }
+        etherType = load16(data + 2);
+        data += VLAN_TAG;
+        length -= VLAN_TAG;
+    }
+    out.etherType = etherType;
+
+    if (etherType == ETHERTYPE_IPV4 || etherType == ETHERTYPE_IPV6) {
+        ParsedPacket::Status status = parseIp(data, length, out);
+        if (status == ParsedPacket::OK && (out.ipVersion == 4) != (etherType == ETHERTYPE_IPV4)) {
+            return ParsedPacket::MALFORMED;
+        }
+        return status;
+    }
+    return ParsedPacket::NOT_IP;
+}
+
+ParsedPacket::Status PacketParser::parseIp(const uint8_t* data, uint32_t length, ParsedPacket& out) const {
+    if (length < 1) return ParsedPacket::TRUNCATED;
+    out.ipVersion = data[0] >> 4;
+    if (out.ipVersion == 4) return parseIpv4(data, length, out);
+    if (out.ipVersion == 6) return parseIpv6(data, length, out);
+    return ParsedPacket::MALFORMED;
+}
+
+ParsedPacket::Status PacketParser::parseIpv4(const uint8_t* data, uint32_t length, ParsedPacket& out) const {
+    if (length < IPV4_MIN_HEADER) return ParsedPacket::TRUNCATED;
+
+    uint32_t headerLength = (data[0] & 0x0F) * 4u;
+    uint32_t totalLength = load16(data + 2);
+    if (headerLength < IPV4_MIN_HEADER || totalLength < headerLength) return ParsedPacket::MALFORMED;
+    if (length < headerLength) return ParsedPacket::TRUNCATED;
+
+    uint16_t fragment = load16(data + 6);
+    uint16_t fragmentOffset = fragment & 0x1FFF;
+    bool moreFragments = (fragment & 0x2000) != 0;
+
+    out.ttl = data[8];
+    out.ipProtocol = data[9];
+    out.sourceAddr = IpAddress::fromV4(load32(data + 12));
+    out.destAddr = IpAddress::fromV4(load32(data + 16));
+    out.isFragment = moreFragments || fragmentOffset != 0;
+
+    // Trailing link-layer padding is not part of the datagram.
+    uint32_t available = (totalLength < length ? totalLength : length) - headerLength;
+    if (fragmentOffset == 0) {
+        parseTransport(data + headerLength, available, out);
+    } else {
+        out.payload = data + headerLength;
+        out.payloadLength = available;
+    }
+    return ParsedPacket::OK;
+}
+
+ParsedPacket::Status PacketParser::parseIpv6(const uint8_t* data, uint32_t length, ParsedPacket& out) const {
+    if (length < IPV6_HEADER) return ParsedPacket::TRUNCATED;
+
+    out.ttl = data[7];
+    out.sourceAddr = IpAddress::fromBytes(data + 8);
+    out.destAddr = IpAddress::fromBytes(data + 24);
+
+    // A zero payload length means a jumbogram; take whatever was captured.
+    uint32_t payloadLength = load16(data + 4);
+    uint32_t available = length - IPV6_HEADER;
+    if (payloadLength != 0 && payloadLength < available) available = payloadLength;
+
+    const uint8_t* next = data + IPV6_HEADER;
+    uint8_t header = data[6];
+    bool firstFragment = true;
+
+    while (header == EXT_HOP_BY_HOP || header == EXT_ROUTING || header == EXT_FRAGMENT || header == EXT_AUTH ||
+           header == EXT_DEST_OPTIONS || header == EXT_MOBILITY || header == EXT_HIP || header == EXT_SHIM6) {
+        if (out.extensionHeaders == MAX_EXTENSION_HEADERS) return ParsedPacket::UNSUPPORTED;
+        if (available < 8) return ParsedPacket::TRUNCATED;
+
+        uint32_t extensionLength;
+        if (header == EXT_FRAGMENT) {
+            uint16_t fragment = load16(next + 2);
+            out.isFragment = true;
+            firstFragment = (fragment & 0xFFF8) == 0;
+            extensionLength = 8;
+        } else if (header == EXT_AUTH) {
+            extensionLength = (next[1] + 2u) * 4u;
+        } else {
+            extensionLength = (next[1] + 1u) * 8u;
+        }
+        if (extensionLength > available) return ParsedPacket::TRUNCATED;
+
+        header = next[0];
+        next += extensionLength;
+        available -= extensionLength;
+        out.extensionHeaders++;
+    }
+
+    out.ipProtocol = header;
+    if (firstFragment) {
+        parseTransport(next, available, out);
+    } else {
+        out.payload = next;
+        out.payloadLength = available;
+    }
+    return ParsedPacket::OK;
+}
+
+void PacketParser::parseTransport(const uint8_t* data, uint32_t length, ParsedPacket& out) const {
+    out.payload = data;
+    out.payloadLength = length;
+
+    if (out.ipProtocol == PROTO_TCP) {
+        out.payloadLength = 0;
+        if (length < 4) return;
+        out.hasPorts = true;
+        out.sourcePort = load16(data);
+        out.destPort = load16(data + 2);
+        if (length < 14) return;
+        out.tcpFlags = data[13];
+        uint32_t headerLength = (data[12] >> 4) * 4u;
+        if (headerLength >= 20 && headerLength <= length) {
+            out.payload = data + headerLength;
+            out.payloadLength = length - headerLength;
+        }
+    } else if (out.ipProtocol == PROTO_UDP) {
+        out.payloadLength = 0;
+        if (length < 4) return;
+        out.hasPorts = true;
+        out.sourcePort = load16(data);
+        out.destPort = load16(data + 2);
+        if (length >= 8) {
+            out.payload = data + 8;
+            out.payloadLength = length - 8;
+        }
+    }
+}
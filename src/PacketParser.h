@@ -0,0 +1,86 @@
+#ifndef PACKET_PARSER_H
+#define PACKET_PARSER_H
+
+#include "IpAddress.h"
+#include <cstdint>
+#include <cstddef>
+
+// Result of decoding one frame. Plain fixed-size data: parsing never
+// allocates, and `payload` points into the caller's frame buffer.
+struct ParsedPacket {
+    enum Status : uint8_t {
+        OK = 0,
+        TRUNCATED,    // A header extends past the captured length
+        NOT_IP,       // Valid link layer carrying something other than IP
+        MALFORMED,    // Header fields are inconsistent (bad version, IHL, ...)
+        UNSUPPORTED,  // Link type or protocol the parser does not decode
+        STATUS_COUNT
+    };
+
+    static const int MAX_VLAN_TAGS = 2;
+
+    Status status;
+    uint16_t etherType;
+    uint8_t vlanCount;
+    uint16_t vlanIds[MAX_VLAN_TAGS];
+
+    uint8_t ipVersion;
+    uint8_t ipProtocol;
+    uint8_t ttl;
+    IpAddress sourceAddr;
+    IpAddress destAddr;
+    bool isFragment;
+    uint8_t extensionHeaders;  // IPv6 extension headers walked to reach ipProtocol
+
+    bool hasPorts;  // False for non-first fragments and truncated transport headers
+    uint16_t sourcePort;
+    uint16_t destPort;
+    uint8_t tcpFlags;
+
+    // After the TCP or UDP header (empty if that header is truncated), or
+    // the whole IP payload for other protocols.
+    const uint8_t* payload;
+    uint32_t payloadLength;
+};
+
+// Decodes frames for one pcap link type down to the transport ports, for
+// IPv4 and for IPv6 through its extension header chain.
+// Every header is checked against the captured length before it is read.
+class PacketParser {
+public:
+    // Link-layer header types (the LINKTYPE_/DLT_ values used by libpcap).
+    enum LinkType {
+        LINK_NULL = 0,
+        LINK_ETHERNET = 1,
+        LINK_RAW = 12,
+        LINK_RAW_OPENBSD = 14,
+        LINK_RAW_LINKTYPE = 101,
+        LINK_LOOP = 108,
+        LINK_LINUX_SLL = 113,
+        LINK_IPV4 = 228,
+        LINK_IPV6 = 229,
+        LINK_LINUX_SLL2 = 276
+    };
+
+    explicit PacketParser(int linkType = LINK_ETHERNET) : linkType(linkType) {}
+
+    static bool isSupported(int linkType);
+    static const char* statusName(ParsedPacket::Status status);
+
+    void setLinkType(int type) { linkType = type; }
+    int getLinkType() const { return linkType; }
+
+    ParsedPacket::Status parse(const uint8_t* frame, uint32_t capturedLength, ParsedPacket& out) const;
+
+private:
+    int linkType;
+
+    ParsedPacket::Status parseEthernet(const uint8_t* data, uint32_t length, ParsedPacket& out) const;
+    ParsedPacket::Status parseEtherType(uint16_t etherType, const uint8_t* data, uint32_t length, ParsedPacket& out) const;
+    ParsedPacket::Status parseIp(const uint8_t* data, uint32_t length, ParsedPacket& out) const;
+    ParsedPacket::Status parseIpv4(const uint8_t* data, uint32_t length, ParsedPacket& out) const;
+    ParsedPacket::Status parseIpv6(const uint8_t* data, uint32_t length, ParsedPacket& out) const;
+    void parseTransport(const uint8_t* data, uint32_t length, ParsedPacket& out) const;
+};
+
+#endif
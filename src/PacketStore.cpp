@@ -0,0 +1,260 @@
+#include "PacketStore.h"
+#include "Utils.h"
+#include <iostream>
+#include <chrono>
+#include <cstring>
+
+bool PacketStore::Filter::parse(const std::vector<std::string>& terms, Filter& filter, std::string& error) {
+    for (const auto& term : terms) {
+        if (term.empty()) continue;
+        if (term == "anomalies") {
+            filter.anomaliesOnly = true;
+            continue;
+        }
+
+        std::size_t eq = term.find('=');
+        std::string key = eq == std::string::npos ? term : term.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : term.substr(eq + 1);
+
+        if (key == "ip") {
+            if (!IpPrefix::parse(value, filter.network)) {
+                error = "Invalid address or prefix '" + value + "'";
+                return false;
+            }
+            filter.hasAddress = true;
+            if (filter.network.isV4()) {
+                int bits = filter.network.bits - 96;
+                filter.mask = bits == 0 ? 0 : ~static_cast<uint32_t>(0) << (32 - bits);
+                filter.address = filter.network.network.v4();
+            }
+        } else if (key == "port") {
+            uint64_t port = 0;
+            if (!Utils::parseCount(value, 65535, port)) {
+                error = "Invalid port number '" + value + "'";
+                return false;
+            }
+            filter.hasPort = true;
+            filter.port = static_cast<uint16_t>(port);
+        } else if (key == "proto") {
+            std::string proto = Utils::toUpperCase(value);
+            if (proto == "TCP") filter.protocol = 6;
+            else if (proto == "UDP") filter.protocol = 17;
+            else if (proto == "ICMP") filter.protocol = 1;
+            else if (proto == "ICMPV6") filter.protocol = 58;
+            else {
+                error = "Invalid protocol '" + value + "' (TCP, UDP, ICMP or ICMPv6)";
+                return false;
+            }
+        } else if (key == "last") {
+            uint64_t seconds = 0;
+            if (!Utils::parseCount(value, 999999999, seconds)) {
+                error = "Invalid number of seconds '" + value + "'";
+                return false;
+            }
+            auto since = std::chrono::system_clock::now() - std::chrono::seconds(static_cast<int64_t>(seconds));
+            filter.fromNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(since.time_since_epoch()).count();
+        } else {
+            error = "Unknown filter '" + term + "' (use ip=, port=, proto=, last=, anomalies)";
+            return false;
+        }
+    }
+    return true;
+}
+
+void PacketStore::Result::toPacketInfo(std::size_t index, PacketInfo& packet) const {
+    const Row& row = rows[index];
+    packet.timestamp = std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(row.timestampNanos)));
+    packet.sourceAddr = row.sourceAddr;
+    packet.destAddr = row.destAddr;
+    packet.packetSize = row.packetSize;
+    packet.sourcePort = row.sourcePort;
+    packet.destPort = row.destPort;
+    packet.ipProtocol = row.ipProtocol;
+    packet.isAnomaly = row.isAnomaly;
+    packet.anomalyReason = row.isAnomaly ? reasons[row.reasonIndex] : "";
+}
+
+PacketStore::PacketStore() : maxChunks(0), current(0), totalRecords(0) {}
+
+void PacketStore::setCapacity(std::size_t records) {
+    maxChunks = (records + CHUNK_RECORDS - 1) / CHUNK_RECORDS;
+    clear();
+}
+
+void PacketStore::clear() {
+    chunks.clear();
+    chunks.shrink_to_fit();
+    current = 0;
+    totalRecords = 0;
+}
+
+void PacketStore::add(const PacketInfo& packet) {
+    if (maxChunks == 0) return;
+
+    if (chunks.empty() || chunks[current]->count == CHUNK_RECORDS) {
+        if (chunks.size() < maxChunks) {
+            chunks.emplace_back(new Chunk);
+            current = chunks.size() - 1;
+        } else {
+            current = (current + 1) % chunks.size();
+        }
+        Chunk& fresh = *chunks[current];
+        fresh.count = 0;
+        fresh.reasons.clear();
+        fresh.v6Rows.clear();
+    }
+
+    Chunk& chunk = *chunks[current];
+    std::size_t row = chunk.count;
+    int64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(packet.timestamp.time_since_epoch()).count();
+    chunk.timestamps[row] = nanos;
+    bool ipv6 = !packet.sourceAddr.isV4() || !packet.destAddr.isV4();
+    chunk.sourceAddrs[row] = ipv6 ? 0 : packet.sourceAddr.v4();
+    chunk.destAddrs[row] = ipv6 ? 0 : packet.destAddr.v4();
+    chunk.sizes[row] = packet.packetSize;
+    chunk.sourcePorts[row] = packet.sourcePort;
+    chunk.destPorts[row] = packet.destPort;
+    chunk.protocols[row] = packet.ipProtocol;
+    chunk.flags[row] = static_cast<uint8_t>((packet.isAnomaly ? ROW_ANOMALY : 0) | (ipv6 ? ROW_IPV6 : 0));
+    if (packet.isAnomaly) {
+        chunk.reasons.emplace_back(static_cast<uint32_t>(row), packet.anomalyReason);
+    }
+    if (ipv6) {
+        chunk.v6Rows.push_back(V6Addresses{static_cast<uint32_t>(row), packet.sourceAddr, packet.destAddr});
+    }
+    if (row == 0 || nanos < chunk.minTimestamp) chunk.minTimestamp = nanos;
+    if (row == 0 || nanos > chunk.maxTimestamp) chunk.maxTimestamp = nanos;
+    chunk.count = row + 1;
+    totalRecords++;
+}
+
+void PacketStore::printStats() const {
+    if (!isEnabled()) {
+        std::cout << "Packet store: disabled" << std::endl;
+        return;
+    }
+    std::cout << "Packet store: " << size() << " of " << getCapacity() << " records, "
+              << Utils::formatBytes(memoryBytes()) << " in " << chunks.size() << " chunks, "
+              << totalRecords << " stored since start" << std::endl;
+}
+
+std::size_t PacketStore::memoryBytes() const {
+    std::size_t total = chunks.size() * sizeof(Chunk);
+    for (const auto& chunk : chunks) {
+        total += chunk->v6Rows.capacity() * sizeof(V6Addresses);
+    }
+    return total;
+}
+
+std::size_t PacketStore::size() const {
+    std::size_t total = 0;
+    for (const auto& chunk : chunks) {
+        total += chunk->count;
+    }
+    return total;
+}
+
+// Each predicate is one pass over a single column, AND-ed into the mask
+// without branches; the gather at the end is the only data-dependent loop.
+void PacketStore::scanChunk(const Chunk& chunk, const Filter& filter, Result& result) const {
+    const std::size_t n = chunk.count;
+    static thread_local uint8_t keep[CHUNK_RECORDS];
+
+    if (filter.fromNanos > chunk.minTimestamp || filter.toNanos <= chunk.maxTimestamp) {
+        const int64_t* ts = chunk.timestamps;
+        const int64_t from = filter.fromNanos;
+        const int64_t to = filter.toNanos;
+        for (std::size_t i = 0; i < n; ++i) {
+            keep[i] = static_cast<uint8_t>((ts[i] >= from) & (ts[i] < to));
+        }
+    } else {
+        std::memset(keep, 1, n);
+    }
+
+    if (filter.hasAddress && filter.network.isV4()) {
+        const uint32_t* src = chunk.sourceAddrs;
+        const uint32_t* dst = chunk.destAddrs;
+        const uint8_t* flags = chunk.flags;
+        const uint32_t mask = filter.mask;
+        const uint32_t net = filter.address;
+        for (std::size_t i = 0; i < n; ++i) {
+            keep[i] &= static_cast<uint8_t>((((src[i] & mask) == net) | ((dst[i] & mask) == net)) &
+                                            ((flags[i] & ROW_IPV6) == 0));
+        }
+    } else if (filter.hasAddress) {
+        // Only IPv6 rows can match: mark hits in bit 1, then keep rows that
+        // passed the earlier predicates and were marked.
+        for (const auto& v6 : chunk.v6Rows) {
+            if (filter.network.contains(v6.source) || filter.network.contains(v6.dest)) keep[v6.row] |= 2;
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            keep[i] = static_cast<uint8_t>(keep[i] & (keep[i] >> 1) & 1);
+        }
+    }
+    if (filter.hasPort) {
+        const uint16_t* sport = chunk.sourcePorts;
+        const uint16_t* dport = chunk.destPorts;
+        const uint16_t port = filter.port;
+        for (std::size_t i = 0; i < n; ++i) {
+            keep[i] &= static_cast<uint8_t>((sport[i] == port) | (dport[i] == port));
+        }
+    }
+    if (filter.protocol >= 0) {
+        const uint8_t* proto = chunk.protocols;
+        const uint8_t wanted = static_cast<uint8_t>(filter.protocol);
+        for (std::size_t i = 0; i < n; ++i) {
+            keep[i] &= static_cast<uint8_t>(proto[i] == wanted);
+        }
+    }
+    if (filter.anomaliesOnly) {
+        const uint8_t* flags = chunk.flags;
+        for (std::size_t i = 0; i < n; ++i) {
+            keep[i] &= static_cast<uint8_t>(flags[i] & ROW_ANOMALY);
+        }
+    }
+
+    auto reason = chunk.reasons.begin();
+    auto v6 = chunk.v6Rows.begin();
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!keep[i]) continue;
+        Row row;
+        row.timestampNanos = chunk.timestamps[i];
+        if (chunk.flags[i] & ROW_IPV6) {
+            while (v6 != chunk.v6Rows.end() && v6->row < i) ++v6;
+            row.sourceAddr = v6->source;
+            row.destAddr = v6->dest;
+        } else {
+            row.sourceAddr = IpAddress::fromV4(chunk.sourceAddrs[i]);
+            row.destAddr = IpAddress::fromV4(chunk.destAddrs[i]);
+        }
+        row.packetSize = chunk.sizes[i];
+        row.sourcePort = chunk.sourcePorts[i];
+        row.destPort = chunk.destPorts[i];
+        row.ipProtocol = chunk.protocols[i];
+        row.isAnomaly = (chunk.flags[i] & ROW_ANOMALY) != 0;
+        row.reasonIndex = 0;
+        if (row.isAnomaly) {
+            while (reason != chunk.reasons.end() && reason->first < i) ++reason;
+            row.reasonIndex = static_cast<uint32_t>(result.reasons.size());
+            result.reasons.push_back(reason != chunk.reasons.end() && reason->first == i ? reason->second : "");
+        }
+        result.rows.push_back(row);
+    }
+}
+
+void PacketStore::query(const Filter& filter, Result& result) const {
+    result.rows.clear();
+    result.reasons.clear();
+    if (chunks.empty()) return;
+
+    // Once every chunk is allocated the oldest one follows the current one.
+    std::size_t first = chunks.size() < maxChunks ? 0 : (current + 1) % chunks.size();
+    for (std::size_t k = 0; k < chunks.size(); ++k) {
+        const Chunk& chunk = *chunks[(first + k) % chunks.size()];
+        if (chunk.count == 0 || chunk.maxTimestamp < filter.fromNanos || chunk.minTimestamp >= filter.toNanos) {
+            continue;
+        }
+        scanChunk(chunk, filter, result);
+    }
+}
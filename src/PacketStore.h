@@ -0,0 +1,118 @@
+#ifndef PACKET_STORE_H
+#define PACKET_STORE_H
+
+#include "PacketTypes.h"
+#include "IpAddress.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+
+// In-memory history of the most recent packets, kept column-wise in fixed
+// chunks of CHUNK_RECORDS. Chunks are allocated as the store fills and then
+// recycled oldest-first, so memory stays at the configured capacity and
+// records always come back in arrival order. Queries scan one column at a
+// time into a selection mask with branch-free loops the compiler can
+// vectorize, and skip chunks whose time span cannot match.
+class PacketStore {
+public:
+    static const std::size_t CHUNK_RECORDS = 65536;
+
+    struct Filter {
+        bool hasAddress = false;
+        IpPrefix network;      // Matches source or destination
+        uint32_t address = 0;  // IPv4 network and mask, when network is IPv4
+        uint32_t mask = 0;
+        bool hasPort = false;
+        uint16_t port = 0;
+        int protocol = -1;
+        int64_t fromNanos = std::numeric_limits<int64_t>::min();
+        int64_t toNanos = std::numeric_limits<int64_t>::max();
+        bool anomaliesOnly = false;
+
+        // Parses terms like "ip=10.0.0.0/8", "ip=2001:db8::/64", "port=443", "proto=tcp",
+        // "last=300" (seconds), "anomalies". Returns false with a message
+        // on the first bad term.
+        static bool parse(const std::vector<std::string>& terms, Filter& filter, std::string& error);
+    };
+
+    struct Row {
+        int64_t timestampNanos;
+        IpAddress sourceAddr;
+        IpAddress destAddr;
+        uint32_t packetSize;
+        uint16_t sourcePort;
+        uint16_t destPort;
+        uint8_t ipProtocol;
+        bool isAnomaly;
+        uint32_t reasonIndex;
+    };
+
+    struct Result {
+        std::vector<Row> rows;
+        std::vector<const char*> reasons;
+
+        std::size_t size() const { return rows.size(); }
+        void toPacketInfo(std::size_t index, PacketInfo& packet) const;
+    };
+
+private:
+    enum RowFlags : uint8_t {
+        ROW_ANOMALY = 1,
+        ROW_IPV6 = 2
+    };
+
+    struct V6Addresses {
+        uint32_t row;
+        IpAddress source;
+        IpAddress dest;
+    };
+
+    // IPv4 addresses fill the address columns; IPv6 rows hold zeros there
+    // and keep their addresses in v6Rows, so IPv4 records stay 4 bytes each.
+    struct Chunk {
+        std::size_t count = 0;
+        int64_t minTimestamp = 0;
+        int64_t maxTimestamp = 0;
+        int64_t timestamps[CHUNK_RECORDS];
+        uint32_t sourceAddrs[CHUNK_RECORDS];
+        uint32_t destAddrs[CHUNK_RECORDS];
+        uint32_t sizes[CHUNK_RECORDS];
+        uint16_t sourcePorts[CHUNK_RECORDS];
+        uint16_t destPorts[CHUNK_RECORDS];
+        uint8_t protocols[CHUNK_RECORDS];
+        uint8_t flags[CHUNK_RECORDS];
+        std::vector<std::pair<uint32_t, const char*>> reasons;  // Anomalous rows only, by row
+        std::vector<V6Addresses> v6Rows;                        // IPv6 rows only, by row
+    };
+
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    std::size_t maxChunks;
+    std::size_t current;  // Chunk receiving new records
+    uint64_t totalRecords;
+
+    void scanChunk(const Chunk& chunk, const Filter& filter, Result& result) const;
+
+public:
+    PacketStore();
+
+    // Rounds up to whole chunks; 0 disables the store.
+    void setCapacity(std::size_t records);
+    std::size_t getCapacity() const { return maxChunks * CHUNK_RECORDS; }
+    bool isEnabled() const { return maxChunks > 0; }
+
+    void add(const PacketInfo& packet);
+    void clear();
+
+    // Matching records, oldest first.
+    void query(const Filter& filter, Result& result) const;
+
+    std::size_t size() const;
+    void printStats() const;
+    std::size_t memoryBytes() const;
+    uint64_t getTotalRecords() const { return totalRecords; }
+};
+
+#endif
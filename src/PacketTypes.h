@@ -1,22 +1,48 @@
 #ifndef PACKET_TYPES_H
 #define PACKET_TYPES_H
 
+#include "IpAddress.h"
+#include "DomainName.h"
 #include <string>
 #include <chrono>
 #include <cstdint>
 
+// What the application-layer dissectors (Dissector.h) found in a packet's
+// payload. `name` is the DNS question, HTTP Host or TLS SNI when the packet
+// carries one.
+struct AppLayer {
+    enum Protocol : uint8_t { NONE = 0, DNS, HTTP, TLS, QUIC, PROTOCOL_COUNT };
+
+    Protocol protocol;
+    bool dnsResponse;
+    uint8_t dnsRcode;    // Responses only
+    DomainName name;
+
+    AppLayer() : protocol(NONE), dnsResponse(false), dnsRcode(0) {}
+
+    static const char* protocolName(Protocol protocol) {
+        static const char* const NAMES[PROTOCOL_COUNT] = {"", "DNS", "HTTP", "TLS", "QUIC"};
+        return protocol < PROTOCOL_COUNT ? NAMES[protocol] : "";
+    }
+};
+
 struct PacketInfo {
-    std::string sourceIP;
-    std::string destIP;
-    std::string protocol;
+    IpAddress sourceAddr;  // Format with FastFormat::address where text is needed
+    IpAddress destAddr;
+    uint8_t ipProtocol;
     uint16_t sourcePort;
     uint16_t destPort;
     uint32_t packetSize;
     std::chrono::system_clock::time_point timestamp;
     bool isAnomaly;
-    std::string anomalyReason;
+    const char* anomalyReason;  // One of AnomalyDetector's *_REASON strings when isAnomaly, else ""
+    uint64_t captureCycles;  // Cycle count at capture when latency-sampled, 0 otherwise
+    uint32_t sampleWeight;   // Packets this one stands for: the sampling rate N when it was kept
+    AppLayer app;
     
-    PacketInfo() : sourcePort(0), destPort(0), packetSize(0), isAnomaly(false) {
+    PacketInfo()
+        : ipProtocol(0), sourcePort(0), destPort(0), packetSize(0), isAnomaly(false), anomalyReason(""),
+          captureCycles(0), sampleWeight(1) {
         timestamp = std::chrono::system_clock::now();
     }
 };
@@ -24,6 +50,7 @@ struct PacketInfo {
 enum class AlertType {
     IP_WATCH,
     PORT_WATCH,
+    DOMAIN_WATCH,
     PACKET_BURST,
     PORT_SCAN,
     FAILED_CONNECTIONS
@@ -0,0 +1,197 @@
+#include "PerfMonitor.h"
+#include "Utils.h"
+#include <iostream>
+#include <iomanip>
+#include <array>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+PerfMonitor::PerfMonitor() : sampleInterval(64) {
+    startCycles = cycles();
+    startTime = std::chrono::steady_clock::now();
+}
+
+uint64_t PerfMonitor::cycles() {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+const char* PerfMonitor::stageName(Stage stage) {
+    switch (stage) {
+        case STAGE_PARSE: return "parse";
+        case STAGE_QUEUE: return "queue";
+        case STAGE_ANALYZE: return "analyze";
+        case STAGE_WATCH: return "watch";
+        case STAGE_RECORD: return "record";
+        case STAGE_LOG: return "log";
+        default: return "unknown";
+    }
+}
+
+void PerfMonitor::setSampleInterval(uint32_t interval) {
+    sampleInterval.store(interval, std::memory_order_relaxed);
+}
+
+bool PerfMonitor::shouldSample() {
+    static thread_local uint32_t countdown = 0;
+    uint32_t interval = sampleInterval.load(std::memory_order_relaxed);
+    if (interval == 0) return false;
+    if (countdown == 0 || countdown >= interval) {
+        countdown = interval - 1;
+        return true;
+    }
+    --countdown;
+    return false;
+}
+
+void PerfMonitor::recordStage(Stage stage, uint64_t elapsedCycles) {
+    StageCounters& counters = stages[stage];
+    counters.samples.increment();
+    counters.totalCycles.add(elapsedCycles);
+    if (elapsedCycles > counters.maxCycles.get()) {
+        counters.maxCycles.set(elapsedCycles);
+    }
+    counters.buckets[LatencyHistogram::bucketIndex(elapsedCycles)].increment();
+}
+
+void PerfMonitor::updateQueueDepth(uint64_t depth) {
+    queueDepth.set(depth);
+    if (depth > maxQueueDepth.get()) {
+        maxQueueDepth.set(depth);
+    }
+}
+
+void PerfMonitor::updateCaptureStats(uint64_t received, uint64_t dropped, uint64_t ifDropped) {
+    pcapReceived.set(received);
+    pcapDropped.set(dropped);
+    pcapIfDropped.set(ifDropped);
+}
+
+double PerfMonitor::nanosPerCycle() const {
+    uint64_t elapsedCycles = cycles() - startCycles;
+    auto elapsedNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+    if (elapsedCycles == 0 || elapsedNanos <= 0) return 1.0;
+    return static_cast<double>(elapsedNanos) / static_cast<double>(elapsedCycles);
+}
+
+PerfMonitor::Snapshot PerfMonitor::snapshot() const {
+    Snapshot snap;
+    double scale = nanosPerCycle();
+    
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        const StageCounters& counters = stages[s];
+        std::array<uint64_t, LatencyHistogram::BUCKET_COUNT> buckets;
+        uint64_t total = 0;
+        for (std::size_t i = 0; i < buckets.size(); ++i) {
+            buckets[i] = counters.buckets[i].get();
+            total += buckets[i];
+        }
+        
+        StageSnapshot& stage = snap.stages[s];
+        stage.packets = counters.packets.get();
+        stage.samples = counters.samples.get();
+        stage.totalNanos = static_cast<uint64_t>(counters.totalCycles.get() * scale);
+        stage.maxNanos = static_cast<uint64_t>(counters.maxCycles.get() * scale);
+        stage.p50 = static_cast<uint64_t>(LatencyHistogram::percentileOf(buckets, total, 0.50) * scale);
+        stage.p99 = static_cast<uint64_t>(LatencyHistogram::percentileOf(buckets, total, 0.99) * scale);
+        stage.p999 = static_cast<uint64_t>(LatencyHistogram::percentileOf(buckets, total, 0.999) * scale);
+    }
+    
+    snap.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    snap.queueDepth = queueDepth.get();
+    snap.maxQueueDepth = maxQueueDepth.get();
+    snap.pcapReceived = pcapReceived.get();
+    snap.pcapDropped = pcapDropped.get();
+    snap.pcapIfDropped = pcapIfDropped.get();
+    snap.sampleInterval = getSampleInterval();
+    return snap;
+}
+
+void PerfMonitor::dump(std::ostream& out) const {
+    Snapshot snap = snapshot();
+    
+    out << std::left << std::setw(10) << "Stage"
+        << std::right << std::setw(14) << "Packets"
+        << std::setw(14) << "Pkts/sec"
+        << std::setw(10) << "Avg ns"
+        << std::setw(10) << "p50 ns"
+        << std::setw(10) << "p99 ns"
+        << std::setw(10) << "p999 ns"
+        << std::setw(12) << "Max ns" << std::endl;
+    
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        const StageSnapshot& stage = snap.stages[s];
+        double throughput = snap.elapsedSeconds > 0 ? stage.packets / snap.elapsedSeconds : 0.0;
+        uint64_t average = stage.samples > 0 ? stage.totalNanos / stage.samples : 0;
+        
+        out << std::left << std::setw(10) << stageName(static_cast<Stage>(s))
+            << std::right << std::setw(14) << stage.packets
+            << std::setw(14) << std::fixed << std::setprecision(1) << throughput
+            << std::setw(10) << average
+            << std::setw(10) << stage.p50
+            << std::setw(10) << stage.p99
+            << std::setw(10) << stage.p999
+            << std::setw(12) << stage.maxNanos << std::endl;
+    }
+    
+    uint64_t offered = snap.pcapReceived;
+    double dropRate = offered > 0 ? (double)snap.pcapDropped / offered * 100 : 0.0;
+    out << "Queue depth: " << snap.queueDepth << " (max " << snap.maxQueueDepth << ")" << std::endl;
+    out << "Capture: received " << snap.pcapReceived << ", dropped " << snap.pcapDropped
+        << " (" << std::setprecision(2) << dropRate << "%), interface dropped " << snap.pcapIfDropped << std::endl;
+    out << "Latency sampling: " << (snap.sampleInterval == 0 ? std::string("off")
+                                   : "1 in " + std::to_string(snap.sampleInterval)) << std::endl;
+}
+
+void PerfMonitor::printStats() const {
+    std::cout << Utils::Colors::BOLD << "\n=== Pipeline Performance ===" << Utils::Colors::RESET << std::endl;
+    dump(std::cout);
+}
+
+void PerfMonitor::writeMetrics(std::ostream& out) const {
+    Snapshot snap = snapshot();
+    
+    out << "# HELP network2_stage_packets_total Packets handled by each pipeline stage.\n"
+        << "# TYPE network2_stage_packets_total counter\n";
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        out << "network2_stage_packets_total{stage=\"" << stageName(static_cast<Stage>(s)) << "\"} "
+            << snap.stages[s].packets << "\n";
+    }
+    
+    out << "# HELP network2_stage_latency_nanoseconds Sampled per-stage latency.\n"
+        << "# TYPE network2_stage_latency_nanoseconds summary\n";
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        const StageSnapshot& stage = snap.stages[s];
+        const char* name = stageName(static_cast<Stage>(s));
+        out << "network2_stage_latency_nanoseconds{stage=\"" << name << "\",quantile=\"0.5\"} " << stage.p50 << "\n"
+            << "network2_stage_latency_nanoseconds{stage=\"" << name << "\",quantile=\"0.99\"} " << stage.p99 << "\n"
+            << "network2_stage_latency_nanoseconds{stage=\"" << name << "\",quantile=\"0.999\"} " << stage.p999 << "\n"
+            << "network2_stage_latency_nanoseconds_sum{stage=\"" << name << "\"} " << stage.totalNanos << "\n"
+            << "network2_stage_latency_nanoseconds_count{stage=\"" << name << "\"} " << stage.samples << "\n";
+    }
+    
+    out << "# HELP network2_queue_depth Packets waiting between capture and processing.\n"
+        << "# TYPE network2_queue_depth gauge\n"
+        << "network2_queue_depth " << snap.queueDepth << "\n"
+        << "# HELP network2_queue_depth_max Highest queue depth observed.\n"
+        << "# TYPE network2_queue_depth_max gauge\n"
+        << "network2_queue_depth_max " << snap.maxQueueDepth << "\n"
+        << "# HELP network2_capture_received_total Packets received by the capture library.\n"
+        << "# TYPE network2_capture_received_total counter\n"
+        << "network2_capture_received_total " << snap.pcapReceived << "\n"
+        << "# HELP network2_capture_dropped_total Packets dropped for lack of buffer space.\n"
+        << "# TYPE network2_capture_dropped_total counter\n"
+        << "network2_capture_dropped_total " << snap.pcapDropped << "\n"
+        << "# HELP network2_capture_interface_dropped_total Packets dropped by the interface or driver.\n"
+        << "# TYPE network2_capture_interface_dropped_total counter\n"
+        << "network2_capture_interface_dropped_total " << snap.pcapIfDropped << "\n";
+}
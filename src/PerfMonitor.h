@@ -0,0 +1,121 @@
+#ifndef PERF_MONITOR_H
+#define PERF_MONITOR_H
+
+#include "Histogram.h"
+#include "Counters.h"
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+// Self-instrumentation for the packet pipeline. Every stage counts the
+// packets it handles; one packet in sampleInterval is additionally timed with
+// the cycle counter and its per-stage latency recorded in an HDR-style
+// histogram. Each stage is written by exactly one thread (parse on the
+// capture thread, the rest on the processing thread), so stage counters are
+// single-writer and never contend with readers.
+class PerfMonitor {
+public:
+    enum Stage {
+        STAGE_PARSE = 0,
+        STAGE_QUEUE,
+        STAGE_ANALYZE,
+        STAGE_WATCH,
+        STAGE_RECORD,
+        STAGE_LOG,
+        STAGE_COUNT
+    };
+
+    typedef LogLinearHistogram<4, 40> LatencyHistogram;
+
+    struct StageSnapshot {
+        uint64_t packets;
+        uint64_t samples;
+        uint64_t totalNanos;
+        uint64_t maxNanos;
+        uint64_t p50;
+        uint64_t p99;
+        uint64_t p999;
+    };
+
+    struct Snapshot {
+        StageSnapshot stages[STAGE_COUNT];
+        double elapsedSeconds;
+        uint64_t queueDepth;
+        uint64_t maxQueueDepth;
+        uint64_t pcapReceived;
+        uint64_t pcapDropped;
+        uint64_t pcapIfDropped;
+        uint32_t sampleInterval;
+    };
+
+    // Times consecutive stages of one packet: each lap() charges the cycles
+    // since the previous lap to the given stage. Does nothing when unsampled.
+    class StageTimer {
+    private:
+        PerfMonitor& monitor;
+        bool active;
+        uint64_t last;
+
+    public:
+        StageTimer(PerfMonitor& perf, bool sampled)
+            : monitor(perf), active(sampled), last(sampled ? cycles() : 0) {}
+
+        void lap(Stage stage) {
+            monitor.countStage(stage);
+            if (!active) return;
+            uint64_t now = cycles();
+            monitor.recordStage(stage, now - last);
+            last = now;
+        }
+    };
+
+    PerfMonitor();
+
+    static uint64_t cycles();
+    static const char* stageName(Stage stage);
+
+    void setSampleInterval(uint32_t interval);
+    uint32_t getSampleInterval() const { return sampleInterval.load(std::memory_order_relaxed); }
+    bool shouldSample();
+
+    void countStage(Stage stage) { stages[stage].packets.increment(); }
+    void recordStage(Stage stage, uint64_t elapsedCycles);
+    void updateQueueDepth(uint64_t depth);
+    uint64_t getQueueDepth() const { return queueDepth.get(); }
+    void updateCaptureStats(uint64_t received, uint64_t dropped, uint64_t ifDropped);
+
+    Snapshot snapshot() const;
+    void printStats() const;
+    void dump(std::ostream& out) const;
+    void writeMetrics(std::ostream& out) const;
+
+private:
+    struct alignas(CACHE_LINE_SIZE) StageCounters {
+        SingleWriterCounter packets;
+        SingleWriterCounter samples;
+        SingleWriterCounter totalCycles;
+        SingleWriterCounter maxCycles;
+        SingleWriterCounter buckets[LatencyHistogram::BUCKET_COUNT];
+    };
+
+    StageCounters stages[STAGE_COUNT];
+
+    std::atomic<uint32_t> sampleInterval;
+    alignas(CACHE_LINE_SIZE) SingleWriterCounter queueDepth;
+    SingleWriterCounter maxQueueDepth;
+    alignas(CACHE_LINE_SIZE) SingleWriterCounter pcapReceived;
+    SingleWriterCounter pcapDropped;
+    SingleWriterCounter pcapIfDropped;
+
+    // Samples stay in cycles; they are converted when read, using the
+    // cycle rate measured against steady_clock over the monitor's lifetime,
+    // so startup never stalls for calibration.
+    uint64_t startCycles;
+    std::chrono::steady_clock::time_point startTime;
+
+    double nanosPerCycle() const;
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include "Pipeline.h"
+#include "FastFormat.h"
+#include "Utils.h"
+#include <utility>
+
+namespace Pipeline {
+namespace {
+    // Runs for every flagged packet, which on busy links can be a large share
+    // of traffic. A flight recorder dump is claimed before its reason is
+    // built, so packets inside the cooldown cost a clock read and a counter
+    // increment, with no lock and no allocation.
+    void raiseAlerts(Context& context, const PacketInfo& packet, bool watched) {
+        if (context.flight != nullptr && context.flight->claimTrigger()) {
+            char text[FastFormat::ROUTE_MAX_WIDTH];
+            if (packet.isAnomaly) {
+                char* end = FastFormat::address(text, packet.sourceAddr);
+                context.flight->trigger("anomaly from " + std::string(text, end) + ": " + packet.anomalyReason);
+            } else {
+                char* end = FastFormat::route(text, packet.sourceAddr, packet.destAddr);
+                context.flight->trigger("watch rule: " + std::string(text, end));
+            }
+        }
+        if (context.onAlert != nullptr && *context.onAlert) {
+            (*context.onAlert)(packet);
+        }
+        if (context.events != nullptr) {
+            if (packet.isAnomaly) {
+                context.events->writeAlert(packet, "anomaly");
+            }
+            if (watched) {
+                context.events->writeAlert(packet, "watch");
+            }
+        }
+    }
+}
+
+void configure(Context& context) {
+    int number = context.filtering() ? Utils::protocolNumber(context.protocolFilter) : -1;
+    context.filterProtocol = number >= 0 ? static_cast<uint8_t>(number) : 0;
+}
+
+void process(Context& context, PacketInfo& packet) {
+    PerfMonitor& perf = *context.perf;
+    bool sampled = packet.captureCycles != 0;
+    perf.countStage(PerfMonitor::STAGE_QUEUE);
+    if (sampled) {
+        uint64_t now = PerfMonitor::cycles();
+        perf.recordStage(PerfMonitor::STAGE_QUEUE, now > packet.captureCycles ? now - packet.captureCycles : 0);
+    }
+
+    if (context.filtering() && packet.ipProtocol != context.filterProtocol) {
+        return;
+    }
+
+    PerfMonitor::StageTimer timer(perf, sampled);
+    context.detector->analyzePacket(packet);
+    timer.lap(PerfMonitor::STAGE_ANALYZE);
+
+    bool watched = context.watching() && context.watchRules->checkPacket(packet);
+    if ((watched || packet.isAnomaly) && context.alerting()) {
+        raiseAlerts(context, packet, watched);
+    }
+    timer.lap(PerfMonitor::STAGE_WATCH);
+
+    context.stats->recordPacket(packet);
+    if (context.storing()) {
+        context.store->add(packet);
+    }
+    if (context.trackingFlows()) {
+        context.flows->add(packet);
+    }
+    if (context.exporting()) {
+        context.exporter->add(packet);
+    }
+    timer.lap(PerfMonitor::STAGE_RECORD);
+
+    if (context.logging()) {
+        context.logger->logPacket(packet);
+        timer.lap(PerfMonitor::STAGE_LOG);
+    }
+
+    if (context.displaying()) {
+        context.recent[*context.recentIndex] = std::move(packet);
+        *context.recentIndex = (*context.recentIndex + 1) % context.recentSize;
+    }
+}
+}
@@ -0,0 +1,67 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "PacketTypes.h"
+#include "PerfMonitor.h"
+#include "AnomalyDetector.h"
+#include "WatchRules.h"
+#include "NetworkStats.h"
+#include "PacketStore.h"
+#include "FlowTable.h"
+#include "Logger.h"
+#include "EventWriter.h"
+#include "FlightRecorder.h"
+#include "SummaryExporter.h"
+#include <cstddef>
+#include <functional>
+#include <string>
+
+// The per-packet processing stages. Each optional stage checks its
+// configuration in the context per packet; those checks are a few predicted
+// branches against the detector and stats work, and compiling one variant
+// per combination of stages measured no faster. configure() resolves what
+// can be resolved up front; call it again whenever the configuration
+// changes (e.g. logging is toggled).
+namespace Pipeline {
+    // The components the stages work on. Null pointers and empty values mean
+    // the stage has nothing to do. Perf, detector and stats are required.
+    struct Context {
+        PerfMonitor* perf = nullptr;
+        AnomalyDetector* detector = nullptr;
+        NetworkStats* stats = nullptr;
+        WatchRules* watchRules = nullptr;
+        PacketStore* store = nullptr;
+        FlowTable* flows = nullptr;
+        Logger* logger = nullptr;
+        EventWriter* events = nullptr;
+        FlightRecorder* flight = nullptr;
+        SummaryExporter* exporter = nullptr;
+        const std::function<void(const PacketInfo&)>* onAlert = nullptr;
+        std::string protocolFilter;  // Empty = no filter, else a name Utils::protocolNumber accepts
+        uint8_t filterProtocol = 0;  // protocolFilter's IP protocol number, resolved by configure()
+
+        // Ring of the most recent packets for the live table.
+        PacketInfo* recent = nullptr;
+        std::size_t recentSize = 0;
+        std::size_t* recentIndex = nullptr;
+
+        bool filtering() const { return !protocolFilter.empty(); }
+        bool watching() const { return watchRules != nullptr && !watchRules->isEmpty(); }
+        bool alerting() const {
+            return flight != nullptr || (onAlert != nullptr && *onAlert) || (events != nullptr && events->isEnabled());
+        }
+        bool storing() const { return store != nullptr && store->isEnabled(); }
+        bool trackingFlows() const { return flows != nullptr; }
+        bool exporting() const { return exporter != nullptr && exporter->isEnabled(); }
+        bool logging() const { return logger != nullptr && logger->isEnabled(); }
+        bool displaying() const { return recent != nullptr && recentSize > 0; }
+    };
+
+    // Resolves protocolFilter into filterProtocol.
+    void configure(Context& context);
+
+    // May leave `packet` moved-from; the caller discards it afterwards.
+    void process(Context& context, PacketInfo& packet);
+}
+
+#endif
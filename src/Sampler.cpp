@@ -0,0 +1,76 @@
+#include "Sampler.h"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+Sampler::Sampler()
+    : rate(1), keepBelow(std::numeric_limits<uint64_t>::max()), packetsSinceKept(0),
+      lastReceived(0), lastDropped(0) {
+    publishedRate.set(1);
+}
+
+void Sampler::setOptions(const Options& samplerOptions) {
+    options = samplerOptions;
+    options.baseRate = (std::max)(options.baseRate, 1u);
+    options.maxRate = (std::max)(options.maxRate, options.baseRate);
+    setRate(options.baseRate);
+}
+
+void Sampler::setRate(uint32_t newRate) {
+    rate = newRate;
+    keepBelow = std::numeric_limits<uint64_t>::max() / rate;
+    packetsSinceKept = 0;
+    publishedRate.set(rate);
+}
+
+void Sampler::adjust(uint64_t queueDepth, uint64_t received, uint64_t dropped) {
+    uint64_t newReceived = received >= lastReceived ? received - lastReceived : 0;
+    uint64_t newDropped = dropped >= lastDropped ? dropped - lastDropped : 0;
+    lastReceived = received;
+    lastDropped = dropped;
+    if (!isAdaptive()) {
+        return;
+    }
+
+    bool overloaded = queueDepth > options.queueLimit ||
+                      (newReceived > 0 && static_cast<double>(newDropped) > options.dropLimit * static_cast<double>(newReceived));
+    auto now = std::chrono::steady_clock::now();
+    if (overloaded) {
+        lastOverload = now;
+        if (rate < options.maxRate && now - lastChange >= std::chrono::milliseconds(RAISE_INTERVAL_MS)) {
+            setRate(static_cast<uint32_t>((std::min)(static_cast<uint64_t>(rate) * 2, static_cast<uint64_t>(options.maxRate))));
+            lastChange = now;
+            raises.increment();
+        }
+    } else if (rate > options.baseRate && now - lastOverload >= std::chrono::seconds(CALM_SECONDS) &&
+               now - lastChange >= std::chrono::seconds(CALM_SECONDS)) {
+        setRate((std::max)(rate / 2, options.baseRate));
+        lastChange = now;
+    }
+}
+
+void Sampler::printStats() const {
+    uint32_t current = getRate();
+    std::cout << "Sampling: " << (options.mode == MODE_FLOW ? "flow" : "packet") << ", 1 in " << current;
+    if (isAdaptive()) {
+        std::cout << " (adaptive " << options.baseRate << "-" << options.maxRate << ", raised "
+                  << raises.get() << " times)";
+    }
+    std::cout << ", " << seen.get() << " seen, " << skipped.get() << " skipped, " << shedPackets.get()
+              << " shed" << std::endl;
+}
+
+void Sampler::writeMetrics(std::ostream& out) const {
+    out << "# HELP network2_sample_rate Current sampling rate N: one packet in N is processed.\n"
+        << "# TYPE network2_sample_rate gauge\n"
+        << "network2_sample_rate " << getRate() << "\n"
+        << "# HELP network2_sampled_out_packets_total Packets skipped by sampling.\n"
+        << "# TYPE network2_sampled_out_packets_total counter\n"
+        << "network2_sampled_out_packets_total " << skipped.get() << "\n"
+        << "# HELP network2_sample_rate_raises_total Times overload raised the sampling rate.\n"
+        << "# TYPE network2_sample_rate_raises_total counter\n"
+        << "network2_sample_rate_raises_total " << raises.get() << "\n"
+        << "# HELP network2_shed_packets_total Packets dropped because the processing queue reached four times the overload limit.\n"
+        << "# TYPE network2_shed_packets_total counter\n"
+        << "network2_shed_packets_total " << shedPackets.get() << "\n";
+}
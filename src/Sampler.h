@@ -0,0 +1,115 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include "PacketParser.h"
+#include "Counters.h"
+#include "IpAddress.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Overload protection: decides on the capture thread, before a packet is
+// formatted and queued, whether it is processed at all. Kept packets carry
+// the current 1-in-N rate as their weight, and statistics and detection
+// count each one N times, so totals and thresholds stay comparable.
+//
+// Flow mode keeps a packet when the hash of its endpoints, ports and
+// protocol (the same in both directions) falls in the lowest 1/N of the
+// hash space, so a kept connection is seen in full. Raising N shrinks that
+// range, so the flows kept at a higher rate are a subset of those kept at a
+// lower one and a flow is not dropped and picked up again as the rate moves.
+// Packet mode keeps every N-th packet.
+//
+// Adaptive sampling doubles N (up to maxRate) while the processing queue is
+// deeper than queueLimit or the kernel drops more than dropLimit of the
+// packets it receives, and halves it back towards baseRate once load has
+// stayed below those limits for CALM_SECONDS.
+class Sampler {
+public:
+    enum Mode { MODE_FLOW = 0, MODE_PACKET };
+
+    struct Options {
+        Mode mode = MODE_FLOW;
+        uint32_t baseRate = 1;            // 1 = keep everything
+        uint32_t maxRate = 1024;
+        std::size_t queueLimit = 262144;  // 0 = not adaptive
+        double dropLimit = 0.01;
+    };
+
+    static constexpr int CALM_SECONDS = 5;
+    static constexpr int RAISE_INTERVAL_MS = 100;  // At most one doubling per interval
+
+private:
+    Options options;
+    uint32_t rate;
+    uint64_t keepBelow;          // Flow mode: hashes up to this are kept
+    uint32_t packetsSinceKept;   // Packet mode
+    uint64_t lastReceived;
+    uint64_t lastDropped;
+    std::chrono::steady_clock::time_point lastOverload;
+    std::chrono::steady_clock::time_point lastChange;
+
+    SingleWriterCounter publishedRate;
+    SingleWriterCounter seen;
+    SingleWriterCounter skipped;
+    SingleWriterCounter raises;
+    SingleWriterCounter shedPackets;
+
+    void setRate(uint32_t newRate);
+
+public:
+    Sampler();
+
+    void setOptions(const Options& samplerOptions);
+    const Options& getOptions() const { return options; }
+    bool isAdaptive() const { return options.queueLimit > 0; }
+
+    static uint64_t flowHash(const IpAddress& a, uint16_t aPort, const IpAddress& b, uint16_t bPort, uint8_t protocol) {
+        uint64_t ha = IpAddress::mix(a.hash() ^ aPort);
+        uint64_t hb = IpAddress::mix(b.hash() ^ bPort);
+        uint64_t low = ha < hb ? ha : hb;
+        uint64_t high = ha < hb ? hb : ha;
+        return IpAddress::mix(low * 0x9E3779B97F4A7C15ULL ^ high ^ protocol);
+    }
+
+    // The weight to give the packet (the current N), or 0 to drop it.
+    uint32_t sample(const ParsedPacket& packet) {
+        seen.increment();
+        if (rate == 1) {
+            return 1;
+        }
+        bool keep;
+        if (options.mode == MODE_PACKET) {
+            keep = ++packetsSinceKept >= rate;
+            if (keep) packetsSinceKept = 0;
+        } else {
+            uint16_t sourcePort = packet.hasPorts ? packet.sourcePort : 0;
+            uint16_t destPort = packet.hasPorts ? packet.destPort : 0;
+            keep = flowHash(packet.sourceAddr, sourcePort, packet.destAddr, destPort, packet.ipProtocol) <= keepBelow;
+        }
+        if (!keep) {
+            skipped.increment();
+            return 0;
+        }
+        return rate;
+    }
+
+    // Capture thread, every few thousand packets. `received` and `dropped`
+    // are the capture's cumulative counts; `queueDepth` is the depth the
+    // processing thread last found.
+    void adjust(uint64_t queueDepth, uint64_t received, uint64_t dropped);
+
+    // Capture thread: a kept packet was dropped because the queue reached
+    // four times the overload limit, whatever the current rate.
+    void shed() { shedPackets.increment(); }
+
+    uint32_t getRate() const { return static_cast<uint32_t>(publishedRate.get()); }
+    uint64_t getSkipped() const { return skipped.get(); }
+    uint64_t getShed() const { return shedPackets.get(); }
+
+    void printStats() const;
+    void writeMetrics(std::ostream& out) const;
+};
+
+#endif
@@ -0,0 +1,120 @@
+#include "SegmentIndex.h"
+#include <filesystem>
+#include <algorithm>
+#include <cstdio>
+#include <cinttypes>
+
+namespace fs = std::filesystem;
+
+namespace {
+    const int SEQUENCE_DIGITS = 6;
+
+    struct SegmentName {
+        fs::path directory;
+        std::string stem;
+        std::string extension;
+    };
+
+    SegmentName splitBase(const std::string& basePath) {
+        fs::path base(basePath);
+        SegmentName name;
+        name.directory = base.has_parent_path() ? base.parent_path() : fs::path(".");
+        name.stem = base.stem().string();
+        name.extension = base.extension().string();
+        return name;
+    }
+
+    // Returns the sequence number if `file` is "<stem>.<digits><extension>", else 0.
+    unsigned parseSequence(const SegmentName& name, const std::string& file) {
+        std::size_t prefix = name.stem.size() + 1;
+        if (file.size() <= prefix + name.extension.size()) return 0;
+        if (file.compare(0, name.stem.size(), name.stem) != 0 || file[name.stem.size()] != '.') return 0;
+        if (file.compare(file.size() - name.extension.size(), name.extension.size(), name.extension) != 0) return 0;
+
+        std::string digits = file.substr(prefix, file.size() - prefix - name.extension.size());
+        if (digits.size() < static_cast<std::size_t>(SEQUENCE_DIGITS) || digits.size() > 9) return 0;
+        unsigned sequence = 0;
+        for (char c : digits) {
+            if (c < '0' || c > '9') return 0;
+            sequence = sequence * 10 + static_cast<unsigned>(c - '0');
+        }
+        return sequence;
+    }
+
+    std::vector<std::pair<unsigned, std::string>> findSegments(const std::string& basePath) {
+        SegmentName name = splitBase(basePath);
+        std::vector<std::pair<unsigned, std::string>> found;
+        std::error_code ec;
+        for (fs::directory_iterator it(name.directory, ec), end; !ec && it != end; it.increment(ec)) {
+            if (!it->is_regular_file(ec)) continue;
+            unsigned sequence = parseSequence(name, it->path().filename().string());
+            if (sequence > 0) {
+                found.emplace_back(sequence, it->path().string());
+            }
+        }
+        std::sort(found.begin(), found.end());
+        return found;
+    }
+}
+
+std::string SegmentIndex::segmentPath(const std::string& basePath, unsigned sequence) {
+    SegmentName name = splitBase(basePath);
+    char digits[16];
+    std::snprintf(digits, sizeof(digits), "%0*u", SEQUENCE_DIGITS, sequence);
+    fs::path path = fs::path(basePath).parent_path() / (name.stem + "." + digits + name.extension);
+    return path.string();
+}
+
+std::string SegmentIndex::indexPath(const std::string& segmentPath) {
+    return segmentPath + ".idx";
+}
+
+std::vector<std::string> SegmentIndex::listSegments(const std::string& basePath) {
+    std::vector<std::string> paths;
+    for (const auto& segment : findSegments(basePath)) {
+        paths.push_back(segment.second);
+    }
+    return paths;
+}
+
+unsigned SegmentIndex::lastSequence(const std::string& basePath) {
+    auto segments = findSegments(basePath);
+    return segments.empty() ? 0 : segments.back().first;
+}
+
+bool SegmentIndex::writeEntry(const std::string& segmentPath, const Entry& entry) {
+    std::FILE* file = std::fopen(indexPath(segmentPath).c_str(), "w");
+    if (file == nullptr) return false;
+    std::fprintf(file, "%" PRId64 " %" PRId64 " %" PRIu64 " %" PRIu64 "\n",
+                 entry.firstNanos, entry.lastNanos, entry.records, entry.bytes);
+    return std::fclose(file) == 0;
+}
+
+bool SegmentIndex::readEntry(const std::string& segmentPath, Entry& entry) {
+    std::FILE* file = std::fopen(indexPath(segmentPath).c_str(), "r");
+    if (file == nullptr) return false;
+    int fields = std::fscanf(file, "%" SCNd64 " %" SCNd64 " %" SCNu64 " %" SCNu64,
+                             &entry.firstNanos, &entry.lastNanos, &entry.records, &entry.bytes);
+    std::fclose(file);
+    return fields == 4;
+}
+
+void SegmentIndex::enforceRetention(const std::string& basePath, uint64_t maxBytes, const std::string& keepPath) {
+    auto segments = findSegments(basePath);
+    std::vector<uint64_t> sizes;
+    uint64_t total = 0;
+    std::error_code ec;
+    for (const auto& segment : segments) {
+        uint64_t size = fs::file_size(segment.second, ec);
+        sizes.push_back(ec ? 0 : size);
+        total += sizes.back();
+    }
+
+    for (std::size_t i = 0; i < segments.size() && total > maxBytes; ++i) {
+        if (fs::path(segments[i].second).filename() == fs::path(keepPath).filename()) continue;
+        if (fs::remove(segments[i].second, ec)) {
+            total -= sizes[i];
+        }
+        fs::remove(indexPath(segments[i].second), ec);
+    }
+}
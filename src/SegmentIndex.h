@@ -0,0 +1,36 @@
+#ifndef SEGMENT_INDEX_H
+#define SEGMENT_INDEX_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Naming and sidecar index for rotated log segments. A log configured as
+// "traffic.n2l" is written to traffic.000001.n2l, traffic.000002.n2l, ...
+// and each closed segment gets a one-line "<segment>.idx" sidecar holding
+// its time span, record count and size, so readers can skip a segment
+// without opening it.
+namespace SegmentIndex {
+    struct Entry {
+        int64_t firstNanos;
+        int64_t lastNanos;
+        uint64_t records;
+        uint64_t bytes;
+    };
+
+    std::string segmentPath(const std::string& basePath, unsigned sequence);
+    std::string indexPath(const std::string& segmentPath);
+
+    // Existing segments of basePath, oldest first.
+    std::vector<std::string> listSegments(const std::string& basePath);
+    unsigned lastSequence(const std::string& basePath);
+
+    bool writeEntry(const std::string& segmentPath, const Entry& entry);
+    bool readEntry(const std::string& segmentPath, Entry& entry);
+
+    // Deletes the oldest segments (and their sidecars) until the segments of
+    // basePath total at most maxBytes. keepPath is never deleted.
+    void enforceRetention(const std::string& basePath, uint64_t maxBytes, const std::string& keepPath);
+}
+
+#endif
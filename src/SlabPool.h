@@ -0,0 +1,85 @@
+#ifndef SLAB_POOL_H
+#define SLAB_POOL_H
+
+#include "MemoryBudget.h"
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+// Fixed-size entries carved from 64 KB slabs, each slab reserved against a
+// MemoryBudget account before it is allocated. Released entries go on a free
+// list and are handed out again before another slab is requested; slabs
+// themselves are only returned by clear(). allocate() returns nullptr once
+// the budget refuses to grow the pool.
+template <typename T>
+class SlabPool {
+public:
+    static const std::size_t SLAB_BYTES = 64 * 1024;
+    static const std::size_t SLAB_ENTRIES = sizeof(T) < SLAB_BYTES ? SLAB_BYTES / sizeof(T) : 1;
+
+private:
+    MemoryBudget& budget;
+    MemoryBudget::Account& account;
+    std::size_t slabCost;  // Charged per slab: the entries, their free-list slots and any caller overhead
+    std::vector<std::unique_ptr<T[]>> slabs;
+    std::vector<T*> freeList;  // Grows geometrically, so up to two slots per entry
+    std::size_t live = 0;
+
+    bool grow() {
+        if (!budget.reserve(account, slabCost)) return false;
+        slabs.emplace_back(new T[SLAB_ENTRIES]);
+        T* slab = slabs.back().get();
+        for (std::size_t i = SLAB_ENTRIES; i-- > 0;) {
+            freeList.push_back(slab + i);
+        }
+        account.capacity.set(capacity());
+        account.slabs.set(slabs.size());
+        return true;
+    }
+
+public:
+    // overheadPerEntry covers memory the caller keeps per entry outside the
+    // pool (an index node, say) so the budget sees the whole footprint.
+    SlabPool(MemoryBudget& budget, MemoryBudget::Account& account, std::size_t overheadPerEntry = 0)
+        : budget(budget), account(account),
+          slabCost(SLAB_ENTRIES * (sizeof(T) + 2 * sizeof(T*) + overheadPerEntry)) {}
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    ~SlabPool() { clear(); }
+
+    T* allocate() {
+        if (freeList.empty() && !grow()) return nullptr;
+        T* entry = freeList.back();
+        freeList.pop_back();
+        account.entries.set(++live);
+        account.allocations.increment();
+        return entry;
+    }
+
+    void release(T* entry) {
+        *entry = T();
+        freeList.push_back(entry);
+        account.entries.set(--live);
+    }
+
+    // Entries by position across all slabs, for sweeps over the whole pool.
+    T& at(std::size_t index) { return slabs[index / SLAB_ENTRIES][index % SLAB_ENTRIES]; }
+
+    void clear() {
+        if (!slabs.empty()) budget.release(account, slabs.size() * slabCost);
+        slabs.clear();
+        freeList.clear();
+        freeList.shrink_to_fit();
+        live = 0;
+        account.entries.set(0);
+        account.capacity.set(0);
+        account.slabs.set(0);
+    }
+
+    std::size_t size() const { return live; }
+    std::size_t capacity() const { return slabs.size() * SLAB_ENTRIES; }
+};
+
+#endif
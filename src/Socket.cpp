@@ -0,0 +1,259 @@
+#include "Socket.h"
+#include "Utils.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace Socket {
+#ifdef _WIN32
+    const Handle INVALID = static_cast<Handle>(INVALID_SOCKET);
+#else
+    const Handle INVALID = -1;
+#endif
+
+namespace {
+    // Resolves numeric or named hosts; `passive` for a listening socket.
+    struct addrinfo* resolve(const std::string& host, uint16_t port, bool passive, std::string& error) {
+        struct addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = passive ? AI_PASSIVE : 0;
+        struct addrinfo* result = nullptr;
+        int status = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result);
+        if (status != 0) {
+            error = "cannot resolve " + host + ": " + gai_strerror(status);
+            return nullptr;
+        }
+        return result;
+    }
+
+    Handle open(const struct addrinfo* info) {
+        return static_cast<Handle>(socket(info->ai_family, info->ai_socktype, info->ai_protocol));
+    }
+}
+
+bool parseHostPort(const std::string& endpoint, const std::string& defaultHost, std::string& host, uint16_t& port) {
+    std::string portText = endpoint;
+    host = defaultHost;
+    if (!endpoint.empty() && endpoint[0] == '[') {
+        std::size_t close = endpoint.find("]:");
+        if (close == std::string::npos) return false;
+        host = endpoint.substr(1, close - 1);
+        portText = endpoint.substr(close + 2);
+    } else {
+        std::size_t colon = endpoint.rfind(':');
+        if (colon != std::string::npos) {
+            if (endpoint.find(':') != colon) return false;  // Unbracketed IPv6
+            host = endpoint.substr(0, colon);
+            portText = endpoint.substr(colon + 1);
+        }
+    }
+    uint64_t value = 0;
+    if (host.empty() || !Utils::parseCount(portText, 65535, value) || value == 0) {
+        return false;
+    }
+    port = static_cast<uint16_t>(value);
+    return true;
+}
+
+Handle listenTcp(const std::string& host, uint16_t port, std::string& error) {
+    struct addrinfo* addresses = resolve(host, port, true, error);
+    if (addresses == nullptr) return INVALID;
+
+    Handle sock = open(addresses);
+    if (sock == INVALID) {
+        error = "cannot create socket";
+    } else {
+        int reuse = 1;
+        setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+        if (bind(sock, addresses->ai_addr, static_cast<int>(addresses->ai_addrlen)) != 0 || listen(sock, 16) != 0) {
+            error = "cannot listen on " + host + ":" + std::to_string(port);
+            close(sock);
+            sock = INVALID;
+        }
+    }
+    freeaddrinfo(addresses);
+    return sock;
+}
+
+Handle listenUnix(const std::string& path, std::string& error) {
+#ifdef _WIN32
+    error = "Unix domain sockets are not supported on Windows: " + path;
+    return INVALID;
+#else
+    struct sockaddr_un addr;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        error = "socket path too long: " + path;
+        return INVALID;
+    }
+
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) {
+        error = "cannot create socket";
+        return INVALID;
+    }
+
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path.c_str());
+
+    if (bind(sock, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 || listen(sock, 16) != 0) {
+        error = "cannot listen on " + path;
+        ::close(sock);
+        return INVALID;
+    }
+    return sock;
+#endif
+}
+
+Handle connectTo(const std::string& endpoint, std::string& error) {
+    if (isUnixPath(endpoint)) {
+#ifdef _WIN32
+        error = "Unix domain sockets are not supported on Windows: " + endpoint;
+        return INVALID;
+#else
+        struct sockaddr_un addr;
+        if (endpoint.size() >= sizeof(addr.sun_path)) {
+            error = "socket path too long: " + endpoint;
+            return INVALID;
+        }
+        int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (sock < 0) {
+            error = "cannot create socket";
+            return INVALID;
+        }
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, endpoint.c_str(), sizeof(addr.sun_path) - 1);
+        if (connect(sock, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+            error = "cannot connect to " + endpoint;
+            ::close(sock);
+            return INVALID;
+        }
+        return sock;
+#endif
+    }
+
+    std::string host;
+    uint16_t port = 0;
+    if (!parseHostPort(endpoint, "", host, port)) {
+        error = "expected host:port or a socket path: " + endpoint;
+        return INVALID;
+    }
+    struct addrinfo* addresses = resolve(host, port, false, error);
+    if (addresses == nullptr) return INVALID;
+
+    Handle sock = INVALID;
+    for (struct addrinfo* info = addresses; info != nullptr && sock == INVALID; info = info->ai_next) {
+        sock = open(info);
+        if (sock != INVALID && connect(sock, info->ai_addr, static_cast<int>(info->ai_addrlen)) != 0) {
+            close(sock);
+            sock = INVALID;
+        }
+    }
+    freeaddrinfo(addresses);
+    if (sock == INVALID) {
+        error = "cannot connect to " + endpoint;
+    }
+    return sock;
+}
+
+Handle accept(Handle listener) {
+    return static_cast<Handle>(::accept(listener, nullptr, nullptr));
+}
+
+void close(Handle socket) {
+#ifdef _WIN32
+    closesocket(static_cast<SOCKET>(socket));
+#else
+    ::close(socket);
+#endif
+}
+
+bool waitReadable(Handle socket, int timeoutMs) {
+    std::vector<Handle> sockets(1, socket);
+    std::vector<uint8_t> ready;
+    return waitReadable(sockets, ready, timeoutMs);
+}
+
+bool waitReadable(const std::vector<Handle>& sockets, std::vector<uint8_t>& ready, int timeoutMs) {
+#ifdef _WIN32
+    std::vector<WSAPOLLFD> fds(sockets.size());
+    for (std::size_t i = 0; i < sockets.size(); ++i) {
+        fds[i].fd = static_cast<SOCKET>(sockets[i]);
+        fds[i].events = POLLRDNORM;
+        fds[i].revents = 0;
+    }
+    int count = WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), timeoutMs);
+#else
+    std::vector<struct pollfd> fds(sockets.size());
+    for (std::size_t i = 0; i < sockets.size(); ++i) {
+        fds[i].fd = sockets[i];
+        fds[i].events = POLLIN;
+        fds[i].revents = 0;
+    }
+    int count = poll(fds.data(), static_cast<nfds_t>(fds.size()), timeoutMs);
+#endif
+    ready.assign(sockets.size(), 0);
+    if (count <= 0) return false;
+    for (std::size_t i = 0; i < fds.size(); ++i) {
+        ready[i] = fds[i].revents != 0;
+    }
+    return true;
+}
+
+long receive(Handle socket, char* buffer, std::size_t size) {
+#ifdef _WIN32
+    return recv(static_cast<SOCKET>(socket), buffer, static_cast<int>(size), 0);
+#else
+    return static_cast<long>(recv(socket, buffer, size, 0));
+#endif
+}
+
+bool sendAll(Handle socket, const char* data, std::size_t size) {
+    std::size_t sent = 0;
+    while (sent < size) {
+#ifdef _WIN32
+        int n = send(static_cast<SOCKET>(socket), data + sent, static_cast<int>(size - sent), 0);
+#else
+        ssize_t n = send(socket, data + sent, size - sent, MSG_NOSIGNAL);
+#endif
+        if (n <= 0) return false;
+        sent += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+void setSendTimeout(Handle socket, int timeoutMs) {
+#ifdef _WIN32
+    DWORD timeout = static_cast<DWORD>(timeoutMs);
+    setsockopt(static_cast<SOCKET>(socket), SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+#else
+    struct timeval timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+    setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+#endif
+}
+
+std::string hostName() {
+    char name[256] = {};
+    if (gethostname(name, sizeof(name) - 1) != 0 || name[0] == '\0') {
+        return "sensor";
+    }
+    return name;
+}
+}
@@ -0,0 +1,49 @@
+#ifndef SOCKET_H
+#define SOCKET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Thin portable wrappers over the BSD socket calls shared by the metrics
+// server, the summary exporter and the collector. Endpoints are written
+// "port" or "host:port" ("[v6addr]:port" for IPv6) for TCP; anything
+// containing a '/' is a Unix domain socket path, which Windows does not
+// support. Functions that can fail return INVALID or false and describe the
+// failure in `error`.
+namespace Socket {
+#ifdef _WIN32
+    typedef uintptr_t Handle;
+#else
+    typedef int Handle;
+#endif
+
+    extern const Handle INVALID;
+
+    inline bool isUnixPath(const std::string& endpoint) { return endpoint.find('/') != std::string::npos; }
+
+    // `host` is left as `defaultHost` when `endpoint` is a bare port.
+    bool parseHostPort(const std::string& endpoint, const std::string& defaultHost, std::string& host, uint16_t& port);
+
+    Handle listenTcp(const std::string& host, uint16_t port, std::string& error);
+    Handle listenUnix(const std::string& path, std::string& error);
+    // Blocking connect to "host:port" or a Unix socket path.
+    Handle connectTo(const std::string& endpoint, std::string& error);
+    Handle accept(Handle listener);
+    void close(Handle socket);
+
+    bool waitReadable(Handle socket, int timeoutMs);
+    // Marks `ready[i]` for each of `sockets` that is readable (or closed)
+    // within `timeoutMs`. False on timeout.
+    bool waitReadable(const std::vector<Handle>& sockets, std::vector<uint8_t>& ready, int timeoutMs);
+    // Bytes read, 0 when the peer closed, negative on error.
+    long receive(Handle socket, char* buffer, std::size_t size);
+    bool sendAll(Handle socket, const char* data, std::size_t size);
+    // Bounds how long sendAll() may block on a peer that stops reading.
+    void setSendTimeout(Handle socket, int timeoutMs);
+
+    std::string hostName();
+}
+
+#endif
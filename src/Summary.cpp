@@ -0,0 +1,169 @@
+#include "Summary.h"
+#include <cmath>
+#include <cstring>
+
+namespace {
+    const char MAGIC[4] = {'N', '2', 'S', 'M'};
+    const std::size_t TALKER_BYTES = 16 + 8 + 8;
+    const std::size_t SOURCE_BYTES = 16 + 4 + 4 + 4 + 1 + 16;
+
+    int popcount(uint64_t word) {
+        int count = 0;
+        for (; word != 0; word &= word - 1) ++count;
+        return count;
+    }
+
+    void put(std::string& out, uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i) {
+            out.push_back(static_cast<char>(value >> (8 * i)));
+        }
+    }
+
+    void putAddress(std::string& out, const IpAddress& address) {
+        uint8_t bytes[16];
+        address.toBytes(bytes);
+        out.append(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+    }
+
+    // Bounds-checked reads over a received frame; once a read runs past the
+    // end every later one fails too.
+    class Reader {
+    private:
+        const uint8_t* data;
+        std::size_t size;
+        std::size_t offset;
+        bool valid;
+
+    public:
+        Reader(const char* bytes, std::size_t length)
+            : data(reinterpret_cast<const uint8_t*>(bytes)), size(length), offset(0), valid(true) {}
+
+        bool has(std::size_t bytes) {
+            valid = valid && size - offset >= bytes;
+            return valid;
+        }
+
+        uint64_t get(int bytes) {
+            if (!has(static_cast<std::size_t>(bytes))) return 0;
+            uint64_t value = 0;
+            for (int i = 0; i < bytes; ++i) {
+                value |= static_cast<uint64_t>(data[offset + i]) << (8 * i);
+            }
+            offset += static_cast<std::size_t>(bytes);
+            return value;
+        }
+
+        IpAddress address() {
+            if (!has(16)) return IpAddress();
+            IpAddress value = IpAddress::fromBytes(data + offset);
+            offset += 16;
+            return value;
+        }
+
+        std::string text(std::size_t length) {
+            if (!has(length)) return std::string();
+            std::string value(reinterpret_cast<const char*>(data + offset), length);
+            offset += length;
+            return value;
+        }
+
+        std::size_t remaining() const { return valid ? size - offset : 0; }
+        bool ok() const { return valid; }
+        bool done() const { return valid && offset == size; }
+    };
+}
+
+double DistinctSketch::estimate() const {
+    int clear = BITS - popcount(words[0]) - popcount(words[1]);
+    // A full sketch can only say "many"; report the most it can tell apart.
+    double share = clear > 0 ? static_cast<double>(clear) / BITS : 1.0 / BITS;
+    return -BITS * std::log(share);
+}
+
+void Summary::encode(std::string& out) const {
+    std::size_t nameLength = sensor.size() < MAX_SENSOR_NAME ? sensor.size() : MAX_SENSOR_NAME;
+    std::size_t payload = 1 + nameLength + 8 * 5 + 4 + 2 + 2 + talkers.size() * TALKER_BYTES +
+                          sources.size() * SOURCE_BYTES;
+
+    out.reserve(out.size() + HEADER_BYTES + payload);
+    out.append(MAGIC, sizeof(MAGIC));
+    put(out, VERSION, 1);
+    put(out, 0, 3);
+    put(out, payload, 4);
+
+    put(out, nameLength, 1);
+    out.append(sensor, 0, nameLength);
+    put(out, static_cast<uint64_t>(startNanos), 8);
+    put(out, static_cast<uint64_t>(endNanos), 8);
+    put(out, packets, 8);
+    put(out, bytes, 8);
+    put(out, anomalies, 8);
+    put(out, sampleRate, 4);
+    put(out, talkers.size(), 2);
+    put(out, sources.size(), 2);
+    for (const Talker& talker : talkers) {
+        putAddress(out, talker.address);
+        put(out, talker.packets, 8);
+        put(out, talker.error, 8);
+    }
+    for (const Source& source : sources) {
+        putAddress(out, source.address);
+        put(out, source.packets, 4);
+        put(out, source.smallTcp, 4);
+        put(out, source.anomalies, 4);
+        put(out, source.reasons, 1);
+        put(out, source.ports.words[0], 8);
+        put(out, source.ports.words[1], 8);
+    }
+}
+
+std::size_t Summary::frameLength(const char* data, std::size_t size) {
+    if (size < HEADER_BYTES) return 0;
+    Reader reader(data, size);
+    if (std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0) return INVALID_FRAME;
+    reader.get(4);
+    if (reader.get(1) != VERSION) return INVALID_FRAME;
+    reader.get(3);
+    uint64_t payload = reader.get(4);
+    if (payload > MAX_FRAME_BYTES - HEADER_BYTES) return INVALID_FRAME;
+    return HEADER_BYTES + static_cast<std::size_t>(payload);
+}
+
+bool Summary::decode(const char* data, std::size_t size) {
+    std::size_t length = frameLength(data, size);
+    if (length == 0 || length == INVALID_FRAME || length != size) return false;
+
+    Reader reader(data + HEADER_BYTES, size - HEADER_BYTES);
+    std::size_t nameLength = static_cast<std::size_t>(reader.get(1));
+    if (nameLength > MAX_SENSOR_NAME) return false;
+    sensor = reader.text(nameLength);
+    startNanos = static_cast<int64_t>(reader.get(8));
+    endNanos = static_cast<int64_t>(reader.get(8));
+    packets = reader.get(8);
+    bytes = reader.get(8);
+    anomalies = reader.get(8);
+    sampleRate = static_cast<uint32_t>(reader.get(4));
+    std::size_t talkerCount = static_cast<std::size_t>(reader.get(2));
+    std::size_t sourceCount = static_cast<std::size_t>(reader.get(2));
+    if (!reader.ok() || reader.remaining() != talkerCount * TALKER_BYTES + sourceCount * SOURCE_BYTES) {
+        return false;
+    }
+
+    talkers.resize(talkerCount);
+    for (Talker& talker : talkers) {
+        talker.address = reader.address();
+        talker.packets = reader.get(8);
+        talker.error = reader.get(8);
+    }
+    sources.resize(sourceCount);
+    for (Source& source : sources) {
+        source.address = reader.address();
+        source.packets = static_cast<uint32_t>(reader.get(4));
+        source.smallTcp = static_cast<uint32_t>(reader.get(4));
+        source.anomalies = static_cast<uint32_t>(reader.get(4));
+        source.reasons = static_cast<uint8_t>(reader.get(1));
+        source.ports.words[0] = reader.get(8);
+        source.ports.words[1] = reader.get(8);
+    }
+    return reader.done() && sampleRate > 0 && endNanos >= startNanos;
+}
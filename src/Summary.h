@@ -0,0 +1,90 @@
+#ifndef SUMMARY_H
+#define SUMMARY_H
+
+#include "IpAddress.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Distinct-value sketch for small counts: each value sets one of 128 bits
+// picked by its hash, and the count is estimated from the share of bits
+// still clear (linear counting). Sketches from different sensors merge with
+// OR, which gives the same bits as one sketch over all of their values, so
+// a collector counts a source's ports as if it had seen every packet. Within
+// a port or two up to about 100 values, well past the scan threshold.
+struct DistinctSketch {
+    static const int BITS = 128;
+
+    uint64_t words[2] = {};
+
+    void add(uint32_t value) {
+        uint64_t hash = IpAddress::mix(value + 0x9E3779B97F4A7C15ULL);
+        words[hash >> 63] |= 1ULL << (hash & 63);
+    }
+
+    void merge(const DistinctSketch& other) {
+        words[0] |= other.words[0];
+        words[1] |= other.words[1];
+    }
+
+    bool isEmpty() const { return (words[0] | words[1]) == 0; }
+    double estimate() const;
+};
+
+// One sensor's traffic over one export interval, as shipped to a collector.
+// Only the sources closest to a detection threshold are included, so a
+// summary stays a few kilobytes however busy the interval was.
+//
+// On the wire a summary is one frame: the 4-byte magic "N2SM", a version
+// byte, three reserved bytes and the payload length, then the payload. All
+// integers are little-endian and addresses are 16 bytes in network order.
+struct Summary {
+    static const uint8_t VERSION = 1;
+    static const std::size_t HEADER_BYTES = 12;
+    static const std::size_t MAX_FRAME_BYTES = 1 << 20;
+    static const std::size_t MAX_SENSOR_NAME = 64;
+
+    enum Reason { REASON_BURST = 1, REASON_SCAN = 2, REASON_FAILED = 4 };
+
+    // Heavy hitter from the sensor's Space-Saving summary for the interval.
+    struct Talker {
+        IpAddress address;
+        uint64_t packets = 0;  // Upper bound
+        uint64_t error = 0;    // At most this much of `packets` may belong to other addresses
+    };
+
+    // Packet counts are weighted by the sampling rate.
+    struct Source {
+        IpAddress address;
+        uint32_t packets = 0;
+        uint32_t smallTcp = 0;   // Counted like the detector's failed connections
+        uint32_t anomalies = 0;  // Packets the sensor's own detector flagged
+        uint8_t reasons = 0;     // REASON_* bits of those detections
+        DistinctSketch ports;    // TCP destination ports
+    };
+
+    std::string sensor;
+    int64_t startNanos = 0;  // Capture time covered
+    int64_t endNanos = 0;
+    uint64_t packets = 0;    // All traffic in the interval, not just the listed sources
+    uint64_t bytes = 0;
+    uint64_t anomalies = 0;
+    uint32_t sampleRate = 1; // Highest rate in force during the interval
+    std::vector<Talker> talkers;
+    std::vector<Source> sources;
+
+    // Appends the framed summary to `out`.
+    void encode(std::string& out) const;
+
+    // Size of the whole frame starting at `data` once its header has
+    // arrived: 0 while fewer than HEADER_BYTES are available, INVALID_FRAME
+    // for a bad magic, version or length.
+    static const std::size_t INVALID_FRAME = static_cast<std::size_t>(-1);
+    static std::size_t frameLength(const char* data, std::size_t size);
+
+    // Decodes one complete frame. False if it is malformed.
+    bool decode(const char* data, std::size_t size);
+};
+
+#endif
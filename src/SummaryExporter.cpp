@@ -0,0 +1,251 @@
+#include "SummaryExporter.h"
+#include "AnomalyDetector.h"
+#include "Utils.h"
+#include <algorithm>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+namespace {
+    // A source is sent once it reaches this share of any threshold, so an
+    // attack split evenly across up to five sensors still adds up at the
+    // collector.
+    const double MIN_SCORE = 0.2;
+    const std::size_t TALKER_COUNTERS = 256;
+    const int64_t NANOS_PER_SECOND = 1000000000LL;
+
+    // How close the source came to each of the detector's thresholds in
+    // this interval; a local detection puts it ahead of everything else.
+    double score(const Summary::Source& source) {
+        double ports = source.ports.estimate() / AnomalyDetector::SCAN_THRESHOLD;
+        double small = static_cast<double>(source.smallTcp) / AnomalyDetector::FAILED_THRESHOLD;
+        double packets = static_cast<double>(source.packets) / AnomalyDetector::BURST_THRESHOLD;
+        return (std::max)({ports, small, packets}) + (source.anomalies > 0 ? 1.0 : 0.0);
+    }
+
+    // The detector's reasons are shared constants, so they compare by address.
+    uint8_t reasonBits(const char* reason) {
+        if (reason == AnomalyDetector::SCAN_REASON) return Summary::REASON_SCAN;
+        if (reason == AnomalyDetector::FAILED_REASON) return Summary::REASON_FAILED;
+        if (reason == AnomalyDetector::BURST_REASON) return Summary::REASON_BURST;
+        return 0;
+    }
+}
+
+SummaryExporter::SummaryExporter(MemoryBudget& budget)
+    : enabled(false), sources(budget, "export_sources"), talkers(TALKER_COUNTERS),
+      intervalNanos(NANOS_PER_SECOND), stopping(false), connection(Socket::INVALID),
+      reportUnreachable(true) {}
+
+SummaryExporter::~SummaryExporter() {
+    stop();
+}
+
+bool SummaryExporter::start(const Options& exporterOptions) {
+    stop();
+    options = exporterOptions;
+    options.intervalSeconds = (std::max)(options.intervalSeconds, 1);
+    intervalNanos = static_cast<int64_t>(options.intervalSeconds) * NANOS_PER_SECOND;
+    current = Summary();
+    current.sensor = options.sensor.substr(0, Summary::MAX_SENSOR_NAME);
+    stopping = false;
+    enabled = true;
+    sender = std::thread([this]() { senderLoop(); });
+    std::cout << Utils::Colors::GREEN << "Exporting summaries every " << options.intervalSeconds << " s to "
+              << options.endpoint << " as sensor '" << current.sensor << "'" << Utils::Colors::RESET << std::endl;
+    return true;
+}
+
+void SummaryExporter::stop() {
+    if (!enabled) return;
+    if (current.endNanos != 0) {
+        closeInterval();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (sender.joinable()) {
+        sender.join();
+    }
+    enabled = false;
+}
+
+void SummaryExporter::record(const PacketInfo& packet) {
+    uint32_t weight = packet.sampleWeight;
+    current.packets += weight;
+    current.bytes += static_cast<uint64_t>(packet.packetSize) * weight;
+    current.sampleRate = (std::max)(current.sampleRate, weight);
+    talkers.add(packet.sourceAddr, weight);
+
+    Summary::Source* source = sources.acquire(packet.sourceAddr);
+    if (source == nullptr) return;
+    source->packets += weight;
+    if (packet.ipProtocol == static_cast<uint8_t>(Protocol::TCP)) {
+        source->ports.add(packet.destPort);
+        if (packet.packetSize < AnomalyDetector::SMALL_TCP_BYTES) {
+            source->smallTcp += weight;
+        }
+    }
+    if (packet.isAnomaly) {
+        current.anomalies += weight;
+        source->anomalies += weight;
+        source->reasons |= reasonBits(packet.anomalyReason);
+    }
+}
+
+void SummaryExporter::tick(std::chrono::system_clock::time_point now) {
+    int64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+    if (current.endNanos != 0 && nanos >= current.endNanos + NANOS_PER_SECOND) {
+        closeInterval();
+    }
+}
+
+// Ranks the interval's sources, keeps the top maxSources, encodes the
+// summary and queues it for the sender. Clears the interval's state.
+void SummaryExporter::closeInterval() {
+    std::vector<std::pair<double, Summary::Source>> ranked;
+    sources.forEach([&ranked](const IpAddress& address, Summary::Source& source) {
+        double rank = score(source);
+        if (rank >= MIN_SCORE) {
+            source.address = address;
+            ranked.emplace_back(rank, source);
+        }
+    });
+    auto byScore = [](const std::pair<double, Summary::Source>& a, const std::pair<double, Summary::Source>& b) {
+        return a.first > b.first;
+    };
+    if (ranked.size() > options.maxSources) {
+        std::nth_element(ranked.begin(), ranked.begin() + static_cast<std::ptrdiff_t>(options.maxSources), ranked.end(), byScore);
+        sourcesSkipped.add(ranked.size() - options.maxSources);
+        ranked.resize(options.maxSources);
+    }
+
+    Summary& summary = current;
+    summary.sources.clear();
+    for (const auto& entry : ranked) {
+        summary.sources.push_back(entry.second);
+    }
+    summary.talkers.clear();
+    for (const auto& entry : talkers.top(options.maxTalkers)) {
+        Summary::Talker talker;
+        talker.address = entry.key;
+        talker.packets = entry.count;
+        talker.error = entry.error;
+        summary.talkers.push_back(talker);
+    }
+    encoded.clear();
+    summary.encode(encoded);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending.size() >= MAX_PENDING) {
+            pending.pop_front();
+            summariesDropped.increment();
+        }
+        pending.push_back(encoded);
+    }
+    wake.notify_one();
+
+    sources.clear();
+    talkers.clear();
+    std::string sensor = std::move(current.sensor);
+    current = Summary();
+    current.sensor = std::move(sensor);
+}
+
+// Delivers queued summaries in order. A summary that fails to send stays at
+// the front and is retried on a new connection every RETRY_MS.
+void SummaryExporter::senderLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    while (true) {
+        wake.wait(lock, [this]() { return stopping || !pending.empty(); });
+        auto now = std::chrono::steady_clock::now();
+        if (stopping && deadline == std::chrono::steady_clock::time_point::max()) {
+            deadline = now + std::chrono::milliseconds(FLUSH_TIMEOUT_MS);
+        }
+        if (pending.empty()) {
+            break;
+        }
+        if (now >= deadline) {
+            summariesDropped.add(pending.size());
+            pending.clear();
+            break;
+        }
+
+        std::string frame = std::move(pending.front());
+        pending.pop_front();
+        lock.unlock();
+        bool sent = deliver(frame);
+        lock.lock();
+        if (!sent) {
+            pending.push_front(std::move(frame));
+            wake.wait_until(lock, (std::min)(deadline, std::chrono::steady_clock::now() + std::chrono::milliseconds(RETRY_MS)));
+        }
+    }
+    if (connection != Socket::INVALID) {
+        Socket::close(connection);
+        connection = Socket::INVALID;
+        connected.set(0);
+    }
+}
+
+// Sender thread. Messages are built whole and written once, since the
+// processing thread may be printing too.
+bool SummaryExporter::deliver(const std::string& frame) {
+    if (connection == Socket::INVALID) {
+        std::string error;
+        connection = Socket::connectTo(options.endpoint, error);
+        if (connection == Socket::INVALID) {
+            if (reportUnreachable) {
+                std::cout << Utils::Colors::YELLOW + "Cannot reach collector: " + error + "; retrying" +
+                             Utils::Colors::RESET + "\n" << std::flush;
+                reportUnreachable = false;
+            }
+            return false;
+        }
+        Socket::setSendTimeout(connection, SEND_TIMEOUT_MS);
+        connected.set(1);
+        reportUnreachable = true;
+        std::cout << Utils::Colors::GREEN + "Connected to collector " + options.endpoint + Utils::Colors::RESET + "\n"
+                  << std::flush;
+    }
+    if (!Socket::sendAll(connection, frame.data(), frame.size())) {
+        Socket::close(connection);
+        connection = Socket::INVALID;
+        connected.set(0);
+        std::cout << Utils::Colors::YELLOW + "Lost connection to collector " + options.endpoint + "; reconnecting" +
+                     Utils::Colors::RESET + "\n" << std::flush;
+        return false;
+    }
+    summariesSent.increment();
+    bytesSent.add(frame.size());
+    return true;
+}
+
+void SummaryExporter::printStats() const {
+    if (!enabled) return;
+    std::cout << "Export: " << summariesSent.get() << " summaries (" << Utils::formatBytes(bytesSent.get())
+              << ") sent to " << options.endpoint << ", " << summariesDropped.get() << " dropped, "
+              << sourcesSkipped.get() << " sources over the per-summary limit, "
+              << (connected.get() != 0 ? "connected" : "not connected") << std::endl;
+}
+
+void SummaryExporter::writeMetrics(std::ostream& out) const {
+    if (!enabled) return;
+    out << "# HELP network2_export_summaries_total Interval summaries sent to the collector, or dropped undelivered.\n"
+        << "# TYPE network2_export_summaries_total counter\n"
+        << "network2_export_summaries_total{result=\"sent\"} " << summariesSent.get() << "\n"
+        << "network2_export_summaries_total{result=\"dropped\"} " << summariesDropped.get() << "\n"
+        << "# HELP network2_export_bytes_total Bytes of summaries sent to the collector.\n"
+        << "# TYPE network2_export_bytes_total counter\n"
+        << "network2_export_bytes_total " << bytesSent.get() << "\n"
+        << "# HELP network2_export_sources_skipped_total Candidate sources left out because a summary was full.\n"
+        << "# TYPE network2_export_sources_skipped_total counter\n"
+        << "network2_export_sources_skipped_total " << sourcesSkipped.get() << "\n"
+        << "# HELP network2_export_connected Whether the exporter is connected to the collector.\n"
+        << "# TYPE network2_export_connected gauge\n"
+        << "network2_export_connected " << connected.get() << "\n";
+}
@@ -0,0 +1,103 @@
+#ifndef SUMMARY_EXPORTER_H
+#define SUMMARY_EXPORTER_H
+
+#include "Summary.h"
+#include "Socket.h"
+#include "PacketTypes.h"
+#include "TrackerTable.h"
+#include "TopK.h"
+#include "Counters.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+// Sensor side of multi-sensor aggregation. The processing thread folds every
+// packet into per-source state for the current interval; when capture time
+// crosses the interval's end, the sources nearest a detection threshold and
+// the interval's heaviest talkers are encoded as a Summary and handed to a
+// sender thread, which keeps a connection to the collector open and
+// reconnects after failures. Intervals are aligned to multiples of their
+// length, so summaries from different sensors cover the same span.
+//
+// Per-source state is charged to the shared state budget and cleared after
+// every interval. Summaries that cannot be delivered wait in a short queue;
+// once it is full the oldest is dropped.
+class SummaryExporter {
+public:
+    struct Options {
+        std::string endpoint;         // "host:port" or a Unix socket path
+        std::string sensor;           // Name sent with every summary
+        int intervalSeconds = 5;
+        std::size_t maxSources = 256;
+        std::size_t maxTalkers = 32;
+    };
+
+    static constexpr std::size_t MAX_PENDING = 64;
+    static constexpr int RETRY_MS = 1000;
+    static constexpr int SEND_TIMEOUT_MS = 2000;
+    static constexpr int FLUSH_TIMEOUT_MS = 3000;  // How long stop() waits for delivery
+
+private:
+    Options options;
+    bool enabled;
+    TrackerTable<Summary::Source> sources;
+    SpaceSaving<IpAddress, IpAddress::Hash> talkers;
+    Summary current;          // Totals for the interval being built
+    int64_t intervalNanos;
+    std::string encoded;      // Reused between intervals
+
+    std::thread sender;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::string> pending;  // Guarded by mutex
+    bool stopping;                     // Guarded by mutex
+    Socket::Handle connection;         // Sender thread only
+    bool reportUnreachable;            // Sender thread only
+
+    SingleWriterCounter sourcesSkipped;    // Processing thread
+    SingleWriterCounter summariesSent;     // Sender thread
+    SingleWriterCounter bytesSent;
+    SingleWriterCounter connected;
+    SingleWriterCounter summariesDropped;  // Either thread, with the mutex held
+
+    void record(const PacketInfo& packet);
+    void closeInterval();
+    void senderLoop();
+    bool deliver(const std::string& frame);
+
+public:
+    // Per-source state is charged to `budget`, which must outlive the exporter.
+    explicit SummaryExporter(MemoryBudget& budget);
+    ~SummaryExporter();
+
+    bool start(const Options& exporterOptions);
+    // Sends the interval in progress and waits up to FLUSH_TIMEOUT_MS for
+    // the queue to drain.
+    void stop();
+    bool isEnabled() const { return enabled; }
+
+    // Processing thread, for every packet after detection.
+    void add(const PacketInfo& packet) {
+        int64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(packet.timestamp.time_since_epoch()).count();
+        if (nanos >= current.endNanos) {
+            if (current.endNanos != 0) closeInterval();
+            current.startNanos = nanos - nanos % intervalNanos;
+            current.endNanos = current.startNanos + intervalNanos;
+        }
+        record(packet);
+    }
+
+    // Processing thread, live capture only: closes the interval once the
+    // clock has passed its end with no packet to do it.
+    void tick(std::chrono::system_clock::time_point now);
+
+    void printStats() const;
+    void writeMetrics(std::ostream& out) const;
+};
+
+#endif
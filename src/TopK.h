@@ -0,0 +1,205 @@
+#ifndef TOP_K_H
+#define TOP_K_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <algorithm>
+
+// Space-Saving heavy-hitter summary (Metwally et al.) over a fixed number of
+// counters. Memory is O(capacity); every key whose true weight exceeds
+// totalWeight() / capacity() is guaranteed to be present, and each reported
+// count over-estimates the true weight by at most its `error`.
+//
+// Counters live in a min-heap addressed through a small open-addressing
+// index, so a hit is one probe plus a short sift (increments rarely move an
+// entry more than a level or two) and a miss replaces the heap root.
+template <typename Key, typename Hash = std::hash<Key>>
+class SpaceSaving {
+public:
+    struct Entry {
+        Key key;
+        uint64_t count;
+        uint64_t error;
+    };
+
+private:
+    struct Counter {
+        Key key;
+        uint64_t count;
+        uint64_t error;
+        std::size_t slot;
+    };
+
+    static constexpr std::size_t EMPTY = static_cast<std::size_t>(-1);
+
+    std::vector<Counter> heap;
+    std::vector<std::size_t> slots;
+    std::size_t slotMask;
+    std::size_t maxEntries;
+    uint64_t total;
+    Hash hasher;
+
+    std::size_t findSlot(const Key& key) const {
+        std::size_t i = hasher(key) & slotMask;
+        while (slots[i] != EMPTY) {
+            if (heap[slots[i]].key == key) return i;
+            i = (i + 1) & slotMask;
+        }
+        return i;
+    }
+
+    const Counter* find(const Key& key) const {
+        std::size_t i = findSlot(key);
+        return slots[i] == EMPTY ? nullptr : &heap[slots[i]];
+    }
+
+    void eraseSlot(std::size_t i) {
+        // Backward-shift deletion keeps linear probing chains intact without tombstones.
+        std::size_t j = i;
+        while (true) {
+            j = (j + 1) & slotMask;
+            if (slots[j] == EMPTY) break;
+            std::size_t home = hasher(heap[slots[j]].key) & slotMask;
+            bool between = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+            if (!between) {
+                slots[i] = slots[j];
+                heap[slots[i]].slot = i;
+                i = j;
+            }
+        }
+        slots[i] = EMPTY;
+    }
+
+    void swapNodes(std::size_t a, std::size_t b) {
+        std::swap(heap[a], heap[b]);
+        slots[heap[a].slot] = a;
+        slots[heap[b].slot] = b;
+    }
+
+    void siftDown(std::size_t pos) {
+        const std::size_t n = heap.size();
+        while (true) {
+            std::size_t left = 2 * pos + 1;
+            if (left >= n) break;
+            std::size_t smallest = left;
+            if (left + 1 < n && heap[left + 1].count < heap[left].count) smallest = left + 1;
+            if (heap[smallest].count >= heap[pos].count) break;
+            swapNodes(pos, smallest);
+            pos = smallest;
+        }
+    }
+
+    void siftUp(std::size_t pos) {
+        while (pos > 0) {
+            std::size_t parent = (pos - 1) / 2;
+            if (heap[parent].count <= heap[pos].count) break;
+            swapNodes(pos, parent);
+            pos = parent;
+        }
+    }
+
+public:
+    explicit SpaceSaving(std::size_t capacity) : maxEntries(capacity < 1 ? 1 : capacity), total(0) {
+        std::size_t slotCount = 1;
+        while (slotCount < maxEntries * 2) slotCount <<= 1;
+        slots.assign(slotCount, EMPTY);
+        slotMask = slotCount - 1;
+        heap.reserve(maxEntries);
+    }
+
+    void add(const Key& key, uint64_t weight = 1) {
+        total += weight;
+        std::size_t i = findSlot(key);
+
+        if (slots[i] != EMPTY) {
+            std::size_t pos = slots[i];
+            heap[pos].count += weight;
+            siftDown(pos);
+            return;
+        }
+
+        if (heap.size() < maxEntries) {
+            heap.push_back(Counter{key, weight, 0, i});
+            slots[i] = heap.size() - 1;
+            siftUp(heap.size() - 1);
+            return;
+        }
+
+        // Evict the minimum: the newcomer inherits its count as the error bound.
+        Counter& root = heap[0];
+        eraseSlot(root.slot);
+        i = findSlot(key);
+        root.key = key;
+        root.error = root.count;
+        root.count += weight;
+        root.slot = i;
+        slots[i] = 0;
+        siftDown(0);
+    }
+
+    std::vector<Entry> top(std::size_t n) const {
+        std::vector<Entry> result;
+        result.reserve(heap.size());
+        for (const auto& counter : heap) {
+            result.push_back(Entry{counter.key, counter.count, counter.error});
+        }
+        std::sort(result.begin(), result.end(), [](const Entry& a, const Entry& b) {
+            return a.count > b.count;
+        });
+        if (result.size() > n) result.resize(n);
+        return result;
+    }
+
+    // Combines summaries built over disjoint streams into the n heaviest keys.
+    // A key absent from a full summary may still have occurred up to that
+    // summary's minimum count, which is added to its count and error so the
+    // merged counts remain upper bounds.
+    static std::vector<Entry> merge(const std::vector<const SpaceSaving*>& parts, std::size_t n) {
+        std::vector<Entry> merged;
+        for (const SpaceSaving* part : parts) {
+            for (const auto& counter : part->heap) {
+                bool seen = false;
+                for (const auto& entry : merged) {
+                    if (entry.key == counter.key) {
+                        seen = true;
+                        break;
+                    }
+                }
+                if (seen) continue;
+
+                Entry entry{counter.key, 0, 0};
+                for (const SpaceSaving* other : parts) {
+                    const Counter* match = other->find(counter.key);
+                    if (match != nullptr) {
+                        entry.count += match->count;
+                        entry.error += match->error;
+                    } else {
+                        entry.count += other->minCount();
+                        entry.error += other->minCount();
+                    }
+                }
+                merged.push_back(entry);
+            }
+        }
+        std::sort(merged.begin(), merged.end(), [](const Entry& a, const Entry& b) {
+            return a.count > b.count;
+        });
+        if (merged.size() > n) merged.resize(n);
+        return merged;
+    }
+
+    void clear() {
+        heap.clear();
+        std::fill(slots.begin(), slots.end(), EMPTY);
+        total = 0;
+    }
+
+    std::size_t size() const { return heap.size(); }
+    std::size_t capacity() const { return maxEntries; }
+    uint64_t totalWeight() const { return total; }
+    uint64_t minCount() const { return heap.size() < maxEntries || heap.empty() ? 0 : heap[0].count; }
+};
+
+#endif
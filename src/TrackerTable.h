@@ -0,0 +1,123 @@
+#ifndef TRACKER_TABLE_H
+#define TRACKER_TABLE_H
+
+#include "AddressIndex.h"
+#include "SlabPool.h"
+#include <string>
+#include <cstddef>
+
+// Per-address state with a hard memory cap. Entries live in a SlabPool and
+// are found through an open-addressing AddressIndex, both charged to the
+// budget, so a new source costs no heap allocation unless a slab or the
+// index has to grow. Once the budget is full, a new address takes over the
+// entry the CLOCK hand picks, i.e. one that has not been touched since the
+// hand last passed it.
+template <typename T, typename Key = IpAddress>
+class TrackerTable {
+private:
+    struct Slot {
+        Key key;
+        bool used = false;
+        bool referenced = false;
+        T value = T();
+    };
+
+    MemoryBudget& budget;
+    MemoryBudget::Account& account;
+    SlabPool<Slot> pool;
+    AddressIndex<Slot, Key> index;
+    std::size_t hand = 0;
+
+    bool growIndex() {
+        if (!index.needsGrowth()) return true;
+        std::size_t next = index.grownCapacity();
+        if (!budget.reserve(account, AddressIndex<Slot, Key>::bytesFor(next) - AddressIndex<Slot, Key>::bytesFor(index.capacity()))) {
+            return false;
+        }
+        index.rehash(next);
+        return true;
+    }
+
+    template <typename Evicted>
+    Slot* evict(Evicted evicted) {
+        const std::size_t capacity = pool.capacity();
+        if (index.size() == 0) return nullptr;
+        for (;;) {
+            Slot& slot = pool.at(hand);
+            hand = (hand + 1) % capacity;
+            if (!slot.used) continue;
+            if (slot.referenced) {
+                slot.referenced = false;
+                continue;
+            }
+            index.erase(slot.key);
+            evicted(slot.value);
+            slot.value = T();
+            account.evictions.increment();
+            return &slot;
+        }
+    }
+
+public:
+    TrackerTable(MemoryBudget& budget, const std::string& name)
+        : budget(budget), account(budget.addAccount(name)), pool(budget, account) {}
+
+    ~TrackerTable() { clear(); }
+
+    // State for `key`, created on first use. Returns nullptr only when the
+    // budget has no room for even one slab of this table. `evicted` sees the
+    // value of an entry just before it is recycled for `key`.
+    template <typename Evicted>
+    T* acquire(const Key& key, Evicted evicted) {
+        if (Slot* found = index.find(key)) {
+            found->referenced = true;
+            return &found->value;
+        }
+        Slot* slot = growIndex() ? pool.allocate() : nullptr;
+        if (slot == nullptr && (slot = evict(evicted)) == nullptr) return nullptr;
+        slot->key = key;
+        slot->used = true;
+        slot->referenced = true;
+        index.insert(key, slot);
+        return &slot->value;
+    }
+
+    T* acquire(const Key& key) {
+        return acquire(key, [](const T&) {});
+    }
+
+    // Frees every entry for which expired(value) is true. Walks the slabs in
+    // order rather than the index.
+    template <typename Pred>
+    void expire(Pred expired) {
+        for (std::size_t i = 0, capacity = pool.capacity(); i < capacity; ++i) {
+            Slot& slot = pool.at(i);
+            if (slot.used && expired(slot.value)) {
+                index.erase(slot.key);
+                pool.release(&slot);
+                account.expirations.increment();
+            }
+        }
+    }
+
+    // Calls visit(key, value) for every entry, in slab order.
+    template <typename Visit>
+    void forEach(Visit visit) {
+        for (std::size_t i = 0, capacity = pool.capacity(); i < capacity; ++i) {
+            Slot& slot = pool.at(i);
+            if (slot.used) visit(slot.key, slot.value);
+        }
+    }
+
+    void clear() {
+        if (index.capacity() > 0) budget.release(account, AddressIndex<Slot, Key>::bytesFor(index.capacity()));
+        index.clear();
+        pool.clear();
+        hand = 0;
+    }
+
+    std::size_t size() const { return index.size(); }
+    std::size_t v6Size() const { return index.v6Size(); }
+};
+
+#endif
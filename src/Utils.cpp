@@ -1,43 +1,39 @@
 #include "Utils.h"
+#include "FastFormat.h"
+#include "IpAddress.h"
 #include <iomanip>
 #include <sstream>
 #include <iostream>
-#include <regex>
 
 #ifdef _WIN32
 #include <windows.h>
 #else
 #include <cstdlib>
 #endif
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
 
 std::string Utils::formatTimestamp(const std::chrono::system_clock::time_point& tp) {
-    auto time_t = std::chrono::system_clock::to_time_t(tp);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        tp.time_since_epoch()) % 1000;
-    
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&time_t), "%H:%M:%S");
-    ss << "." << std::setfill('0') << std::setw(3) << ms.count();
-    return ss.str();
+    char buffer[FastFormat::TIMESTAMP_WIDTH];
+    return std::string(buffer, FastFormat::timestamp(buffer, tp));
 }
 
-std::string Utils::formatBytes(uint32_t bytes) {
-    const char* units[] = {"B", "KB", "MB", "GB"};
-    int unit = 0;
-    double size = bytes;
-    
-    while (size >= 1024 && unit < 3) {
-        size /= 1024;
-        unit++;
-    }
-    
-    std::stringstream ss;
-    if (unit == 0) {
-        ss << static_cast<int>(size) << " " << units[unit];
-    } else {
-        ss << std::fixed << std::setprecision(2) << size << " " << units[unit];
-    }
-    return ss.str();
+void Utils::localTime(std::time_t time, std::tm& out) {
+#ifdef _WIN32
+    localtime_s(&out, &time);
+#else
+    localtime_r(&time, &out);
+#endif
+}
+
+std::string Utils::formatBytes(uint64_t bytes) {
+    char buffer[FastFormat::BYTES_MAX_WIDTH];
+    return std::string(buffer, FastFormat::bytes(buffer, bytes));
 }
 
 std::string Utils::protocolToString(int protocol) {
@@ -45,6 +41,7 @@ std::string Utils::protocolToString(int protocol) {
         case 1: return "ICMP";
         case 6: return "TCP";
         case 17: return "UDP";
+        case 58: return "ICMPv6";
         default: return "OTHER(" + std::to_string(protocol) + ")";
     }
 }
@@ -78,25 +75,36 @@ std::vector<std::string> Utils::splitString(const std::string& str, char delimit
 }
 
 bool Utils::isValidIP(const std::string& ip) {
-    std::regex ipRegex(R"(^(?:(?:25[0-5]|2[0-4][0-9]|[01]?[0-9][0-9]?)\.){3}(?:25[0-5]|2[0-4][0-9]|[01]?[0-9][0-9]?)$)");
-    return std::regex_match(ip, ipRegex);
+    IpAddress address;
+    return IpAddress::parse(ip, address);
 }
 
-bool Utils::isValidPort(const std::string& port) {
-    try {
-        int p = std::stoi(port);
-        return p >= 0 && p <= 65535;
-    } catch (...) {
+bool Utils::parseCount(const std::string& text, uint64_t max, uint64_t& out) {
+    if (text.empty()) {
         return false;
     }
+    uint64_t value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        uint64_t digit = static_cast<uint64_t>(c - '0');
+        if (value > max / 10 || digit > max - value * 10) {
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+    out = value;
+    return true;
 }
 
 std::string Utils::getCurrentDateTime() {
     auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
+    std::tm local;
+    localTime(std::chrono::system_clock::to_time_t(now), local);
     
     std::stringstream ss;
-    ss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
+    ss << std::put_time(&local, "%Y-%m-%d %H:%M:%S");
     return ss.str();
 }
 
@@ -108,7 +116,41 @@ std::string Utils::toUpperCase(const std::string& str) {
     return result;
 }
 
-bool Utils::isValidProtocol(const std::string& protocol) {
-    std::string upper = toUpperCase(protocol);
-    return (upper == "TCP" || upper == "UDP" || upper == "ICMP");
+int Utils::protocolNumber(const std::string& name) {
+    std::string upper = toUpperCase(name);
+    if (upper == "TCP") return 6;
+    if (upper == "UDP") return 17;
+    if (upper == "ICMP") return 1;
+    if (upper == "ICMPV6") return 58;
+    return -1;
+}
+
+bool Utils::pinCurrentThread(int cpu) {
+    if (cpu < 0) {
+        return false;
+    }
+#if defined(_WIN32)
+    if (cpu >= static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+        return false;
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << cpu) != 0;
+#elif defined(__linux__)
+    if (cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+void Utils::cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
 }
@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 #include <chrono>
+#include <cstdint>
+#include <ctime>
 
 namespace Utils {
     namespace Colors {
@@ -19,16 +21,26 @@ namespace Utils {
     }
     
     std::string formatTimestamp(const std::chrono::system_clock::time_point& tp);
-    std::string formatBytes(uint32_t bytes);
+    void localTime(std::time_t time, std::tm& out);
+    std::string formatBytes(uint64_t bytes);
     std::string protocolToString(int protocol);
     void playBeep();
     void clearScreen();
     std::vector<std::string> splitString(const std::string& str, char delimiter);
     bool isValidIP(const std::string& ip);
-    bool isValidPort(const std::string& port);
-    bool isValidProtocol(const std::string& protocol);
+    // Parses a plain decimal count no greater than `max`. Signs, spaces,
+    // trailing characters and overflow are all rejected.
+    bool parseCount(const std::string& text, uint64_t max, uint64_t& out);
+    // The IP protocol number for TCP, UDP, ICMP or ICMPv6 in any case; -1 otherwise.
+    int protocolNumber(const std::string& name);
     std::string toUpperCase(const std::string& str);
     std::string getCurrentDateTime();
+    
+    // Pins the calling thread to one CPU. False where thread affinity is not
+    // supported (macOS) or the CPU is not available to the process.
+    bool pinCurrentThread(int cpu);
+    // Tells the CPU the caller is spinning (PAUSE on x86, YIELD on ARM).
+    void cpuRelax();
 }
 
 #endif
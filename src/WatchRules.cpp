@@ -1,11 +1,19 @@
 #include "WatchRules.h"
+#include "FastFormat.h"
 #include "Utils.h"
 #include <iostream>
+#include <algorithm>
+#include <cstring>
 
 void WatchRules::addWatchIP(const std::string& ip) {
-    if (Utils::isValidIP(ip)) {
-        watchedIPs.insert(ip);
-        std::cout << Utils::Colors::GREEN << "Added IP watch: " << ip << Utils::Colors::RESET << std::endl;
+    IpPrefix prefix;
+    if (IpPrefix::parse(ip, prefix)) {
+        auto same = [&prefix](const IpPrefix& p) { return p.bits == prefix.bits && p.network == prefix.network; };
+        if (std::none_of(watchedPrefixes.begin(), watchedPrefixes.end(), same)) {
+            watchedPrefixes.push_back(prefix);
+            rebuildPrefixIndex();
+        }
+        std::cout << Utils::Colors::GREEN << "Added IP watch: " << prefix.toString() << Utils::Colors::RESET << std::endl;
     } else {
         std::cout << Utils::Colors::RED << "Invalid IP address: " << ip << Utils::Colors::RESET << std::endl;
     }
@@ -20,12 +28,54 @@ void WatchRules::addWatchPort(uint16_t port) {
     }
 }
 
+void WatchRules::addWatchDomain(const std::string& domain) {
+    DomainName name;
+    if (DomainName::parse(domain, name)) {
+        if (std::find(watchedDomains.begin(), watchedDomains.end(), name) == watchedDomains.end()) {
+            watchedDomains.push_back(name);
+            domainHashes.insert(name.hash());
+        }
+        std::cout << Utils::Colors::GREEN << "Added domain watch: " << name.toString() << Utils::Colors::RESET << std::endl;
+    } else {
+        std::cout << Utils::Colors::RED << "Invalid domain name: " << domain << Utils::Colors::RESET << std::endl;
+    }
+}
+
 void WatchRules::removeWatchIP(const std::string& ip) {
-    auto it = watchedIPs.find(ip);
-    if (it != watchedIPs.end()) {
-        watchedIPs.erase(it);
-        std::cout << Utils::Colors::YELLOW << "Removed IP watch: " << ip << Utils::Colors::RESET << std::endl;
+    IpPrefix prefix;
+    if (!IpPrefix::parse(ip, prefix)) return;
+    auto it = std::find_if(watchedPrefixes.begin(), watchedPrefixes.end(), [&prefix](const IpPrefix& p) {
+        return p.bits == prefix.bits && p.network == prefix.network;
+    });
+    if (it != watchedPrefixes.end()) {
+        watchedPrefixes.erase(it);
+        rebuildPrefixIndex();
+        std::cout << Utils::Colors::YELLOW << "Removed IP watch: " << prefix.toString() << Utils::Colors::RESET << std::endl;
+    }
+}
+
+void WatchRules::rebuildPrefixIndex() {
+    prefixLengths.clear();
+    for (const auto& prefix : watchedPrefixes) {
+        auto it = std::find_if(prefixLengths.begin(), prefixLengths.end(), [&prefix](const PrefixLength& length) {
+            return length.bits == prefix.bits;
+        });
+        if (it == prefixLengths.end()) {
+            prefixLengths.push_back(PrefixLength{prefix.bits, {}});
+            it = prefixLengths.end() - 1;
+        }
+        it->networks.insert(prefix.network);
+    }
+    std::sort(prefixLengths.begin(), prefixLengths.end(), [](const PrefixLength& a, const PrefixLength& b) {
+        return a.bits > b.bits;
+    });
+}
+
+bool WatchRules::isWatched(const IpAddress& address) const {
+    for (const auto& length : prefixLengths) {
+        if (length.networks.count(address.masked(length.bits))) return true;
     }
+    return false;
 }
 
 void WatchRules::removeWatchPort(uint16_t port) {
@@ -36,20 +86,61 @@ void WatchRules::removeWatchPort(uint16_t port) {
     }
 }
 
+void WatchRules::removeWatchDomain(const std::string& domain) {
+    DomainName name;
+    if (!DomainName::parse(domain, name)) return;
+    auto it = std::find(watchedDomains.begin(), watchedDomains.end(), name);
+    if (it != watchedDomains.end()) {
+        watchedDomains.erase(it);
+        domainHashes.clear();
+        for (const auto& watched : watchedDomains) {
+            domainHashes.insert(watched.hash());
+        }
+        std::cout << Utils::Colors::YELLOW << "Removed domain watch: " << name.toString() << Utils::Colors::RESET << std::endl;
+    }
+}
+
+bool WatchRules::isWatched(const DomainName& name) const {
+    return name.forEachSuffix([this, &name](uint64_t hash, std::size_t offset) {
+        if (!domainHashes.count(hash)) return false;
+        std::size_t size = name.size() - offset;
+        for (const auto& domain : watchedDomains) {
+            if (domain.size() == size && std::memcmp(domain.data(), name.data() + offset, size) == 0) return true;
+        }
+        return false;
+    });
+}
+
 bool WatchRules::checkPacket(const PacketInfo& packet) {
     bool matched = false;
-    if (watchedIPs.count(packet.sourceIP) || watchedIPs.count(packet.destIP)) {
-        addAlert(AlertType::IP_WATCH, "Watched IP traffic detected: " + packet.sourceIP + " -> " + packet.destIP, packet);
+    char route[FastFormat::ROUTE_MAX_WIDTH];
+    if (!prefixLengths.empty() && (isWatched(packet.sourceAddr) || isWatched(packet.destAddr))) {
+        char* end = FastFormat::route(route, packet.sourceAddr, packet.destAddr);
+        addAlert(AlertType::IP_WATCH, "Watched IP traffic detected: " + std::string(route, end), packet);
         matched = true;
     }
     if (watchedPorts.count(packet.sourcePort) || watchedPorts.count(packet.destPort)) {
         addAlert(AlertType::PORT_WATCH, "Watched port traffic detected: " + std::to_string(packet.sourcePort) + " -> " + std::to_string(packet.destPort), packet);
         matched = true;
     }
+    if (!domainHashes.empty() && !packet.app.name.empty() && isWatched(packet.app.name)) {
+        char* end = FastFormat::route(route, packet.sourceAddr, packet.destAddr);
+        addAlert(AlertType::DOMAIN_WATCH, "Watched domain traffic detected: " + packet.app.name.toString() + " (" +
+                 AppLayer::protocolName(packet.app.protocol) + ") " + std::string(route, end), packet);
+        matched = true;
+    }
     return matched;
 }
 
 void WatchRules::addAlert(AlertType type, const std::string& message, const PacketInfo& packet) {
+    if (type == AlertType::IP_WATCH) {
+        ipAlertCount.increment();
+    } else if (type == AlertType::PORT_WATCH) {
+        portAlertCount.increment();
+    } else if (type == AlertType::DOMAIN_WATCH) {
+        domainAlertCount.increment();
+    }
+    
     Alert alert;
     alert.type = type;
     alert.message = message;
@@ -63,14 +154,18 @@ const std::vector<Alert>& WatchRules::getAlerts() const {
     return alerts;
 }
 
-const std::unordered_set<std::string>& WatchRules::getWatchedIPs() const {
-    return watchedIPs;
+const std::vector<IpPrefix>& WatchRules::getWatchedIPs() const {
+    return watchedPrefixes;
 }
 
 const std::unordered_set<uint16_t>& WatchRules::getWatchedPorts() const {
     return watchedPorts;
 }
 
+const std::vector<DomainName>& WatchRules::getWatchedDomains() const {
+    return watchedDomains;
+}
+
 void WatchRules::clearAlerts() {
     alerts.clear();
 }
@@ -78,10 +173,10 @@ void WatchRules::clearAlerts() {
 void WatchRules::printWatchedItems() const {
     std::cout << Utils::Colors::BOLD << "\n=== Watch Rules ===" << Utils::Colors::RESET << std::endl;
 
-    if (!watchedIPs.empty()) {
+    if (!watchedPrefixes.empty()) {
         std::cout << Utils::Colors::CYAN << "Watched IPs:" << Utils::Colors::RESET;
-        for (const auto& ip : watchedIPs) {
-            std::cout << " " << ip;
+        for (const auto& prefix : watchedPrefixes) {
+            std::cout << " " << prefix.toString();
         }
         std::cout << std::endl;
     }
@@ -94,8 +189,24 @@ void WatchRules::printWatchedItems() const {
         std::cout << std::endl;
     }
 
-    if (watchedIPs.empty() && watchedPorts.empty()) {
+    if (!watchedDomains.empty()) {
+        std::cout << Utils::Colors::CYAN << "Watched Domains:" << Utils::Colors::RESET;
+        for (const auto& domain : watchedDomains) {
+            std::cout << " " << domain.toString();
+        }
+        std::cout << std::endl;
+    }
+
+    if (isEmpty()) {
         std::cout << Utils::Colors::YELLOW << "No watch rules configured" << Utils::Colors::RESET << std::endl;
     }
     std::cout << std::endl;
 }
+
+void WatchRules::writeMetrics(std::ostream& out) const {
+    out << "# HELP network2_watch_alerts_total Alerts raised by watch rules.\n"
+        << "# TYPE network2_watch_alerts_total counter\n"
+        << "network2_watch_alerts_total{type=\"ip\"} " << ipAlertCount.get() << "\n"
+        << "network2_watch_alerts_total{type=\"port\"} " << portAlertCount.get() << "\n"
+        << "network2_watch_alerts_total{type=\"domain\"} " << domainAlertCount.get() << "\n";
+}
@@ -3,34 +3,66 @@
 
 #include "PacketTypes.h"
 #include "Alert.h"
+#include "Counters.h"
+#include "IpAddress.h"
 #include <vector>
 #include <string>
 #include <unordered_set>
 #include <cstdint>
+#include <ostream>
 
 class WatchRules {
 private:
-    std::unordered_set<std::string> watchedIPs;
+    // Watched addresses and networks, as entered, plus one hash set of
+    // networks per distinct prefix length (longest first), so matching costs
+    // one probe per length in use rather than one per rule.
+    struct PrefixLength {
+        int bits;
+        std::unordered_set<IpAddress, IpAddress::Hash> networks;
+    };
+
+    std::vector<IpPrefix> watchedPrefixes;
+    std::vector<PrefixLength> prefixLengths;
     std::unordered_set<uint16_t> watchedPorts;
+    // Watched domains, matching the name itself and every subdomain. The
+    // hash set holds DomainName::hash() of each, so a packet's name costs
+    // one probe per label (see DomainName::forEachSuffix).
+    std::vector<DomainName> watchedDomains;
+    std::unordered_set<uint64_t> domainHashes;
     std::vector<Alert> alerts;
 
+    void rebuildPrefixIndex();
+    bool isWatched(const IpAddress& address) const;
+    bool isWatched(const DomainName& name) const;
+    SingleWriterCounter ipAlertCount;
+    SingleWriterCounter portAlertCount;
+    SingleWriterCounter domainAlertCount;
+
 public:
     WatchRules() = default;
 
+    // Accepts a single address or a network such as 10.0.0.0/8 or 2001:db8:1:2::/64.
     void addWatchIP(const std::string& ip);
     void addWatchPort(uint16_t port);
+    // Matches DNS query names, HTTP Host headers and TLS SNI for the domain
+    // or any subdomain of it; "*.example.com" is the same as "example.com".
+    void addWatchDomain(const std::string& domain);
     void removeWatchIP(const std::string& ip);
     void removeWatchPort(uint16_t port);
+    void removeWatchDomain(const std::string& domain);
 
+    bool isEmpty() const { return watchedPrefixes.empty() && watchedPorts.empty() && watchedDomains.empty(); }
     bool checkPacket(const PacketInfo& packet);
     void addAlert(AlertType type, const std::string& message, const PacketInfo& packet);
 
     const std::vector<Alert>& getAlerts() const;
-    const std::unordered_set<std::string>& getWatchedIPs() const;
+    const std::vector<IpPrefix>& getWatchedIPs() const;
     const std::unordered_set<uint16_t>& getWatchedPorts() const;
+    const std::vector<DomainName>& getWatchedDomains() const;
 
     void clearAlerts();
     void printWatchedItems() const;
+    void writeMetrics(std::ostream& out) const;
 };
 
 #endif 
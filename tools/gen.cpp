@@ -0,0 +1,728 @@
+#include "IpAddress.h"
+#include "Utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <pcap.h>
+#else
+#include <pcap/pcap.h>
+#endif
+
+// network2.0-gen: writes reproducible synthetic pcap traces for load and
+// detection testing. Background traffic comes from Zipf-distributed talkers
+// and servers; attack scenarios (scans, bursts, floods) are laid over it at
+// given times, and their ground truth can be written as a CSV of labels.
+
+namespace {
+    const int64_t NANOS_PER_SECOND = 1000000000LL;
+
+    // xoshiro256** seeded through splitmix64: fast, and the same stream on
+    // every platform for a given seed.
+    class Random {
+    private:
+        uint64_t s[4];
+
+        static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    public:
+        explicit Random(uint64_t seed) {
+            for (uint64_t& word : s) {
+                seed += 0x9E3779B97F4A7C15ULL;
+                uint64_t z = seed;
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+                word = z ^ (z >> 31);
+            }
+        }
+
+        uint64_t next() {
+            uint64_t result = rotl(s[1] * 5, 7) * 9;
+            uint64_t t = s[1] << 17;
+            s[2] ^= s[0];
+            s[3] ^= s[1];
+            s[1] ^= s[2];
+            s[0] ^= s[3];
+            s[2] ^= t;
+            s[3] = rotl(s[3], 45);
+            return result;
+        }
+
+        double uniform() { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); }
+        uint32_t below(uint32_t n) { return static_cast<uint32_t>((next() >> 32) * n >> 32); }
+
+        // Gap to the next event of a Poisson process with the given rate.
+        int64_t exponentialNanos(double rate) {
+            return static_cast<int64_t>(-std::log(1.0 - uniform()) / rate * NANOS_PER_SECOND);
+        }
+    };
+
+    // Zipf(s) over ranks 0..n-1 through Vose's alias method, so a draw costs
+    // one random number and at most two table reads whatever n is.
+    class ZipfSampler {
+    private:
+        std::vector<double> threshold;
+        std::vector<uint32_t> alias;
+
+    public:
+        void build(uint32_t n, double exponent) {
+            std::vector<double> weight(n);
+            double total = 0;
+            for (uint32_t i = 0; i < n; ++i) {
+                weight[i] = 1.0 / std::pow(static_cast<double>(i + 1), exponent);
+                total += weight[i];
+            }
+            threshold.assign(n, 1.0);
+            alias.resize(n);
+            std::vector<uint32_t> small, large;
+            for (uint32_t i = 0; i < n; ++i) {
+                weight[i] = weight[i] * n / total;
+                alias[i] = i;
+                (weight[i] < 1.0 ? small : large).push_back(i);
+            }
+            while (!small.empty() && !large.empty()) {
+                uint32_t lo = small.back();
+                uint32_t hi = large.back();
+                small.pop_back();
+                threshold[lo] = weight[lo];
+                alias[lo] = hi;
+                weight[hi] -= 1.0 - weight[lo];
+                if (weight[hi] < 1.0) {
+                    large.pop_back();
+                    small.push_back(hi);
+                }
+            }
+        }
+
+        uint32_t sample(Random& random) const {
+            uint64_t r = random.next();
+            uint32_t column = static_cast<uint32_t>((r >> 32) * threshold.size() >> 32);
+            double coin = static_cast<double>(r & 0xFFFFFFFF) * (1.0 / 4294967296.0);
+            return coin < threshold[column] ? column : alias[column];
+        }
+    };
+
+    enum TcpFlags : uint8_t { FIN = 0x01, SYN = 0x02, RST = 0x04, PSH = 0x08, ACK = 0x10 };
+
+    struct PacketSpec {
+        IpAddress source;
+        IpAddress dest;
+        uint8_t protocol = 6;
+        uint16_t sourcePort = 0;
+        uint16_t destPort = 0;
+        uint8_t tcpFlags = ACK;
+        uint32_t length = 0;  // On-the-wire frame length
+        std::vector<uint8_t> payload;  // When set, replaces `length` with the headers plus this
+    };
+
+    // Application payloads for --app-payloads, laid out as the monitor's
+    // dissectors expect them on the wire.
+    namespace Payload {
+        void put16(std::vector<uint8_t>& out, std::size_t v) {
+            out.push_back(static_cast<uint8_t>(v >> 8));
+            out.push_back(static_cast<uint8_t>(v));
+        }
+
+        void dns(std::vector<uint8_t>& out, uint16_t id, const std::string& name, bool response, uint8_t rcode) {
+            put16(out, id);
+            put16(out, response ? 0x8180u | rcode : 0x0100u);
+            put16(out, 1);
+            put16(out, response && rcode == 0 ? 1 : 0);
+            put16(out, 0);
+            put16(out, 0);
+            std::size_t label = 0;
+            while (label < name.size()) {
+                std::size_t dot = name.find('.', label);
+                if (dot == std::string::npos) dot = name.size();
+                out.push_back(static_cast<uint8_t>(dot - label));
+                out.insert(out.end(), name.begin() + label, name.begin() + dot);
+                label = dot + 1;
+            }
+            out.push_back(0);
+            put16(out, 1);  // A
+            put16(out, 1);  // IN
+            if (response && rcode == 0) {
+                put16(out, 0xC00C);
+                put16(out, 1);
+                put16(out, 1);
+                put16(out, 0);
+                put16(out, 300);
+                put16(out, 4);
+                out.insert(out.end(), {192, 0, 2, static_cast<uint8_t>(id)});
+            }
+        }
+
+        void http(std::vector<uint8_t>& out, const std::string& host) {
+            std::string request = "GET /index.html HTTP/1.1\r\nUser-Agent: network2.0-gen\r\nHost: " + host +
+                                  "\r\nAccept: */*\r\n\r\n";
+            out.insert(out.end(), request.begin(), request.end());
+        }
+
+        // TLS 1.3-style ClientHello: one cipher suite and a server_name extension.
+        void clientHello(std::vector<uint8_t>& out, const std::string& serverName) {
+            std::size_t extensions = 4 + 5 + serverName.size();
+            std::size_t body = 2 + 32 + 1 + 4 + 2 + 2 + extensions;
+            out.insert(out.end(), {22, 3, 1});
+            put16(out, 4 + body);
+            out.push_back(1);
+            out.push_back(0);
+            put16(out, body);
+            out.insert(out.end(), {3, 3});
+            out.insert(out.end(), 32, 0x5A);
+            out.push_back(0);
+            put16(out, 2);
+            put16(out, 0x1301);
+            out.insert(out.end(), {1, 0});
+            put16(out, extensions);
+            put16(out, 0);
+            put16(out, 5 + serverName.size());
+            put16(out, 3 + serverName.size());
+            out.push_back(0);
+            put16(out, serverName.size());
+            out.insert(out.end(), serverName.begin(), serverName.end());
+        }
+    }
+
+    // Builds Ethernet frames (optionally 802.1Q tagged) in one reused buffer
+    // and hands them to pcap_dump. Unless the spec carries a payload, payload
+    // bytes are left as they are in the buffer; transport checksums are zero
+    // and the IPv4 header checksum is valid.
+    class FrameWriter {
+    private:
+        pcap_t* dead = nullptr;
+        pcap_dumper_t* dumper = nullptr;
+        std::FILE* file = nullptr;
+        std::vector<char> fileBuffer;
+        std::vector<uint8_t> frame;
+        uint32_t snaplen = 65535;
+        int vlan = -1;
+
+        static void put16(uint8_t* p, uint16_t v) {
+            p[0] = static_cast<uint8_t>(v >> 8);
+            p[1] = static_cast<uint8_t>(v);
+        }
+
+        static void put32(uint8_t* p, uint32_t v) {
+            put16(p, static_cast<uint16_t>(v >> 16));
+            put16(p + 2, static_cast<uint16_t>(v));
+        }
+
+        static uint16_t ipv4Checksum(const uint8_t* header) {
+            uint32_t sum = 0;
+            for (int i = 0; i < 20; i += 2) sum += static_cast<uint32_t>(header[i] << 8 | header[i + 1]);
+            while (sum >> 16) sum = (sum & 0xFFFF) + (sum >> 16);
+            return static_cast<uint16_t>(~sum);
+        }
+
+    public:
+        uint64_t packets = 0;
+        uint64_t bytes = 0;
+
+        ~FrameWriter() { close(); }
+
+        bool open(const std::string& path, uint32_t snapLength, int vlanId) {
+            snaplen = snapLength;
+            vlan = vlanId;
+            frame.assign(65535 + 64, 0);
+            file = path == "-" ? stdout : std::fopen(path.c_str(), "wb");
+            if (file == nullptr) return false;
+            fileBuffer.resize(1 << 20);
+            std::setvbuf(file, fileBuffer.data(), _IOFBF, fileBuffer.size());
+            dead = pcap_open_dead(DLT_EN10MB, static_cast<int>(snaplen));
+            dumper = dead != nullptr ? pcap_dump_fopen(dead, file) : nullptr;
+            return dumper != nullptr;
+        }
+
+        void close() {
+            if (dumper != nullptr) {
+                pcap_dump_close(dumper);  // Closes the file as well
+                dumper = nullptr;
+                file = nullptr;
+            } else if (file != nullptr && file != stdout) {
+                std::fclose(file);
+                file = nullptr;
+            }
+            if (dead != nullptr) {
+                pcap_close(dead);
+                dead = nullptr;
+            }
+        }
+
+        void write(int64_t nanos, const PacketSpec& spec) {
+            uint8_t* p = frame.data();
+            std::memset(p, 0x02, 12);  // Locally administered MACs
+            p[5] = static_cast<uint8_t>(spec.source.hash());
+            p[11] = static_cast<uint8_t>(spec.dest.hash());
+            std::size_t offset = 12;
+            if (vlan >= 0) {
+                put16(p + offset, 0x8100);
+                put16(p + offset + 2, static_cast<uint16_t>(vlan));
+                offset += 4;
+            }
+
+            const bool v4 = spec.source.isV4();
+            const std::size_t transportLength = spec.protocol == 6 ? 20 : 8;
+            const std::size_t headers = offset + 2 + (v4 ? 20 : 40) + transportLength;
+            uint32_t length = spec.length < headers ? static_cast<uint32_t>(headers) : spec.length;
+            if (!spec.payload.empty()) {
+                length = static_cast<uint32_t>(headers + spec.payload.size());
+            }
+            const uint16_t ipLength = static_cast<uint16_t>(length - offset - 2);
+
+            put16(p + offset, v4 ? 0x0800 : 0x86DD);
+            uint8_t* ip = p + offset + 2;
+            uint8_t* transport;
+            if (v4) {
+                std::memset(ip, 0, 20);
+                ip[0] = 0x45;
+                put16(ip + 2, ipLength);
+                put16(ip + 4, static_cast<uint16_t>(packets));
+                put16(ip + 6, 0x4000);
+                ip[8] = 64;
+                ip[9] = spec.protocol;
+                put32(ip + 12, spec.source.v4());
+                put32(ip + 16, spec.dest.v4());
+                put16(ip + 10, ipv4Checksum(ip));
+                transport = ip + 20;
+            } else {
+                put32(ip, 0x60000000);
+                put16(ip + 4, static_cast<uint16_t>(ipLength - 40));
+                ip[6] = spec.protocol;
+                ip[7] = 64;
+                spec.source.toBytes(ip + 8);
+                spec.dest.toBytes(ip + 24);
+                transport = ip + 40;
+            }
+
+            put16(transport, spec.sourcePort);
+            put16(transport + 2, spec.destPort);
+            if (spec.protocol == 6) {
+                put32(transport + 4, static_cast<uint32_t>(packets * 1460));
+                put32(transport + 8, (spec.tcpFlags & ACK) ? 1 : 0);
+                transport[12] = 0x50;
+                transport[13] = spec.tcpFlags;
+                put16(transport + 14, 65535);
+                put32(transport + 16, 0);
+            } else {
+                put16(transport + 4, static_cast<uint16_t>(length - (transport - p)));
+                put16(transport + 6, 0);
+            }
+
+            // Cleared again afterwards, so later frames do not carry stale
+            // application data in their payload bytes.
+            uint8_t* payload = p + headers;
+            if (!spec.payload.empty()) {
+                std::memcpy(payload, spec.payload.data(), spec.payload.size());
+            }
+
+            struct pcap_pkthdr header;
+            header.ts.tv_sec = static_cast<decltype(header.ts.tv_sec)>(nanos / NANOS_PER_SECOND);
+            header.ts.tv_usec = static_cast<decltype(header.ts.tv_usec)>(nanos % NANOS_PER_SECOND / 1000);
+            header.len = length;
+            header.caplen = length < snaplen ? length : snaplen;
+            pcap_dump(reinterpret_cast<u_char*>(dumper), &header, p);
+            if (!spec.payload.empty()) {
+                std::memset(payload, 0, spec.payload.size());
+            }
+            packets++;
+            bytes += length;
+        }
+    };
+
+    // Address plan: talkers in 10.0.0.0/8 (or 2001:db8:1::/48), servers in
+    // 172.16.0.0/12 (or 2001:db8:2::/48), attackers in 198.51.100.0/24,
+    // spoofed SYN flood sources in 100.64.0.0/10.
+    IpAddress v6Address(uint16_t net, uint32_t host) {
+        uint8_t bytes[16] = {0x20, 0x01, 0x0D, 0xB8, 0x00, static_cast<uint8_t>(net)};
+        for (int i = 0; i < 4; ++i) bytes[12 + i] = static_cast<uint8_t>(host >> (24 - 8 * i));
+        return IpAddress::fromBytes(bytes);
+    }
+
+    // Scatters ranks over the 24-bit host space (an odd multiplier is a
+    // bijection modulo 2^24) so the busiest talkers are not neighbours.
+    uint32_t scatter(uint32_t rank) { return (rank * 0x9E3779u + 1) & 0xFFFFFF; }
+
+    struct Background {
+        double rate = 10000;
+        uint32_t talkers = 10000;
+        uint32_t servers = 100;
+        double exponent = 1.1;
+        int ipv6Percent = 0;
+        bool appPayloads = false;
+        ZipfSampler talkerRanks;
+        ZipfSampler serverRanks;
+
+        bool isV6(uint32_t rank) const { return static_cast<int>(rank * 2654435761u >> 16) % 100 < ipv6Percent; }
+
+        IpAddress talker(uint32_t rank) const {
+            return isV6(rank) ? v6Address(1, rank + 1) : IpAddress::fromV4(0x0A000000u | scatter(rank));
+        }
+
+        IpAddress server(uint32_t rank, bool v6) const {
+            return v6 ? v6Address(2, rank + 1) : IpAddress::fromV4(0xAC100000u + rank + 1);
+        }
+
+        void next(Random& random, PacketSpec& spec) const {
+            static const uint16_t PORTS[] = {443, 443, 443, 80, 80, 53, 22, 123, 8080, 3306};
+            uint32_t talkerRank = talkerRanks.sample(random);
+            uint32_t serverRank = serverRanks.sample(random);
+            uint64_t r = random.next();
+            uint16_t servicePort = PORTS[(serverRank + (r & 1)) % (sizeof(PORTS) / sizeof(PORTS[0]))];
+            uint16_t clientPort = static_cast<uint16_t>(32768 + (talkerRank * 31 + serverRank) % 28000);
+            bool v6 = isV6(talkerRank);
+            bool request = (r >> 1 & 1) != 0;
+
+            IpAddress client = talker(talkerRank);
+            IpAddress host = server(serverRank, v6);
+            spec.protocol = servicePort == 53 || servicePort == 123 ? 17 : 6;
+            spec.source = request ? client : host;
+            spec.dest = request ? host : client;
+            spec.sourcePort = request ? clientPort : servicePort;
+            spec.destPort = request ? servicePort : clientPort;
+            spec.tcpFlags = (r >> 2 & 3) == 0 ? static_cast<uint8_t>(ACK) : static_cast<uint8_t>(ACK | PSH);
+            uint32_t bucket = static_cast<uint32_t>(r >> 8 & 0xFF);
+            if (request) {
+                spec.length = bucket < 96 ? 66 : 100 + static_cast<uint32_t>(r >> 16) % 500;
+            } else {
+                spec.length = bucket < 160 ? 1514 : 66 + static_cast<uint32_t>(r >> 16) % 1448;
+            }
+            spec.payload.clear();
+            if (appPayloads) {
+                addPayload(spec, request, bucket >= 96, serverRank, r);
+            }
+        }
+
+        // DNS carries a query or its answer in every packet; HTTP and TLS
+        // requests that have payload carry a GET or a ClientHello. One DNS
+        // name in eight does not exist and is answered with NXDOMAIN.
+        static void addPayload(PacketSpec& spec, bool request, bool hasPayload, uint32_t serverRank, uint64_t r) {
+            std::string rank = std::to_string(serverRank);
+            switch (request ? spec.destPort : spec.sourcePort) {
+                case 53: {
+                    bool missing = (r >> 24 & 7) == 0;
+                    std::string name = missing ? "host" + std::to_string(r >> 27 & 1023) + ".nx.example.net"
+                                               : "svc" + rank + ".example.net";
+                    Payload::dns(spec.payload, static_cast<uint16_t>(r >> 32), name, !request, missing ? 3 : 0);
+                    break;
+                }
+                case 80:
+                case 8080:
+                    if (request && hasPayload) Payload::http(spec.payload, "www" + rank + ".example.com");
+                    break;
+                case 443:
+                    if (request && hasPayload) Payload::clientHello(spec.payload, "api" + rank + ".example.org");
+                    break;
+                default:
+                    break;
+            }
+        }
+    };
+
+    enum class AttackType { VERTICAL_SCAN, HORIZONTAL_SCAN, BURST, SYN_FLOOD, SPOOF_FLOOD };
+
+    struct Attack {
+        AttackType type;
+        std::string name;
+        double start = 0;     // Seconds from the start of the trace
+        double duration = 0;
+        double rate = 0;      // Packets per second
+        uint32_t sources = 1;
+        IpAddress attacker;
+        IpAddress victim;
+        uint64_t packets = 0;
+        int64_t nextNanos = 0;
+        int64_t endNanos = 0;
+
+        void next(Random& random, PacketSpec& spec) {
+            spec.source = attacker;
+            spec.dest = victim;
+            spec.protocol = 6;
+            spec.sourcePort = static_cast<uint16_t>(40000 + packets % 20000);
+            spec.tcpFlags = SYN;
+            spec.length = 60;
+            spec.payload.clear();
+            switch (type) {
+                case AttackType::VERTICAL_SCAN:
+                    spec.destPort = static_cast<uint16_t>(1 + packets % 65535);
+                    break;
+                case AttackType::HORIZONTAL_SCAN:
+                    spec.dest = IpAddress::fromV4(victim.v4() + static_cast<uint32_t>(packets % 65534));
+                    spec.destPort = 22;
+                    break;
+                case AttackType::BURST:
+                    spec.protocol = 17;
+                    spec.destPort = 53;
+                    spec.length = 512;
+                    break;
+                case AttackType::SYN_FLOOD:
+                    spec.source = IpAddress::fromV4(0x64400000u + random.below(sources));
+                    spec.sourcePort = static_cast<uint16_t>(1024 + random.below(64000));
+                    spec.destPort = 80;
+                    break;
+                case AttackType::SPOOF_FLOOD:
+                    spec.source = IpAddress::fromV4(static_cast<uint32_t>(random.next() >> 32));
+                    spec.protocol = 17;
+                    spec.sourcePort = static_cast<uint16_t>(random.next() >> 48);
+                    spec.destPort = 53;
+                    spec.length = 100 + random.below(400);
+                    break;
+            }
+            packets++;
+        }
+
+        std::string sourceLabel() const {
+            if (type == AttackType::SYN_FLOOD) return "100.64.0.0/10 (" + std::to_string(sources) + " sources)";
+            if (type == AttackType::SPOOF_FLOOD) return "random";
+            return attacker.toString();
+        }
+
+        std::string targetLabel() const {
+            if (type == AttackType::HORIZONTAL_SCAN) return IpPrefix{victim.masked(112), 112}.toString() + " port 22";
+            if (type == AttackType::VERTICAL_SCAN) return victim.toString() + " ports 1-65535";
+            return victim.toString() + (type == AttackType::BURST || type == AttackType::SPOOF_FLOOD ? " port 53" : " port 80");
+        }
+    };
+
+    bool parseAttack(const std::string& text, Attack& attack) {
+        std::vector<std::string> fields = Utils::splitString(text, ':');
+        if (fields.size() < 3 || fields.size() > 5) return false;
+        struct Kind {
+            const char* name;
+            AttackType type;
+            double rate;
+        };
+        static const Kind KINDS[] = {
+            {"vscan", AttackType::VERTICAL_SCAN, 100},
+            {"hscan", AttackType::HORIZONTAL_SCAN, 100},
+            {"burst", AttackType::BURST, 1000},
+            {"synflood", AttackType::SYN_FLOOD, 10000},
+            {"spoof", AttackType::SPOOF_FLOOD, 50000},
+        };
+        const Kind* kind = nullptr;
+        for (const Kind& k : KINDS) {
+            if (fields[0] == k.name) kind = &k;
+        }
+        if (kind == nullptr) return false;
+        try {
+            attack.type = kind->type;
+            attack.name = kind->name;
+            attack.start = std::stod(fields[1]);
+            attack.duration = std::stod(fields[2]);
+            attack.rate = fields.size() > 3 ? std::stod(fields[3]) : kind->rate;
+            attack.sources = fields.size() > 4 ? static_cast<uint32_t>(std::stoul(fields[4])) : 1000;
+        } catch (...) {
+            return false;
+        }
+        return attack.start >= 0 && attack.duration > 0 && attack.rate > 0 && attack.sources > 0 &&
+               attack.sources <= (1u << 22);
+    }
+
+    void printUsage() {
+        std::cout << "Usage: network2.0-gen [OPTIONS] -o <trace.pcap>\n\n"
+                  << "Writes a synthetic Ethernet pcap: Zipf-distributed background traffic plus\n"
+                  << "optional attack scenarios. The same seed and options give the same file.\n\n"
+                  << "Options:\n"
+                  << "  -o, --output <file>   Output pcap ('-' for stdout)\n"
+                  << "  --duration <sec>      Length of the trace (default 10)\n"
+                  << "  --rate <pps>          Background packets per second (default 10000, 0 for none)\n"
+                  << "  --talkers <N>         Distinct background client addresses (default 10000)\n"
+                  << "  --servers <N>         Distinct background servers (default 100)\n"
+                  << "  --zipf <s>            Zipf exponent for talker and server popularity (default 1.1)\n"
+                  << "  --ipv6 <percent>      Share of talkers using IPv6 (default 0)\n"
+                  << "  --vlan <id>           Tag every frame with this 802.1Q VLAN ID\n"
+                  << "  --app-payloads        Fill background DNS, HTTP and TLS packets with queries, answers,\n"
+                  << "                        GET requests and ClientHellos instead of zeros\n"
+                  << "  --snaplen <bytes>     Bytes of each frame stored in the file (default 65535)\n"
+                  << "  --start <unix sec>    Timestamp of the first packet (default 1700000000)\n"
+                  << "  --seed <N>            Random seed (default 1)\n"
+                  << "  --attack <spec>       Add an attack; may be repeated (see below)\n"
+                  << "  --segment <i>/<n>     Keep only every n-th attack packet, starting at the i-th (0-based),\n"
+                  << "                        as one of n sensors would see an attack spread across segments\n"
+                  << "  --labels <file>       Write ground truth for each attack as CSV\n"
+                  << "  --help, -h            Show this help message\n\n"
+                  << "Attack spec: <type>:<start sec>:<duration sec>[:<pps>[:<sources>]]\n"
+                  << "  vscan     One source SYNs every port of one server (default 100 pps)\n"
+                  << "  hscan     One source SYNs port 22 across a range of hosts (default 100 pps)\n"
+                  << "  burst     One source sends UDP at a high rate (default 1000 pps)\n"
+                  << "  synflood  SYNs to one server port from <sources> addresses (default 10000 pps, 1000 sources)\n"
+                  << "  spoof     UDP from a random source address per packet (default 50000 pps)\n\n"
+                  << "Example: network2.0-gen -o stress.pcap --duration 60 --rate 200000 --talkers 1000000 \\\n"
+                  << "             --attack vscan:10:5 --attack spoof:30:10:500000 --labels stress.csv\n";
+    }
+
+    bool parseNumber(const std::string& text, double& out) {
+        try {
+            std::size_t used = 0;
+            out = std::stod(text, &used);
+            return used == text.size() && out >= 0;
+        } catch (...) {
+            return false;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string output;
+    std::string labelsPath;
+    Background background;
+    std::vector<Attack> attacks;
+    double duration = 10;
+    uint64_t seed = 1;
+    uint64_t start = 1700000000;
+    uint64_t snaplen = 65535;
+    int vlan = -1;
+    uint64_t segment = 0;
+    uint64_t segments = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool ok = true;
+        uint64_t count = 0;
+
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        } else if ((arg == "-o" || arg == "--output") && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg == "--labels" && i + 1 < argc) {
+            labelsPath = argv[++i];
+        } else if (arg == "--duration" && i + 1 < argc) {
+            ok = parseNumber(argv[++i], duration) && duration > 0;
+        } else if (arg == "--rate" && i + 1 < argc) {
+            ok = parseNumber(argv[++i], background.rate);
+        } else if (arg == "--talkers" && i + 1 < argc) {
+            ok = Utils::parseCount(argv[++i], 1u << 24, count) && count > 0;
+            background.talkers = static_cast<uint32_t>(count);
+        } else if (arg == "--servers" && i + 1 < argc) {
+            ok = Utils::parseCount(argv[++i], 65535, count) && count > 0;
+            background.servers = static_cast<uint32_t>(count);
+        } else if (arg == "--zipf" && i + 1 < argc) {
+            ok = parseNumber(argv[++i], background.exponent);
+        } else if (arg == "--ipv6" && i + 1 < argc) {
+            ok = Utils::parseCount(argv[++i], 100, count);
+            background.ipv6Percent = static_cast<int>(count);
+        } else if (arg == "--vlan" && i + 1 < argc) {
+            ok = Utils::parseCount(argv[++i], 4094, count);
+            vlan = static_cast<int>(count);
+        } else if (arg == "--app-payloads") {
+            background.appPayloads = true;
+        } else if (arg == "--snaplen" && i + 1 < argc) {
+            ok = Utils::parseCount(argv[++i], 65535, snaplen) && snaplen >= 64;
+        } else if (arg == "--start" && i + 1 < argc) {
+            ok = Utils::parseCount(argv[++i], 4000000000ULL, start);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            ok = Utils::parseCount(argv[++i], 9999999999ULL, seed);
+        } else if (arg == "--segment" && i + 1 < argc) {
+            std::string value = argv[++i];
+            std::size_t slash = value.find('/');
+            ok = slash != std::string::npos && Utils::parseCount(value.substr(0, slash), 1000, segment) &&
+                 Utils::parseCount(value.substr(slash + 1), 1000, segments) && segment < segments;
+        } else if (arg == "--attack" && i + 1 < argc) {
+            Attack attack;
+            ok = parseAttack(argv[++i], attack);
+            attacks.push_back(attack);
+        } else {
+            std::cerr << Utils::Colors::RED << "Unknown argument: " << arg << Utils::Colors::RESET << std::endl;
+            return 1;
+        }
+
+        if (!ok) {
+            std::cerr << Utils::Colors::RED << "Error: Invalid value for " << arg << ": '" << argv[i] << "'"
+                      << Utils::Colors::RESET << std::endl;
+            return 1;
+        }
+    }
+
+    if (output.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    FrameWriter writer;
+    if (!writer.open(output, static_cast<uint32_t>(snaplen), vlan)) {
+        std::cerr << Utils::Colors::RED << "Error: Cannot create " << output << Utils::Colors::RESET << std::endl;
+        return 1;
+    }
+
+    Random random(seed);
+    background.talkerRanks.build(background.talkers, background.exponent);
+    background.serverRanks.build(background.servers, background.exponent);
+
+    const int64_t base = static_cast<int64_t>(start) * NANOS_PER_SECOND;
+    const int64_t end = base + static_cast<int64_t>(duration * NANOS_PER_SECOND);
+    for (std::size_t i = 0; i < attacks.size(); ++i) {
+        Attack& attack = attacks[i];
+        attack.attacker = IpAddress::fromV4(0xC6336400u + 1 + static_cast<uint32_t>(i % 254));
+        attack.victim = attack.type == AttackType::HORIZONTAL_SCAN ? IpAddress::fromV4(0xAC140001u)
+                                                                   : background.server(0, false);
+        attack.nextNanos = base + static_cast<int64_t>(attack.start * NANOS_PER_SECOND);
+        attack.endNanos = std::min(end, attack.nextNanos + static_cast<int64_t>(attack.duration * NANOS_PER_SECOND));
+    }
+
+    // Streams are merged by time: background packets arrive as a Poisson
+    // process, attack packets at a fixed rate.
+    auto wallStart = std::chrono::steady_clock::now();
+    int64_t backgroundNanos = background.rate > 0 ? base + random.exponentialNanos(background.rate) : end;
+    PacketSpec spec;
+    for (;;) {
+        Attack* due = nullptr;
+        int64_t now = backgroundNanos;
+        for (Attack& attack : attacks) {
+            if (attack.nextNanos < attack.endNanos && attack.nextNanos < now) {
+                now = attack.nextNanos;
+                due = &attack;
+            }
+        }
+        if (now >= end) break;
+
+        if (due != nullptr) {
+            bool kept = due->packets % segments == segment;
+            due->next(random, spec);
+            due->nextNanos = base + static_cast<int64_t>((due->start + static_cast<double>(due->packets) / due->rate) *
+                                                         NANOS_PER_SECOND);
+            if (!kept) continue;
+        } else {
+            background.next(random, spec);
+            backgroundNanos += random.exponentialNanos(background.rate);
+        }
+        writer.write(now, spec);
+    }
+    writer.close();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    if (!labelsPath.empty()) {
+        std::FILE* labels = std::fopen(labelsPath.c_str(), "w");
+        if (labels == nullptr) {
+            std::cerr << Utils::Colors::RED << "Error: Cannot create " << labelsPath << Utils::Colors::RESET << std::endl;
+            return 1;
+        }
+        std::fprintf(labels, "Id,Type,Start,End,Source,Target,Packets\n");
+        for (std::size_t i = 0; i < attacks.size(); ++i) {
+            const Attack& attack = attacks[i];
+            double first = static_cast<double>(start) + attack.start;
+            double last = first + static_cast<double>(attack.packets) / attack.rate;
+            std::fprintf(labels, "%zu,%s,%.6f,%.6f,%s,%s,%llu\n", i + 1, attack.name.c_str(), first, last,
+                         attack.sourceLabel().c_str(), attack.targetLabel().c_str(),
+                         static_cast<unsigned long long>(attack.packets));
+        }
+        std::fclose(labels);
+    }
+
+    // The summary goes to stderr when the trace is streamed to stdout.
+    std::ostream& summary = output == "-" ? std::cerr : std::cout;
+    summary << "Wrote " << writer.packets << " packets (" << Utils::formatBytes(writer.bytes) << " on the wire, "
+            << duration << " s of traffic) in " << seconds << " s, "
+            << (seconds > 0 ? static_cast<double>(writer.packets) / seconds / 1e6 : 0) << " Mpps" << std::endl;
+    for (const Attack& attack : attacks) {
+        summary << "  " << attack.name << ": " << attack.packets << " packets from " << attack.sourceLabel() << " to "
+                << attack.targetLabel() << std::endl;
+    }
+    return 0;
+}
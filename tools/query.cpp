@@ -0,0 +1,296 @@
+#include "BinaryLog.h"
+#include "FastFormat.h"
+#include "Utils.h"
+#include "SegmentIndex.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+// network2.0-query: filters binary packet logs written with --log-format
+// binary and prints a summary, or the matching records as CSV.
+
+namespace {
+    struct Filter {
+        int64_t from = std::numeric_limits<int64_t>::min();
+        int64_t to = std::numeric_limits<int64_t>::max();
+        bool hasIP = false;
+        IpPrefix ip;
+        bool hasPort = false;
+        uint16_t port = 0;
+        bool anomaliesOnly = false;
+    };
+
+    struct Totals {
+        uint64_t records = 0;
+        uint64_t matched = 0;
+        uint64_t matchedBytes = 0;
+        uint64_t blocks = 0;
+        uint64_t blocksSkipped = 0;
+        uint64_t fileBytes = 0;
+        uint64_t segments = 0;
+        uint64_t segmentsSkipped = 0;
+    };
+
+    const char CSV_HEADER[] = "Timestamp,Source_IP,Source_Port,Dest_IP,Dest_Port,Protocol,Size_Bytes,Is_Anomaly,Anomaly_Reason\n";
+
+    void printUsage() {
+        std::cout << "Usage: network2.0-query [OPTIONS] <log.n2l>...\n\n"
+                  << "A log written with rotation may be given by its base name (e.g. traffic.n2l)\n"
+                  << "to query all of its segments.\n\n"
+                  << "Options:\n"
+                  << "  --from <time>       Only records at or after this time\n"
+                  << "  --to <time>         Only records before this time\n"
+                  << "  --ip <IP[/len]>     Records with a source or destination in this address or network\n"
+                  << "  --port <port>       Records with this source or destination port\n"
+                  << "  --anomalies         Only anomalies and alerts\n"
+                  << "  --csv <file>        Write matching records as CSV ('-' for stdout)\n"
+                  << "  --help, -h          Show this help message\n\n"
+                  << "Times are Unix seconds or local 'YYYY-MM-DD HH:MM:SS' (the T separator also works).\n";
+    }
+
+    bool parseTime(const std::string& text, int64_t& nanos) {
+        std::tm local = {};
+        int year, month, day, hour = 0, minute = 0, second = 0;
+        char separator = ' ';
+        int fields = std::sscanf(text.c_str(), "%d-%d-%d%c%d:%d:%d", &year, &month, &day, &separator, &hour, &minute, &second);
+        if (fields == 3 || fields == 7) {
+            local.tm_year = year - 1900;
+            local.tm_mon = month - 1;
+            local.tm_mday = day;
+            local.tm_hour = hour;
+            local.tm_min = minute;
+            local.tm_sec = second;
+            local.tm_isdst = -1;
+            std::time_t seconds = std::mktime(&local);
+            if (seconds == static_cast<std::time_t>(-1)) return false;
+            nanos = static_cast<int64_t>(seconds) * 1000000000LL;
+            return true;
+        }
+        try {
+            std::size_t used = 0;
+            long long seconds = std::stoll(text, &used);
+            if (used != text.size()) return false;
+            nanos = seconds * 1000000000LL;
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+
+    class CsvOutput {
+    private:
+        std::FILE* file;
+        bool ownsFile;
+        std::vector<char> buffer;
+        std::size_t used;
+
+    public:
+        CsvOutput() : file(nullptr), ownsFile(false), buffer(1 << 20), used(0) {}
+        ~CsvOutput() { close(); }
+
+        bool open(const std::string& path) {
+            if (path == "-") {
+                file = stdout;
+            } else {
+                file = std::fopen(path.c_str(), "wb");
+                ownsFile = true;
+            }
+            if (file == nullptr) return false;
+            std::fwrite(CSV_HEADER, 1, sizeof(CSV_HEADER) - 1, file);
+            return true;
+        }
+
+        bool isOpen() const { return file != nullptr; }
+
+        void write(const BinaryLog::BlockView& block, uint32_t i) {
+            std::string reason = block.reason(i);
+            std::string protocol = Utils::protocolToString(block.protocols[i]);
+            std::size_t needed = 160 + protocol.size() + reason.size();
+            if (used + needed > buffer.size()) flush();
+            if (needed > buffer.size()) buffer.resize(needed);
+
+            std::chrono::system_clock::time_point timestamp(
+                std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(block.timestamps[i])));
+            char* start = buffer.data() + used;
+            char* out = FastFormat::timestamp(start, timestamp);
+            *out++ = ',';
+            out = FastFormat::address(out, block.sourceAddress(i));
+            *out++ = ',';
+            out = FastFormat::uint(out, block.sourcePorts[i]);
+            *out++ = ',';
+            out = FastFormat::address(out, block.destAddress(i));
+            *out++ = ',';
+            out = FastFormat::uint(out, block.destPorts[i]);
+            *out++ = ',';
+            out = FastFormat::text(out, protocol);
+            *out++ = ',';
+            out = FastFormat::uint(out, block.sizes[i]);
+            bool anomaly = (block.flags[i] & BinaryLog::FLAG_ANOMALY) != 0;
+            out = anomaly ? FastFormat::text(out, ",true,\"", 7) : FastFormat::text(out, ",false,\"", 8);
+            if (block.flags[i] & BinaryLog::FLAG_ALERT) out = FastFormat::text(out, "ALERT: ", 7);
+            out = FastFormat::text(out, reason);
+            out = FastFormat::text(out, "\"\n", 2);
+            used += static_cast<std::size_t>(out - start);
+        }
+
+        void flush() {
+            if (file != nullptr && used > 0) std::fwrite(buffer.data(), 1, used, file);
+            used = 0;
+        }
+
+        void close() {
+            if (file == nullptr) return;
+            flush();
+            if (ownsFile) {
+                std::fclose(file);
+            } else {
+                std::fflush(file);
+            }
+            file = nullptr;
+        }
+    };
+
+    bool matches(const BinaryLog::BlockView& block, uint32_t i, const Filter& filter) {
+        int64_t t = block.timestamps[i];
+        if (t < filter.from || t >= filter.to) return false;
+        if (filter.anomaliesOnly && (block.flags[i] & (BinaryLog::FLAG_ANOMALY | BinaryLog::FLAG_ALERT)) == 0) return false;
+        if (filter.hasIP && !filter.ip.contains(block.sourceAddress(i)) && !filter.ip.contains(block.destAddress(i))) {
+            return false;
+        }
+        if (filter.hasPort && block.sourcePorts[i] != filter.port && block.destPorts[i] != filter.port) return false;
+        return true;
+    }
+
+    bool scanFile(const std::string& path, const Filter& filter, CsvOutput& csv, Totals& totals) {
+        totals.segments++;
+        SegmentIndex::Entry entry;
+        if (SegmentIndex::readEntry(path, entry) && (entry.lastNanos < filter.from || entry.firstNanos >= filter.to)) {
+            totals.segmentsSkipped++;
+            totals.records += entry.records;
+            return true;
+        }
+        
+        BinaryLog::Reader reader;
+        if (!reader.open(path)) {
+            std::cerr << Utils::Colors::RED << "Error: " << reader.getError() << Utils::Colors::RESET << std::endl;
+            return false;
+        }
+        totals.fileBytes += reader.fileSize();
+
+        BinaryLog::BlockView block;
+        while (reader.next(block)) {
+            const BinaryLog::BlockHeader& header = *block.header;
+            totals.blocks++;
+            totals.records += header.recordCount;
+            if (header.maxTimestamp < filter.from || header.minTimestamp >= filter.to) {
+                totals.blocksSkipped++;
+                continue;
+            }
+            for (uint32_t i = 0; i < header.recordCount; ++i) {
+                if (!matches(block, i, filter)) continue;
+                totals.matched++;
+                totals.matchedBytes += block.sizes[i];
+                if (csv.isOpen()) csv.write(block, i);
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Filter filter;
+    std::string csvPath;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        } else if ((arg == "--from" || arg == "--to") && i + 1 < argc) {
+            std::string value = argv[++i];
+            int64_t nanos;
+            if (!parseTime(value, nanos)) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid time '" << value << "'"
+                          << Utils::Colors::RESET << std::endl;
+                return 1;
+            }
+            (arg == "--from" ? filter.from : filter.to) = nanos;
+        } else if (arg == "--ip" && i + 1 < argc) {
+            std::string ip = argv[++i];
+            if (!IpPrefix::parse(ip, filter.ip)) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid IP address '" << ip << "'"
+                          << Utils::Colors::RESET << std::endl;
+                return 1;
+            }
+            filter.hasIP = true;
+        } else if (arg == "--port" && i + 1 < argc) {
+            std::string portStr = argv[++i];
+            uint64_t port = 0;
+            if (!Utils::parseCount(portStr, 65535, port)) {
+                std::cerr << Utils::Colors::RED << "Error: Invalid port number '" << portStr << "'"
+                          << Utils::Colors::RESET << std::endl;
+                return 1;
+            }
+            filter.hasPort = true;
+            filter.port = static_cast<uint16_t>(port);
+        } else if (arg == "--anomalies") {
+            filter.anomaliesOnly = true;
+        } else if (arg == "--csv" && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << Utils::Colors::RED << "Unknown argument: " << arg << Utils::Colors::RESET << std::endl;
+            return 1;
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    if (files.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    CsvOutput csv;
+    if (!csvPath.empty() && !csv.open(csvPath)) {
+        std::cerr << Utils::Colors::RED << "Error: Cannot create " << csvPath << Utils::Colors::RESET << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Totals totals;
+    bool ok = true;
+    for (const auto& file : files) {
+        std::vector<std::string> segments;
+        std::error_code ec;
+        if (!std::filesystem::exists(file, ec)) {
+            segments = SegmentIndex::listSegments(file);
+        }
+        if (segments.empty()) {
+            segments.push_back(file);
+        }
+        for (const auto& segment : segments) {
+            ok = scanFile(segment, filter, csv, totals) && ok;
+        }
+    }
+    csv.close();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // The summary goes to stderr when CSV is streamed to stdout.
+    std::ostream& summary = csvPath == "-" ? std::cerr : std::cout;
+    summary << "Matched " << totals.matched << " of " << totals.records << " records ("
+            << Utils::formatBytes(totals.matchedBytes) << " of traffic)\n"
+            << "Scanned " << Utils::formatBytes(totals.fileBytes) << " in " << totals.segments - totals.segmentsSkipped
+            << " file(s) (" << totals.segmentsSkipped << " skipped by index), "
+            << totals.blocks << " blocks (" << totals.blocksSkipped << " skipped by time) in "
+            << static_cast<int>(seconds * 1000) << " ms" << std::endl;
+    return ok ? 0 : 1;
+}
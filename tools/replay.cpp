@@ -0,0 +1,431 @@
+#include "NetworkMonitor.h"
+#include "IpAddress.h"
+#include "Utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// network2.0-replay: drives the full NetworkMonitor pipeline (parse, queue,
+// analysis, watch rules, stats, store, log) over a pcap trace as fast as it
+// will go, and reports throughput, peak memory, drops and detection accuracy
+// against network2.0-gen labels. Results are written as JSON and can be
+// compared with a stored baseline; a regression beyond the tolerance makes
+// the exit status non-zero, which is how CTest runs it.
+
+namespace {
+    // Alerts raised this long after an attack's last packet still count for it.
+    const double DETECTION_GRACE_SECONDS = 5;
+
+    struct Label {
+        std::string id;
+        std::string type;
+        double start = 0;
+        double end = 0;
+        bool scored = true;  // False for spoofed sources, which no alert can be attributed to
+        IpPrefix source;
+        uint64_t alerts = 0;
+    };
+
+    struct Result {
+        NetworkMonitor::ReplaySummary summary;
+        uint64_t alertPackets = 0;
+        uint64_t falsePositivePackets = 0;
+        std::unordered_set<IpAddress, IpAddress::Hash> falsePositiveSources;
+        std::vector<Label> labels;
+        uint64_t peakRssKB = 0;
+
+        double mpps() const { return summary.seconds > 0 ? static_cast<double>(summary.packets) / summary.seconds / 1e6 : 0; }
+        double nanosPerPacket() const {
+            return summary.packets > 0 ? summary.seconds * 1e9 / static_cast<double>(summary.packets) : 0;
+        }
+        uint64_t expected() const {
+            return static_cast<uint64_t>(std::count_if(labels.begin(), labels.end(), [](const Label& l) { return l.scored; }));
+        }
+        uint64_t detected() const {
+            return static_cast<uint64_t>(std::count_if(labels.begin(), labels.end(), [](const Label& l) { return l.alerts > 0; }));
+        }
+    };
+
+    uint64_t readPeakRssKB() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+        return static_cast<uint64_t>(counters.PeakWorkingSetSize) / 1024;
+#else
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+        return static_cast<uint64_t>(usage.ru_maxrss) / 1024;  // Bytes on macOS
+#else
+        return static_cast<uint64_t>(usage.ru_maxrss);
+#endif
+#endif
+    }
+
+    // The first word of a label field: "10.0.0.1", "100.64.0.0/10 (1000 sources)".
+    bool parseLabelPrefix(const std::string& field, IpPrefix& out) {
+        return IpPrefix::parse(field.substr(0, field.find(' ')), out);
+    }
+
+    bool loadLabels(const std::string& path, std::vector<Label>& labels) {
+        std::ifstream in(path);
+        if (!in.is_open()) {
+            std::cerr << Utils::Colors::RED << "Error: Cannot open " << path << Utils::Colors::RESET << std::endl;
+            return false;
+        }
+        std::string line;
+        std::getline(in, line);  // Header
+        while (std::getline(in, line)) {
+            if (line.empty()) continue;
+            std::vector<std::string> fields = Utils::splitString(line, ',');
+            Label label;
+            bool ok = fields.size() == 7;
+            if (ok) {
+                label.id = fields[0];
+                label.type = fields[1];
+                label.scored = fields[4] != "random";
+                try {
+                    label.start = std::stod(fields[2]);
+                    label.end = std::stod(fields[3]);
+                } catch (...) {
+                    ok = false;
+                }
+                ok = ok && (!label.scored || parseLabelPrefix(fields[4], label.source));
+            }
+            if (!ok) {
+                std::cerr << Utils::Colors::RED << "Error: Malformed label in " << path << ": " << line
+                          << Utils::Colors::RESET << std::endl;
+                return false;
+            }
+            labels.push_back(label);
+        }
+        return true;
+    }
+
+    void recordAlert(Result& result, const PacketInfo& packet) {
+        double time = std::chrono::duration<double>(packet.timestamp.time_since_epoch()).count();
+        bool expected = false;
+        for (Label& label : result.labels) {
+            if (!label.scored || time < label.start || time > label.end + DETECTION_GRACE_SECONDS) continue;
+            if (label.source.contains(packet.sourceAddr)) {
+                label.alerts++;
+                expected = true;
+            }
+        }
+        result.alertPackets++;
+        if (!expected) {
+            result.falsePositivePackets++;
+            result.falsePositiveSources.insert(packet.sourceAddr);
+        }
+    }
+
+    bool runOnce(const std::vector<std::string>& monitorArgs, const std::vector<Label>& labels, Result& result) {
+        std::vector<char*> argv;
+        for (const std::string& arg : monitorArgs) argv.push_back(const_cast<char*>(arg.c_str()));
+
+        result.labels = labels;
+        std::unique_ptr<NetworkMonitor> monitor(new NetworkMonitor());
+        if (!monitor->parseArguments(static_cast<int>(argv.size()), argv.data()) || !monitor->initialize("")) {
+            return false;
+        }
+        monitor->onAlert = [&result](const PacketInfo& packet) { recordAlert(result, packet); };
+        return monitor->replay(result.summary);
+    }
+
+    std::string jsonEscape(const std::string& text) {
+        std::string out;
+        for (char c : text) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    void writeJson(std::ostream& out, const std::string& trace, int runs, const Result& result) {
+        out << "{\n"
+            << "  \"trace\": \"" << jsonEscape(trace) << "\",\n"
+            << "  \"runs\": " << runs << ",\n"
+            << "  \"frames\": " << result.summary.frames << ",\n"
+            << "  \"packets\": " << result.summary.packets << ",\n"
+            << "  \"seconds\": " << result.summary.seconds << ",\n"
+            << "  \"mpps\": " << result.mpps() << ",\n"
+            << "  \"ns_per_packet\": " << result.nanosPerPacket() << ",\n"
+            << "  \"peak_rss_kb\": " << result.peakRssKB << ",\n"
+            << "  \"max_queue_depth\": " << result.summary.maxQueueDepth << ",\n"
+            << "  \"capture_drops\": " << result.summary.captureDrops << ",\n"
+            << "  \"log_drops\": " << result.summary.logDrops << ",\n"
+            << "  \"alert_packets\": " << result.alertPackets << ",\n"
+            << "  \"attacks_expected\": " << result.expected() << ",\n"
+            << "  \"attacks_detected\": " << result.detected() << ",\n"
+            << "  \"false_positive_packets\": " << result.falsePositivePackets << ",\n"
+            << "  \"false_positive_sources\": " << result.falsePositiveSources.size() << ",\n"
+            << "  \"attacks\": [";
+        for (std::size_t i = 0; i < result.labels.size(); ++i) {
+            const Label& label = result.labels[i];
+            out << (i == 0 ? "\n" : ",\n") << "    {\"id\": \"" << jsonEscape(label.id) << "\", \"type\": \"" << jsonEscape(label.type)
+                << "\", \"scored\": " << (label.scored ? "true" : "false") << ", \"alerts\": " << label.alerts << "}";
+        }
+        out << (result.labels.empty() ? "]\n" : "\n  ]\n") << "}\n";
+    }
+
+    // Only top-level numbers are read back, so a flat key search is enough.
+    bool readNumber(const std::string& json, const std::string& key, double& out) {
+        std::size_t pos = json.find("\"" + key + "\":");
+        if (pos == std::string::npos) return false;
+        try {
+            out = std::stod(json.substr(pos + key.size() + 3));
+        } catch (...) {
+            return false;
+        }
+        return true;
+    }
+
+    // An attack's alert packets from the "attacks" array.
+    bool readAttackAlerts(const std::string& json, const std::string& id, double& out) {
+        std::size_t pos = json.find("{\"id\": \"" + id + "\"");
+        if (pos == std::string::npos) return false;
+        std::size_t end = json.find('}', pos);
+        pos = json.find("\"alerts\": ", pos);
+        if (pos == std::string::npos || pos > end) return false;
+        try {
+            out = std::stod(json.substr(pos + 10));
+        } catch (...) {
+            return false;
+        }
+        return true;
+    }
+
+    enum Direction { HIGHER_IS_BETTER, LOWER_IS_BETTER, EITHER };
+
+    struct Check {
+        const char* key;
+        Direction direction;
+        bool useTolerance;  // Otherwise any change in a bad direction fails
+    };
+
+    bool regressed(const Check& check, double expected, double actual, double tolerance) {
+        double allowed = check.useTolerance ? expected * tolerance : 0;
+        bool fell = actual < expected - allowed;
+        bool rose = actual > expected + allowed;
+        switch (check.direction) {
+            case HIGHER_IS_BETTER: return fell;
+            case LOWER_IS_BETTER: return rose;
+            default: return fell || rose;
+        }
+    }
+
+    bool compareBaseline(const std::string& path, const std::string& json, const std::vector<Label>& labels,
+                         double tolerancePercent) {
+        std::ifstream in(path);
+        if (!in.is_open()) {
+            std::cerr << Utils::Colors::RED << "Error: Cannot open baseline " << path << Utils::Colors::RESET << std::endl;
+            return false;
+        }
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        std::string baseline = buffer.str();
+
+        double baselinePackets = 0, packets = 0;
+        if (!readNumber(baseline, "packets", baselinePackets) || !readNumber(json, "packets", packets) ||
+            baselinePackets != packets) {
+            std::cerr << Utils::Colors::RED << "Baseline " << path << " was recorded on a different trace"
+                      << Utils::Colors::RESET << std::endl;
+            return false;
+        }
+
+        // Alert packets move both ways when detection changes: fewer may mean
+        // missed attack traffic, more usually means noise.
+        static const Check CHECKS[] = {
+            {"mpps", HIGHER_IS_BETTER, true},
+            {"ns_per_packet", LOWER_IS_BETTER, true},
+            {"peak_rss_kb", LOWER_IS_BETTER, true},
+            {"capture_drops", LOWER_IS_BETTER, false},
+            {"log_drops", LOWER_IS_BETTER, false},
+            {"attacks_detected", HIGHER_IS_BETTER, false},
+            {"alert_packets", EITHER, true},
+            {"false_positive_packets", LOWER_IS_BETTER, true},
+            {"false_positive_sources", LOWER_IS_BETTER, true},
+        };
+        static const Check ATTACK_ALERTS = {"", HIGHER_IS_BETTER, true};
+
+        double tolerance = tolerancePercent / 100.0;
+        bool passed = true;
+        auto report = [&](const std::string& name, const Check& check, bool found, double expected, double actual) {
+            if (!found) {
+                std::printf("%-24s %14s\n", name.c_str(), "missing");
+                passed = false;
+                return;
+            }
+            double change = expected != 0 ? (actual - expected) / expected * 100.0 : 0;
+            bool bad = regressed(check, expected, actual, tolerance);
+            std::printf("%-24s %14.3f %14.3f %8.1f%%  %s\n", name.c_str(), expected, actual, change,
+                        bad ? "REGRESSED" : "ok");
+            passed = passed && !bad;
+        };
+
+        std::printf("\n%-24s %14s %14s %9s\n", "metric", "baseline", "current", "change");
+        for (const Check& check : CHECKS) {
+            double expected = 0, actual = 0;
+            bool found = readNumber(baseline, check.key, expected) && readNumber(json, check.key, actual);
+            report(check.key, check, found, expected, actual);
+        }
+        for (const Label& label : labels) {
+            if (!label.scored) continue;
+            double expected = 0, actual = 0;
+            bool found = readAttackAlerts(baseline, label.id, expected) && readAttackAlerts(json, label.id, actual);
+            report("alerts " + label.id + " " + label.type, ATTACK_ALERTS, found, expected, actual);
+        }
+
+        if (passed) {
+            std::cout << Utils::Colors::GREEN << "Within " << tolerancePercent << "% of " << path
+                      << Utils::Colors::RESET << std::endl;
+        } else {
+            std::cout << Utils::Colors::RED << "Regression against " << path << " (tolerance " << tolerancePercent
+                      << "%)" << Utils::Colors::RESET << std::endl;
+        }
+        return passed;
+    }
+
+    void printUsage() {
+        std::cout << "Usage: network2.0-replay [OPTIONS] <trace.pcap> [-- <network2.0 options>]\n\n"
+                  << "Runs the full monitor pipeline over a trace at maximum speed and reports\n"
+                  << "throughput, peak memory, drops and, given labels, detection accuracy.\n"
+                  << "Options after -- are passed to the monitor (e.g. --max-state-mb 16).\n\n"
+                  << "Options:\n"
+                  << "  --labels <file>       Ground truth CSV from network2.0-gen --labels\n"
+                  << "  --runs <N>            Replay N times and keep the fastest run (default 5)\n"
+                  << "  --json <file>         Write the results as JSON\n"
+                  << "  --baseline <file>     Compare against results from an earlier --json run\n"
+                  << "  --tolerance <percent> Allowed throughput, memory and alert count change (default 10)\n"
+                  << "  --help, -h            Show this help message\n\n"
+                  << "Exits non-zero if the run fails or regresses against the baseline. To accept\n"
+                  << "new results, copy the --json output over the baseline.\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string trace;
+    std::string labelsPath;
+    std::string jsonPath;
+    std::string baselinePath;
+    double tolerance = 10;
+    int runs = 5;
+    std::vector<std::string> monitorArgs;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool ok = true;
+
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        } else if (arg == "--") {
+            monitorArgs.assign(argv + i + 1, argv + argc);
+            break;
+        } else if (arg == "--labels" && i + 1 < argc) {
+            labelsPath = argv[++i];
+        } else if (arg == "--json" && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (arg == "--tolerance" && i + 1 < argc) {
+            try {
+                tolerance = std::stod(argv[++i]);
+            } catch (...) {
+                ok = false;
+            }
+            ok = ok && tolerance >= 0 && tolerance < 100;
+        } else if (arg == "--runs" && i + 1 < argc) {
+            std::string value = argv[++i];
+            uint64_t count = 0;
+            ok = Utils::parseCount(value, 65535, count) && count > 0;
+            if (ok) runs = static_cast<int>(count);
+        } else if (arg[0] != '-' && trace.empty()) {
+            trace = arg;
+        } else {
+            std::cerr << Utils::Colors::RED << "Unknown argument: " << arg << Utils::Colors::RESET << std::endl;
+            return 1;
+        }
+
+        if (!ok) {
+            std::cerr << Utils::Colors::RED << "Error: Invalid value for " << arg << ": '" << argv[i] << "'"
+                      << Utils::Colors::RESET << std::endl;
+            return 1;
+        }
+    }
+
+    if (trace.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<Label> labels;
+    if (!labelsPath.empty() && !loadLabels(labelsPath, labels)) {
+        return 1;
+    }
+
+    monitorArgs.insert(monitorArgs.begin(), {"network2.0", "--read", trace});
+    Result best;
+    uint64_t firstRunPeakKB = 0;
+    for (int run = 0; run < runs; ++run) {
+        Result result;
+        if (!runOnce(monitorArgs, labels, result)) {
+            std::cerr << Utils::Colors::RED << "Replay of " << trace << " failed" << Utils::Colors::RESET << std::endl;
+            return 1;
+        }
+        // Later runs reuse memory the allocator kept from earlier ones, which
+        // only adds noise to the high-water mark.
+        if (run == 0) firstRunPeakKB = readPeakRssKB();
+        if (run == 0 || result.summary.seconds < best.summary.seconds) {
+            best = std::move(result);
+        }
+    }
+    best.peakRssKB = firstRunPeakKB;
+
+    std::cout << "\n" << best.summary.packets << " packets (" << best.summary.frames << " frames) in "
+              << best.summary.seconds << " s: " << best.mpps() << " Mpps, " << best.nanosPerPacket() << " ns/packet, peak RSS "
+              << Utils::formatBytes(best.peakRssKB * 1024) << std::endl;
+    std::cout << "Alerts: " << best.alertPackets << " packets; " << best.detected() << " of " << best.expected()
+              << " attacks detected, " << best.falsePositiveSources.size() << " false positive sources" << std::endl;
+    for (const Label& label : best.labels) {
+        std::cout << "  " << label.id << " " << label.type << ": ";
+        if (!label.scored) {
+            std::cout << "not scored (spoofed sources)" << std::endl;
+        } else if (label.alerts > 0) {
+            std::cout << label.alerts << " alert packets" << std::endl;
+        } else {
+            std::cout << "missed" << std::endl;
+        }
+    }
+
+    std::ostringstream json;
+    writeJson(json, trace, runs, best);
+    if (!jsonPath.empty()) {
+        std::ofstream out(jsonPath);
+        if (!out.is_open() || !(out << json.str())) {
+            std::cerr << Utils::Colors::RED << "Error: Cannot write " << jsonPath << Utils::Colors::RESET << std::endl;
+            return 1;
+        }
+    }
+
+    if (!baselinePath.empty() && !compareBaseline(baselinePath, json.str(), best.labels, tolerance)) {
+        return 1;
+    }
+    return 0;
+}